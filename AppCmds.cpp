@@ -10,8 +10,13 @@
 #include "TheView.hpp"
 #include "AboutDlg.hpp"
 #include "FindDlg.hpp"
+#include "BulkEditDlg.hpp"
 #include "ShowPathDlg.hpp"
+#include "StructureDlg.hpp"
+#include "SubtreesDlg.hpp"
+#include "CompareDlg.hpp"
 #include <XML/XPathIterator.hpp>
+#include <WCL/BusyCursor.hpp>
 
 //! The ID of the first MRU command.
 const int ID_MRU_FIRST = ID_FILE_MRU_1;
@@ -30,18 +35,32 @@ AppCmds::AppCmds(AppWnd& appWnd)
 		// File menu.
 		CMD_ENTRY(ID_FILE_NEW,					&AppCmds::OnFileNew,		&AppCmds::OnUIFileNew,		 0)
 		CMD_ENTRY(ID_FILE_OPEN,					&AppCmds::OnFileOpen,		nullptr,					 1)
+		CMD_ENTRY(ID_FILE_OPEN_PREVIEW,			&AppCmds::OnFileOpenPreview,nullptr,					-1)
+		CMD_ENTRY(ID_FILE_OPEN_COMPACT,			&AppCmds::OnFileOpenCompact,nullptr,					-1)
+		CMD_ENTRY(ID_FILE_COMPARE,				&AppCmds::OnFileCompare,	&AppCmds::OnUIFileCompare,	-1)
+		CMD_ENTRY(ID_FILE_LOAD_MORE,			&AppCmds::OnFileLoadMore,	&AppCmds::OnUIFileLoadMore,	-1)
 		CMD_ENTRY(ID_FILE_SAVE,					&AppCmds::OnFileSave,		&AppCmds::OnUIFileSave,		 2)
 		CMD_ENTRY(ID_FILE_SAVEAS,				&AppCmds::OnFileSaveAs,		&AppCmds::OnUIFileSaveAs,	-1)
 		CMD_ENTRY(ID_FILE_CLOSE,				&AppCmds::OnFileClose,		&AppCmds::OnUIFileClose,	 1)
 		CMD_RANGE(ID_MRU_FIRST,	ID_MRU_LAST,	&AppCmds::OnFileOpenMRU,	&AppCmds::OnUIFileOpenMRU,	-1)
 		CMD_ENTRY(ID_FILE_EXIT,					&AppCmds::OnFileExit,		nullptr,					-1)
 		// Edit menu.
+		CMD_ENTRY(ID_EDIT_UNDO,					&AppCmds::OnEditUndo,		&AppCmds::OnUIEditUndo,		-1)
+		CMD_ENTRY(ID_EDIT_REDO,					&AppCmds::OnEditRedo,		&AppCmds::OnUIEditRedo,		-1)
 		CMD_ENTRY(ID_EDIT_FIND,					&AppCmds::OnEditFind,		&AppCmds::OnUIEditFind,		-1)
 		CMD_ENTRY(ID_EDIT_FIND_NEXT,			&AppCmds::OnEditFindNext,	&AppCmds::OnUIEditFindNext,	-1)
+		CMD_ENTRY(ID_EDIT_BULK_EDIT,			&AppCmds::OnEditBulkEdit,	&AppCmds::OnUIEditBulkEdit,	-1)
+		CMD_ENTRY(ID_EDIT_COPY,					&AppCmds::OnEditCopy,		&AppCmds::OnUIEditCopy,		-1)
+		CMD_ENTRY(ID_EDIT_PASTE,				&AppCmds::OnEditPaste,		&AppCmds::OnUIEditPaste,	-1)
 		// View menu.
 		CMD_ENTRY(ID_VIEW_HORZ,					&AppCmds::OnViewHorz,		&AppCmds::OnUIViewHorz,		-1)
 		CMD_ENTRY(ID_VIEW_VERT,					&AppCmds::OnViewVert,		&AppCmds::OnUIViewVert,		-1)
 		CMD_ENTRY(ID_VIEW_NODE_PATH,			&AppCmds::OnViewNodePath,	&AppCmds::OnUIViewNodePath,	-1)
+		CMD_ENTRY(ID_VIEW_STRUCTURE,			&AppCmds::OnViewStructure,	&AppCmds::OnUIViewStructure,-1)
+		CMD_ENTRY(ID_VIEW_SUBTREES,				&AppCmds::OnViewSubtrees,	&AppCmds::OnUIViewSubtrees,	-1)
+		CMD_ENTRY(ID_VIEW_FOLLOW,				&AppCmds::OnViewFollow,		&AppCmds::OnUIViewFollow,	-1)
+		CMD_ENTRY(ID_VIEW_AUTO_SCROLL,			&AppCmds::OnViewAutoScroll,	&AppCmds::OnUIViewAutoScroll,-1)
+		CMD_ENTRY(ID_VIEW_PROBLEMS,				&AppCmds::OnViewProblems,	&AppCmds::OnUIViewProblems,	-1)
 		// Help menu.
 		CMD_ENTRY(ID_HELP_ABOUT,				&AppCmds::OnHelpAbout,		nullptr,					10)
 	END_CMD_TABLE
@@ -70,6 +89,96 @@ void AppCmds::OnFileOpen()
 	OpenFile();
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! Open the first part of an existing document.
+
+void AppCmds::OnFileOpenPreview()
+{
+	App.m_bOpenPreview = true;
+
+	OpenFile();
+
+	App.m_bOpenPreview = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Open an existing document in the compact read-only form.
+
+void AppCmds::OnFileOpenCompact()
+{
+	App.m_bOpenCompact = true;
+
+	OpenFile();
+
+	App.m_bOpenCompact = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Compare the document with another file and show the differences.
+
+void AppCmds::OnFileCompare()
+{
+	ASSERT(App.Document() != nullptr);
+	ASSERT(App.Document()->IsEditable());
+
+	TheDoc* pDoc = App.Document();
+	CPath   strPath;
+
+	if (!strPath.Select(App.m_oAppWnd, CPath::OpenFile, App.FileExts(), App.DefFileExt()))
+		return;
+
+	XML::DocumentPtr      pOther;
+	StructuralDiff::Items vecItems;
+	bool                  bComplete = false;
+
+	try
+	{
+		CBusyCursor busyCursor;
+
+		bComplete = pDoc->CompareWith(strPath, pOther, vecItems);
+	}
+	catch (const Core::Exception& e)
+	{
+		App.AlertMsg(TXT("Failed to compare the documents:-\n\n%s"), e.twhat());
+		return;
+	}
+	catch (const std::exception& e)
+	{
+		App.AlertMsg(TXT("Failed to compare the documents:-\n\n%hs"), e.what());
+		return;
+	}
+
+	tstring strLeft  = static_cast<const tchar*>(pDoc->Path().FileName());
+	tstring strRight = static_cast<const tchar*>(strPath.FileName());
+
+	CompareDlg dlgCompare(strLeft, strRight, vecItems, bComplete);
+
+	if ( (dlgCompare.RunModal(App.m_oAppWnd) == IDOK) && (dlgCompare.m_pSelection.get() != nullptr) )
+		pDoc->View()->SetSelection(dlgCompare.m_pSelection);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Load the next part of a previewed document.
+
+void AppCmds::OnFileLoadMore()
+{
+	ASSERT(App.Document() != nullptr);
+
+	TheDoc* pDoc = App.Document();
+
+	if (!pDoc->IsPartial())
+		return;
+
+	CBusyCursor                   busyCursor;
+	IncrementalReader::NodeChain  vecTruncated = pDoc->TruncatedElements();
+	IncrementalReader::AddedNodes vecAdded;
+
+	if (pDoc->LoadMore(vecAdded))
+		pDoc->View()->OnNodesAdded(vecAdded, vecTruncated);
+
+	UpdateUI();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! Save the current document.
 
@@ -110,6 +219,32 @@ void AppCmds::OnFileExit()
 	App.m_oAppWnd.Close();
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! Undo the last edit.
+
+void AppCmds::OnEditUndo()
+{
+	ASSERT(App.m_pDoc != nullptr);
+
+	if (!App.Document()->IsEditable())
+		return;
+
+	App.Document()->History().Undo();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Redo the last edit undone.
+
+void AppCmds::OnEditRedo()
+{
+	ASSERT(App.m_pDoc != nullptr);
+
+	if (!App.Document()->IsEditable())
+		return;
+
+	App.Document()->History().Redo();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! Find the first node that matches an XPath expression.
 
@@ -125,15 +260,39 @@ void AppCmds::OnEditFind()
 	if (dlgFind.RunModal(App.m_oAppWnd) == IDOK)
 	{
 		App.m_lstQueryNodes.clear();
+		App.m_lstQueryIndices.clear();
+
+		TheDoc* pDoc = App.Document();
 
 		try
 		{
-			// Evaluate the expression.
-			XML::XPathIterator it(dlgFind.m_strQuery, App.Document()->DOM());
-			XML::XPathIterator end;
-
-			for (; it != end; ++it)
-				App.m_lstQueryNodes.push_back(*it);
+			CBusyCursor busyCursor;
+
+			if (pDoc->IsCompact())
+			{
+				CompactDoc::NodeIndices vecIndices;
+
+				// Only simple name tests are supported by the compact form.
+				if (!pDoc->Compact().Query(dlgFind.m_strQuery, vecIndices))
+				{
+					App.NotifyMsg(TXT("Only simple name queries, e.g. //name[@attr='value'], are supported for compact documents"));
+					return;
+				}
+
+				App.m_lstQueryIndices.assign(vecIndices.begin(), vecIndices.end());
+			}
+			// Simple name tests are answered by the name index.
+			else if (!pDoc->Index().Query(dlgFind.m_strQuery, App.m_lstQueryNodes))
+			{
+				// Evaluate the expression against the current text.
+				pDoc->Editor().FlattenText();
+
+				XML::XPathIterator it(dlgFind.m_strQuery, pDoc->DOM());
+				XML::XPathIterator end;
+
+				for (; it != end; ++it)
+					App.m_lstQueryNodes.push_back(*it);
+			}
 
 			// Remember valid queries.
 			App.m_strLastSearch = dlgFind.m_strQuery;
@@ -145,7 +304,7 @@ void AppCmds::OnEditFind()
 		}
 
 		// No results?
-		if (App.m_lstQueryNodes.empty())
+		if ( (App.m_lstQueryNodes.empty()) && (App.m_lstQueryIndices.empty()) )
 		{
 			App.NotifyMsg(TXT("The query did not match any nodes"));
 			return;
@@ -173,6 +332,148 @@ void AppCmds::OnEditFindNext()
 		// Display it.
 		App.Document()->View()->SetSelection(pNode);
 	}
+	else if (!App.m_lstQueryIndices.empty())
+	{
+		// Get head and move to tail.
+		CompactDoc::NodeIndex nNode = App.m_lstQueryIndices.front();
+
+		App.m_lstQueryIndices.pop_front();
+		App.m_lstQueryIndices.push_back(nNode);
+
+		// Display it.
+		App.Document()->View()->SetSelection(nNode);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Apply an edit to every node that matches an XPath expression.
+
+void AppCmds::OnEditBulkEdit()
+{
+	ASSERT(App.Document() != nullptr);
+
+	BulkEditDlg dlgBulkEdit;
+
+	dlgBulkEdit.m_oEdit = App.m_oLastBulkEdit;
+
+	// Query user for the edit.
+	if (dlgBulkEdit.RunModal(App.m_oAppWnd) == IDOK)
+	{
+		size_t nNodes = 0;
+
+		try
+		{
+			CBusyCursor busyCursor;
+
+			nNodes = App.Document()->ApplyBulkEdit(dlgBulkEdit.m_oEdit);
+
+			// Remember valid edits.
+			App.m_oLastBulkEdit = dlgBulkEdit.m_oEdit;
+		}
+		catch (const Core::Exception& e)
+		{
+			App.AlertMsg(TXT("Failed to apply the bulk edit:-\n\n%s"), e.twhat());
+			return;
+		}
+
+		// No results?
+		if (nNodes == 0)
+			App.NotifyMsg(TXT("The query did not match any nodes that can be edited"));
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Copy the selected node to the clipboard.
+
+void AppCmds::OnEditCopy()
+{
+	ASSERT(App.Document() != nullptr);
+
+	TheDoc*  pDoc  = App.Document();
+	TheView* pView = pDoc->View();
+
+	if (pView->ForwardToValue(WM_COPY))
+		return;
+
+	XML::NodePtr pNode = (!pDoc->IsCompact()) ? pView->Selection() : XML::NodePtr();
+
+	if (pNode.get() == nullptr)
+	{
+		App.NotifyMsg(TXT("There is no node selected that can be copied"));
+		return;
+	}
+
+	try
+	{
+		CBusyCursor busyCursor;
+
+		pDoc->Editor().FlattenText();
+
+		if (!App.m_oClipboard.Copy(App.m_oAppWnd.Handle(), pNode))
+		{
+			App.NotifyMsg(TXT("Only elements and the nodes inside them can be copied"));
+			return;
+		}
+	}
+	catch (const Core::Exception& e)
+	{
+		App.AlertMsg(TXT("Failed to copy the node:-\n\n%s"), e.twhat());
+		return;
+	}
+
+	UpdateUI();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Paste a node from the clipboard, after the selected node or, if that is an
+//! element, as its last child.
+
+void AppCmds::OnEditPaste()
+{
+	ASSERT(App.Document() != nullptr);
+
+	TheDoc*  pDoc  = App.Document();
+	TheView* pView = pDoc->View();
+
+	if (pView->ForwardToValue(WM_PASTE))
+		return;
+
+	XML::NodePtr pSelection = (!pDoc->IsCompact()) ? pView->Selection() : XML::NodePtr();
+
+	if (pSelection.get() == nullptr)
+	{
+		App.NotifyMsg(TXT("There is no node selected to paste next to"));
+		return;
+	}
+
+	XML::NodePtr pNode;
+
+	try
+	{
+		CBusyCursor busyCursor;
+
+		DWORD dwStart = ::GetTickCount();
+
+		pNode = NodeClipboard::Paste(App.m_oAppWnd.Handle(), pDoc->Editor().Arena());
+
+		if (pNode.get() == nullptr)
+			return;
+
+		if (!pDoc->PasteNode(pSelection, pNode))
+		{
+			App.NotifyMsg(TXT("Nodes can only be pasted inside an element"));
+			return;
+		}
+
+		TRACE1(TXT("Pasted a node in %u ms\n"), ::GetTickCount() - dwStart);
+	}
+	catch (const Core::Exception& e)
+	{
+		App.AlertMsg(TXT("Failed to paste the node:-\n\n%s"), e.twhat());
+		return;
+	}
+
+	pView->SetSelection(pNode);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -208,19 +509,32 @@ void AppCmds::OnViewNodePath()
 {
 	tstring strPath;
 
-	// Derive the simple path.
-	XML::NodePtr pNode = App.Document()->View()->Selection();
+	if (App.Document()->IsCompact())
+	{
+		const CompactDoc&     oDoc  = App.Document()->Compact();
+		CompactDoc::NodeIndex nNode = App.Document()->View()->SelectedIndex();
 
-	while (pNode.get() != nullptr)
+		// Derive the simple path.
+		for (; nNode != CompactDoc::NO_NODE; nNode = oDoc.Parent(nNode))
+		{
+			if (oDoc.Type(nNode) == XML::ELEMENT_NODE)
+				strPath = TXT("/") + oDoc.Name(nNode) + strPath;
+		}
+	}
+	else
 	{
-		if (pNode->type() == XML::ELEMENT_NODE)
+		// Derive the simple path.
+		XML::NodePtr pSelection = App.Document()->View()->Selection();
+		NodeRef      pNode      = pSelection;
+
+		// The ancestors are kept alive by the document.
+		while (pNode.get() != nullptr)
 		{
-			XML::ElementNodePtr pElemNode = Core::static_ptr_cast<XML::ElementNode>(pNode);
+			if (pNode->type() == XML::ELEMENT_NODE)
+				strPath = TXT("/") + pNode.As<XML::ElementNode>()->name() + strPath;
 
-			strPath = TXT("/") + pElemNode->name() + strPath;
+			pNode = pNode->parent();
 		}
-
-		pNode = pNode->parent();
 	}
 
 	// Display it.
@@ -231,6 +545,110 @@ void AppCmds::OnViewNodePath()
 	dlgPath.RunModal(App.m_oAppWnd);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! Summarise the structure of the document.
+
+void AppCmds::OnViewStructure()
+{
+	ASSERT(App.Document() != nullptr);
+
+	StructureDlg dlgStructure;
+
+	try
+	{
+		CBusyCursor busyCursor;
+
+		App.Document()->AnalyseStructure(dlgStructure.m_vecSummary);
+	}
+	catch (const std::exception& e)
+	{
+		App.AlertMsg(TXT("Failed to analyse the document structure:-\n\n%hs"), e.what());
+		return;
+	}
+
+	if (dlgStructure.m_vecSummary.empty())
+	{
+		App.NotifyMsg(TXT("The document has no elements to analyse"));
+		return;
+	}
+
+	dlgStructure.RunModal(App.m_oAppWnd);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Show the largest element sub-trees and select the one chosen, if any.
+
+void AppCmds::OnViewSubtrees()
+{
+	ASSERT(App.Document() != nullptr);
+	ASSERT(App.Document()->IsEditable());
+
+	const SubtreeProfile* pProfile = nullptr;
+
+	try
+	{
+		CBusyCursor busyCursor;
+
+		pProfile = &App.Document()->Profile();
+	}
+	catch (const std::exception& e)
+	{
+		App.AlertMsg(TXT("Failed to measure the document subtrees:-\n\n%hs"), e.what());
+		return;
+	}
+
+	SubtreesDlg dlgSubtrees(*pProfile);
+
+	if ( (dlgSubtrees.RunModal(App.m_oAppWnd) == IDOK) && (dlgSubtrees.m_pSelection.get() != nullptr) )
+		App.Document()->View()->SetSelection(dlgSubtrees.m_pSelection);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Toggle following the file for appended content.
+
+void AppCmds::OnViewFollow()
+{
+	ASSERT(App.Document() != nullptr);
+
+	TheDoc* pDoc = App.Document();
+
+	if (pDoc->IsFollowing())
+	{
+		pDoc->View()->StopFollowing();
+	}
+	else
+	{
+		CBusyCursor busyCursor;
+
+		pDoc->View()->StartFollowing();
+	}
+
+	UpdateUI();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Toggle scrolling to the newest record when following.
+
+void AppCmds::OnViewAutoScroll()
+{
+	App.m_bAutoScroll = !App.m_bAutoScroll;
+
+	UpdateUI();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Toggle showing the problems found by validating the document.
+
+void AppCmds::OnViewProblems()
+{
+	App.m_bShowProblems = !App.m_bShowProblems;
+
+	if (App.m_pDoc != nullptr)
+		App.Document()->View()->ShowProblems(App.m_bShowProblems);
+
+	UpdateUI();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! Show the about dialog.
 
@@ -253,15 +671,23 @@ void AppCmds::OnUIFileNew()
 ////////////////////////////////////////////////////////////////////////////////
 //! Update the command UI.
 
+void AppCmds::OnUIFileLoadMore()
+{
+	bool bPartial = ( (App.Document() != nullptr) && (App.Document()->IsPartial()) );
+
+	App.m_oAppWnd.m_oMenu.EnableCmd(ID_FILE_LOAD_MORE, bPartial);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Update the command UI.
+
 void AppCmds::OnUIFileSave()
 {
-//	bool bDocOpen  = (App.m_pDoc != nullptr);
-//	bool bModified = (bDocOpen && App.m_pDoc->Modified());
+	bool bEditable = ( (App.m_pDoc != nullptr) && (App.Document()->IsEditable()) );
+	bool bModified = (bEditable && App.m_pDoc->Modified());
 
-//	App.m_oAppWnd.m_oMenu.EnableCmd(ID_FILE_SAVE, (bDocOpen && bModified));
-//	App.m_oAppWnd.m_oToolbar.m_btnSave.Enable(bDocOpen && bModified);
-	App.m_oAppWnd.m_oMenu.EnableCmd(ID_FILE_SAVE, false);
-	App.m_oAppWnd.m_oToolbar.m_btnSave.Enable(false);
+	App.m_oAppWnd.m_oMenu.EnableCmd(ID_FILE_SAVE, bModified);
+	App.m_oAppWnd.m_oToolbar.m_btnSave.Enable(bModified);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -269,10 +695,9 @@ void AppCmds::OnUIFileSave()
 
 void AppCmds::OnUIFileSaveAs()
 {
-//	bool bDocOpen = (App.m_pDoc != nullptr);
+	bool bEditable = ( (App.m_pDoc != nullptr) && (App.Document()->IsEditable()) );
 
-//	App.m_oAppWnd.m_oMenu.EnableCmd(ID_FILE_SAVEAS, bDocOpen);
-	App.m_oAppWnd.m_oMenu.EnableCmd(ID_FILE_SAVEAS, false);
+	App.m_oAppWnd.m_oMenu.EnableCmd(ID_FILE_SAVEAS, bEditable);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -296,6 +721,26 @@ void AppCmds::OnUIFileOpenMRU()
 ////////////////////////////////////////////////////////////////////////////////
 //! Update the command UI.
 
+void AppCmds::OnUIEditUndo()
+{
+	bool bCanUndo = ( (App.m_pDoc != nullptr) && (App.Document()->IsEditable()) && (App.Document()->History().CanUndo()) );
+
+	App.m_oAppWnd.m_oMenu.EnableCmd(ID_EDIT_UNDO, bCanUndo);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Update the command UI.
+
+void AppCmds::OnUIEditRedo()
+{
+	bool bCanRedo = ( (App.m_pDoc != nullptr) && (App.Document()->IsEditable()) && (App.Document()->History().CanRedo()) );
+
+	App.m_oAppWnd.m_oMenu.EnableCmd(ID_EDIT_REDO, bCanRedo);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Update the command UI.
+
 void AppCmds::OnUIEditFind()
 {
 	bool bDocOpen = (App.m_pDoc != nullptr);
@@ -316,6 +761,36 @@ void AppCmds::OnUIEditFindNext()
 ////////////////////////////////////////////////////////////////////////////////
 //! Update the command UI.
 
+void AppCmds::OnUIEditBulkEdit()
+{
+	bool bEditable = ( (App.m_pDoc != nullptr) && (App.Document()->IsEditable()) );
+
+	App.m_oAppWnd.m_oMenu.EnableCmd(ID_EDIT_BULK_EDIT, bEditable);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Update the command UI.
+
+void AppCmds::OnUIEditCopy()
+{
+	bool bDocOpen = (App.m_pDoc != nullptr);
+
+	App.m_oAppWnd.m_oMenu.EnableCmd(ID_EDIT_COPY, bDocOpen);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Update the command UI.
+
+void AppCmds::OnUIEditPaste()
+{
+	bool bCanPaste = ( (App.m_pDoc != nullptr) && (App.Document()->IsEditable()) && (NodeClipboard::CanPaste()) );
+
+	App.m_oAppWnd.m_oMenu.EnableCmd(ID_EDIT_PASTE, bCanPaste);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Update the command UI.
+
 void AppCmds::OnUIViewHorz()
 {
 	bool docOpen  = (App.m_pDoc != nullptr);
@@ -346,3 +821,61 @@ void AppCmds::OnUIViewNodePath()
 
 	App.m_oAppWnd.m_oMenu.EnableCmd(ID_VIEW_NODE_PATH, bDocOpen);
 }
+
+////////////////////////////////////////////////////////////////////////////////
+//! Update the command UI.
+
+void AppCmds::OnUIViewStructure()
+{
+	bool bDocOpen = (App.m_pDoc != nullptr);
+
+	App.m_oAppWnd.m_oMenu.EnableCmd(ID_VIEW_STRUCTURE, bDocOpen);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Update the command UI.
+
+void AppCmds::OnUIViewSubtrees()
+{
+	bool bEditable = ( (App.m_pDoc != nullptr) && (App.Document()->IsEditable()) );
+
+	App.m_oAppWnd.m_oMenu.EnableCmd(ID_VIEW_SUBTREES, bEditable);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Update the command UI.
+
+void AppCmds::OnUIFileCompare()
+{
+	bool bEditable = ( (App.m_pDoc != nullptr) && (App.Document()->IsEditable()) );
+
+	App.m_oAppWnd.m_oMenu.EnableCmd(ID_FILE_COMPARE, bEditable);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Update the command UI.
+
+void AppCmds::OnUIViewFollow()
+{
+	bool bDocOpen   = (App.m_pDoc != nullptr);
+	bool bFollowing = (bDocOpen && App.Document()->IsFollowing());
+
+	App.m_oAppWnd.m_oMenu.EnableCmd(ID_VIEW_FOLLOW, bDocOpen);
+	App.m_oAppWnd.m_oMenu.CheckCmd(ID_VIEW_FOLLOW, bFollowing);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Update the command UI.
+
+void AppCmds::OnUIViewAutoScroll()
+{
+	App.m_oAppWnd.m_oMenu.CheckCmd(ID_VIEW_AUTO_SCROLL, App.m_bAutoScroll);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Update the command UI.
+
+void AppCmds::OnUIViewProblems()
+{
+	App.m_oAppWnd.m_oMenu.CheckCmd(ID_VIEW_PROBLEMS, App.m_bShowProblems);
+}
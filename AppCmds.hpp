@@ -38,6 +38,18 @@ public:
 	//! Open an existing document.
 	void OnFileOpen();
 
+	//! Open the first part of an existing document.
+	void OnFileOpenPreview();
+
+	//! Open an existing document in the compact read-only form.
+	void OnFileOpenCompact();
+
+	//! Compare the document with another file.
+	void OnFileCompare();
+
+	//! Load the next part of a previewed document.
+	void OnFileLoadMore();
+
 	//! Save the current document.
 	void OnFileSave();
 
@@ -53,12 +65,27 @@ public:
 	//! Close the application.
 	void OnFileExit();
 
+	//! Undo the last edit.
+	void OnEditUndo();
+
+	//! Redo the last edit undone.
+	void OnEditRedo();
+
 	//! Find the first node that matches an XPath expression.
 	void OnEditFind();
 
 	//! Find the next node that matches the previous expression.
 	void OnEditFindNext();
 
+	//! Apply an edit to every node that matches an XPath expression.
+	void OnEditBulkEdit();
+
+	//! Copy the selected node to the clipboard.
+	void OnEditCopy();
+
+	//! Paste a node from the clipboard.
+	void OnEditPaste();
+
 	//! Change the layout to the horizontal one.
 	void OnViewHorz();
 
@@ -68,6 +95,21 @@ public:
 	//! Show the full path to the select node.
 	void OnViewNodePath();
 
+	//! Summarise the structure of the document.
+	void OnViewStructure();
+
+	//! Show the largest element sub-trees.
+	void OnViewSubtrees();
+
+	//! Toggle following the file for appended content.
+	void OnViewFollow();
+
+	//! Toggle scrolling to the newest record when following.
+	void OnViewAutoScroll();
+
+	//! Toggle showing the validation problems.
+	void OnViewProblems();
+
 	//! Show the about dialog.
 	void OnHelpAbout();
 
@@ -78,6 +120,9 @@ public:
 	//! Update the command UI.
 	void OnUIFileNew();
 
+	//! Update the command UI.
+	void OnUIFileLoadMore();
+
 	//! Update the command UI.
 	void OnUIFileSave();
 
@@ -90,12 +135,27 @@ public:
 	//! Update the command UI.
 	void OnUIFileOpenMRU();
 
+	//! Update the command UI.
+	void OnUIEditUndo();
+
+	//! Update the command UI.
+	void OnUIEditRedo();
+
 	//! Update the command UI.
 	void OnUIEditFind();
 
 	//! Update the command UI.
 	void OnUIEditFindNext();
 
+	//! Update the command UI.
+	void OnUIEditBulkEdit();
+
+	//! Update the command UI.
+	void OnUIEditCopy();
+
+	//! Update the command UI.
+	void OnUIEditPaste();
+
 	//! Update the command UI.
 	void OnUIViewHorz();
 
@@ -104,6 +164,24 @@ public:
 
 	//! Update the command UI.
 	void OnUIViewNodePath();
+
+	//! Update the command UI.
+	void OnUIViewStructure();
+
+	//! Update the command UI.
+	void OnUIViewSubtrees();
+
+	//! Update the command UI.
+	void OnUIFileCompare();
+
+	//! Update the command UI.
+	void OnUIViewFollow();
+
+	//! Update the command UI.
+	void OnUIViewAutoScroll();
+
+	//! Update the command UI.
+	void OnUIViewProblems();
 };
 
 #endif // APP_APPCMDS_HPP
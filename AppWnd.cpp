@@ -65,3 +65,40 @@ void AppWnd::OnActivate(bool bActivating)
 	if ( (bActivating) && (App.Document() != nullptr) )
 		App.Document()->View()->Activate();
 }
+
+////////////////////////////////////////////////////////////////////////////////
+//! Window procedure. The main window owns the clipboard after a copy, so it
+//! handles the requests to render the text of the copied nodes.
+
+LRESULT AppWnd::WndProc(HWND hWnd, UINT iMsg, WPARAM wParam, LPARAM lParam)
+{
+	switch (iMsg)
+	{
+		case WM_RENDERFORMAT:
+		{
+			try
+			{
+				App.m_oClipboard.RenderFormat(static_cast<UINT>(wParam));
+			}
+			catch (const Core::Exception& e)
+			{
+				TRACE1(TXT("Failed to render the clipboard: %s\n"), e.twhat());
+			}
+			return 0;
+		}
+
+		case WM_RENDERALLFORMATS:
+		{
+			App.m_oClipboard.RenderAllFormats(hWnd);
+			return 0;
+		}
+
+		case WM_DESTROYCLIPBOARD:
+		{
+			App.m_oClipboard.Release();
+			return 0;
+		}
+	}
+
+	return CSDIFrame::WndProc(hWnd, iMsg, wParam, lParam);
+}
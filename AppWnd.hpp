@@ -61,6 +61,9 @@ private:
 
 	//! Handle the window being activated.
 	virtual void OnActivate(bool bActivating);
+
+	//! Window procedure.
+	virtual LRESULT WndProc(HWND hWnd, UINT iMsg, WPARAM wParam, LPARAM lParam);
 };
 
 #endif // APP_APPWND_HPP
@@ -0,0 +1,88 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   ArenaBench.cpp
+//! \brief  The benchmark for the DocArena class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "Benchmarks.hpp"
+#include "DocArena.hpp"
+#include <XML/Document.hpp>
+#include <XML/ElementNode.hpp>
+#include <XML/TextNode.hpp>
+
+//! The number of elements in the generated document.
+static const size_t ARENA_ELEMENTS = 1000000;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Build a document with a root and the given number of child elements, each
+//! with an attribute and some text.
+
+static XML::DocumentPtr BuildDocument(size_t nElements)
+{
+	XML::DocumentPtr    pDocument(new XML::Document);
+	XML::ElementNodePtr pRoot(new XML::ElementNode(TXT("root")));
+
+	pDocument->appendChild(pRoot);
+
+	for (size_t i = 0; i != nElements; ++i)
+	{
+		XML::ElementNodePtr pElement(new XML::ElementNode(TXT("record")));
+
+		pElement->getAttributes().set(TXT("id"), Core::fmt(TXT("%u"), static_cast<uint>(i)));
+		pElement->appendChild(XML::NodePtr(new XML::TextNode(TXT("Some text for the record"))));
+
+		pRoot->appendChild(pElement);
+	}
+
+	return pDocument;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Time building and releasing a document, with or without an arena. The
+//! document is released in the same order as TheDoc::ReleaseDOM().
+
+static void TimeDocument(size_t nElements, bool bArena, DWORD& dwBuild, DWORD& dwRelease)
+{
+	DWORD            dwStart = ::GetTickCount();
+	DocArena*        pArena  = (bArena) ? new DocArena : nullptr;
+	XML::DocumentPtr pDocument;
+
+	{
+		DocArena::Scope oScope(pArena);
+
+		pDocument = BuildDocument(nElements);
+	}
+
+	dwBuild = ::GetTickCount() - dwStart;
+	dwStart = ::GetTickCount();
+
+	delete pArena;
+	pDocument.reset();
+
+	dwRelease = ::GetTickCount() - dwStart;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Time building and releasing a large document with and without an arena.
+
+void ArenaBenchmark()
+{
+	for (int nArena = 0; nArena != 2; ++nArena)
+	{
+		DWORD dwBestBuild   = ULONG_MAX;
+		DWORD dwBestRelease = ULONG_MAX;
+
+		for (size_t nRun = 0; nRun != BENCHMARK_RUNS; ++nRun)
+		{
+			DWORD dwBuild, dwRelease;
+
+			TimeDocument(ARENA_ELEMENTS, (nArena != 0), dwBuild, dwRelease);
+
+			dwBestBuild   = std::min(dwBestBuild, dwBuild);
+			dwBestRelease = std::min(dwBestRelease, dwRelease);
+		}
+
+		_tprintf(TXT("  %u elements, %s: build %u ms, release %u ms\n"), static_cast<uint>(ARENA_ELEMENTS),
+					(nArena != 0) ? TXT("arena") : TXT("CRT heap"), dwBestBuild, dwBestRelease);
+	}
+}
@@ -0,0 +1,60 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   Bench.cpp
+//! \brief  The benchmark runner for the application's non-UI classes.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "Benchmarks.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+//! A benchmark that can be selected on the command line.
+
+struct Benchmark
+{
+	const tchar*	m_pszName;		//!< The name used to select it.
+	void			(*m_pfnRun)();	//!< The function that runs it.
+};
+
+//! The benchmarks, in the order they are run.
+static const Benchmark BENCHMARKS[] =
+{
+	{ TXT("arena"),		ArenaBenchmark		},
+	{ TXT("scan"),		ScanBenchmark		},
+	{ TXT("decode"),	DecodeBenchmark		},
+	{ TXT("parallel"),	ParallelBenchmark	},
+};
+
+//! The number of benchmarks.
+static const size_t NUM_BENCHMARKS = sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0]);
+
+////////////////////////////////////////////////////////////////////////////////
+//! The entry point for the benchmark runner. The benchmarks named on the
+//! command line are run, or all of them if none are.
+
+int _tmain(int argc, tchar* argv[])
+{
+	for (size_t i = 0; i != NUM_BENCHMARKS; ++i)
+	{
+		bool bSelected = (argc < 2);
+
+		for (int nArg = 1; (nArg < argc) && (!bSelected); ++nArg)
+			bSelected = (tstricmp(argv[nArg], BENCHMARKS[i].m_pszName) == 0);
+
+		if (!bSelected)
+			continue;
+
+		_tprintf(TXT("Benchmark: %s\n"), BENCHMARKS[i].m_pszName);
+
+		try
+		{
+			BENCHMARKS[i].m_pfnRun();
+		}
+		catch (const Core::Exception& e)
+		{
+			_tprintf(TXT("  Failed: %s\n"), e.twhat());
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,29 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   Benchmarks.hpp
+//! \brief  The benchmark function declarations.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef BENCH_BENCHMARKS_HPP
+#define BENCH_BENCHMARKS_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+//! The number of times each measurement is repeated, the fastest being kept.
+const size_t BENCHMARK_RUNS = 3;
+
+//! Time building and releasing a large document with and without an arena.
+void ArenaBenchmark();
+
+//! Time FastScan::Find() against a scalar loop for both sizes of character.
+void ScanBenchmark();
+
+//! Time decoding 7-bit ASCII markup with TextDecoder against a scalar loop.
+void DecodeBenchmark();
+
+//! Time parsing a large record-shaped document on 1 to 16 threads.
+void ParallelBenchmark();
+
+#endif // BENCH_BENCHMARKS_HPP
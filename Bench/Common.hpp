@@ -0,0 +1,20 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   Common.hpp
+//! \brief  Wrapper include file for the most common header files.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef BENCH_COMMON_HPP
+#define BENCH_COMMON_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// System headers.
+
+#include <Core/Common.hpp>		// Core library common headers.
+#include <WCL/Common.hpp>		// Windows C++ library common headers.
+
+#endif // BENCH_COMMON_HPP
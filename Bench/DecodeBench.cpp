@@ -0,0 +1,108 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DecodeBench.cpp
+//! \brief  The benchmark for the TextDecoder class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "Benchmarks.hpp"
+#include "TextDecoder.hpp"
+#include <Core/RuntimeException.hpp>
+
+//! The number of bytes decoded.
+static const size_t DECODE_BYTES = 64 * 1024 * 1024;
+
+//! The size of the blocks the bytes are decoded in, as read from a file.
+static const size_t DECODE_BLOCK_SIZE = 64 * 1024;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Fill a buffer with records of 7-bit ASCII markup.
+
+static void FillMarkup(std::vector<byte>& vecBytes, size_t nBytes)
+{
+	const char* pszRecord = "<record id=\"42\">Some text for the record</record>\n";
+	size_t      nLength   = strlen(pszRecord);
+
+	vecBytes.resize(nBytes);
+
+	for (size_t i = 0; i != nBytes; ++i)
+		vecBytes[i] = static_cast<byte>(pszRecord[i % nLength]);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Widen the bytes one at a time, as the decoder would without FastScan.
+
+static void DecodeScalar(const std::vector<byte>& vecBytes, tstring& strText)
+{
+	for (size_t nOffset = 0; nOffset != vecBytes.size(); )
+	{
+		size_t nBlock = std::min(DECODE_BLOCK_SIZE, vecBytes.size() - nOffset);
+
+		for (size_t i = nOffset; i != nOffset + nBlock; ++i)
+			strText += static_cast<tchar>(vecBytes[i]);
+
+		nOffset += nBlock;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Decode the bytes as UTF-8 in file sized blocks.
+
+static void DecodeUtf8(const std::vector<byte>& vecBytes, tstring& strText)
+{
+	TextDecoder oDecoder(TextDecoder::UTF_8);
+
+	for (size_t nOffset = 0; nOffset != vecBytes.size(); )
+	{
+		size_t      nBlock = std::min(DECODE_BLOCK_SIZE, vecBytes.size() - nOffset);
+		const byte* pBlock = &vecBytes[nOffset];
+
+		oDecoder.Decode(pBlock, pBlock + nBlock, strText);
+
+		nOffset += nBlock;
+	}
+
+	oDecoder.Finish(strText);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Time a decoder, returning the best rate in MB/s of input.
+
+static uint TimeDecode(const std::vector<byte>& vecBytes, void (*pfnDecode)(const std::vector<byte>&, tstring&))
+{
+	DWORD   dwBest = ULONG_MAX;
+	tstring strText;
+
+	// The text is reused so that only the first run pays for faulting it in.
+	strText.reserve(vecBytes.size());
+
+	for (size_t nRun = 0; nRun != BENCHMARK_RUNS; ++nRun)
+	{
+		strText.erase();
+
+		DWORD dwStart = ::GetTickCount();
+
+		pfnDecode(vecBytes, strText);
+
+		dwBest = std::min(dwBest, ::GetTickCount() - dwStart);
+
+		if (strText.size() != vecBytes.size())
+			throw Core::RuntimeException(TXT("The decoded text is the wrong length"));
+	}
+
+	uint64 nBytes = vecBytes.size();
+
+	return static_cast<uint>((nBytes * 1000) / (static_cast<uint64>(std::max<DWORD>(dwBest, 1)) * 1024 * 1024));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Time decoding 7-bit ASCII markup with TextDecoder against a scalar loop.
+
+void DecodeBenchmark()
+{
+	std::vector<byte> vecBytes;
+
+	FillMarkup(vecBytes, DECODE_BYTES);
+
+	_tprintf(TXT("  ASCII: scalar %u MB/s, TextDecoder %u MB/s\n"),
+				TimeDecode(vecBytes, DecodeScalar), TimeDecode(vecBytes, DecodeUtf8));
+}
@@ -0,0 +1,83 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   ParallelBench.cpp
+//! \brief  The benchmark for the ParallelReader class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "Benchmarks.hpp"
+#include "ParallelReader.hpp"
+#include <XML/ElementNode.hpp>
+#include <Core/RuntimeException.hpp>
+
+//! The number of records in the generated document.
+static const size_t PARALLEL_RECORDS = 1000000;
+
+//! The largest number of threads measured.
+static const size_t MAX_PARALLEL_THREADS = 16;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Build the text of a document with a root and the given number of records.
+
+static tstring BuildText(size_t nRecords)
+{
+	tstring strText = TXT("<?xml version=\"1.0\"?>\n<root>\n");
+
+	for (size_t i = 0; i != nRecords; ++i)
+	{
+		strText += Core::fmt(TXT("<record id=\"%u\">"), static_cast<uint>(i));
+		strText += TXT("<name>Record</name><value>Some text for the record</value>");
+		strText += TXT("</record>\n");
+	}
+
+	strText += TXT("</root>\n");
+
+	return strText;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Time parsing the text with the given number of threads, returning the best
+//! time in ms.
+
+static DWORD TimeRead(const tstring& strText, size_t nThreads, size_t nRecords)
+{
+	DWORD dwBest = ULONG_MAX;
+
+	for (size_t nRun = 0; nRun != BENCHMARK_RUNS; ++nRun)
+	{
+		DWORD            dwStart = ::GetTickCount();
+		XML::DocumentPtr pDOM    = ParallelReader(strText, nThreads, nullptr).Read();
+
+		dwBest = std::min(dwBest, ::GetTickCount() - dwStart);
+
+		if (pDOM->getRootElement()->getChildCount() != nRecords)
+			throw Core::RuntimeException(TXT("The document has the wrong number of records"));
+	}
+
+	return dwBest;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Time parsing a large record-shaped document on 1 to 16 threads.
+
+void ParallelBenchmark()
+{
+	tstring     strText = BuildText(PARALLEL_RECORDS);
+	SYSTEM_INFO oInfo;
+
+	::GetSystemInfo(&oInfo);
+
+	_tprintf(TXT("  %u records, %u MB of text, %u processors\n"), static_cast<uint>(PARALLEL_RECORDS),
+				static_cast<uint>((strText.size() * sizeof(tchar)) / (1024 * 1024)), oInfo.dwNumberOfProcessors);
+
+	DWORD dwSequential = TimeRead(strText, 1, PARALLEL_RECORDS);
+
+	_tprintf(TXT("  1 thread: %u ms\n"), dwSequential);
+
+	for (size_t nThreads = 2; nThreads <= MAX_PARALLEL_THREADS; nThreads *= 2)
+	{
+		DWORD dwParallel = TimeRead(strText, nThreads, PARALLEL_RECORDS);
+
+		_tprintf(TXT("  %u threads: %u ms, speed-up %u.%02u\n"), static_cast<uint>(nThreads), dwParallel,
+					dwSequential / std::max<DWORD>(dwParallel, 1), ((dwSequential * 100) / std::max<DWORD>(dwParallel, 1)) % 100);
+	}
+}
@@ -0,0 +1,90 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   ScanBench.cpp
+//! \brief  The benchmark for the FastScan class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "Benchmarks.hpp"
+#include "FastScan.hpp"
+#include <Core/RuntimeException.hpp>
+
+//! The number of characters scanned.
+static const size_t SCAN_CHARS = 64 * 1024 * 1024;
+
+//! The number of times the characters are scanned per run.
+static const size_t SCAN_PASSES = 4;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Fill a buffer with lower case words separated by spaces.
+
+template<typename CharT>
+static void FillText(std::vector<CharT>& vecText, size_t nChars)
+{
+	vecText.resize(nChars);
+
+	for (size_t i = 0; i != nChars; ++i)
+		vecText[i] = static_cast<CharT>(((i % 8) == 7) ? ' ' : 'a' + (i % 26));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find a character one at a time, as the parsers did before FastScan.
+
+template<typename CharT>
+static const CharT* FindScalar(const CharT* pBegin, const CharT* pEnd, CharT cChar)
+{
+	for (const CharT* pCurrent = pBegin; pCurrent != pEnd; ++pCurrent)
+	{
+		if (*pCurrent == cChar)
+			return pCurrent;
+	}
+
+	return pEnd;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Time a search that runs to the end of the text, returning the best rate in
+//! MB/s.
+
+template<typename CharT, typename Finder>
+static uint TimeFind(const std::vector<CharT>& vecText, Finder pfnFind)
+{
+	const CharT* pBegin  = &vecText[0];
+	const CharT* pEnd    = pBegin + vecText.size();
+	DWORD        dwBest  = ULONG_MAX;
+	size_t       nMissed = 0;
+
+	for (size_t nRun = 0; nRun != BENCHMARK_RUNS; ++nRun)
+	{
+		DWORD dwStart = ::GetTickCount();
+
+		for (size_t nPass = 0; nPass != SCAN_PASSES; ++nPass)
+			nMissed += (pfnFind(pBegin, pEnd, static_cast<CharT>('<')) == pEnd) ? 1 : 0;
+
+		dwBest = std::min(dwBest, ::GetTickCount() - dwStart);
+	}
+
+	// Checking the result also stops the searches being optimised away.
+	if (nMissed != BENCHMARK_RUNS * SCAN_PASSES)
+		throw Core::RuntimeException(TXT("The search found a character that isn't in the text"));
+
+	uint64 nBytes = static_cast<uint64>(vecText.size()) * sizeof(CharT) * SCAN_PASSES;
+
+	return static_cast<uint>((nBytes * 1000) / (static_cast<uint64>(std::max<DWORD>(dwBest, 1)) * 1024 * 1024));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Time FastScan::Find() against a scalar loop for both sizes of character.
+
+void ScanBenchmark()
+{
+	std::vector<char>    vecNarrow;
+	std::vector<wchar_t> vecWide;
+
+	FillText(vecNarrow, SCAN_CHARS);
+	FillText(vecWide, SCAN_CHARS);
+
+	_tprintf(TXT("  char:    scalar %u MB/s, FastScan %u MB/s\n"),
+				TimeFind(vecNarrow, FindScalar<char>), TimeFind(vecNarrow, FastScan::Find<char>));
+	_tprintf(TXT("  wchar_t: scalar %u MB/s, FastScan %u MB/s\n"),
+				TimeFind(vecWide, FindScalar<wchar_t>), TimeFind(vecWide, FastScan::Find<wchar_t>));
+}
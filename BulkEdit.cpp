@@ -0,0 +1,210 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   BulkEdit.cpp
+//! \brief  The BulkEdit class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "BulkEdit.hpp"
+#include <XML/ElementNode.hpp>
+#include <XML/XPathIterator.hpp>
+#include <set>
+#include "DomEditor.hpp"
+#include "DocArena.hpp"
+#include "NodeCursor.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+BulkEdit::BulkEdit()
+	: m_eOperation(SET_ATTRIBUTE)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Apply the edit, returning the number of nodes edited. The changes are
+//! published as a single batch. Any text being edited in place is written back
+//! first so that the query sees it.
+
+size_t BulkEdit::Apply(DomEditor& oEditor, const XML::DocumentPtr& pDocument) const
+{
+	Targets vecTargets;
+
+	oEditor.FlattenText();
+	FindTargets(pDocument, vecTargets);
+
+	oEditor.BeginBatch();
+
+	try
+	{
+		for (Targets::const_reverse_iterator it = vecTargets.rbegin(); it != vecTargets.rend(); ++it)
+		{
+			if (m_eOperation == SET_ATTRIBUTE)
+				oEditor.SetAttribute(it->m_pNode, m_strName, m_strValue);
+			else if (m_eOperation == RENAME)
+				Rename(oEditor, *it);
+			else if (m_eOperation == DELETE_NODES)
+				oEditor.RemoveChild(it->m_pParent, it->m_nIndex);
+			else if (m_eOperation == WRAP)
+				Wrap(oEditor, *it);
+			else
+				ASSERT_FALSE();
+		}
+	}
+	catch (...)
+	{
+		oEditor.EndBatch();
+		throw;
+	}
+
+	oEditor.EndBatch();
+
+	return vecTargets.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the name of the edit, as shown to the user.
+
+tstring BulkEdit::Description() const
+{
+	if (m_eOperation == SET_ATTRIBUTE)
+		return TXT("Bulk Set Attribute");
+	else if (m_eOperation == RENAME)
+		return TXT("Bulk Rename");
+	else if (m_eOperation == DELETE_NODES)
+		return TXT("Bulk Delete");
+
+	return TXT("Bulk Wrap");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the nodes matched by the query that the operation applies to, in
+//! document order. The query is evaluated in full before the DOM is walked
+//! once to find the position of each match. The descendants of a node that is
+//! to be deleted are skipped as they go with it.
+
+void BulkEdit::FindTargets(const XML::DocumentPtr& pDocument, Targets& vecTargets) const
+{
+	typedef std::set<const XML::Node*> NodeSet;
+
+	NodeSet            setMatches;
+	XML::XPathIterator it(m_strQuery, pDocument);
+	XML::XPathIterator end;
+
+	for (; it != end; ++it)
+	{
+		XML::NodePtr pNode = *it;
+
+		if (!AppliesTo(*pNode))
+			continue;
+
+		// The position is only needed when the node is replaced or removed.
+		if (m_eOperation == SET_ATTRIBUTE)
+		{
+			Target oTarget = { pNode, XML::NodePtr(), 0 };
+
+			vecTargets.push_back(oTarget);
+		}
+		else
+		{
+			setMatches.insert(pNode.get());
+		}
+	}
+
+	size_t              nRemaining = setMatches.size();
+	std::vector<size_t> vecIndices;
+
+	for (NodeCursor oCursor(*pDocument); (nRemaining != 0) && (oCursor.Next()); )
+	{
+		size_t nDepth = oCursor.Depth();
+
+		// Track the position of the node in its container.
+		if (vecIndices.size() < nDepth)
+		{
+			vecIndices.push_back(0);
+		}
+		else
+		{
+			vecIndices.resize(nDepth);
+			++vecIndices.back();
+		}
+
+		NodeRef pNode = oCursor.Node();
+
+		if (setMatches.find(pNode.get()) == setMatches.end())
+			continue;
+
+		Target oTarget = { pNode.ToPtr(), pNode->parent(), vecIndices.back() };
+
+		vecTargets.push_back(oTarget);
+		--nRemaining;
+
+		if (m_eOperation == DELETE_NODES)
+			oCursor.SkipChildren();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the operation can be applied to a node. Only elements have names
+//! and attributes, and only an element can be wrapped at the document level
+//! as the wrapper must become the root element.
+
+bool BulkEdit::AppliesTo(const XML::Node& oNode) const
+{
+	XML::NodeType eType = oNode.type();
+
+	if ( (m_eOperation == SET_ATTRIBUTE) || (m_eOperation == RENAME) )
+		return (eType == XML::ELEMENT_NODE);
+
+	if (!oNode.hasParent())
+		return false;
+
+	if (m_eOperation == WRAP)
+		return ( (eType == XML::ELEMENT_NODE) || (oNode.parent()->type() == XML::ELEMENT_NODE) );
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Replace an element with one of another name. The new element is inserted
+//! before the old one, takes its attributes and children, and then the old one
+//! is removed. The children are moved as a whole so that an element with many
+//! of them costs the same three changes as one with none.
+
+void BulkEdit::Rename(DomEditor& oEditor, const Target& oTarget) const
+{
+	NodeRef      pOld = oTarget.m_pNode;
+	XML::NodePtr pNew;
+
+	{
+		DocArena::Scope oScope(oEditor.Arena());
+
+		XML::ElementNodePtr     pElement = XML::ElementNodePtr(new XML::ElementNode(m_strName));
+		const XML::Attributes&  vAttribs = pOld.As<XML::ElementNode>()->getAttributes();
+
+		for (XML::Attributes::const_iterator it = vAttribs.begin(); it != vAttribs.end(); ++it)
+			pElement->getAttributes().set((*it)->name(), (*it)->value());
+
+		pNew = pElement;
+	}
+
+	oEditor.InsertNode(oTarget.m_pParent, oTarget.m_nIndex, pNew);
+	oEditor.MoveChildren(pOld, pNew);
+	oEditor.RemoveChild(oTarget.m_pParent, oTarget.m_nIndex+1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Wrap a node in a new element.
+
+void BulkEdit::Wrap(DomEditor& oEditor, const Target& oTarget) const
+{
+	XML::NodePtr pWrapper;
+
+	{
+		DocArena::Scope oScope(oEditor.Arena());
+
+		pWrapper = XML::ElementNodePtr(new XML::ElementNode(m_strName));
+	}
+
+	oEditor.InsertNode(oTarget.m_pParent, oTarget.m_nIndex, pWrapper);
+	oEditor.MoveChild(oTarget.m_pParent, oTarget.m_nIndex+1, pWrapper, 0);
+}
@@ -0,0 +1,81 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   BulkEdit.hpp
+//! \brief  The BulkEdit class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_BULKEDIT_HPP
+#define APP_BULKEDIT_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <XML/Document.hpp>
+
+// Forward declarations.
+class DomEditor;
+
+////////////////////////////////////////////////////////////////////////////////
+//! An edit applied to every node matched by an XPath expression. The matches
+//! are found before any change is made and then edited in reverse document
+//! order, so that the position of each one in its container is still valid
+//! when it is reached and nested matches are edited before their ancestors.
+
+struct BulkEdit
+{
+	//! The operations that can be applied.
+	enum Operation
+	{
+		SET_ATTRIBUTE,	//!< Set an attribute on each element.
+		RENAME,			//!< Rename each element.
+		DELETE_NODES,	//!< Delete each node.
+		WRAP,			//!< Wrap each node in a new element.
+	};
+
+	Operation	m_eOperation;	//!< The operation to apply.
+	tstring		m_strQuery;		//!< The XPath expression to match.
+	tstring		m_strName;		//!< The attribute or element name.
+	tstring		m_strValue;		//!< The attribute value.
+
+	//! Default constructor.
+	BulkEdit();
+
+	//! Apply the edit, returning the number of nodes edited.
+	size_t Apply(DomEditor& oEditor, const XML::DocumentPtr& pDocument) const;
+
+	//! Get the name of the edit, as shown to the user.
+	tstring Description() const;
+
+private:
+	////////////////////////////////////////////////////////////////////////////
+	//! A matched node and its position.
+
+	struct Target
+	{
+		XML::NodePtr	m_pNode;	//!< The matched node.
+		XML::NodePtr	m_pParent;	//!< The container it is in.
+		size_t			m_nIndex;	//!< Its position in the container.
+	};
+
+	//! The collection of targets.
+	typedef std::vector<Target> Targets;
+
+	//
+	// Internal methods.
+	//
+
+	//! Find the nodes matched by the query that the operation applies to.
+	void FindTargets(const XML::DocumentPtr& pDocument, Targets& vecTargets) const;
+
+	//! Query if the operation can be applied to a node.
+	bool AppliesTo(const XML::Node& oNode) const;
+
+	//! Replace an element with one of another name.
+	void Rename(DomEditor& oEditor, const Target& oTarget) const;
+
+	//! Wrap a node in a new element.
+	void Wrap(DomEditor& oEditor, const Target& oTarget) const;
+};
+
+#endif // APP_BULKEDIT_HPP
@@ -0,0 +1,73 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   BulkEditDlg.cpp
+//! \brief  The BulkEditDlg class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "BulkEditDlg.hpp"
+#include "Resource.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+BulkEditDlg::BulkEditDlg()
+	: CDialog(IDD_BULK_EDIT)
+{
+	DEFINE_CTRL_TABLE
+		CTRL(IDC_PATH,				&m_ebQuery)
+		CTRL(IDC_BULK_OPERATION,	&m_cbOperation)
+		CTRL(IDC_BULK_NAME,			&m_ebName)
+		CTRL(IDC_BULK_VALUE,		&m_ebValue)
+	END_CTRL_TABLE
+
+	DEFINE_CTRLMSG_TABLE
+	END_CTRLMSG_TABLE
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Dialog initialisation handler.
+
+void BulkEditDlg::OnInitDialog()
+{
+	// Initialise controls, in BulkEdit::Operation order.
+	m_cbOperation.Add(TXT("Set Attribute"));
+	m_cbOperation.Add(TXT("Rename Element"));
+	m_cbOperation.Add(TXT("Delete Node"));
+	m_cbOperation.Add(TXT("Wrap Node In Element"));
+
+	m_ebQuery.Text(m_oEdit.m_strQuery);
+	m_cbOperation.CurSel(m_oEdit.m_eOperation);
+	m_ebName.Text(m_oEdit.m_strName);
+	m_ebValue.Text(m_oEdit.m_strValue);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! OK button handler.
+
+bool BulkEditDlg::OnOk()
+{
+	BulkEdit::Operation eOperation = static_cast<BulkEdit::Operation>(m_cbOperation.CurSel());
+
+	// Validate controls.
+	if (m_ebQuery.TextLength() == 0)
+	{
+		AlertMsg(TXT("Please enter an XPath expression query"));
+		m_ebQuery.Focus();
+		return false;
+	}
+
+	if ( (eOperation != BulkEdit::DELETE_NODES) && (m_ebName.TextLength() == 0) )
+	{
+		AlertMsg(TXT("Please enter the attribute or element name"));
+		m_ebName.Focus();
+		return false;
+	}
+
+	// Save parameters.
+	m_oEdit.m_strQuery   = m_ebQuery.Text();
+	m_oEdit.m_eOperation = eOperation;
+	m_oEdit.m_strName    = m_ebName.Text();
+	m_oEdit.m_strValue   = m_ebValue.Text();
+
+	return true;
+}
@@ -0,0 +1,51 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   BulkEditDlg.hpp
+//! \brief  The BulkEditDlg class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef BULKEDITDLG_HPP
+#define BULKEDITDLG_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <WCL/CommonUI.hpp>
+#include "BulkEdit.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+//! The dialog used to enter the XPath expression and operation of a bulk edit.
+
+class BulkEditDlg : public CDialog
+{
+public:
+	//! Default constructor.
+	BulkEditDlg();
+	
+	//
+	// Members.
+	//
+	BulkEdit	m_oEdit;		//!< The bulk edit.
+
+private:
+	//
+	// Controls.
+	//
+	CEditBox	m_ebQuery;		//!< The input control for the query.
+	CComboBox	m_cbOperation;	//!< The operation choice.
+	CEditBox	m_ebName;		//!< The input control for the name.
+	CEditBox	m_ebValue;		//!< The input control for the value.
+
+	//
+	// Message handlers.
+	//
+
+	//! Dialog initialisation handler.
+	virtual void OnInitDialog();
+
+	//! OK button handler.
+	virtual bool OnOk();
+};
+
+#endif // BULKEDITDLG_HPP
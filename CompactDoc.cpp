@@ -0,0 +1,832 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   CompactDoc.cpp
+//! \brief  The CompactDoc class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "CompactDoc.hpp"
+#include "NameIndex.hpp"
+#include "FastScan.hpp"
+#include "TextDecoder.hpp"
+#include <WCL/File.hpp>
+#include <Core/RuntimeException.hpp>
+
+//! The character type of the stored text.
+typedef CompactDoc::Char Char;
+
+////////////////////////////////////////////////////////////////////////////////
+// Constants.
+
+//! The byte order mark, if left in the text.
+static const tchar BYTE_ORDER_MARK = static_cast<tchar>(0xFEFF);
+
+//! The largest block read from or written to a snapshot in one call.
+static const size_t MAX_BLOCK_SIZE = 16 * 1024 * 1024;
+
+#ifdef APP_UTF8_STORAGE
+//! The largest block handed to the Win32 conversion functions in one call.
+static const size_t MAX_SLICE_SIZE = 16 * 1024 * 1024;
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the character is XML whitespace.
+
+static bool IsSpace(Char c)
+{
+	return ( (c == TXT(' ')) || (c == TXT('\t')) || (c == TXT('\r')) || (c == TXT('\n')) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the character terminates a tag or target name.
+
+static bool IsNameEnd(Char c)
+{
+	return ( (IsSpace(c)) || (c == TXT('/')) || (c == TXT('>')) || (c == TXT('?')) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the range starts with the string.
+
+static bool StartsWith(const Char* pBegin, const Char* pEnd, const char* pszString)
+{
+	for (; *pszString != '\0'; ++pBegin, ++pszString)
+	{
+		if ( (pBegin == pEnd) || (*pBegin != *pszString) )
+			return false;
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the start of a string in the range, or the end of the range.
+
+static const Char* FindString(const Char* pBegin, const Char* pEnd, const char* pszString)
+{
+	for (const Char* pCurrent = pBegin; ; ++pCurrent)
+	{
+		pCurrent = FastScan::Find(pCurrent, pEnd, static_cast<Char>(*pszString));
+
+		if ( (pCurrent == pEnd) || (StartsWith(pCurrent, pEnd, pszString)) )
+			return pCurrent;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the closing '>' of a tag, skipping quoted values and, for a DOCTYPE,
+//! any internal subset. Returns the end of the range if not found.
+
+static const Char* FindTagEnd(const Char* pBegin, const Char* pEnd)
+{
+	int nSubsetDepth = 0;
+
+	for (const Char* pCurrent = pBegin; pCurrent != pEnd; ++pCurrent)
+	{
+		Char c = *pCurrent;
+
+		if ( (c == TXT('"')) || (c == TXT('\'')) )
+		{
+			pCurrent = FastScan::Find(pCurrent+1, pEnd, c);
+
+			if (pCurrent == pEnd)
+				break;
+		}
+		else if (c == TXT('['))
+		{
+			++nSubsetDepth;
+		}
+		else if (c == TXT(']'))
+		{
+			--nSubsetDepth;
+		}
+		else if ( (c == TXT('>')) && (nSubsetDepth <= 0) )
+		{
+			return pCurrent;
+		}
+	}
+
+	return pEnd;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append a range of the stored text to the string, converting it from UTF-8
+//! when that is how it is stored.
+
+static void AppendText(const Char* pBegin, const Char* pEnd, tstring& str)
+{
+#ifdef APP_UTF8_STORAGE
+	TextDecoder oDecoder(TextDecoder::UTF_8);
+
+	oDecoder.Decode(reinterpret_cast<const byte*>(pBegin), reinterpret_cast<const byte*>(pEnd), str);
+	oDecoder.Finish(str);
+#else
+	str.append(pBegin, pEnd);
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Convert a range of the stored text to a string.
+
+static tstring ToText(const Char* pBegin, const Char* pEnd)
+{
+	tstring str;
+
+	AppendText(pBegin, pEnd, str);
+
+	return str;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if a range of the stored text is the same as the string. Stored text
+//! that is all ASCII is compared in place, anything else is converted first.
+
+static bool SameText(const tstring& str, const Char* pBegin, const Char* pEnd)
+{
+#ifdef APP_UTF8_STORAGE
+	if (FastScan::SkipAscii(pBegin, pEnd) != pEnd)
+		return (str == ToText(pBegin, pEnd));
+
+	return ( (str.size() == static_cast<size_t>(pEnd - pBegin)) && (std::equal(pBegin, pEnd, str.begin())) );
+#else
+	return (str.compare(0, tstring::npos, pBegin, pEnd - pBegin) == 0);
+#endif
+}
+
+#ifdef APP_UTF8_STORAGE
+
+////////////////////////////////////////////////////////////////////////////////
+//! Convert the loaded text to UTF-8, dropping any byte order mark. The text is
+//! converted in slices that don't split a surrogate pair.
+
+static void EncodeUtf8(const tstring& strText, std::string& strUtf8)
+{
+	const tchar* pBegin = strText.data();
+	const tchar* pEnd   = pBegin + strText.size();
+
+	if ( (pBegin != pEnd) && (*pBegin == BYTE_ORDER_MARK) )
+		++pBegin;
+
+	strUtf8.clear();
+	strUtf8.reserve(pEnd - pBegin);
+
+	while (pBegin != pEnd)
+	{
+		const tchar* pSliceEnd = pBegin + std::min<size_t>(pEnd - pBegin, MAX_SLICE_SIZE);
+
+		if ( (pSliceEnd != pEnd) && (*(pSliceEnd-1) >= 0xD800) && (*(pSliceEnd-1) <= 0xDBFF) )
+			--pSliceEnd;
+
+		int    nChars  = static_cast<int>(pSliceEnd - pBegin);
+		int    nLength = ::WideCharToMultiByte(CP_UTF8, 0, pBegin, nChars, NULL, 0, NULL, NULL);
+		size_t nOffset = strUtf8.size();
+
+		strUtf8.resize(nOffset + nLength);
+		::WideCharToMultiByte(CP_UTF8, 0, pBegin, nChars, &strUtf8[nOffset], nLength, NULL, NULL);
+
+		pBegin = pSliceEnd;
+	}
+}
+
+#endif // APP_UTF8_STORAGE
+
+////////////////////////////////////////////////////////////////////////////////
+//! Convert a string to the form the text is stored in, so that it can be
+//! compared with the stored text directly.
+
+static CompactDoc::String ToStored(const tstring& str)
+{
+#ifdef APP_UTF8_STORAGE
+	std::string strUtf8;
+
+	EncodeUtf8(str, strUtf8);
+
+	return strUtf8;
+#else
+	return str;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append a character reference to the string.
+
+static void AppendCharRef(ulong nChar, tstring& str)
+{
+#ifdef _UNICODE
+	if (nChar > 0xFFFF)
+	{
+		nChar -= 0x10000;
+		str += static_cast<tchar>(0xD800 + (nChar >> 10));
+		str += static_cast<tchar>(0xDC00 + (nChar & 0x3FF));
+		return;
+	}
+#else
+	if (nChar > 0xFF)
+	{
+		str += TXT('?');
+		return;
+	}
+#endif
+
+	str += static_cast<tchar>(nChar);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Decode the entity and character references in the range.
+
+static void DecodeText(const Char* pBegin, const Char* pEnd, tstring& str)
+{
+	str.reserve(str.size() + (pEnd - pBegin));
+
+	for (const Char* pCurrent = pBegin; pCurrent != pEnd; )
+	{
+		const Char* pAmp = FastScan::Find(pCurrent, pEnd, Char('&'));
+
+		AppendText(pCurrent, pAmp, str);
+
+		if (pAmp == pEnd)
+			break;
+
+		const Char* pSemi = FastScan::Find(pAmp, pEnd, Char(';'));
+
+		if (pSemi == pEnd)
+		{
+			AppendText(pAmp, pEnd, str);
+			break;
+		}
+
+		tstring strRef(pAmp+1, pSemi);
+
+		if (strRef == TXT("lt"))
+			str += TXT('<');
+		else if (strRef == TXT("gt"))
+			str += TXT('>');
+		else if (strRef == TXT("amp"))
+			str += TXT('&');
+		else if (strRef == TXT("quot"))
+			str += TXT('"');
+		else if (strRef == TXT("apos"))
+			str += TXT('\'');
+		else if ( (strRef.size() > 2) && (strRef[0] == TXT('#')) && (strRef[1] == TXT('x')) )
+			AppendCharRef(_tcstoul(strRef.c_str()+2, nullptr, 16), str);
+		else if ( (strRef.size() > 1) && (strRef[0] == TXT('#')) )
+			AppendCharRef(_tcstoul(strRef.c_str()+1, nullptr, 10), str);
+		else
+			AppendText(pAmp, pSemi+1, str);
+
+		pCurrent = pSemi+1;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the next attribute in the text of a tag. Returns the position after the
+//! attribute or nullptr if there are no more.
+
+static const Char* NextAttribute(const Char* pCurrent, const Char* pEnd, CompactDoc::TextRange& oName, CompactDoc::TextRange& oValue)
+{
+	pCurrent = FastScan::SkipSpace(pCurrent, pEnd);
+
+	const Char* pEqual = FastScan::Find(pCurrent, pEnd, Char('='));
+
+	if (pEqual == pEnd)
+		return nullptr;
+
+	const Char* pQuote = FastScan::SkipSpace(pEqual+1, pEnd);
+
+	if ( (pQuote == pEnd) || ((*pQuote != TXT('"')) && (*pQuote != TXT('\''))) )
+		return nullptr;
+
+	const Char* pValueEnd = FastScan::Find(pQuote+1, pEnd, *pQuote);
+
+	if (pValueEnd == pEnd)
+		return nullptr;
+
+	oName  = CompactDoc::TextRange(pCurrent, std::find_if(pCurrent, pEqual, IsSpace));
+	oValue = CompactDoc::TextRange(pQuote+1, pValueEnd);
+
+	return pValueEnd+1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read a block of a snapshot, in parts small enough for a single file read.
+
+static void ReadBlock(CFile& oFile, void* pvData, size_t nBytes)
+{
+	byte* pData = static_cast<byte*>(pvData);
+
+	for (size_t nOffset = 0; nOffset != nBytes; )
+	{
+		size_t nPart = std::min(nBytes - nOffset, MAX_BLOCK_SIZE);
+
+		oFile.Read(pData + nOffset, nPart);
+		nOffset += nPart;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a block of a snapshot, in parts small enough for a single file write.
+
+static void WriteBlock(CFile& oFile, const void* pvData, size_t nBytes)
+{
+	const byte* pData = static_cast<const byte*>(pvData);
+
+	for (size_t nOffset = 0; nOffset != nBytes; )
+	{
+		size_t nPart = std::min(nBytes - nOffset, MAX_BLOCK_SIZE);
+
+		oFile.Write(pData + nOffset, nPart);
+		nOffset += nPart;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+CompactDoc::CompactDoc()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+CompactDoc::~CompactDoc()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the decoded value of a text, CDATA, comment or DOCTYPE node. Only text
+//! can contain references, and only when flagged is it scanned to decode them.
+
+tstring CompactDoc::Value(NodeIndex nNode) const
+{
+	TextRange oValue = RawValue(nNode);
+
+	if (!NeedsDecoding(nNode))
+		return ToText(oValue.first, oValue.second);
+
+	tstring strValue;
+
+	DecodeText(oValue.first, oValue.second, strValue);
+
+	return strValue;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the decoded attributes of an element or processing instruction. The
+//! attributes are parsed from the source text each time they are requested.
+
+void CompactDoc::GetAttributes(NodeIndex nNode, Attributes& vecAttribs) const
+{
+	TextRange   oText    = RawValue(nNode);
+	bool        bDecode  = NeedsDecoding(nNode);
+	const Char* pCurrent = oText.first;
+	TextRange   oName, oValue;
+
+	vecAttribs.clear();
+
+	while ((pCurrent = NextAttribute(pCurrent, oText.second, oName, oValue)) != nullptr)
+	{
+		vecAttribs.push_back(Attribute(ToText(oName.first, oName.second), tstring()));
+
+		if (bDecode)
+			DecodeText(oValue.first, oValue.second, vecAttribs.back().second);
+		else
+			AppendText(oValue.first, oValue.second, vecAttribs.back().second);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse the document text, taking ownership of it. The markup is validated as
+//! it is read but text and attributes are only located, not decoded.
+
+void CompactDoc::Parse(tstring& strText, bool bDiscardWhitespace)
+{
+#ifdef APP_UTF8_STORAGE
+	EncodeUtf8(strText, m_strText);
+	tstring().swap(strText);
+#else
+	m_strText.swap(strText);
+#endif
+	m_vecNodes.clear();
+	m_oNames.Clear();
+
+	if (m_strText.size() >= NO_NODE)
+		throw Core::RuntimeException(TXT("The document is too large for the compact representation"));
+
+	const Char* pBegin   = m_strText.c_str();
+	const Char* pEnd     = pBegin + m_strText.size();
+	const Char* pCurrent = pBegin;
+	NodeIndices vecOpen;
+	NodeIndices vecLastChild;
+	bool        bRootSeen = false;
+
+#ifndef APP_UTF8_STORAGE
+	if ( (pCurrent != pEnd) && (*pCurrent == BYTE_ORDER_MARK) )
+		++pCurrent;
+#endif
+
+	AddNode(XML::DOCUMENT_NODE, 0, 0, vecOpen, vecLastChild);
+
+	vecOpen.push_back(DOCUMENT);
+	vecLastChild.push_back(NO_NODE);
+
+	while (pCurrent != pEnd)
+	{
+		// Text?
+		if (*pCurrent != TXT('<'))
+		{
+			const Char* pTextEnd    = FastScan::Find(pCurrent, pEnd, Char('<'));
+			bool        bWhitespace = (FastScan::SkipSpace(pCurrent, pTextEnd) == pTextEnd);
+
+			if ( (vecOpen.size() == 1) && (!bWhitespace) )
+				ThrowError(TXT("Text found outside the root element"), pCurrent);
+
+			if ( (!bWhitespace) || ((!bDiscardWhitespace) && (vecOpen.size() != 1)) )
+			{
+				NodeIndex nNode = AddNode(XML::TEXT_NODE, pCurrent - pBegin, pTextEnd - pBegin, vecOpen, vecLastChild);
+
+				if (FastScan::Find(pCurrent, pTextEnd, Char('&')) != pTextEnd)
+					m_vecNodes[nNode].m_nFlags |= NEEDS_DECODING;
+			}
+
+			pCurrent = pTextEnd;
+		}
+		// Comment?
+		else if (StartsWith(pCurrent, pEnd, "<!--"))
+		{
+			const Char* pClose = FindString(pCurrent+4, pEnd, "-->");
+
+			if (pClose == pEnd)
+				ThrowError(TXT("Unterminated comment"), pCurrent);
+
+			AddNode(XML::COMMENT_NODE, pCurrent+4 - pBegin, pClose - pBegin, vecOpen, vecLastChild);
+
+			pCurrent = pClose+3;
+		}
+		// CDATA section?
+		else if (StartsWith(pCurrent, pEnd, "<![CDATA["))
+		{
+			const Char* pClose = FindString(pCurrent+9, pEnd, "]]>");
+
+			if (pClose == pEnd)
+				ThrowError(TXT("Unterminated CDATA section"), pCurrent);
+
+			AddNode(XML::CDATA_NODE, pCurrent+9 - pBegin, pClose - pBegin, vecOpen, vecLastChild);
+
+			pCurrent = pClose+3;
+		}
+		// DOCTYPE?
+		else if (StartsWith(pCurrent, pEnd, "<!DOCTYPE"))
+		{
+			const Char* pDecl  = FastScan::SkipSpace(pCurrent+9, pEnd);
+			const Char* pClose = FindTagEnd(pDecl, pEnd);
+
+			if (pClose == pEnd)
+				ThrowError(TXT("Unterminated DOCTYPE"), pCurrent);
+
+			AddNode(XML::DOCTYPE_NODE, pDecl - pBegin, pClose - pBegin, vecOpen, vecLastChild);
+
+			pCurrent = pClose+1;
+		}
+		// Processing instruction?
+		else if (StartsWith(pCurrent, pEnd, "<?"))
+		{
+			const Char* pClose   = FindString(pCurrent+2, pEnd, "?>");
+			const Char* pNameEnd = std::find_if(pCurrent+2, pClose, IsNameEnd);
+
+			if (pClose == pEnd)
+				ThrowError(TXT("Unterminated processing instruction"), pCurrent);
+
+			NodeIndex nNode = AddNode(XML::PROCESSING_NODE, pNameEnd - pBegin, pClose - pBegin, vecOpen, vecLastChild);
+
+			m_vecNodes[nNode].m_nName = m_oNames.Intern(ToText(pCurrent+2, pNameEnd));
+
+			if (FastScan::Find(pNameEnd, pClose, Char('&')) != pClose)
+				m_vecNodes[nNode].m_nFlags |= NEEDS_DECODING;
+
+			pCurrent = pClose+2;
+		}
+		// End tag?
+		else if (StartsWith(pCurrent, pEnd, "</"))
+		{
+			const Char* pClose   = FastScan::Find(pCurrent+2, pEnd, Char('>'));
+			const Char* pNameEnd = std::find_if(pCurrent+2, pClose, IsSpace);
+
+			if (pClose == pEnd)
+				ThrowError(TXT("Unterminated end tag"), pCurrent);
+
+			if (vecOpen.size() == 1)
+				ThrowError(TXT("End tag found without a start tag"), pCurrent);
+
+			const tstring& strOpen = Name(vecOpen.back());
+
+			if (!SameText(strOpen, pCurrent+2, pNameEnd))
+				ThrowError(TXT("End tag does not match the start tag"), pCurrent);
+
+			vecOpen.pop_back();
+			vecLastChild.pop_back();
+
+			pCurrent = pClose+1;
+		}
+		// Start tag.
+		else
+		{
+			const Char* pClose   = FindTagEnd(pCurrent+1, pEnd);
+			const Char* pNameEnd = std::find_if(pCurrent+1, pClose, IsNameEnd);
+
+			if (pClose == pEnd)
+				ThrowError(TXT("Unterminated start tag"), pCurrent);
+
+			if (pNameEnd == pCurrent+1)
+				ThrowError(TXT("Invalid element name"), pCurrent);
+
+			if ( (vecOpen.size() == 1) && (bRootSeen) )
+				ThrowError(TXT("Multiple root elements found"), pCurrent);
+
+			bool        bEmptyTag   = (*(pClose-1) == TXT('/'));
+			const Char* pAttribsEnd = (bEmptyTag) ? pClose-1 : pClose;
+			NodeIndex   nNode       = AddNode(XML::ELEMENT_NODE, pNameEnd - pBegin, pAttribsEnd - pBegin, vecOpen, vecLastChild);
+
+			m_vecNodes[nNode].m_nName = m_oNames.Intern(ToText(pCurrent+1, pNameEnd));
+
+			if (FastScan::Find(pNameEnd, pAttribsEnd, Char('&')) != pAttribsEnd)
+				m_vecNodes[nNode].m_nFlags |= NEEDS_DECODING;
+
+			if (vecOpen.size() == 1)
+				bRootSeen = true;
+
+			if (!bEmptyTag)
+			{
+				vecOpen.push_back(nNode);
+				vecLastChild.push_back(NO_NODE);
+			}
+
+			pCurrent = pClose+1;
+		}
+	}
+
+	if (vecOpen.size() != 1)
+		ThrowError(TXT("Unterminated element"), pEnd);
+
+	TRACE3(TXT("Compact DOM: %u nodes of %u bytes, %u bytes of text\n"), m_vecNodes.size(), sizeof(Node), m_strText.size() * sizeof(Char));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the elements that match a simple name test query, see NameIndex for
+//! the supported forms. The element names are compared by their handles.
+//! Returns false if the query is not a simple name test.
+
+bool CompactDoc::Query(const tstring& strQuery, NodeIndices& vecNodes) const
+{
+	tstring strName, strAttrib, strValue;
+	bool    bHasValue = false;
+
+	if (!NameIndex::ParseQuery(strQuery, strName, strAttrib, strValue, bHasValue))
+		return false;
+
+	NameTable::NameId nID = m_oNames.Find(strName);
+
+	// No elements with the name?
+	if (nID == NameTable::INVALID_NAME)
+		return true;
+
+	const String strStoredAttrib = ToStored(strAttrib);
+	const String strStoredValue  = ToStored(strValue);
+	tstring      strDecoded;
+
+	for (NodeIndex nNode = 0; nNode != m_vecNodes.size(); ++nNode)
+	{
+		const Node& oNode = m_vecNodes[nNode];
+
+		if ( (oNode.m_nName != nID) || (oNode.m_eType != XML::ELEMENT_NODE) )
+			continue;
+
+		if (!strAttrib.empty())
+		{
+			TextRange oValue;
+
+			if (!FindAttribute(nNode, strStoredAttrib, oValue))
+				continue;
+
+			if (bHasValue)
+			{
+				// Compare straight from the source unless there's something to decode.
+				if ((oNode.m_nFlags & NEEDS_DECODING) != 0)
+				{
+					strDecoded.clear();
+					DecodeText(oValue.first, oValue.second, strDecoded);
+
+					if (strDecoded != strValue)
+						continue;
+				}
+				else if (strStoredValue.compare(0, String::npos, oValue.first, oValue.second - oValue.first) != 0)
+				{
+					continue;
+				}
+			}
+		}
+
+		vecNodes.push_back(nNode);
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read the document from a snapshot written by Write(). The node table and
+//! text are read back as they are, so nothing is parsed. As the snapshot may
+//! be corrupt, every count is checked against the size of the file before it
+//! is allocated and every link and range is checked once it has been read.
+
+void CompactDoc::Read(CFile& oFile)
+{
+	const size_t nFileSize = oFile.Size();
+
+	uint32 nNodeSize = 0;
+	uint32 nNodes    = 0;
+	uint32 nNames    = 0;
+	uint32 nLength   = 0;
+
+	m_vecNodes.clear();
+	m_oNames.Clear();
+	m_strText.clear();
+
+	oFile.Read(&nNodeSize, sizeof(nNodeSize));
+	oFile.Read(&nNodes, sizeof(nNodes));
+
+	if ( (nNodeSize != sizeof(Node)) || (nNodes == 0) )
+		throw Core::RuntimeException(TXT("The snapshot's node table is not supported"));
+
+	if (nNodes > (nFileSize / sizeof(Node)))
+		throw Core::RuntimeException(TXT("The snapshot's node table is larger than the file"));
+
+	m_vecNodes.resize(nNodes);
+	ReadBlock(oFile, &m_vecNodes.front(), nNodes * sizeof(Node));
+
+	oFile.Read(&nNames, sizeof(nNames));
+
+	if (nNames > (nFileSize / sizeof(nLength)))
+		throw Core::RuntimeException(TXT("The snapshot's name table is larger than the file"));
+
+	tstring strName;
+
+	for (uint32 i = 0; i != nNames; ++i)
+	{
+		oFile.Read(&nLength, sizeof(nLength));
+
+		if (nLength > (nFileSize / sizeof(tchar)))
+			throw Core::RuntimeException(TXT("The snapshot's name table is larger than the file"));
+
+		strName.resize(nLength);
+
+		if (nLength != 0)
+			oFile.Read(&strName[0], nLength * sizeof(tchar));
+
+		m_oNames.Intern(strName);
+	}
+
+	oFile.Read(&nLength, sizeof(nLength));
+
+	if (nLength > (nFileSize / sizeof(Char)))
+		throw Core::RuntimeException(TXT("The snapshot's text is larger than the file"));
+
+	m_strText.resize(nLength);
+
+	if (nLength != 0)
+		ReadBlock(oFile, &m_strText[0], nLength * sizeof(Char));
+
+	CheckNodes();
+
+	TRACE3(TXT("Compact DOM: %u nodes, %u names, %u characters read from snapshot\n"), m_vecNodes.size(), m_oNames.Count(), m_strText.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Check the node table read from a snapshot is consistent. The nodes are in
+//! document order and so a parent always comes before its children, and a
+//! node before its next sibling; checking that also rules out any cycles. The
+//! names and source ranges must lie within the name table and text.
+
+void CompactDoc::CheckNodes() const
+{
+	const size_t nNodes  = m_vecNodes.size();
+	const size_t nNames  = m_oNames.Count();
+	const size_t nLength = m_strText.size();
+
+	for (size_t i = 0; i != nNodes; ++i)
+	{
+		const Node&   oNode = m_vecNodes[i];
+		XML::NodeType eType = static_cast<XML::NodeType>(oNode.m_eType);
+
+		bool bValidType   = (i == DOCUMENT) ? (eType == XML::DOCUMENT_NODE)
+						  : ( (eType == XML::ELEMENT_NODE) || (eType == XML::TEXT_NODE) || (eType == XML::COMMENT_NODE)
+						   || (eType == XML::CDATA_NODE) || (eType == XML::DOCTYPE_NODE) || (eType == XML::PROCESSING_NODE) );
+		bool bValidParent = (i == DOCUMENT) ? (oNode.m_nParent == NO_NODE) : (oNode.m_nParent < i);
+		bool bValidChild  = (oNode.m_nFirstChild == NO_NODE)
+						 || ( (oNode.m_nFirstChild > i) && (oNode.m_nFirstChild < nNodes)
+						   && (m_vecNodes[oNode.m_nFirstChild].m_nParent == i) );
+		bool bValidNext   = (oNode.m_nNextSibling == NO_NODE)
+						 || ( (oNode.m_nNextSibling > i) && (oNode.m_nNextSibling < nNodes)
+						   && (m_vecNodes[oNode.m_nNextSibling].m_nParent == oNode.m_nParent) );
+		bool bValidName   = ( (eType != XML::ELEMENT_NODE) && (eType != XML::PROCESSING_NODE) ) || (oNode.m_nName < nNames);
+		bool bValidRange  = (oNode.m_nBegin <= oNode.m_nEnd) && (oNode.m_nEnd <= nLength);
+
+		if ( (!bValidType) || (!bValidParent) || (!bValidChild) || (!bValidNext) || (!bValidName) || (!bValidRange) )
+			throw Core::RuntimeException(Core::fmt(TXT("The snapshot's node table is corrupt at node %u"), static_cast<uint>(i)));
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write the document to a snapshot. The names are written in handle order so
+//! that they are given the same handles when read back.
+
+void CompactDoc::Write(CFile& oFile) const
+{
+	uint32 nNodeSize = sizeof(Node);
+	uint32 nNodes    = static_cast<uint32>(m_vecNodes.size());
+	uint32 nNames    = static_cast<uint32>(m_oNames.Count());
+	uint32 nLength   = 0;
+
+	oFile.Write(&nNodeSize, sizeof(nNodeSize));
+	oFile.Write(&nNodes, sizeof(nNodes));
+	WriteBlock(oFile, &m_vecNodes.front(), nNodes * sizeof(Node));
+
+	oFile.Write(&nNames, sizeof(nNames));
+
+	for (NameTable::NameId nID = 0; nID != nNames; ++nID)
+	{
+		const tstring& strName = m_oNames.Name(nID);
+
+		nLength = static_cast<uint32>(strName.size());
+
+		oFile.Write(&nLength, sizeof(nLength));
+		oFile.Write(strName.data(), nLength * sizeof(tchar));
+	}
+
+	nLength = static_cast<uint32>(m_strText.size());
+
+	oFile.Write(&nLength, sizeof(nLength));
+	WriteBlock(oFile, m_strText.data(), nLength * sizeof(Char));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find an attribute by name in the source text of an element or processing
+//! instruction. The name is given in the stored form and the value is returned
+//! as it appears in the source.
+
+bool CompactDoc::FindAttribute(NodeIndex nNode, const String& strName, TextRange& oValue) const
+{
+	TextRange   oText    = RawValue(nNode);
+	const Char* pCurrent = oText.first;
+	TextRange   oName;
+
+	while ((pCurrent = NextAttribute(pCurrent, oText.second, oName, oValue)) != nullptr)
+	{
+		if (strName.compare(0, String::npos, oName.first, oName.second - oName.first) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append a node to the table and link it to its parent and previous sibling.
+
+CompactDoc::NodeIndex CompactDoc::AddNode(XML::NodeType eType, size_t nBegin, size_t nEnd, NodeIndices& vecOpen, NodeIndices& vecLastChild)
+{
+	NodeIndex nNode   = static_cast<NodeIndex>(m_vecNodes.size());
+	NodeIndex nParent = (!vecOpen.empty()) ? vecOpen.back() : NO_NODE;
+	Node      oNode;
+
+	oNode.m_nParent      = nParent;
+	oNode.m_nFirstChild  = NO_NODE;
+	oNode.m_nNextSibling = NO_NODE;
+	oNode.m_nName        = NameTable::INVALID_NAME;
+	oNode.m_nBegin       = static_cast<uint32>(nBegin);
+	oNode.m_nEnd         = static_cast<uint32>(nEnd);
+	oNode.m_eType        = static_cast<byte>(eType);
+	oNode.m_nFlags       = 0;
+
+	m_vecNodes.push_back(oNode);
+
+	if (nParent != NO_NODE)
+	{
+		if (vecLastChild.back() == NO_NODE)
+			m_vecNodes[nParent].m_nFirstChild = nNode;
+		else
+			m_vecNodes[vecLastChild.back()].m_nNextSibling = nNode;
+
+		vecLastChild.back() = nNode;
+	}
+
+	return nNode;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Throw a parsing error for the given position.
+
+void CompactDoc::ThrowError(const tchar* pszError, const Char* pszPos) const
+{
+	const Char* pBegin = m_strText.c_str();
+	size_t      nLine  = std::count(pBegin, pszPos, Char('\n')) + 1;
+
+	throw Core::RuntimeException(Core::fmt(TXT("%s at line %u"), pszError, nLine));
+}
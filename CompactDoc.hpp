@@ -0,0 +1,286 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   CompactDoc.hpp
+//! \brief  The CompactDoc class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_COMPACTDOC_HPP
+#define APP_COMPACTDOC_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <XML/Node.hpp>
+#include "NameTable.hpp"
+
+// Forward declarations.
+class CFile;
+
+// Defining APP_UTF8_STORAGE stores the compact document text as UTF-8.
+#if (defined(APP_UTF8_STORAGE) && !defined(_UNICODE))
+#error UTF-8 storage is only supported in Unicode builds
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//! A compact, read-only representation of a document for view-only sessions.
+//! The nodes are held in a flat table in document (preorder) order and refer
+//! to each other by index. Text, comments and attributes are not copied but
+//! kept as ranges into the loaded text, and are only decoded when asked for.
+//! Nodes whose text contains references are flagged at load; the values of the
+//! others are copied straight from the source text without being scanned, and
+//! can be compared in place through RawValue().
+//! When built with APP_UTF8_STORAGE the text is held as UTF-8 rather than
+//! UTF-16, which halves it for mostly ASCII documents, and is only converted
+//! when names, values and attributes are handed out.
+//! The first node is always the document node.
+
+class CompactDoc : private Core::NotCopyable
+{
+public:
+#ifdef APP_UTF8_STORAGE
+	//! The character type of the stored text.
+	typedef char Char;
+	//! The string type of the stored text.
+	typedef std::string String;
+#else
+	//! The character type of the stored text.
+	typedef tchar Char;
+	//! The string type of the stored text.
+	typedef tstring String;
+#endif
+	//! The index of a node in the table.
+	typedef uint32 NodeIndex;
+	//! A collection of node indices.
+	typedef std::vector<NodeIndex> NodeIndices;
+	//! A decoded attribute name and value.
+	typedef std::pair<tstring, tstring> Attribute;
+	//! The decoded attributes of a node.
+	typedef std::vector<Attribute> Attributes;
+	//! A range of the source text.
+	typedef std::pair<const Char*, const Char*> TextRange;
+
+	//! The index used for a missing node.
+	static const NodeIndex NO_NODE = static_cast<NodeIndex>(-1);
+	//! The index of the document node.
+	static const NodeIndex DOCUMENT = 0;
+
+	//! Default constructor.
+	CompactDoc();
+
+	//! Destructor.
+	~CompactDoc();
+
+	//
+	// Properties.
+	//
+
+	//! Get the number of nodes.
+	size_t NodeCount() const;
+
+	//! Get the type of a node.
+	XML::NodeType Type(NodeIndex nNode) const;
+
+	//! Get the parent of a node.
+	NodeIndex Parent(NodeIndex nNode) const;
+
+	//! Get the first child of a node.
+	NodeIndex FirstChild(NodeIndex nNode) const;
+
+	//! Get the next sibling of a node.
+	NodeIndex NextSibling(NodeIndex nNode) const;
+
+	//! Query if a node has any children.
+	bool HasChildren(NodeIndex nNode) const;
+
+	//! Get the name handle of an element or processing instruction.
+	NameTable::NameId NameId(NodeIndex nNode) const;
+
+	//! Get the name of an element or target of a processing instruction.
+	const tstring& Name(NodeIndex nNode) const;
+
+	//! Query if a node's value or attributes contain references to decode.
+	bool NeedsDecoding(NodeIndex nNode) const;
+
+	//! Get the source text of a node's value, before any decoding.
+	TextRange RawValue(NodeIndex nNode) const;
+
+	//! Get the decoded value of a text, CDATA, comment or DOCTYPE node.
+	tstring Value(NodeIndex nNode) const;
+
+	//! Get the decoded attributes of an element or processing instruction.
+	void GetAttributes(NodeIndex nNode, Attributes& vecAttribs) const;
+
+	//! Get the table of interned names.
+	const NameTable& Names() const;
+
+	//
+	// Methods.
+	//
+
+	//! Parse the document text, taking ownership of it.
+	void Parse(tstring& strText, bool bDiscardWhitespace);
+
+	//! Find the elements that match a simple name test query.
+	bool Query(const tstring& strQuery, NodeIndices& vecNodes) const;
+
+	//! Read the document from a snapshot.
+	void Read(CFile& oFile);
+
+	//! Write the document to a snapshot.
+	void Write(CFile& oFile) const;
+
+private:
+	////////////////////////////////////////////////////////////////////////////
+	//! A single entry in the node table.
+
+	struct Node
+	{
+		NodeIndex			m_nParent;		//!< The parent node.
+		NodeIndex			m_nFirstChild;	//!< The first child node.
+		NodeIndex			m_nNextSibling;	//!< The next sibling node.
+		NameTable::NameId	m_nName;		//!< The element name or PI target.
+		uint32				m_nBegin;		//!< The start of the source range.
+		uint32				m_nEnd;			//!< The end of the source range.
+		byte				m_eType;		//!< The XML::NodeType.
+		byte				m_nFlags;		//!< The node flags.
+	};
+
+	//! The node flags.
+	enum Flag
+	{
+		NEEDS_DECODING	= 0x01,	//!< The value or attributes contain references.
+	};
+
+	//! The table of nodes.
+	typedef std::vector<Node> Nodes;
+
+	//
+	// Members.
+	//
+	String		m_strText;		//!< The source text.
+	Nodes		m_vecNodes;		//!< The nodes in document order.
+	NameTable	m_oNames;		//!< The element names and PI targets.
+
+	//
+	// Internal methods.
+	//
+
+	//! Get a node's entry in the table.
+	const Node& GetNode(NodeIndex nNode) const;
+
+	//! Append a node to the table and link it to its parent and sibling.
+	NodeIndex AddNode(XML::NodeType eType, size_t nBegin, size_t nEnd, NodeIndices& vecOpen, NodeIndices& vecLastChild);
+
+	//! Check the node table read from a snapshot is consistent.
+	void CheckNodes() const;
+
+	//! Find an attribute by name in the source text.
+	bool FindAttribute(NodeIndex nNode, const String& strName, TextRange& oValue) const;
+
+	//! Throw a parsing error for the given offset.
+	void ThrowError(const tchar* pszError, const Char* pszPos) const;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of nodes.
+
+inline size_t CompactDoc::NodeCount() const
+{
+	return m_vecNodes.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get a node's entry in the table.
+
+inline const CompactDoc::Node& CompactDoc::GetNode(NodeIndex nNode) const
+{
+	ASSERT(nNode < m_vecNodes.size());
+
+	return m_vecNodes[nNode];
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the type of a node.
+
+inline XML::NodeType CompactDoc::Type(NodeIndex nNode) const
+{
+	return static_cast<XML::NodeType>(GetNode(nNode).m_eType);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the parent of a node.
+
+inline CompactDoc::NodeIndex CompactDoc::Parent(NodeIndex nNode) const
+{
+	return GetNode(nNode).m_nParent;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the first child of a node.
+
+inline CompactDoc::NodeIndex CompactDoc::FirstChild(NodeIndex nNode) const
+{
+	return GetNode(nNode).m_nFirstChild;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the next sibling of a node.
+
+inline CompactDoc::NodeIndex CompactDoc::NextSibling(NodeIndex nNode) const
+{
+	return GetNode(nNode).m_nNextSibling;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if a node has any children.
+
+inline bool CompactDoc::HasChildren(NodeIndex nNode) const
+{
+	return (GetNode(nNode).m_nFirstChild != NO_NODE);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if a node's value or attributes contain references to decode.
+
+inline bool CompactDoc::NeedsDecoding(NodeIndex nNode) const
+{
+	return ((GetNode(nNode).m_nFlags & NEEDS_DECODING) != 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the source text of a node's value, before any decoding. For elements
+//! and processing instructions this is the text of the attributes.
+
+inline CompactDoc::TextRange CompactDoc::RawValue(NodeIndex nNode) const
+{
+	const Node& oNode = GetNode(nNode);
+
+	return TextRange(m_strText.data() + oNode.m_nBegin, m_strText.data() + oNode.m_nEnd);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the name handle of an element or processing instruction.
+
+inline NameTable::NameId CompactDoc::NameId(NodeIndex nNode) const
+{
+	return GetNode(nNode).m_nName;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the name of an element or target of a processing instruction.
+
+inline const tstring& CompactDoc::Name(NodeIndex nNode) const
+{
+	return m_oNames.Name(GetNode(nNode).m_nName);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the table of interned names.
+
+inline const NameTable& CompactDoc::Names() const
+{
+	return m_oNames;
+}
+
+#endif // APP_COMPACTDOC_HPP
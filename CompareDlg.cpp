@@ -0,0 +1,336 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   CompareDlg.cpp
+//! \brief  The CompareDlg class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "CompareDlg.hpp"
+#include "Resource.h"
+#include <XML/ElementNode.hpp>
+#include <XML/TextNode.hpp>
+#include <XML/ProcessingNode.hpp>
+#include <algorithm>
+#include "NodeRef.hpp"
+
+// Constants.
+static const size_t MAX_SUMMARY_LEN = 100;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if an entry is a difference in itself, rather than on the path to one.
+
+static bool IsDifference(const DiffItem& oItem)
+{
+	return ( (oItem.m_eType == DiffItem::CHANGED) || (oItem.m_eType == DiffItem::ADDED)
+		  || (oItem.m_eType == DiffItem::REMOVED) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+CompareDlg::CompareDlg(const tstring& strLeft, const tstring& strRight, const StructuralDiff::Items& vecItems, bool bComplete)
+	: CDialog(IDD_COMPARE)
+	, m_pSelection()
+	, m_strLeft(strLeft)
+	, m_strRight(strRight)
+	, m_vecItems(vecItems)
+	, m_bComplete(bComplete)
+	, m_bSyncing(false)
+{
+	DEFINE_CTRL_TABLE
+		CTRL(IDC_SUMMARY,		&m_txtSummary)
+		CTRL(IDC_LEFT_TREE,		&m_tvLeft)
+		CTRL(IDC_RIGHT_TREE,	&m_tvRight)
+	END_CTRL_TABLE
+
+	DEFINE_CTRLMSG_TABLE
+		CMD_CTRLMSG(IDC_NEXT_DIFF,  BN_CLICKED,       &CompareDlg::OnNextDifference)
+		NFY_CTRLMSG(IDC_LEFT_TREE,  TVN_SELCHANGED,   &CompareDlg::OnLeftSelChanged)
+		NFY_CTRLMSG(IDC_RIGHT_TREE, TVN_SELCHANGED,   &CompareDlg::OnRightSelChanged)
+		NFY_CTRLMSG(IDC_LEFT_TREE,  TVN_ITEMEXPANDED, &CompareDlg::OnLeftItemExpanded)
+		NFY_CTRLMSG(IDC_RIGHT_TREE, TVN_ITEMEXPANDED, &CompareDlg::OnRightItemExpanded)
+	END_CTRLMSG_TABLE
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Dialog initialisation handler.
+
+void CompareDlg::OnInitDialog()
+{
+	size_t nDiffs = std::count_if(m_vecItems.begin(), m_vecItems.end(), IsDifference);
+
+	if (m_vecItems.empty())
+	{
+		m_txtSummary.Text(Core::fmt(TXT("%s and %s are identical"), m_strLeft.c_str(), m_strRight.c_str()));
+	}
+	else
+	{
+		m_txtSummary.Text(Core::fmt(TXT("%s and %s have %u differences%s"), m_strLeft.c_str(), m_strRight.c_str(),
+									nDiffs, m_bComplete ? TXT("") : TXT(" (only the first are shown)")));
+	}
+
+	LoadTrees();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! OK button handler.
+
+bool CompareDlg::OnOk()
+{
+	ItemEntryMap::const_iterator it = m_mapLeftItems.find(m_tvLeft.Selection());
+
+	if ( (it != m_mapLeftItems.end()) && (m_vecItems[it->second].m_pLeft != nullptr) )
+	{
+		XML::Node* pNode = const_cast<XML::Node*>(m_vecItems[it->second].m_pLeft);
+
+		m_pSelection = NodeRef(pNode).ToPtr();
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Next Difference button handler. The search wraps back to the start after
+//! the last difference.
+
+void CompareDlg::OnNextDifference()
+{
+	if (m_vecItems.empty())
+		return;
+
+	ItemEntryMap::const_iterator it    = m_mapLeftItems.find(m_tvLeft.Selection());
+	size_t                       nFrom = (it != m_mapLeftItems.end()) ? it->second+1 : 0;
+	size_t                       nSize = m_vecItems.size();
+
+	for (size_t i = 0; i != nSize; ++i)
+	{
+		size_t nEntry = (nFrom + i) % nSize;
+
+		if (IsDifference(m_vecItems[nEntry]))
+		{
+			m_tvLeft.Select(m_vecLeftItems[nEntry]);
+			TreeView_EnsureVisible(m_tvLeft.Handle(), m_vecLeftItems[nEntry]);
+			m_tvLeft.Focus();
+			break;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Left item selected handler.
+
+LRESULT CompareDlg::OnLeftSelChanged(NMHDR& oMsgHdr)
+{
+	const NMTREEVIEW& oInfo = reinterpret_cast<const NMTREEVIEW&>(oMsgHdr);
+
+	SyncSelection(m_mapLeftItems, m_tvRight, m_vecRightItems, oInfo.itemNew.hItem);
+
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Right item selected handler.
+
+LRESULT CompareDlg::OnRightSelChanged(NMHDR& oMsgHdr)
+{
+	const NMTREEVIEW& oInfo = reinterpret_cast<const NMTREEVIEW&>(oMsgHdr);
+
+	SyncSelection(m_mapRightItems, m_tvLeft, m_vecLeftItems, oInfo.itemNew.hItem);
+
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Left item expanded or collapsed handler.
+
+LRESULT CompareDlg::OnLeftItemExpanded(NMHDR& oMsgHdr)
+{
+	SyncExpansion(m_mapLeftItems, m_tvRight, m_vecRightItems, reinterpret_cast<const NMTREEVIEW&>(oMsgHdr));
+
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Right item expanded or collapsed handler.
+
+LRESULT CompareDlg::OnRightItemExpanded(NMHDR& oMsgHdr)
+{
+	SyncExpansion(m_mapRightItems, m_tvLeft, m_vecLeftItems, reinterpret_cast<const NMTREEVIEW&>(oMsgHdr));
+
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Load the entries into both trees. The entries are in preorder with their
+//! depth, so the items are added with a stack of the parent items, and those
+//! on the path to a difference are expanded.
+
+void CompareDlg::LoadTrees()
+{
+	TreeItems vecLeftParents(1, TVI_ROOT);
+	TreeItems vecRightParents(1, TVI_ROOT);
+
+	m_bSyncing = true;
+
+	m_vecLeftItems.reserve(m_vecItems.size());
+	m_vecRightItems.reserve(m_vecItems.size());
+
+	for (size_t i = 0; i != m_vecItems.size(); ++i)
+	{
+		const DiffItem& oItem = m_vecItems[i];
+
+		vecLeftParents.resize(oItem.m_nDepth+1);
+		vecRightParents.resize(oItem.m_nDepth+1);
+
+		HTREEITEM hLeft  = m_tvLeft.InsertItem(vecLeftParents.back(), TVI_LAST, ItemText(oItem, oItem.m_pLeft).c_str());
+		HTREEITEM hRight = m_tvRight.InsertItem(vecRightParents.back(), TVI_LAST, ItemText(oItem, oItem.m_pRight).c_str());
+
+		m_vecLeftItems.push_back(hLeft);
+		m_vecRightItems.push_back(hRight);
+		m_mapLeftItems.insert(std::make_pair(hLeft, i));
+		m_mapRightItems.insert(std::make_pair(hRight, i));
+
+		vecLeftParents.push_back(hLeft);
+		vecRightParents.push_back(hRight);
+	}
+
+	// Expand the path to every difference.
+	for (size_t i = 0; i != m_vecItems.size(); ++i)
+	{
+		bool bHasEntries = ( (i+1 != m_vecItems.size()) && (m_vecItems[i+1].m_nDepth > m_vecItems[i].m_nDepth) );
+
+		if (bHasEntries)
+		{
+			TreeView_Expand(m_tvLeft.Handle(), m_vecLeftItems[i], TVE_EXPAND);
+			TreeView_Expand(m_tvRight.Handle(), m_vecRightItems[i], TVE_EXPAND);
+		}
+	}
+
+	m_bSyncing = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Select the same entry in the other tree and scroll it to the same item.
+
+void CompareDlg::SyncSelection(const ItemEntryMap& mapFrom, WCL::TreeView& tvTo, const TreeItems& vecTo, HTREEITEM hItem)
+{
+	if (m_bSyncing)
+		return;
+
+	ItemEntryMap::const_iterator it = mapFrom.find(hItem);
+
+	if (it == mapFrom.end())
+		return;
+
+	m_bSyncing = true;
+
+	tvTo.Select(vecTo[it->second]);
+	TreeView_EnsureVisible(tvTo.Handle(), vecTo[it->second]);
+
+	m_bSyncing = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Expand or collapse the same entry in the other tree.
+
+void CompareDlg::SyncExpansion(const ItemEntryMap& mapFrom, WCL::TreeView& tvTo, const TreeItems& vecTo, const NMTREEVIEW& oInfo)
+{
+	if (m_bSyncing)
+		return;
+
+	ItemEntryMap::const_iterator it = mapFrom.find(oInfo.itemNew.hItem);
+
+	if (it == mapFrom.end())
+		return;
+
+	m_bSyncing = true;
+
+	UINT nAction = (oInfo.action == TVE_EXPAND) ? TVE_EXPAND : TVE_COLLAPSE;
+
+	TreeView_Expand(tvTo.Handle(), vecTo[it->second], nAction);
+
+	m_bSyncing = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Generate the text for one side of an entry. A node that is missing from that
+//! side has a blank item, to keep the two trees aligned.
+
+tstring CompareDlg::ItemText(const DiffItem& oItem, const XML::Node* pNode)
+{
+	if (pNode == nullptr)
+		return TXT("");
+
+	tstring strItem = NodeSummary(pNode);
+
+	if (oItem.m_eType == DiffItem::IDENTICAL)
+	{
+		if (oItem.m_nCount > 1)
+			strItem += Core::fmt(TXT("  (+%u identical siblings)"), oItem.m_nCount-1);
+	}
+	else if (oItem.m_eType == DiffItem::CHANGED)
+	{
+		strItem = TXT("[*] ") + strItem;
+	}
+	else if (oItem.m_eType == DiffItem::ADDED)
+	{
+		strItem = TXT("[+] ") + strItem + Core::fmt(TXT("  (%u nodes)"), oItem.m_nCount);
+	}
+	else if (oItem.m_eType == DiffItem::REMOVED)
+	{
+		strItem = TXT("[-] ") + strItem + Core::fmt(TXT("  (%u nodes)"), oItem.m_nCount);
+	}
+
+	return strItem;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Generate a summary of a node, on a single line.
+
+tstring CompareDlg::NodeSummary(const XML::Node* pNode)
+{
+	XML::NodeType eType   = pNode->type();
+	tstring       strItem = pNode->typeStr();
+
+	if (eType == XML::DOCUMENT_NODE)
+	{
+		strItem = TXT("Document");
+	}
+	else if (eType == XML::ELEMENT_NODE)
+	{
+		const XML::ElementNode* pElement = static_cast<const XML::ElementNode*>(pNode);
+		const XML::Attributes&  oAttribs = pElement->getAttributes();
+
+		strItem = pElement->name();
+
+		for (XML::Attributes::const_iterator it = oAttribs.begin(); it != oAttribs.end(); ++it)
+			strItem += TXT(' ') + (*it)->name() + TXT("=\"") + (*it)->value() + TXT("\"");
+	}
+	else if (eType == XML::TEXT_NODE)
+	{
+		strItem = static_cast<const XML::TextNode*>(pNode)->text();
+	}
+	else if (eType == XML::PROCESSING_NODE)
+	{
+		strItem = static_cast<const XML::ProcessingNode*>(pNode)->target();
+	}
+	else if (eType == XML::DOCTYPE_NODE)
+	{
+		strItem = TXT("DOCTYPE");
+	}
+	else if (eType == XML::CDATA_NODE)
+	{
+		strItem = TXT("CDATA");
+	}
+
+	if (strItem.length() > MAX_SUMMARY_LEN)
+		strItem = strItem.substr(0, MAX_SUMMARY_LEN) + TXT("...");
+
+	// Keep it on a single line.
+	for (tstring::iterator it = strItem.begin(); it != strItem.end(); ++it)
+	{
+		if (tisspace(static_cast<utchar>(*it)))
+			*it = TXT(' ');
+	}
+
+	return strItem;
+}
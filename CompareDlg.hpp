@@ -0,0 +1,107 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   CompareDlg.hpp
+//! \brief  The CompareDlg class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef COMPAREDLG_HPP
+#define COMPAREDLG_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <WCL/CommonUI.hpp>
+#include <WCL/TreeView.hpp>
+#include "StructuralDiff.hpp"
+#include <map>
+
+////////////////////////////////////////////////////////////////////////////////
+//! The dialog used to display the differences between two documents. The two
+//! trees have an item for every entry, with a blank one where a node is only on
+//! one side, so that selecting or expanding an item in one can be mirrored by
+//! the same item in the other. Choosing a node selects it in the main tree.
+
+class CompareDlg : public CDialog
+{
+public:
+	//! Constructor.
+	CompareDlg(const tstring& strLeft, const tstring& strRight, const StructuralDiff::Items& vecItems, bool bComplete);
+
+	//
+	// Members.
+	//
+	XML::NodePtr	m_pSelection;	//!< The node chosen, if any.
+
+private:
+	//! The items for the entries.
+	typedef std::vector<HTREEITEM> TreeItems;
+	//! The map of item to entry.
+	typedef std::map<HTREEITEM, size_t> ItemEntryMap;
+
+	//
+	// Members.
+	//
+	tstring							m_strLeft;			//!< The left document's name.
+	tstring							m_strRight;			//!< The right document's name.
+	const StructuralDiff::Items&	m_vecItems;			//!< The differences.
+	bool							m_bComplete;		//!< Are all the differences listed?
+	TreeItems						m_vecLeftItems;		//!< The left items by entry.
+	TreeItems						m_vecRightItems;	//!< The right items by entry.
+	ItemEntryMap					m_mapLeftItems;		//!< The entries by left item.
+	ItemEntryMap					m_mapRightItems;	//!< The entries by right item.
+	bool							m_bSyncing;			//!< Is one tree being matched to the other?
+
+	//
+	// Controls.
+	//
+	CLabel			m_txtSummary;		//!< The summary label.
+	WCL::TreeView	m_tvLeft;			//!< The left document's tree.
+	WCL::TreeView	m_tvRight;			//!< The right document's tree.
+
+	//
+	// Message handlers.
+	//
+
+	//! Dialog initialisation handler.
+	virtual void OnInitDialog();
+
+	//! OK button handler.
+	virtual bool OnOk();
+
+	//! Next Difference button handler.
+	void OnNextDifference();
+
+	//! Left item selected handler.
+	LRESULT OnLeftSelChanged(NMHDR& oMsgHdr);
+
+	//! Right item selected handler.
+	LRESULT OnRightSelChanged(NMHDR& oMsgHdr);
+
+	//! Left item expanded or collapsed handler.
+	LRESULT OnLeftItemExpanded(NMHDR& oMsgHdr);
+
+	//! Right item expanded or collapsed handler.
+	LRESULT OnRightItemExpanded(NMHDR& oMsgHdr);
+
+	//
+	// Internal methods.
+	//
+
+	//! Load the entries into both trees.
+	void LoadTrees();
+
+	//! Select the same entry in the other tree.
+	void SyncSelection(const ItemEntryMap& mapFrom, WCL::TreeView& tvTo, const TreeItems& vecTo, HTREEITEM hItem);
+
+	//! Expand or collapse the same entry in the other tree.
+	void SyncExpansion(const ItemEntryMap& mapFrom, WCL::TreeView& tvTo, const TreeItems& vecTo, const NMTREEVIEW& oInfo);
+
+	//! Generate the text for one side of an entry.
+	static tstring ItemText(const DiffItem& oItem, const XML::Node* pNode);
+
+	//! Generate a summary of a node.
+	static tstring NodeSummary(const XML::Node* pNode);
+};
+
+#endif // COMPAREDLG_HPP
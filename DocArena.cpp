@@ -0,0 +1,491 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DocArena.cpp
+//! \brief  The DocArena class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "DocArena.hpp"
+#include <malloc.h>
+#include <new>
+
+//! The size of the chunks of address space an arena allocates from. A chunk
+//! is aligned to its size, so the chunk holding a block can be found from the
+//! block's address alone.
+static const size_t CHUNK_SIZE = 1024 * 1024;
+
+//! The largest block taken from an arena; bigger ones come from the CRT heap.
+static const size_t MAX_BLOCK_SIZE = 256;
+
+//! The alignment of, and granularity of the sizes of, the blocks.
+static const size_t BLOCK_ALIGNMENT = MEMORY_ALLOCATION_ALIGNMENT;
+
+//! The number of block size classes.
+static const size_t SIZE_CLASSES = MAX_BLOCK_SIZE / BLOCK_ALIGNMENT;
+
+//! The number of slots in the table of chunks.
+static const size_t CHUNK_SLOTS = 4096;
+
+//! The number of times to try reserving an aligned chunk.
+static const size_t MAX_RESERVE_ATTEMPTS = 8;
+
+////////////////////////////////////////////////////////////////////////////////
+//! The header at the start of every chunk. Its size is a multiple of the block
+//! alignment, so the first block follows it directly.
+
+struct ChunkHeader
+{
+	ArenaState*		m_pState;		//!< The arena the chunk belongs to.
+	ChunkHeader*	m_pNext;		//!< The arena's next chunk.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The header that precedes every block allocated from a chunk. The padding
+//! preserves the alignment of the block itself.
+
+union BlockHeader
+{
+	size_t		m_nClass;					//!< The block's size class.
+	byte		m_abPad[BLOCK_ALIGNMENT];	//!< Matches the CRT heap's alignment.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! A freed block waiting to be reused.
+
+struct FreeBlock
+{
+	FreeBlock*	m_pNext;		//!< The next block of the same size.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The state of an arena. It's shared by the arena and every block allocated
+//! from it, and is destroyed, along with the chunks, when the last of them
+//! lets go.
+
+struct ArenaState
+{
+	CRITICAL_SECTION	m_oLock;					//!< Guards the chunks and free lists.
+	volatile LONG		m_nRefs;					//!< The arena, if alive, plus each block.
+	volatile LONG		m_bRetired;					//!< Has the arena been destroyed?
+	volatile LONG		m_bCancelled;				//!< Do allocations in scope fail?
+	size_t				m_nLimit;					//!< The limit on the bytes allocated, or 0.
+	size_t				m_nBytes;					//!< The bytes allocated, if limited.
+	ChunkHeader*		m_pChunks;					//!< The chunks, newest first.
+	byte*				m_pNext;					//!< The next free byte in the newest chunk.
+	byte*				m_pEnd;						//!< The end of the newest chunk.
+	FreeBlock*			m_apFree[SIZE_CLASSES+1];	//!< The freed blocks, by size class.
+};
+
+//! The arena that operator new currently allocates from on this thread.
+static __declspec(thread) DocArena* g_pCurrent = nullptr;
+
+//! The address of every chunk in use, tagged with the low bit, in the slot for
+//! its address. An empty slot is null and so never matches.
+static void* volatile g_apChunks[CHUNK_SLOTS];
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the table slot for a chunk address.
+
+static size_t ChunkSlot(ULONG_PTR nChunk)
+{
+	return (nChunk / CHUNK_SIZE) % CHUNK_SLOTS;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the chunk a block was allocated from, or nullptr if it was allocated
+//! from the CRT heap.
+
+static ChunkHeader* FindChunk(const void* pBlock)
+{
+	ULONG_PTR nChunk = reinterpret_cast<ULONG_PTR>(pBlock) & ~static_cast<ULONG_PTR>(CHUNK_SIZE-1);
+
+	if (g_apChunks[ChunkSlot(nChunk)] != reinterpret_cast<void*>(nChunk | 1))
+		return nullptr;
+
+	return reinterpret_cast<ChunkHeader*>(nChunk);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Reserve and commit a new chunk aligned to its size and enter it in the
+//! table. Returns nullptr if there is no address space left, or no free slot.
+
+static ChunkHeader* CreateChunk(ArenaState* pState)
+{
+	for (size_t nAttempt = 0; nAttempt != MAX_RESERVE_ATTEMPTS; ++nAttempt)
+	{
+		// Find an aligned range by reserving twice the size, then take just that.
+		void* pRange = ::VirtualAlloc(NULL, CHUNK_SIZE*2, MEM_RESERVE, PAGE_NOACCESS);
+
+		if (pRange == nullptr)
+			return nullptr;
+
+		ULONG_PTR nChunk = (reinterpret_cast<ULONG_PTR>(pRange) + CHUNK_SIZE-1) & ~static_cast<ULONG_PTR>(CHUNK_SIZE-1);
+
+		::VirtualFree(pRange, 0, MEM_RELEASE);
+
+		void* pChunk = ::VirtualAlloc(reinterpret_cast<void*>(nChunk), CHUNK_SIZE, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+
+		// Taken by another thread in the meantime?
+		if (pChunk == nullptr)
+			continue;
+
+		void* volatile* ppSlot = &g_apChunks[ChunkSlot(nChunk)];
+
+		// The slot can only be taken in a 64-bit build.
+		if (::InterlockedCompareExchangePointer(ppSlot, reinterpret_cast<void*>(nChunk | 1), nullptr) != nullptr)
+		{
+			::VirtualFree(pChunk, 0, MEM_RELEASE);
+			continue;
+		}
+
+		ChunkHeader* pHeader = static_cast<ChunkHeader*>(pChunk);
+
+		pHeader->m_pState = pState;
+		pHeader->m_pNext  = pState->m_pChunks;
+
+		return pHeader;
+	}
+
+	return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Remove a chunk from the table and return it to the system.
+
+static void DestroyChunk(ChunkHeader* pChunk)
+{
+	ULONG_PTR nChunk = reinterpret_cast<ULONG_PTR>(pChunk);
+
+	::InterlockedExchangePointer(&g_apChunks[ChunkSlot(nChunk)], nullptr);
+	::VirtualFree(pChunk, 0, MEM_RELEASE);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Drop a reference to an arena's state, destroying it and its chunks if that
+//! was the last one.
+
+static void ReleaseState(ArenaState* pState)
+{
+	if (::InterlockedDecrement(&pState->m_nRefs) != 0)
+		return;
+
+	for (ChunkHeader* pChunk = pState->m_pChunks; pChunk != nullptr; )
+	{
+		ChunkHeader* pNext = pChunk->m_pNext;
+
+		DestroyChunk(pChunk);
+
+		pChunk = pNext;
+	}
+
+	::DeleteCriticalSection(&pState->m_oLock);
+	free(pState);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Count memory against an arena's limit, if it has one. Once the limit has
+//! been reached the arena is cancelled. The lock must be held.
+
+static bool Charge(ArenaState* pState, size_t nBytes)
+{
+	if (pState->m_nLimit == 0)
+		return true;
+
+	if (nBytes > pState->m_nLimit - std::min(pState->m_nBytes, pState->m_nLimit))
+	{
+		::InterlockedExchange(&pState->m_bCancelled, TRUE);
+		return false;
+	}
+
+	pState->m_nBytes += nBytes;
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Allocate a block from an arena, reusing a freed block of the same size if
+//! there is one. Returns nullptr if a new chunk is needed and can't be had.
+
+static void* AllocateBlock(ArenaState* pState, size_t nSize)
+{
+	size_t       nClass  = (nSize != 0) ? (nSize + BLOCK_ALIGNMENT-1) / BLOCK_ALIGNMENT : 1;
+	size_t       nTotal  = sizeof(BlockHeader) + (nClass * BLOCK_ALIGNMENT);
+	BlockHeader* pHeader = nullptr;
+
+	::EnterCriticalSection(&pState->m_oLock);
+
+	FreeBlock* pFree = pState->m_apFree[nClass];
+
+	if (pFree != nullptr)
+	{
+		pState->m_apFree[nClass] = pFree->m_pNext;
+		pHeader = reinterpret_cast<BlockHeader*>(pFree) - 1;
+	}
+	else
+	{
+		if ( (static_cast<size_t>(pState->m_pEnd - pState->m_pNext) < nTotal) && (Charge(pState, CHUNK_SIZE)) )
+		{
+			ChunkHeader* pChunk = CreateChunk(pState);
+
+			if (pChunk != nullptr)
+			{
+				pState->m_pChunks = pChunk;
+				pState->m_pNext   = reinterpret_cast<byte*>(pChunk + 1);
+				pState->m_pEnd    = reinterpret_cast<byte*>(pChunk) + CHUNK_SIZE;
+			}
+		}
+
+		if (static_cast<size_t>(pState->m_pEnd - pState->m_pNext) >= nTotal)
+		{
+			pHeader = reinterpret_cast<BlockHeader*>(pState->m_pNext);
+			pHeader->m_nClass = nClass;
+			pState->m_pNext += nTotal;
+		}
+	}
+
+	::LeaveCriticalSection(&pState->m_oLock);
+
+	if (pHeader == nullptr)
+		return nullptr;
+
+	::InterlockedIncrement(&pState->m_nRefs);
+
+	return pHeader + 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+DocArena::DocArena()
+	: m_pState(static_cast<ArenaState*>(malloc(sizeof(ArenaState))))
+{
+	if (m_pState == nullptr)
+		throw std::bad_alloc();
+
+	memset(m_pState, 0, sizeof(ArenaState));
+
+	::InitializeCriticalSection(&m_pState->m_oLock);
+
+	m_pState->m_nRefs = 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor. The chunks are released once every block allocated from them
+//! has been freed, which may be straight away. Until then the blocks that
+//! remain are only counted when they're freed, not put back for reuse.
+
+DocArena::~DocArena()
+{
+	ASSERT(g_pCurrent != this);
+
+	::InterlockedExchange(&m_pState->m_bRetired, TRUE);
+
+	ReleaseState(m_pState);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of blocks still allocated from the arena.
+
+size_t DocArena::Blocks() const
+{
+	return m_pState->m_nRefs - 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the arena has been cancelled or has reached its limit.
+
+bool DocArena::IsCancelled() const
+{
+	return (m_pState->m_bCancelled != FALSE);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Limit the memory allocated within the arena's scope. The arena's chunks and
+//! any larger blocks are counted, the latter until the arena is destroyed as
+//! they aren't tracked once allocated. A limit of 0 means no limit.
+
+void DocArena::SetLimit(size_t nMaxBytes)
+{
+	::EnterCriticalSection(&m_pState->m_oLock);
+
+	m_pState->m_nLimit = nMaxBytes;
+
+	::LeaveCriticalSection(&m_pState->m_oLock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Make any further allocation within the arena's scope fail. This can be
+//! called from any thread. The blocks already allocated are unaffected.
+
+void DocArena::Cancel()
+{
+	::InterlockedExchange(&m_pState->m_bCancelled, TRUE);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Allocate a block from the current arena, or the CRT heap if none or the
+//! block is too large for it. Returns nullptr if the memory could not be
+//! allocated, or the current arena has been cancelled.
+
+void* DocArena::Allocate(size_t nSize)
+{
+	if (g_pCurrent != nullptr)
+	{
+		ArenaState* pState = g_pCurrent->m_pState;
+
+		if (pState->m_bCancelled)
+			return nullptr;
+
+		if (nSize <= MAX_BLOCK_SIZE)
+		{
+			void* pBlock = AllocateBlock(pState, nSize);
+
+			if (pBlock != nullptr)
+				return pBlock;
+
+			// Refused a chunk by the limit?
+			if (pState->m_bCancelled)
+				return nullptr;
+		}
+
+		if (pState->m_nLimit != 0)
+		{
+			::EnterCriticalSection(&pState->m_oLock);
+
+			bool bCharged = Charge(pState, nSize);
+
+			::LeaveCriticalSection(&pState->m_oLock);
+
+			if (!bCharged)
+				return nullptr;
+		}
+	}
+
+	return malloc(nSize);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Free a block returned by Allocate(). A block from an arena goes back to it,
+//! regardless of which arena is now current. A block from an arena that has
+//! been destroyed is only counted, as its chunk is about to be released.
+
+void DocArena::Free(void* pBlock)
+{
+	if (pBlock == nullptr)
+		return;
+
+	ChunkHeader* pChunk = FindChunk(pBlock);
+
+	if (pChunk == nullptr)
+	{
+		free(pBlock);
+		return;
+	}
+
+	ArenaState* pState = pChunk->m_pState;
+
+	if (!pState->m_bRetired)
+	{
+		BlockHeader* pHeader = static_cast<BlockHeader*>(pBlock) - 1;
+		FreeBlock*   pFree   = static_cast<FreeBlock*>(pBlock);
+
+		::EnterCriticalSection(&pState->m_oLock);
+
+		pFree->m_pNext = pState->m_apFree[pHeader->m_nClass];
+		pState->m_apFree[pHeader->m_nClass] = pFree;
+
+		::LeaveCriticalSection(&pState->m_oLock);
+	}
+
+	ReleaseState(pState);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+DocArena::Scope::Scope(DocArena* pArena)
+	: m_pPrevious(g_pCurrent)
+{
+	g_pCurrent = pArena;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+DocArena::Scope::~Scope()
+{
+	g_pCurrent = m_pPrevious;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Global operator new, redirected via the arena.
+
+void* __cdecl operator new(size_t nSize)
+{
+	void* pBlock = DocArena::Allocate(nSize);
+
+	if (pBlock == nullptr)
+		throw std::bad_alloc();
+
+	return pBlock;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Global operator new[], redirected via the arena.
+
+void* __cdecl operator new[](size_t nSize)
+{
+	return operator new(nSize);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Global non-throwing operator new, redirected via the arena.
+
+void* __cdecl operator new(size_t nSize, const std::nothrow_t&) throw()
+{
+	return DocArena::Allocate(nSize);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Global non-throwing operator new[], redirected via the arena.
+
+void* __cdecl operator new[](size_t nSize, const std::nothrow_t&) throw()
+{
+	return DocArena::Allocate(nSize);
+}
+
+#ifdef _DEBUG
+
+////////////////////////////////////////////////////////////////////////////////
+//! Debug CRT operator new, redirected via the arena as its blocks are released
+//! with the ordinary operator delete.
+
+void* __cdecl operator new(size_t nSize, int /*nBlockUse*/, const char* /*pszFile*/, int /*nLine*/)
+{
+	return operator new(nSize);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Debug CRT operator new[], redirected via the arena.
+
+void* __cdecl operator new[](size_t nSize, int /*nBlockUse*/, const char* /*pszFile*/, int /*nLine*/)
+{
+	return operator new(nSize);
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//! Global operator delete, redirected via the arena.
+
+void __cdecl operator delete(void* pBlock) throw()
+{
+	DocArena::Free(pBlock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Global operator delete[], redirected via the arena.
+
+void __cdecl operator delete[](void* pBlock) throw()
+{
+	DocArena::Free(pBlock);
+}
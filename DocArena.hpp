@@ -0,0 +1,94 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DocArena.hpp
+//! \brief  The DocArena class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_DOCARENA_HPP
+#define APP_DOCARENA_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+// Forward declarations.
+struct ArenaState;
+
+////////////////////////////////////////////////////////////////////////////////
+//! The memory for the nodes and strings of a single document. While a Scope is
+//! active on a thread the global operator new takes the small blocks that make
+//! up nodes, attributes and short strings from the arena; larger blocks, and
+//! everything allocated outside a scope, come from the CRT heap unchanged. The
+//! arena's blocks are carved from 1 MB chunks that are returned to the system
+//! when the arena has been destroyed and the last of its blocks freed. Freeing
+//! a block after that only counts it. An arena can be given a limit, and can
+//! be cancelled from another thread, after which allocations within its scope
+//! fail, so that whatever is building the nodes unwinds with std::bad_alloc.
+
+class DocArena : private Core::NotCopyable
+{
+public:
+	//! Constructor.
+	DocArena();
+
+	//! Destructor.
+	~DocArena();
+
+	//
+	// Properties.
+	//
+
+	//! Get the number of blocks still allocated from the arena.
+	size_t Blocks() const;
+
+	//! Query if the arena has been cancelled or has reached its limit.
+	bool IsCancelled() const;
+
+	//
+	// Methods.
+	//
+
+	//! Limit the memory allocated within the arena's scope.
+	void SetLimit(size_t nMaxBytes);
+
+	//! Make any further allocation within the arena's scope fail.
+	void Cancel();
+
+	//
+	// Class methods.
+	//
+
+	//! Allocate a block from the current arena, or the CRT heap if none.
+	static void* Allocate(size_t nSize);
+
+	//! Free a block returned by Allocate().
+	static void Free(void* pBlock);
+
+	////////////////////////////////////////////////////////////////////////////
+	//! Makes an arena the target of operator new on the current thread for the
+	//! lifetime of the scope. A null arena leaves the CRT heap as the target.
+
+	class Scope : private Core::NotCopyable
+	{
+	public:
+		//! Constructor.
+		Scope(DocArena* pArena);
+
+		//! Destructor.
+		~Scope();
+
+	private:
+		//
+		// Members.
+		//
+		DocArena*	m_pPrevious;	//!< The arena that was previously current.
+	};
+
+private:
+	//
+	// Members.
+	//
+	ArenaState*	m_pState;		//!< The chunks and free lists, shared with its blocks.
+};
+
+#endif // APP_DOCARENA_HPP
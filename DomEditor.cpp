@@ -0,0 +1,569 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DomEditor.cpp
+//! \brief  The DomEditor class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "DomEditor.hpp"
+#include <XML/Document.hpp>
+#include <XML/ElementNode.hpp>
+#include <XML/TextNode.hpp>
+#include <XML/CDataNode.hpp>
+#include "DocArena.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the text held by a text or CDATA node itself.
+
+static const tstring& NodeText(NodeRef pNode)
+{
+	if (pNode->type() == XML::CDATA_NODE)
+		return pNode.As<XML::CDataNode>()->text();
+
+	return pNode.As<XML::TextNode>()->text();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Replace the text held by a text or CDATA node itself.
+
+static void SetNodeText(NodeRef pNode, const tstring& strText)
+{
+	if (pNode->type() == XML::CDATA_NODE)
+		pNode.As<XML::CDataNode>()->setText(strText);
+	else
+		pNode.As<XML::TextNode>()->setText(strText);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+DomEditor::DomEditor()
+	: m_pArena(nullptr)
+	, m_bModified(false)
+	, m_nBatchDepth(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+DomEditor::~DomEditor()
+{
+	DiscardText();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Register a listener for changes.
+
+void DomEditor::AddListener(IDomListener* pListener)
+{
+	ASSERT(std::find(m_vecListeners.begin(), m_vecListeners.end(), pListener) == m_vecListeners.end());
+
+	m_vecListeners.push_back(pListener);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Unregister a listener for changes.
+
+void DomEditor::RemoveListener(IDomListener* pListener)
+{
+	m_vecListeners.erase(std::remove(m_vecListeners.begin(), m_vecListeners.end(), pListener), m_vecListeners.end());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Start a batch of changes. The calls can be nested, in which case only the
+//! outermost batch is published.
+
+void DomEditor::BeginBatch()
+{
+	if (m_nBatchDepth++ != 0)
+		return;
+
+	for (Listeners::const_iterator it = m_vecListeners.begin(); it != m_vecListeners.end(); ++it)
+		(*it)->OnBatchStarted();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Finish a batch of changes.
+
+void DomEditor::EndBatch()
+{
+	ASSERT(m_nBatchDepth != 0);
+
+	if (--m_nBatchDepth != 0)
+		return;
+
+	for (Listeners::const_iterator it = m_vecListeners.begin(); it != m_vecListeners.end(); ++it)
+		(*it)->OnBatchFinished();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Insert a node into a container. The node must not already have a parent.
+
+void DomEditor::InsertNode(NodeRef pParent, size_t nIndex, const XML::NodePtr& pNode)
+{
+	ASSERT(!pNode->hasParent());
+
+	XML::NodeContainer& oContainer = Container(pParent);
+
+	ASSERT(nIndex <= oContainer.getChildCount());
+
+	Prepare();
+
+	{
+		DocArena::Scope oScope(m_pArena);
+
+		oContainer.insertChild(nIndex, pNode);
+	}
+
+	DomChange oChange(DomChange::NODE_INSERTED, pNode);
+
+	oChange.m_pParent = pParent;
+	oChange.m_nIndex  = nIndex;
+
+	Publish(oChange);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Remove a node from its container. The node is returned so that the caller
+//! can decide whether it lives on, e.g. to be inserted again by an undo.
+
+XML::NodePtr DomEditor::RemoveNode(NodeRef pNode)
+{
+	ASSERT(pNode->hasParent());
+
+	NodeRef pParent = pNode->parent();
+
+	return RemoveChild(pParent, IndexOf(Container(pParent), pNode));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Remove the node at a position in a container. This avoids searching for the
+//! node when the caller already knows where it is.
+
+XML::NodePtr DomEditor::RemoveChild(NodeRef pParent, size_t nIndex)
+{
+	XML::NodeContainer& oContainer = Container(pParent);
+
+	ASSERT(nIndex < oContainer.getChildCount());
+
+	XML::NodePtr pRemoved = *(oContainer.beginChild() + nIndex);
+
+	Prepare();
+
+	{
+		DocArena::Scope oScope(m_pArena);
+
+		oContainer.removeChild(nIndex);
+	}
+
+	DomChange oChange(DomChange::NODE_REMOVED, pRemoved);
+
+	oChange.m_pOldParent = pParent;
+	oChange.m_nOldIndex  = nIndex;
+
+	Publish(oChange);
+
+	return pRemoved;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Move a node to a position in a container. The position is the one it will
+//! have after it has been removed from its current container.
+
+void DomEditor::MoveNode(NodeRef pNode, NodeRef pParent, size_t nIndex)
+{
+	ASSERT(pNode->hasParent());
+
+	NodeRef pOldParent = pNode->parent();
+
+	MoveChild(pOldParent, IndexOf(Container(pOldParent), pNode), pParent, nIndex);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Move the node at a position in a container to a position in another. The
+//! new position is the one it will have after it has been removed.
+
+void DomEditor::MoveChild(NodeRef pOldParent, size_t nOldIndex, NodeRef pParent, size_t nIndex)
+{
+	XML::NodeContainer& oOldContainer = Container(pOldParent);
+
+	ASSERT(nOldIndex < oOldContainer.getChildCount());
+
+	XML::NodePtr        pMoved     = *(oOldContainer.beginChild() + nOldIndex);
+	XML::NodeContainer& oContainer = Container(pParent);
+
+	Prepare();
+
+	{
+		DocArena::Scope oScope(m_pArena);
+
+		oOldContainer.removeChild(nOldIndex);
+
+		ASSERT(nIndex <= oContainer.getChildCount());
+
+		oContainer.insertChild(nIndex, pMoved);
+	}
+
+	DomChange oChange(DomChange::NODE_MOVED, pMoved);
+
+	oChange.m_pParent    = pParent;
+	oChange.m_nIndex     = nIndex;
+	oChange.m_pOldParent = pOldParent;
+	oChange.m_nOldIndex  = nOldIndex;
+
+	Publish(oChange);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Move all the children of a container to another, empty, one, keeping their
+//! order. This is published as a single change, rather than one per child, and
+//! the children are removed from the end so that the rest aren't shuffled down
+//! each time.
+
+void DomEditor::MoveChildren(NodeRef pOldParent, NodeRef pParent)
+{
+	ASSERT(pOldParent.get() != pParent.get());
+
+	XML::NodeContainer& oOldContainer = Container(pOldParent);
+	XML::NodeContainer& oContainer    = Container(pParent);
+
+	ASSERT(!oContainer.hasChildren());
+
+	if (!oOldContainer.hasChildren())
+		return;
+
+	XML::Nodes vecMoved(oOldContainer.beginChild(), oOldContainer.endChild());
+
+	Prepare();
+
+	{
+		DocArena::Scope oScope(m_pArena);
+
+		for (size_t i = vecMoved.size(); i != 0; --i)
+			oOldContainer.removeChild(i-1);
+
+		for (XML::Nodes::const_iterator it = vecMoved.begin(); it != vecMoved.end(); ++it)
+			oContainer.appendChild(*it);
+	}
+
+	DomChange oChange(DomChange::CHILDREN_MOVED, pParent);
+
+	oChange.m_pParent    = pParent;
+	oChange.m_pOldParent = pOldParent;
+
+	Publish(oChange);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Set the value of an element's attribute, adding it if required.
+
+void DomEditor::SetAttribute(NodeRef pElement, const tstring& strName, const tstring& strValue)
+{
+	ASSERT(pElement->type() == XML::ELEMENT_NODE);
+
+	XML::Attributes& vAttribs = pElement.As<XML::ElementNode>()->getAttributes();
+	DomChange        oChange(DomChange::ATTRIBUTE_CHANGED, pElement);
+
+	oChange.m_strName = strName;
+
+	SaveAttribute(vAttribs, oChange);
+
+	Prepare();
+
+	{
+		DocArena::Scope oScope(m_pArena);
+
+		vAttribs.set(strName, strValue);
+	}
+
+	Publish(oChange);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Remove an element's attribute.
+
+void DomEditor::RemoveAttribute(NodeRef pElement, const tstring& strName)
+{
+	ASSERT(pElement->type() == XML::ELEMENT_NODE);
+
+	XML::Attributes& vAttribs = pElement.As<XML::ElementNode>()->getAttributes();
+	DomChange        oChange(DomChange::ATTRIBUTE_CHANGED, pElement);
+
+	oChange.m_strName = strName;
+
+	SaveAttribute(vAttribs, oChange);
+
+	if (!oChange.m_bHadValue)
+		return;
+
+	Prepare();
+
+	{
+		DocArena::Scope oScope(m_pArena);
+
+		vAttribs.remove(strName);
+	}
+
+	Publish(oChange);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Replace the text of a text node. Any buffer for the text being edited in
+//! place is discarded.
+
+void DomEditor::SetText(NodeRef pNode, const tstring& strText)
+{
+	ASSERT(pNode->type() == XML::TEXT_NODE);
+
+	DomChange oChange(DomChange::TEXT_CHANGED, pNode);
+
+	oChange.m_strOldValue = Text(pNode);
+
+	TextBuffers::iterator it = m_mapText.find(pNode.get());
+
+	if (it != m_mapText.end())
+	{
+		delete it->second;
+		m_mapText.erase(it);
+	}
+
+	Prepare();
+
+	{
+		DocArena::Scope oScope(m_pArena);
+
+		SetNodeText(pNode, strText);
+	}
+
+	Publish(oChange);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Replace a range of the text of a text or CDATA node. The first edit moves
+//! the text into a rope and later ones are made there, so the node's own
+//! string is left stale until FlattenText() is called.
+
+void DomEditor::EditText(NodeRef pNode, size_t nOffset, size_t nCount, const tstring& strText)
+{
+	ASSERT( (pNode->type() == XML::TEXT_NODE) || (pNode->type() == XML::CDATA_NODE) );
+
+	TextBuffer* pBuffer = FindText(pNode);
+
+	if (pBuffer == nullptr)
+	{
+		pBuffer = new TextBuffer;
+
+		pBuffer->m_pNode  = pNode.ToPtr();
+		pBuffer->m_bDirty = false;
+		m_mapText[pNode.get()] = pBuffer;
+
+		pBuffer->m_oText.Assign(NodeText(pNode));
+	}
+
+	ASSERT(nOffset + nCount <= pBuffer->m_oText.Length());
+
+	DomChange oChange(DomChange::TEXT_EDITED, pNode);
+
+	oChange.m_nOffset     = nOffset;
+	oChange.m_strOldValue = pBuffer->m_oText.Text(nOffset, nCount);
+	oChange.m_strNewText  = strText;
+
+	pBuffer->m_oText.Erase(nOffset, nCount);
+	pBuffer->m_oText.Insert(nOffset, strText);
+	pBuffer->m_bDirty = true;
+
+	Publish(oChange);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the current text of a text or CDATA node.
+
+tstring DomEditor::Text(NodeRef pNode) const
+{
+	const TextBuffer* pBuffer = FindText(pNode);
+
+	if (pBuffer != nullptr)
+		return pBuffer->m_oText.Text();
+
+	return NodeText(pNode);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get a range of the current text of a text or CDATA node. This avoids
+//! copying the whole value when only part of it is shown.
+
+tstring DomEditor::Text(NodeRef pNode, size_t nOffset, size_t nCount) const
+{
+	const TextBuffer* pBuffer = FindText(pNode);
+
+	if (pBuffer != nullptr)
+		return pBuffer->m_oText.Text(nOffset, nCount);
+
+	const tstring& strText = NodeText(pNode);
+
+	ASSERT(nOffset <= strText.length());
+
+	return strText.substr(nOffset, nCount);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the length of the current text of a text or CDATA node.
+
+size_t DomEditor::TextLength(NodeRef pNode) const
+{
+	const TextBuffer* pBuffer = FindText(pNode);
+
+	if (pBuffer != nullptr)
+		return pBuffer->m_oText.Length();
+
+	return NodeText(pNode).length();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write the text of the nodes edited in place back to them. This must be done
+//! before the DOM is saved, serialised or queried. The buffers are kept so that
+//! editing can continue without taking over the text again.
+
+void DomEditor::FlattenText()
+{
+	for (TextBuffers::const_iterator it = m_mapText.begin(); it != m_mapText.end(); ++it)
+	{
+		if (it->second->m_bDirty)
+			FlattenBuffer(it->second);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write the text of the nodes edited in place within a sub-tree back to them,
+//! leaving the text of those elsewhere in their buffers.
+
+void DomEditor::FlattenText(NodeRef pRoot)
+{
+	for (TextBuffers::const_iterator it = m_mapText.begin(); it != m_mapText.end(); ++it)
+	{
+		if ( (it->second->m_bDirty) && (IsWithin(NodeRef(it->second->m_pNode), pRoot)) )
+			FlattenBuffer(it->second);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Discard the buffers for the text of the nodes edited in place. The buffers
+//! hold nodes from the document, so this must be done before the document's
+//! arena is destroyed.
+
+void DomEditor::DiscardText()
+{
+	for (TextBuffers::const_iterator it = m_mapText.begin(); it != m_mapText.end(); ++it)
+		delete it->second;
+
+	m_mapText.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the children of a document or element node.
+
+XML::NodeContainer& DomEditor::Container(NodeRef pNode)
+{
+	ASSERT( (pNode->type() == XML::DOCUMENT_NODE) || (pNode->type() == XML::ELEMENT_NODE) );
+
+	if (pNode->type() == XML::DOCUMENT_NODE)
+		return *pNode.As<XML::Document>();
+
+	return *pNode.As<XML::ElementNode>();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the position of a node in its container.
+
+size_t DomEditor::IndexOf(const XML::NodeContainer& oContainer, NodeRef pNode)
+{
+	typedef XML::NodeContainer::const_iterator CIter;
+
+	for (CIter it = oContainer.beginChild(); it != oContainer.endChild(); ++it)
+	{
+		if (it->get() == pNode.get())
+			return it - oContainer.beginChild();
+	}
+
+	ASSERT_FALSE();
+	return oContainer.getChildCount();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if a node is, or is inside, another one.
+
+bool DomEditor::IsWithin(NodeRef pNode, NodeRef pAncestor)
+{
+	for (;;)
+	{
+		if (pNode.get() == pAncestor.get())
+			return true;
+
+		if (!pNode->hasParent())
+			return false;
+
+		pNode = pNode->parent();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the buffer for the text of a node, if it has one.
+
+DomEditor::TextBuffer* DomEditor::FindText(NodeRef pNode) const
+{
+	TextBuffers::const_iterator it = m_mapText.find(pNode.get());
+
+	return (it != m_mapText.end()) ? it->second : nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Save the current value of the changed attribute, if it exists.
+
+void DomEditor::SaveAttribute(const XML::Attributes& vAttribs, DomChange& oChange)
+{
+	XML::AttributePtr pAttrib = vAttribs.find(oChange.m_strName);
+
+	oChange.m_bHadValue = (pAttrib.get() != nullptr);
+
+	if (oChange.m_bHadValue)
+		oChange.m_strOldValue = pAttrib->value();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write the text in a buffer back to its node.
+
+void DomEditor::FlattenBuffer(TextBuffer* pBuffer)
+{
+	tstring strText = pBuffer->m_oText.Text();
+
+	Prepare();
+
+	{
+		DocArena::Scope oScope(m_pArena);
+
+		SetNodeText(pBuffer->m_pNode, strText);
+	}
+
+	pBuffer->m_bDirty = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Tell the listeners that a node is about to be modified.
+
+void DomEditor::Prepare()
+{
+	for (Listeners::const_iterator it = m_vecListeners.begin(); it != m_vecListeners.end(); ++it)
+		(*it)->OnDomChanging();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Publish a change to the listeners. This is done outside the arena so that
+//! the listeners' own state is not allocated from the document.
+
+void DomEditor::Publish(const DomChange& oChange)
+{
+	m_bModified = true;
+
+	for (Listeners::const_iterator it = m_vecListeners.begin(); it != m_vecListeners.end(); ++it)
+		(*it)->OnDomChanged(oChange);
+}
@@ -0,0 +1,210 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DomEditor.hpp
+//! \brief  The DomEditor class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_DOMEDITOR_HPP
+#define APP_DOMEDITOR_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <XML/NodeContainer.hpp>
+#include <XML/Attributes.hpp>
+#include "IDomListener.hpp"
+#include "TextRope.hpp"
+#include <map>
+
+// Forward declarations.
+class DocArena;
+
+////////////////////////////////////////////////////////////////////////////////
+//! The single route by which the DOM is modified. Each primitive edit is made
+//! inside the document's arena and then published to the listeners as a fine
+//! grained change, so that they can update only what is affected. The text of
+//! a text or CDATA node that is edited in place is held in a rope until the
+//! document is saved or serialised, so that each edit only copies the part of
+//! the value around it.
+
+class DomEditor : private Core::NotCopyable
+{
+public:
+	//! Default constructor.
+	DomEditor();
+
+	//! Destructor.
+	~DomEditor();
+
+	//
+	// Properties.
+	//
+
+	//! Get the arena that new nodes should be allocated from.
+	DocArena* Arena() const;
+
+	//! Set the arena that new nodes should be allocated from.
+	void SetArena(DocArena* pArena);
+
+	//! Query if the DOM has been edited since it was loaded or saved.
+	bool IsModified() const;
+
+	//! Set the modified state.
+	void SetModified(bool bModified);
+
+	//
+	// Methods.
+	//
+
+	//! Register a listener for changes.
+	void AddListener(IDomListener* pListener);
+
+	//! Unregister a listener for changes.
+	void RemoveListener(IDomListener* pListener);
+
+	//! Start a batch of changes.
+	void BeginBatch();
+
+	//! Finish a batch of changes.
+	void EndBatch();
+
+	//! Insert a node into a container.
+	void InsertNode(NodeRef pParent, size_t nIndex, const XML::NodePtr& pNode);
+
+	//! Remove a node from its container.
+	XML::NodePtr RemoveNode(NodeRef pNode);
+
+	//! Remove the node at a position in a container.
+	XML::NodePtr RemoveChild(NodeRef pParent, size_t nIndex);
+
+	//! Move a node to a position in a container.
+	void MoveNode(NodeRef pNode, NodeRef pParent, size_t nIndex);
+
+	//! Move the node at a position in a container to a position in another.
+	void MoveChild(NodeRef pOldParent, size_t nOldIndex, NodeRef pParent, size_t nIndex);
+
+	//! Move all the children of a container to another, empty, one.
+	void MoveChildren(NodeRef pOldParent, NodeRef pParent);
+
+	//! Set the value of an element's attribute, adding it if required.
+	void SetAttribute(NodeRef pElement, const tstring& strName, const tstring& strValue);
+
+	//! Remove an element's attribute.
+	void RemoveAttribute(NodeRef pElement, const tstring& strName);
+
+	//! Replace the text of a text node.
+	void SetText(NodeRef pNode, const tstring& strText);
+
+	//! Replace a range of the text of a text or CDATA node.
+	void EditText(NodeRef pNode, size_t nOffset, size_t nCount, const tstring& strText);
+
+	//! Get the current text of a text or CDATA node.
+	tstring Text(NodeRef pNode) const;
+
+	//! Get a range of the current text of a text or CDATA node.
+	tstring Text(NodeRef pNode, size_t nOffset, size_t nCount) const;
+
+	//! Get the length of the current text of a text or CDATA node.
+	size_t TextLength(NodeRef pNode) const;
+
+	//! Write the text of the nodes edited in place back to them.
+	void FlattenText();
+
+	//! Write the text of the nodes edited in place within a sub-tree back to them.
+	void FlattenText(NodeRef pRoot);
+
+	//! Discard the buffers for the text of the nodes edited in place.
+	void DiscardText();
+
+	//
+	// Class methods.
+	//
+
+	//! Get the children of a document or element node.
+	static XML::NodeContainer& Container(NodeRef pNode);
+
+	//! Find the position of a node in its container.
+	static size_t IndexOf(const XML::NodeContainer& oContainer, NodeRef pNode);
+
+	//! Query if a node is, or is inside, another one.
+	static bool IsWithin(NodeRef pNode, NodeRef pAncestor);
+
+private:
+	////////////////////////////////////////////////////////////////////////////
+	//! The text of a node that is being edited in place.
+
+	struct TextBuffer
+	{
+		XML::NodePtr	m_pNode;	//!< The node the text belongs to.
+		TextRope		m_oText;	//!< The current text.
+		bool			m_bDirty;	//!< Has the node's own text not been updated?
+	};
+
+	//! The collection of listeners.
+	typedef std::vector<IDomListener*> Listeners;
+	//! The map of node to text buffer.
+	typedef std::map<const XML::Node*, TextBuffer*> TextBuffers;
+
+	//
+	// Members.
+	//
+	DocArena*	m_pArena;		//!< The arena the DOM is allocated from.
+	bool		m_bModified;	//!< Has the DOM been edited?
+	Listeners	m_vecListeners;	//!< The listeners for changes.
+	size_t		m_nBatchDepth;	//!< The nesting of BeginBatch() calls.
+	TextBuffers	m_mapText;		//!< The text of the nodes edited in place.
+
+	//
+	// Internal methods.
+	//
+
+	//! Write the text in a buffer back to its node.
+	void FlattenBuffer(TextBuffer* pBuffer);
+
+	//! Tell the listeners that a node is about to be modified.
+	void Prepare();
+
+	//! Publish a change to the listeners.
+	void Publish(const DomChange& oChange);
+
+	//! Find the buffer for the text of a node, if it has one.
+	TextBuffer* FindText(NodeRef pNode) const;
+
+	//! Save the current value of the changed attribute, if it exists.
+	static void SaveAttribute(const XML::Attributes& vAttribs, DomChange& oChange);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the arena that new nodes should be allocated from.
+
+inline DocArena* DomEditor::Arena() const
+{
+	return m_pArena;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Set the arena that new nodes should be allocated from.
+
+inline void DomEditor::SetArena(DocArena* pArena)
+{
+	m_pArena = pArena;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the DOM has been edited since it was loaded or saved.
+
+inline bool DomEditor::IsModified() const
+{
+	return m_bModified;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Set the modified state.
+
+inline void DomEditor::SetModified(bool bModified)
+{
+	m_bModified = bModified;
+}
+
+#endif // APP_DOMEDITOR_HPP
@@ -0,0 +1,533 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DtdModel.cpp
+//! \brief  The DtdModel class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "DtdModel.hpp"
+#include <algorithm>
+
+// Constants.
+static const tchar DOCTYPE_START[] = TXT("<!DOCTYPE");
+
+// The start of the declarations of interest.
+static const tchar ELEMENT_DECL[] = TXT("<!ELEMENT");
+static const tchar ATTLIST_DECL[] = TXT("<!ATTLIST");
+
+// The characters that end a name in a declaration.
+static const tchar NAME_TERMINATORS[] = TXT(" \t\r\n()|,?*+>\"'[");
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the text at a position starts with a string.
+
+static bool StartsWith(const tstring& str, size_t nPos, const tchar* pszPrefix)
+{
+	return (str.compare(nPos, tstrlen(pszPrefix), pszPrefix) == 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Skip any whitespace.
+
+static size_t SkipSpace(const tstring& str, size_t nPos)
+{
+	while ( (nPos < str.length()) && (tisspace(static_cast<utchar>(str[nPos]))) )
+		++nPos;
+
+	return nPos;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read a name, or a keyword such as EMPTY or #REQUIRED.
+
+static tstring ReadName(const tstring& str, size_t& nPos)
+{
+	size_t nEnd = str.find_first_of(NAME_TERMINATORS, nPos);
+
+	if (nEnd == tstring::npos)
+		nEnd = str.length();
+
+	tstring strName = str.substr(nPos, nEnd - nPos);
+
+	nPos = nEnd;
+
+	return strName;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find a character that is not inside a quoted string.
+
+static size_t FindUnquoted(const tstring& str, tchar cFind, size_t nPos)
+{
+	tchar cQuote = TXT('\0');
+
+	for (; nPos < str.length(); ++nPos)
+	{
+		tchar cChar = str[nPos];
+
+		if (cQuote != TXT('\0'))
+		{
+			if (cChar == cQuote)
+				cQuote = TXT('\0');
+		}
+		else if ( (cChar == TXT('"')) || (cChar == TXT('\'')) )
+		{
+			cQuote = cChar;
+		}
+		else if (cChar == cFind)
+		{
+			return nPos;
+		}
+	}
+
+	return tstring::npos;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Merge a sorted set of positions into another.
+
+static void MergePositions(std::vector<size_t>& vecInto, const std::vector<size_t>& vecFrom)
+{
+	std::vector<size_t> vecMerged;
+
+	vecMerged.reserve(vecInto.size() + vecFrom.size());
+
+	std::set_union(vecInto.begin(), vecInto.end(), vecFrom.begin(), vecFrom.end(), std::back_inserter(vecMerged));
+
+	vecInto.swap(vecMerged);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+DtdModel::DtdModel()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse a DOCTYPE declaration. Only the ELEMENT and ATTLIST declarations in
+//! the internal subset are used; everything else is skipped.
+
+void DtdModel::Parse(const tstring& strDeclaration)
+{
+	Clear();
+
+	size_t nPos = SkipSpace(strDeclaration, 0);
+
+	if (StartsWith(strDeclaration, nPos, DOCTYPE_START))
+		nPos = SkipSpace(strDeclaration, nPos + tstrlen(DOCTYPE_START));
+
+	m_strRoot = ReadName(strDeclaration, nPos);
+
+	size_t nOpen  = FindUnquoted(strDeclaration, TXT('['), nPos);
+	size_t nClose = strDeclaration.rfind(TXT(']'));
+
+	if (nOpen == tstring::npos)
+		return;
+
+	if ( (nClose == tstring::npos) || (nClose < nOpen) )
+		nClose = strDeclaration.length();
+
+	for (size_t nNext = nOpen+1; nNext < nClose; )
+	{
+		size_t nEnd = tstring::npos;
+
+		if (StartsWith(strDeclaration, nNext, TXT("<!--")))
+		{
+			nEnd = strDeclaration.find(TXT("-->"), nNext);
+			nNext = (nEnd != tstring::npos) ? nEnd+3 : nClose;
+		}
+		else if (StartsWith(strDeclaration, nNext, TXT("<?")))
+		{
+			nEnd = strDeclaration.find(TXT("?>"), nNext);
+			nNext = (nEnd != tstring::npos) ? nEnd+2 : nClose;
+		}
+		else if (strDeclaration[nNext] == TXT('<'))
+		{
+			nEnd = FindUnquoted(strDeclaration, TXT('>'), nNext);
+
+			if (nEnd == tstring::npos)
+				nEnd = nClose;
+
+			if (StartsWith(strDeclaration, nNext, ELEMENT_DECL))
+				ParseElement(strDeclaration.substr(nNext + tstrlen(ELEMENT_DECL), nEnd - nNext - tstrlen(ELEMENT_DECL)));
+			else if (StartsWith(strDeclaration, nNext, ATTLIST_DECL))
+				ParseAttList(strDeclaration.substr(nNext + tstrlen(ATTLIST_DECL), nEnd - nNext - tstrlen(ATTLIST_DECL)));
+
+			nNext = nEnd+1;
+		}
+		else
+		{
+			++nNext;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Discard the declarations.
+
+void DtdModel::Clear()
+{
+	m_strRoot.clear();
+	m_mapElements.clear();
+	m_mapAttributes.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if an element is declared.
+
+bool DtdModel::IsDeclared(const tstring& strElement) const
+{
+	return (m_mapElements.find(strElement) != m_mapElements.end());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Check the content of an element against its declared model. The content is
+//! given as the names of its child elements and whether it contains any text
+//! other than whitespace. An undeclared element matches any content.
+
+bool DtdModel::MatchesContent(const tstring& strElement, const Names& vecChildren, bool bHasText) const
+{
+	Elements::const_iterator itElement = m_mapElements.find(strElement);
+
+	if (itElement == m_mapElements.end())
+		return true;
+
+	const Element& oElement = itElement->second;
+
+	if (oElement.m_eContent == Element::EMPTY_CONTENT)
+		return ( (vecChildren.empty()) && (!bHasText) );
+
+	if (oElement.m_eContent == Element::ANY_CONTENT)
+		return true;
+
+	if (oElement.m_eContent == Element::MIXED_CONTENT)
+	{
+		for (Names::const_iterator it = vecChildren.begin(); it != vecChildren.end(); ++it)
+		{
+			if (std::find(oElement.m_vecMixed.begin(), oElement.m_vecMixed.end(), *it) == oElement.m_vecMixed.end())
+				return false;
+		}
+
+		return true;
+	}
+
+	if (bHasText)
+		return false;
+
+	Positions vecStarts(1, 0);
+	Positions vecEnds;
+
+	Match(oElement.m_oModel, vecChildren, vecStarts, vecEnds);
+
+	return std::binary_search(vecEnds.begin(), vecEnds.end(), vecChildren.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the text of an element's declared content model.
+
+tstring DtdModel::ContentModel(const tstring& strElement) const
+{
+	Elements::const_iterator itElement = m_mapElements.find(strElement);
+
+	if (itElement == m_mapElements.end())
+		return TXT("");
+
+	return itElement->second.m_strModel;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the declared type of an attribute.
+
+DtdModel::AttribType DtdModel::AttributeType(const tstring& strElement, const tstring& strAttrib) const
+{
+	Attributes::const_iterator itElement = m_mapAttributes.find(strElement);
+
+	if (itElement == m_mapAttributes.end())
+		return OTHER_ATTRIB;
+
+	AttribTypes::const_iterator itAttrib = itElement->second.find(strAttrib);
+
+	if (itAttrib == itElement->second.end())
+		return OTHER_ATTRIB;
+
+	return itAttrib->second;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if an element has an attribute declared as an ID.
+
+bool DtdModel::HasIdAttribute(const tstring& strElement) const
+{
+	Attributes::const_iterator itElement = m_mapAttributes.find(strElement);
+
+	if (itElement == m_mapAttributes.end())
+		return false;
+
+	for (AttribTypes::const_iterator it = itElement->second.begin(); it != itElement->second.end(); ++it)
+	{
+		if (it->second == ID_ATTRIB)
+			return true;
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse an element declaration, from after the keyword. A model that cannot
+//! be parsed, e.g. because it uses a parameter entity, allows any content.
+
+void DtdModel::ParseElement(const tstring& strDecl)
+{
+	size_t  nPos    = SkipSpace(strDecl, 0);
+	tstring strName = ReadName(strDecl, nPos);
+
+	if ( (strName.empty()) || (m_mapElements.find(strName) != m_mapElements.end()) )
+		return;
+
+	Element& oElement = m_mapElements[strName];
+
+	nPos = SkipSpace(strDecl, nPos);
+
+	size_t nEnd = strDecl.find_last_not_of(TXT(" \t\r\n"));
+
+	oElement.m_eContent = Element::ANY_CONTENT;
+	oElement.m_strModel = ( (nEnd != tstring::npos) && (nEnd >= nPos) ) ? strDecl.substr(nPos, nEnd - nPos + 1) : TXT("");
+
+	if (oElement.m_strModel.find(TXT('%')) != tstring::npos)
+		return;
+
+	if (oElement.m_strModel == TXT("EMPTY"))
+	{
+		oElement.m_eContent = Element::EMPTY_CONTENT;
+	}
+	else if ( (strDecl[nPos] == TXT('(')) && (StartsWith(strDecl, SkipSpace(strDecl, nPos+1), TXT("#PCDATA"))) )
+	{
+		nPos = SkipSpace(strDecl, nPos+1) + tstrlen(TXT("#PCDATA"));
+
+		for (nPos = SkipSpace(strDecl, nPos); (nPos < strDecl.length()) && (strDecl[nPos] == TXT('|')); nPos = SkipSpace(strDecl, nPos))
+		{
+			nPos = SkipSpace(strDecl, nPos+1);
+			oElement.m_vecMixed.push_back(ReadName(strDecl, nPos));
+		}
+
+		oElement.m_eContent = Element::MIXED_CONTENT;
+	}
+	else if (strDecl[nPos] == TXT('('))
+	{
+		if (ParseParticle(strDecl, nPos, oElement.m_oModel))
+			oElement.m_eContent = Element::CHILDREN_CONTENT;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse an attribute list declaration, from after the keyword. Only the first
+//! declaration of an attribute is binding.
+
+void DtdModel::ParseAttList(const tstring& strDecl)
+{
+	size_t  nPos       = SkipSpace(strDecl, 0);
+	tstring strElement = ReadName(strDecl, nPos);
+
+	if (strElement.empty())
+		return;
+
+	AttribTypes& mapTypes = m_mapAttributes[strElement];
+
+	for (;;)
+	{
+		nPos = SkipSpace(strDecl, nPos);
+
+		tstring strName = ReadName(strDecl, nPos);
+
+		if (strName.empty())
+			break;
+
+		nPos = SkipSpace(strDecl, nPos);
+
+		tstring strType = ( (nPos < strDecl.length()) && (strDecl[nPos] != TXT('(')) ) ? ReadName(strDecl, nPos) : TXT("");
+
+		if (strType == TXT("NOTATION"))
+			nPos = SkipSpace(strDecl, nPos);
+
+		// Skip an enumeration.
+		if ( (nPos < strDecl.length()) && (strDecl[nPos] == TXT('(')) )
+		{
+			nPos = strDecl.find(TXT(')'), nPos);
+
+			if (nPos == tstring::npos)
+				break;
+
+			++nPos;
+		}
+
+		AttribType eType = OTHER_ATTRIB;
+
+		if (strType == TXT("ID"))
+			eType = ID_ATTRIB;
+		else if (strType == TXT("IDREF"))
+			eType = IDREF_ATTRIB;
+		else if (strType == TXT("IDREFS"))
+			eType = IDREFS_ATTRIB;
+
+		mapTypes.insert(AttribTypes::value_type(strName, eType));
+
+		// Skip the default.
+		nPos = SkipSpace(strDecl, nPos);
+
+		if ( (nPos < strDecl.length()) && (strDecl[nPos] == TXT('#')) )
+		{
+			tstring strDefault = ReadName(strDecl, nPos);
+
+			if (strDefault == TXT("#FIXED"))
+				nPos = SkipSpace(strDecl, nPos);
+		}
+
+		if ( (nPos < strDecl.length()) && ((strDecl[nPos] == TXT('"')) || (strDecl[nPos] == TXT('\''))) )
+		{
+			nPos = strDecl.find(strDecl[nPos], nPos+1);
+
+			if (nPos == tstring::npos)
+				break;
+
+			++nPos;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse a content particle: a name or a bracketed sequence or choice, with an
+//! optional occurrence indicator. Returns false if the model is malformed.
+
+bool DtdModel::ParseParticle(const tstring& strModel, size_t& nPos, Particle& oParticle)
+{
+	nPos = SkipSpace(strModel, nPos);
+
+	if (nPos >= strModel.length())
+		return false;
+
+	if (strModel[nPos] == TXT('('))
+	{
+		tchar cSeparator = TXT('\0');
+
+		++nPos;
+
+		for (;;)
+		{
+			oParticle.m_vecItems.push_back(Particle());
+
+			if (!ParseParticle(strModel, nPos, oParticle.m_vecItems.back()))
+				return false;
+
+			nPos = SkipSpace(strModel, nPos);
+
+			if (nPos >= strModel.length())
+				return false;
+
+			tchar cChar = strModel[nPos++];
+
+			if (cChar == TXT(')'))
+				break;
+
+			if ( ((cChar != TXT('|')) && (cChar != TXT(','))) || ((cSeparator != TXT('\0')) && (cChar != cSeparator)) )
+				return false;
+
+			cSeparator = cChar;
+		}
+
+		oParticle.m_eKind = (cSeparator == TXT('|')) ? Particle::CHOICE : Particle::SEQUENCE;
+	}
+	else
+	{
+		oParticle.m_eKind   = Particle::NAME;
+		oParticle.m_strName = ReadName(strModel, nPos);
+
+		if (oParticle.m_strName.empty())
+			return false;
+	}
+
+	oParticle.m_cOccurs = TXT('1');
+
+	if ( (nPos < strModel.length()) && (tstring(TXT("?*+")).find(strModel[nPos]) != tstring::npos) )
+		oParticle.m_cOccurs = strModel[nPos++];
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Match a particle, including its occurrences, from a set of positions in the
+//! children, giving the set of positions each possible match ends at. The
+//! positions are kept sorted. A repeated particle is matched again only from
+//! the positions not already reached, so every repetition makes progress.
+
+void DtdModel::Match(const Particle& oParticle, const Names& vecChildren, const Positions& vecStarts, Positions& vecEnds)
+{
+	if (oParticle.m_cOccurs == TXT('1'))
+	{
+		MatchOnce(oParticle, vecChildren, vecStarts, vecEnds);
+		return;
+	}
+
+	if (oParticle.m_cOccurs == TXT('?'))
+	{
+		MatchOnce(oParticle, vecChildren, vecStarts, vecEnds);
+		MergePositions(vecEnds, vecStarts);
+		return;
+	}
+
+	Positions vecReached  = (oParticle.m_cOccurs == TXT('*')) ? vecStarts : Positions();
+	Positions vecFrontier = vecStarts;
+
+	while (!vecFrontier.empty())
+	{
+		Positions vecNext;
+		Positions vecNew;
+
+		MatchOnce(oParticle, vecChildren, vecFrontier, vecNext);
+
+		std::set_difference(vecNext.begin(), vecNext.end(), vecReached.begin(), vecReached.end(), std::back_inserter(vecNew));
+
+		MergePositions(vecReached, vecNew);
+		vecFrontier.swap(vecNew);
+	}
+
+	vecEnds.swap(vecReached);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Match a particle once from a set of positions in the children.
+
+void DtdModel::MatchOnce(const Particle& oParticle, const Names& vecChildren, const Positions& vecStarts, Positions& vecEnds)
+{
+	vecEnds.clear();
+
+	if (oParticle.m_eKind == Particle::NAME)
+	{
+		for (Positions::const_iterator it = vecStarts.begin(); it != vecStarts.end(); ++it)
+		{
+			if ( (*it < vecChildren.size()) && (vecChildren[*it] == oParticle.m_strName) )
+				vecEnds.push_back(*it + 1);
+		}
+	}
+	else if (oParticle.m_eKind == Particle::SEQUENCE)
+	{
+		vecEnds = vecStarts;
+
+		for (size_t i = 0; (i != oParticle.m_vecItems.size()) && (!vecEnds.empty()); ++i)
+		{
+			Positions vecNext;
+
+			Match(oParticle.m_vecItems[i], vecChildren, vecEnds, vecNext);
+			vecEnds.swap(vecNext);
+		}
+	}
+	else
+	{
+		for (size_t i = 0; i != oParticle.m_vecItems.size(); ++i)
+		{
+			Positions vecItemEnds;
+
+			Match(oParticle.m_vecItems[i], vecChildren, vecStarts, vecItemEnds);
+			MergePositions(vecEnds, vecItemEnds);
+		}
+	}
+}
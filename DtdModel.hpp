@@ -0,0 +1,168 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DtdModel.hpp
+//! \brief  The DtdModel class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_DTDMODEL_HPP
+#define APP_DTDMODEL_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <map>
+
+////////////////////////////////////////////////////////////////////////////////
+//! The element content models and attribute types declared in the internal
+//! subset of a document's DOCTYPE. External DTDs are not read, and a model that
+//! refers to a parameter entity is treated as allowing any content, so only
+//! what is declared in the document itself is checked.
+
+class DtdModel
+{
+public:
+	//! The types of attribute that are of interest.
+	enum AttribType
+	{
+		OTHER_ATTRIB,		//!< Any other type.
+		ID_ATTRIB,			//!< An ID.
+		IDREF_ATTRIB,		//!< A reference to an ID.
+		IDREFS_ATTRIB,		//!< A list of references to IDs.
+	};
+
+	//! The names of a sequence of child elements.
+	typedef std::vector<tstring> Names;
+
+	//! Default constructor.
+	DtdModel();
+
+	//
+	// Properties.
+	//
+
+	//! Get the name of the root element given by the DOCTYPE.
+	const tstring& RootName() const;
+
+	//! Query if any elements are declared.
+	bool HasElements() const;
+
+	//
+	// Methods.
+	//
+
+	//! Parse a DOCTYPE declaration.
+	void Parse(const tstring& strDeclaration);
+
+	//! Discard the declarations.
+	void Clear();
+
+	//! Query if an element is declared.
+	bool IsDeclared(const tstring& strElement) const;
+
+	//! Check the content of an element against its declared model.
+	bool MatchesContent(const tstring& strElement, const Names& vecChildren, bool bHasText) const;
+
+	//! Get the text of an element's declared content model.
+	tstring ContentModel(const tstring& strElement) const;
+
+	//! Get the declared type of an attribute.
+	AttribType AttributeType(const tstring& strElement, const tstring& strAttrib) const;
+
+	//! Query if an element has an attribute declared as an ID.
+	bool HasIdAttribute(const tstring& strElement) const;
+
+private:
+	////////////////////////////////////////////////////////////////////////////
+	//! A content particle: a name, or a sequence or choice of particles, with
+	//! the number of times it may occur.
+
+	struct Particle
+	{
+		//! The kinds of particle.
+		enum Kind
+		{
+			NAME,		//!< A child element name.
+			SEQUENCE,	//!< Each particle in turn.
+			CHOICE,		//!< One of the particles.
+		};
+
+		Kind					m_eKind;	//!< The kind of particle.
+		tstring					m_strName;	//!< The element name, for a name.
+		std::vector<Particle>	m_vecItems;	//!< The particles in a sequence or choice.
+		tchar					m_cOccurs;	//!< One of '1', '?', '*' or '+'.
+	};
+
+	////////////////////////////////////////////////////////////////////////////
+	//! The declaration of an element.
+
+	struct Element
+	{
+		//! The kinds of content.
+		enum Content
+		{
+			EMPTY_CONTENT,		//!< No content.
+			ANY_CONTENT,		//!< Any content.
+			MIXED_CONTENT,		//!< Text and any of a set of elements.
+			CHILDREN_CONTENT,	//!< Elements only, matching the model.
+		};
+
+		Content				m_eContent;		//!< The kind of content.
+		Particle			m_oModel;		//!< The model, for element content.
+		Names				m_vecMixed;		//!< The elements allowed in mixed content.
+		tstring				m_strModel;		//!< The model as declared.
+	};
+
+	//! The map of element name to declaration.
+	typedef std::map<tstring, Element> Elements;
+	//! The map of attribute name to type.
+	typedef std::map<tstring, AttribType> AttribTypes;
+	//! The map of element name to attribute types.
+	typedef std::map<tstring, AttribTypes> Attributes;
+	//! The set of positions reached in a sequence of children.
+	typedef std::vector<size_t> Positions;
+
+	//
+	// Members.
+	//
+	tstring			m_strRoot;			//!< The root element name.
+	Elements		m_mapElements;		//!< The element declarations.
+	Attributes		m_mapAttributes;	//!< The attribute types.
+
+	//
+	// Internal methods.
+	//
+
+	//! Parse an element declaration.
+	void ParseElement(const tstring& strDecl);
+
+	//! Parse an attribute list declaration.
+	void ParseAttList(const tstring& strDecl);
+
+	//! Parse a content particle.
+	static bool ParseParticle(const tstring& strModel, size_t& nPos, Particle& oParticle);
+
+	//! Match a particle, including its occurrences, from a set of positions.
+	static void Match(const Particle& oParticle, const Names& vecChildren, const Positions& vecStarts, Positions& vecEnds);
+
+	//! Match a particle once from a set of positions.
+	static void MatchOnce(const Particle& oParticle, const Names& vecChildren, const Positions& vecStarts, Positions& vecEnds);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the name of the root element given by the DOCTYPE.
+
+inline const tstring& DtdModel::RootName() const
+{
+	return m_strRoot;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if any elements are declared.
+
+inline bool DtdModel::HasElements() const
+{
+	return !m_mapElements.empty();
+}
+
+#endif // APP_DTDMODEL_HPP
@@ -0,0 +1,912 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   EditJournal.cpp
+//! \brief  The EditJournal class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "EditJournal.hpp"
+#include <XML/Document.hpp>
+#include <XML/ElementNode.hpp>
+#include <XML/TextNode.hpp>
+#include <WCL/File.hpp>
+#include <WCL/StrCvt.hpp>
+#include <Core/RuntimeException.hpp>
+#include <process.h>
+#include "DomEditor.hpp"
+#include "DocArena.hpp"
+#include "BulkEdit.hpp"
+#include "NodeStream.hpp"
+
+// Constants.
+static const char JOURNAL_MAGIC[8] = { 'X', 'E', 'J', 'R', 'N', 'L', '\r', '\n' };
+
+// The journal format version.
+static const uint32 JOURNAL_FORMAT = 3;
+
+// The journal file extension, appended to the document's.
+static const tchar JOURNAL_EXT[] = TXT(".xejournal");
+
+// The size of the queue that wakes the writer before the interval is up.
+static const size_t BATCH_SIZE = 64 * 1024;
+
+// The operation code for a bulk edit, after those of the DOM changes.
+static const uint32 BULK_EDIT_OP = 0x100;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Convert a file time to a single value.
+
+static uint64 ToUInt64(const FILETIME& ftTime)
+{
+	return (static_cast<uint64>(ftTime.dwHighDateTime) << 32) | ftTime.dwLowDateTime;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append an unsigned value to an operation.
+
+static void AppendUInt(std::vector<byte>& vecOp, uint32 nValue)
+{
+	const byte* pBytes = reinterpret_cast<const byte*>(&nValue);
+
+	vecOp.insert(vecOp.end(), pBytes, pBytes + sizeof(nValue));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append a length-prefixed string to an operation.
+
+static void AppendString(std::vector<byte>& vecOp, const tstring& str)
+{
+	const byte* pBytes = reinterpret_cast<const byte*>(str.data());
+
+	AppendUInt(vecOp, static_cast<uint32>(str.size()));
+	vecOp.insert(vecOp.end(), pBytes, pBytes + (str.size() * sizeof(tchar)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append a length-prefixed block of bytes to an operation.
+
+static void AppendBlock(std::vector<byte>& vecOp, const std::vector<byte>& vecBlock)
+{
+	AppendUInt(vecOp, static_cast<uint32>(vecBlock.size()));
+	vecOp.insert(vecOp.end(), vecBlock.begin(), vecBlock.end());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append the path of child indices from the document to a node. A move has
+//! already been made when it's published but is replayed from the positions
+//! before it, so the indices from nFrom onwards in one container can be
+//! shifted to give the path as it was.
+
+static void AppendPath(std::vector<byte>& vecOp, NodeRef pNode, const XML::Node* pShifted = nullptr, size_t nFrom = 0, int nShift = 0)
+{
+	std::vector<uint32> vecPath;
+
+	while (pNode->hasParent())
+	{
+		NodeRef pParent = pNode->parent();
+		size_t  nIndex  = DomEditor::IndexOf(DomEditor::Container(pParent), pNode);
+
+		if ( (pParent.get() == pShifted) && (nIndex >= nFrom) )
+			nIndex += nShift;
+
+		vecPath.push_back(static_cast<uint32>(nIndex));
+		pNode = pParent;
+	}
+
+	AppendUInt(vecOp, static_cast<uint32>(vecPath.size()));
+
+	for (std::vector<uint32>::const_reverse_iterator it = vecPath.rbegin(); it != vecPath.rend(); ++it)
+		AppendUInt(vecOp, *it);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append an insertion to a batch of operations, encoding the inserted sub-tree
+//! after the start of the operation.
+
+static void AppendInsert(std::vector<byte>& vecBatch, const std::vector<byte>& vecStart, NodeRef pNode)
+{
+	NodeStream::Buffer vecNodes;
+
+	NodeStream::Write(pNode, vecNodes);
+
+	AppendUInt(vecBatch, static_cast<uint32>(vecStart.size() + sizeof(uint32) + vecNodes.size()));
+	vecBatch.insert(vecBatch.end(), vecStart.begin(), vecStart.end());
+	AppendBlock(vecBatch, vecNodes);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if a node can contain other nodes.
+
+static bool IsContainer(NodeRef pNode)
+{
+	return ( (pNode->type() == XML::DOCUMENT_NODE) || (pNode->type() == XML::ELEMENT_NODE) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! A cursor over the fields of an encoded operation.
+
+class OpReader
+{
+public:
+	//! Constructor.
+	OpReader(const byte* pBegin, const byte* pEnd)
+		: m_pNext(pBegin)
+		, m_pEnd(pEnd)
+	{
+	}
+
+	//! Read an unsigned value.
+	uint32 ReadUInt()
+	{
+		uint32 nValue;
+
+		Read(&nValue, sizeof(nValue));
+
+		return nValue;
+	}
+
+	//! Read a length-prefixed string.
+	tstring ReadString()
+	{
+		uint32  nLength = ReadUInt();
+		tstring str(nLength, TXT('\0'));
+
+		if (nLength != 0)
+			Read(&str[0], nLength * sizeof(tchar));
+
+		return str;
+	}
+
+	//! Read a length-prefixed block of bytes, returning its start.
+	const byte* ReadBlock(uint32& nLength)
+	{
+		nLength = ReadUInt();
+
+		const byte* pBlock = m_pNext;
+
+		Skip(nLength);
+
+		return pBlock;
+	}
+
+	//! Read a path and find the node it addresses.
+	NodeRef ReadNode(NodeRef pDocument)
+	{
+		NodeRef pNode   = pDocument;
+		uint32  nLength = ReadUInt();
+
+		for (uint32 i = 0; i != nLength; ++i)
+		{
+			XML::NodeType eType  = pNode->type();
+			uint32        nIndex = ReadUInt();
+
+			if ( (eType != XML::DOCUMENT_NODE) && (eType != XML::ELEMENT_NODE) )
+				throw Core::RuntimeException(TXT("The journal refers to a node that does not exist"));
+
+			const XML::NodeContainer& oContainer = DomEditor::Container(pNode);
+
+			if (nIndex >= oContainer.getChildCount())
+				throw Core::RuntimeException(TXT("The journal refers to a node that does not exist"));
+
+			pNode = *(oContainer.beginChild() + nIndex);
+		}
+
+		return pNode;
+	}
+
+private:
+	//
+	// Members.
+	//
+	const byte*	m_pNext;	//!< The next field.
+	const byte*	m_pEnd;		//!< The end of the operation.
+
+	//! Read raw bytes.
+	void Read(void* pvBuffer, size_t nBytes)
+	{
+		if (static_cast<size_t>(m_pEnd - m_pNext) < nBytes)
+			throw Core::RuntimeException(TXT("The journal contains a corrupt operation"));
+
+		memcpy(pvBuffer, m_pNext, nBytes);
+		m_pNext += nBytes;
+	}
+
+	//! Skip raw bytes.
+	void Skip(size_t nBytes)
+	{
+		if (static_cast<size_t>(m_pEnd - m_pNext) < nBytes)
+			throw Core::RuntimeException(TXT("The journal contains a corrupt operation"));
+
+		m_pNext += nBytes;
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+EditJournal::EditJournal(DomEditor& oEditor, DWORD dwFlushInterval)
+	: m_oEditor(oEditor)
+	, m_dwFlushInterval(dwFlushInterval)
+	, m_bOpen(false)
+	, m_bFailed(false)
+	, m_hFile(INVALID_HANDLE_VALUE)
+	, m_hThread(NULL)
+	, m_hWakeEvent(NULL)
+	, m_hEncodedEvent(NULL)
+	, m_bSuspended(false)
+	, m_bStop(false)
+{
+	::InitializeCriticalSection(&m_oLock);
+
+	m_oEditor.AddListener(this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+EditJournal::~EditJournal()
+{
+	m_oEditor.RemoveListener(this);
+
+	Stop();
+
+	::DeleteCriticalSection(&m_oLock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Start journalling the edits to a document. Nothing is written until the
+//! first edit is made.
+
+void EditJournal::Open(const tstring& strDocPath)
+{
+	ASSERT(!m_bOpen);
+
+	m_strDocPath = strDocPath;
+	m_bOpen      = true;
+	m_bFailed    = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Stop journalling. The journal is deleted if the edits are not wanted, i.e.
+//! the document was saved or closed without saving, otherwise it is left for
+//! recovery.
+
+void EditJournal::Close(bool bDiscard)
+{
+	if (!m_bOpen)
+		return;
+
+	Stop();
+
+	if (bDiscard)
+		::DeleteFile(JournalPath(m_strDocPath).c_str());
+
+	m_bOpen = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Discard the journal, as the document has been saved. The next edit starts
+//! a new journal against the saved version.
+
+void EditJournal::Reset()
+{
+	if (!m_bOpen)
+		return;
+
+	tstring strDocPath = m_strDocPath;
+
+	Close(true);
+	Open(strDocPath);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Handle a change to the DOM by queueing an operation that repeats it. If a
+//! change cannot be recorded the journal is abandoned, as replaying the edits
+//! either side of it would give the wrong result. Only the text edited in place
+//! within an inserted sub-tree is written back to its nodes, as the writer
+//! thread encodes the sub-tree and cannot read the editor's buffers.
+
+void EditJournal::OnDomChanged(const DomChange& oChange)
+{
+	if ( (!m_bOpen) || (m_bFailed) || (m_bSuspended) )
+		return;
+
+	if ( (m_hThread == NULL) && (!Start()) )
+		return;
+
+	Buffer vecOp;
+
+	AppendUInt(vecOp, static_cast<uint32>(oChange.m_eType));
+
+	switch (oChange.m_eType)
+	{
+		case DomChange::NODE_INSERTED:
+		{
+			if (!NodeStream::CanWrite(oChange.m_pNode))
+			{
+				Fail(TXT("The inserted node cannot be journalled"));
+				return;
+			}
+
+			m_oEditor.FlattenText(oChange.m_pNode);
+
+			AppendPath(vecOp, oChange.m_pParent);
+			AppendUInt(vecOp, static_cast<uint32>(oChange.m_nIndex));
+
+			QueueInsert(vecOp, oChange.m_pNode);
+		}
+		return;
+
+		case DomChange::NODE_REMOVED:
+		{
+			AppendPath(vecOp, oChange.m_pOldParent);
+			AppendUInt(vecOp, static_cast<uint32>(oChange.m_nOldIndex));
+		}
+		break;
+
+		case DomChange::NODE_MOVED:
+		{
+			// Undo the insertion in the old parent's path and the removal in the
+			// new parent's path.
+			AppendPath(vecOp, oChange.m_pOldParent, oChange.m_pParent.get(), oChange.m_nIndex+1, -1);
+			AppendUInt(vecOp, static_cast<uint32>(oChange.m_nOldIndex));
+			AppendPath(vecOp, oChange.m_pParent, oChange.m_pOldParent.get(), oChange.m_nOldIndex, +1);
+			AppendUInt(vecOp, static_cast<uint32>(oChange.m_nIndex));
+		}
+		break;
+
+		case DomChange::CHILDREN_MOVED:
+		{
+			AppendPath(vecOp, oChange.m_pOldParent);
+			AppendPath(vecOp, oChange.m_pParent);
+		}
+		break;
+
+		case DomChange::ATTRIBUTE_CHANGED:
+		{
+			XML::AttributePtr pAttrib = oChange.m_pNode.As<XML::ElementNode>()->getAttributes().find(oChange.m_strName);
+
+			AppendPath(vecOp, oChange.m_pNode);
+			AppendString(vecOp, oChange.m_strName);
+			AppendUInt(vecOp, (pAttrib.get() != nullptr) ? 1 : 0);
+
+			if (pAttrib.get() != nullptr)
+				AppendString(vecOp, pAttrib->value());
+		}
+		break;
+
+		case DomChange::TEXT_CHANGED:
+		{
+			AppendPath(vecOp, oChange.m_pNode);
+			AppendString(vecOp, oChange.m_pNode.As<XML::TextNode>()->text());
+		}
+		break;
+
+		case DomChange::TEXT_EDITED:
+		{
+			AppendPath(vecOp, oChange.m_pNode);
+			AppendUInt(vecOp, static_cast<uint32>(oChange.m_nOffset));
+			AppendUInt(vecOp, static_cast<uint32>(oChange.m_strOldValue.length()));
+			AppendString(vecOp, oChange.m_strNewText);
+		}
+		break;
+
+		default:
+		{
+			ASSERT_FALSE();
+		}
+		break;
+	}
+
+	Queue(vecOp);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Wait until the writer thread has encoded an inserted sub-tree, if it hasn't
+//! already, as the nodes are about to be modified. The event may have been set
+//! for an earlier insertion, so the state is checked again after waking.
+
+void EditJournal::OnDomChanging()
+{
+	if (m_hThread == NULL)
+		return;
+
+	for (;;)
+	{
+		::EnterCriticalSection(&m_oLock);
+		bool bPending = (m_pInserted.get() != nullptr);
+		::LeaveCriticalSection(&m_oLock);
+
+		if (!bPending)
+			break;
+
+		::WaitForSingleObject(m_hEncodedEvent, INFINITE);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Stop recording the individual changes while a bulk edit is applied.
+
+void EditJournal::BeginBulkEdit()
+{
+	ASSERT(!m_bSuspended);
+
+	m_bSuspended = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Record a bulk edit as a single operation, if it was applied. Replaying the
+//! edit against the same DOM matches the same nodes, so this is both smaller
+//! and faster than recording each change.
+
+void EditJournal::EndBulkEdit(const BulkEdit& oEdit, bool bApplied)
+{
+	ASSERT(m_bSuspended);
+
+	m_bSuspended = false;
+
+	if ( (!bApplied) || (!m_bOpen) || (m_bFailed) )
+		return;
+
+	if ( (m_hThread == NULL) && (!Start()) )
+		return;
+
+	Buffer vecOp;
+
+	AppendUInt(vecOp, BULK_EDIT_OP);
+	AppendUInt(vecOp, static_cast<uint32>(oEdit.m_eOperation));
+	AppendString(vecOp, oEdit.m_strQuery);
+	AppendString(vecOp, oEdit.m_strName);
+	AppendString(vecOp, oEdit.m_strValue);
+
+	Queue(vecOp);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the path of the journal for a document.
+
+tstring EditJournal::JournalPath(const tstring& strDocPath)
+{
+	return strDocPath + JOURNAL_EXT;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if there is a journal for a document.
+
+bool EditJournal::Exists(const tstring& strDocPath)
+{
+	return (::GetFileAttributes(JournalPath(strDocPath).c_str()) != INVALID_FILE_ATTRIBUTES);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Replay a document's journal onto its DOM, returning the number of edits.
+//! The whole journal is read before any edit is made so that the journal can
+//! be replaced as the edits are recorded again. The edits are only replayed
+//! onto the version of the document they were made to. An operation cut short
+//! by the crash ends the journal.
+
+size_t EditJournal::Replay(const tstring& strDocPath, DomEditor& oEditor, const XML::DocumentPtr& pDOM)
+{
+	DWORD   dwStart     = ::GetTickCount();
+	tstring strJournal  = JournalPath(strDocPath);
+	Header  oExpected;
+	Header  oHeader;
+	Buffer  vecOps;
+
+	if (!CreateHeader(strDocPath, oExpected))
+		throw Core::RuntimeException(Core::fmt(TXT("Failed to read the details of '%s'"), strDocPath.c_str()));
+
+	CFile oFile;
+
+	oFile.Open(strJournal.c_str(), CFile::ReadOnly);
+
+	size_t nSize = oFile.Size();
+
+	if (nSize < sizeof(oHeader))
+		throw Core::RuntimeException(TXT("The journal is empty"));
+
+	oFile.Read(&oHeader, sizeof(oHeader));
+
+	if (memcmp(&oHeader, &oExpected, sizeof(oHeader)) != 0)
+		throw Core::RuntimeException(TXT("The document has changed since the journal was written"));
+
+	vecOps.resize(nSize - sizeof(oHeader));
+
+	if (!vecOps.empty())
+		oFile.Read(&vecOps.front(), vecOps.size());
+
+	oFile.Close();
+
+	const byte* pBegin = vecOps.empty() ? nullptr : &vecOps.front();
+	const byte* pEnd   = pBegin + vecOps.size();
+	size_t      nOps   = ReplayOps(pBegin, pEnd, oEditor, pDOM);
+
+	TRACE2(TXT("Replayed %u journalled edits in %u ms\n"), nOps, ::GetTickCount() - dwStart);
+
+	return nOps;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Replay the encoded operations onto the DOM, returning the number replayed.
+//! Every node and position an operation refers to is checked before the edit
+//! is made, so a journal that doesn't match the DOM is rejected rather than
+//! breaking one of the editor's assumptions.
+
+size_t EditJournal::ReplayOps(const byte* pBegin, const byte* pEnd, DomEditor& oEditor, const XML::DocumentPtr& pDOM)
+{
+	NodeRef pDocument(pDOM.get());
+	size_t  nOps = 0;
+
+	for (const byte* pOp = pBegin; static_cast<size_t>(pEnd - pOp) >= sizeof(uint32); )
+	{
+		uint32 nLength;
+
+		memcpy(&nLength, pOp, sizeof(nLength));
+		pOp += sizeof(nLength);
+
+		if (static_cast<size_t>(pEnd - pOp) < nLength)
+			break;
+
+		OpReader oReader(pOp, pOp + nLength);
+
+		pOp += nLength;
+
+		switch (oReader.ReadUInt())
+		{
+			case DomChange::NODE_INSERTED:
+			{
+				NodeRef pParent = oReader.ReadNode(pDocument);
+				uint32  nIndex  = oReader.ReadUInt();
+
+				uint32      nBytes = 0;
+				const byte* pNodes = oReader.ReadBlock(nBytes);
+
+				if ( (!IsContainer(pParent)) || (nIndex > DomEditor::Container(pParent).getChildCount()) )
+					throw Core::RuntimeException(TXT("The journal refers to a position that does not exist"));
+
+				oEditor.InsertNode(pParent, nIndex, NodeStream::Read(pNodes, pNodes + nBytes, oEditor.Arena()));
+			}
+			break;
+
+			case DomChange::NODE_REMOVED:
+			{
+				NodeRef pParent = oReader.ReadNode(pDocument);
+				uint32  nIndex  = oReader.ReadUInt();
+
+				if ( (!IsContainer(pParent)) || (nIndex >= DomEditor::Container(pParent).getChildCount()) )
+					throw Core::RuntimeException(TXT("The journal refers to a node that does not exist"));
+
+				oEditor.RemoveNode(*(DomEditor::Container(pParent).beginChild() + nIndex));
+			}
+			break;
+
+			case DomChange::NODE_MOVED:
+			{
+				NodeRef pOldParent = oReader.ReadNode(pDocument);
+				uint32  nOldIndex  = oReader.ReadUInt();
+				NodeRef pParent    = oReader.ReadNode(pDocument);
+				uint32  nIndex     = oReader.ReadUInt();
+
+				if ( (!IsContainer(pOldParent)) || (nOldIndex >= DomEditor::Container(pOldParent).getChildCount()) )
+					throw Core::RuntimeException(TXT("The journal refers to a node that does not exist"));
+
+				NodeRef pNode = *(DomEditor::Container(pOldParent).beginChild() + nOldIndex);
+
+				// The index is the one the node has after it's been removed.
+				size_t nChildren = IsContainer(pParent) ? DomEditor::Container(pParent).getChildCount() : 0;
+
+				if (pParent.get() == pOldParent.get())
+					--nChildren;
+
+				if ( (!IsContainer(pParent)) || (DomEditor::IsWithin(pParent, pNode)) || (nIndex > nChildren) )
+					throw Core::RuntimeException(TXT("The journal refers to a position that does not exist"));
+
+				oEditor.MoveChild(pOldParent, nOldIndex, pParent, nIndex);
+			}
+			break;
+
+			case DomChange::CHILDREN_MOVED:
+			{
+				NodeRef pOldParent = oReader.ReadNode(pDocument);
+				NodeRef pParent    = oReader.ReadNode(pDocument);
+
+				if ( (!IsContainer(pOldParent)) || (!IsContainer(pParent)) || (DomEditor::IsWithin(pParent, pOldParent))
+				  || (DomEditor::Container(pParent).hasChildren()) )
+					throw Core::RuntimeException(TXT("The journal refers to a position that does not exist"));
+
+				oEditor.MoveChildren(pOldParent, pParent);
+			}
+			break;
+
+			case DomChange::ATTRIBUTE_CHANGED:
+			{
+				NodeRef pElement = oReader.ReadNode(pDocument);
+				tstring strName  = oReader.ReadString();
+
+				if (pElement->type() != XML::ELEMENT_NODE)
+					throw Core::RuntimeException(TXT("The journal refers to an element that does not exist"));
+
+				if (oReader.ReadUInt() != 0)
+					oEditor.SetAttribute(pElement, strName, oReader.ReadString());
+				else
+					oEditor.RemoveAttribute(pElement, strName);
+			}
+			break;
+
+			case DomChange::TEXT_CHANGED:
+			{
+				NodeRef pNode = oReader.ReadNode(pDocument);
+
+				if (pNode->type() != XML::TEXT_NODE)
+					throw Core::RuntimeException(TXT("The journal refers to text that does not exist"));
+
+				oEditor.SetText(pNode, oReader.ReadString());
+			}
+			break;
+
+			case DomChange::TEXT_EDITED:
+			{
+				NodeRef pNode   = oReader.ReadNode(pDocument);
+				uint32  nOffset = oReader.ReadUInt();
+				uint32  nCount  = oReader.ReadUInt();
+
+				if ( ((pNode->type() != XML::TEXT_NODE) && (pNode->type() != XML::CDATA_NODE))
+				  || (nOffset + nCount > oEditor.TextLength(pNode)) )
+					throw Core::RuntimeException(TXT("The journal refers to text that does not exist"));
+
+				oEditor.EditText(pNode, nOffset, nCount, oReader.ReadString());
+			}
+			break;
+
+			case BULK_EDIT_OP:
+			{
+				BulkEdit oEdit;
+
+				oEdit.m_eOperation = static_cast<BulkEdit::Operation>(oReader.ReadUInt());
+				oEdit.m_strQuery   = oReader.ReadString();
+				oEdit.m_strName    = oReader.ReadString();
+				oEdit.m_strValue   = oReader.ReadString();
+
+				if (oEdit.m_eOperation > BulkEdit::WRAP)
+					throw Core::RuntimeException(TXT("The journal contains an unknown operation"));
+
+				oEdit.Apply(oEditor, pDOM);
+			}
+			break;
+
+			default:
+			{
+				throw Core::RuntimeException(TXT("The journal contains an unknown operation"));
+			}
+			break;
+		}
+
+		++nOps;
+	}
+
+	return nOps;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Create the journal file and start the writer thread. Returns false, having
+//! abandoned journalling, if either fails.
+
+bool EditJournal::Start()
+{
+	Header oHeader;
+
+	if (!CreateHeader(m_strDocPath, oHeader))
+	{
+		Fail(TXT("The document's details could not be read"));
+		return false;
+	}
+
+	tstring strJournal = JournalPath(m_strDocPath);
+	DWORD   dwWritten  = 0;
+
+	m_hFile = ::CreateFile(strJournal.c_str(), GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if ( (m_hFile == INVALID_HANDLE_VALUE)
+	  || (!::WriteFile(m_hFile, &oHeader, sizeof(oHeader), &dwWritten, NULL)) )
+	{
+		Fail(CStrCvt::FormatError().c_str());
+		return false;
+	}
+
+	m_bStop         = false;
+	m_hWakeEvent    = ::CreateEvent(NULL, FALSE, FALSE, NULL);
+	m_hEncodedEvent = ::CreateEvent(NULL, FALSE, FALSE, NULL);
+
+	if ( (m_hWakeEvent != NULL) && (m_hEncodedEvent != NULL) )
+		m_hThread = reinterpret_cast<HANDLE>(_beginthreadex(NULL, 0, ThreadProc, this, 0, NULL));
+
+	if (m_hThread == NULL)
+	{
+		Fail(TXT("The writer thread could not be started"));
+		return false;
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Queue an encoded operation for the writer thread, waking it early if the
+//! queue has reached the batch size.
+
+void EditJournal::Queue(const Buffer& vecOp)
+{
+	::EnterCriticalSection(&m_oLock);
+
+	AppendUInt(m_vecPending, static_cast<uint32>(vecOp.size()));
+	m_vecPending.insert(m_vecPending.end(), vecOp.begin(), vecOp.end());
+
+	bool bWake = (m_vecPending.size() >= BATCH_SIZE);
+
+	::LeaveCriticalSection(&m_oLock);
+
+	if (bWake)
+		::SetEvent(m_hWakeEvent);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Queue an insertion for the writer thread to finish by encoding the inserted
+//! sub-tree. The thread is woken straight away, as the next change must wait
+//! for it.
+
+void EditJournal::QueueInsert(const Buffer& vecOp, NodeRef pNode)
+{
+	::EnterCriticalSection(&m_oLock);
+
+	ASSERT(m_pInserted.get() == nullptr);
+
+	m_vecInsertOp = vecOp;
+	m_pInserted   = pNode;
+
+	::LeaveCriticalSection(&m_oLock);
+
+	::SetEvent(m_hWakeEvent);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Stop the writer thread after it has written everything queued.
+
+void EditJournal::Stop()
+{
+	if (m_hThread != NULL)
+	{
+		::EnterCriticalSection(&m_oLock);
+		m_bStop = true;
+		::LeaveCriticalSection(&m_oLock);
+
+		::SetEvent(m_hWakeEvent);
+		::WaitForSingleObject(m_hThread, INFINITE);
+		::CloseHandle(m_hThread);
+
+		m_hThread = NULL;
+	}
+
+	if (m_hWakeEvent != NULL)
+	{
+		::CloseHandle(m_hWakeEvent);
+		m_hWakeEvent = NULL;
+	}
+
+	if (m_hEncodedEvent != NULL)
+	{
+		::CloseHandle(m_hEncodedEvent);
+		m_hEncodedEvent = NULL;
+	}
+
+	if (m_hFile != INVALID_HANDLE_VALUE)
+	{
+		::CloseHandle(m_hFile);
+		m_hFile = INVALID_HANDLE_VALUE;
+	}
+
+	m_vecPending.clear();
+	m_vecInsertOp.clear();
+	m_pInserted = NodeRef();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Abandon journalling after an edit could not be recorded. The journal is
+//! deleted as it no longer describes all the edits.
+
+void EditJournal::Fail(const tchar* pszReason)
+{
+	TRACE2(TXT("Abandoned the journal for '%s': %s\n"), m_strDocPath.c_str(), pszReason);
+
+	Stop();
+
+	::DeleteFile(JournalPath(m_strDocPath).c_str());
+
+	m_bFailed = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write the queued operations until asked to stop. The queue is swapped out
+//! under the lock so that the UI thread never waits for the disk. An inserted
+//! sub-tree is encoded after the operations queued before it, and the UI thread
+//! is told once that is done; the operations after it are queued later.
+
+void EditJournal::WriteQueue()
+{
+	Buffer  vecBatch;
+	Buffer  vecInsertOp;
+	NodeRef pInserted;
+	bool    bStop = false;
+
+	while (!bStop)
+	{
+		::WaitForSingleObject(m_hWakeEvent, m_dwFlushInterval);
+
+		::EnterCriticalSection(&m_oLock);
+		vecBatch.swap(m_vecPending);
+		vecInsertOp.swap(m_vecInsertOp);
+		pInserted = m_pInserted;
+		bStop     = m_bStop;
+		::LeaveCriticalSection(&m_oLock);
+
+		if (pInserted.get() != nullptr)
+		{
+			AppendInsert(vecBatch, vecInsertOp, pInserted);
+
+			::EnterCriticalSection(&m_oLock);
+			m_pInserted = NodeRef();
+			::LeaveCriticalSection(&m_oLock);
+
+			::SetEvent(m_hEncodedEvent);
+
+			vecInsertOp.clear();
+		}
+
+		if (vecBatch.empty())
+			continue;
+
+		DWORD dwWritten = 0;
+
+		if ( (!::WriteFile(m_hFile, &vecBatch.front(), static_cast<DWORD>(vecBatch.size()), &dwWritten, NULL))
+		  || (!::FlushFileBuffers(m_hFile)) )
+		{
+			TRACE1(TXT("Failed to write the journal: %s\n"), CStrCvt::FormatError().c_str());
+		}
+
+		vecBatch.clear();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Create the header that identifies the current version of a document.
+//! Returns false if the document's details could not be read.
+
+bool EditJournal::CreateHeader(const tstring& strDocPath, Header& oHeader)
+{
+	WIN32_FILE_ATTRIBUTE_DATA oInfo;
+
+	if (!::GetFileAttributesEx(strDocPath.c_str(), GetFileExInfoStandard, &oInfo))
+		return false;
+
+	memset(&oHeader, 0, sizeof(oHeader));
+	memcpy(oHeader.m_achMagic, JOURNAL_MAGIC, sizeof(oHeader.m_achMagic));
+
+	oHeader.m_nFormat    = JOURNAL_FORMAT;
+	oHeader.m_nCharSize  = sizeof(tchar);
+	oHeader.m_nFileSize  = (static_cast<uint64>(oInfo.nFileSizeHigh) << 32) | oInfo.nFileSizeLow;
+	oHeader.m_nLastWrite = ToUInt64(oInfo.ftLastWriteTime);
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The writer thread function. The thread runs in background mode so that its
+//! I/O takes second place to the UI.
+
+unsigned __stdcall EditJournal::ThreadProc(void* pParam)
+{
+	EditJournal* pJournal = static_cast<EditJournal*>(pParam);
+
+	::SetThreadPriority(::GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+
+	pJournal->WriteQueue();
+
+	return 0;
+}
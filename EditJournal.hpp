@@ -0,0 +1,163 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   EditJournal.hpp
+//! \brief  The EditJournal class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_EDITJOURNAL_HPP
+#define APP_EDITJOURNAL_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <XML/Document.hpp>
+#include "IDomListener.hpp"
+
+// Forward declarations.
+class DomEditor;
+struct BulkEdit;
+
+////////////////////////////////////////////////////////////////////////////////
+//! An append-only journal of the edits made to a document since it was last
+//! saved, kept in a file next to it so that they can be recovered after a
+//! crash. Each change is encoded as a compact operation that addresses nodes
+//! by their path of child indices and is queued; a background thread appends
+//! the queue to the file in batches. An inserted sub-tree is encoded by that
+//! thread too, and the next change waits for it so that the nodes are never
+//! modified while they are being read. The file is only created by the first
+//! edit and is deleted when the document is saved or closed normally, so one
+//! that is found when a document is opened holds edits that were lost. A bulk
+//! edit is recorded as a single operation rather than as its changes.
+
+class EditJournal : public IDomListener, private Core::NotCopyable
+{
+public:
+	//! Constructor.
+	EditJournal(DomEditor& oEditor, DWORD dwFlushInterval);
+
+	//! Destructor.
+	virtual ~EditJournal();
+
+	//
+	// Properties.
+	//
+
+	//! Query if edits are being journalled.
+	bool IsOpen() const;
+
+	//
+	// Methods.
+	//
+
+	//! Start journalling the edits to a document.
+	void Open(const tstring& strDocPath);
+
+	//! Stop journalling, optionally deleting the journal.
+	void Close(bool bDiscard);
+
+	//! Discard the journal, as the document has been saved.
+	void Reset();
+
+	//! Stop recording the individual changes while a bulk edit is applied.
+	void BeginBulkEdit();
+
+	//! Record a bulk edit as a single operation, if it was applied.
+	void EndBulkEdit(const BulkEdit& oEdit, bool bApplied);
+
+	//! Handle a change to the DOM.
+	virtual void OnDomChanged(const DomChange& oChange);
+
+	//! Wait until an inserted sub-tree has been encoded.
+	virtual void OnDomChanging();
+
+	//
+	// Class methods.
+	//
+
+	//! Get the path of the journal for a document.
+	static tstring JournalPath(const tstring& strDocPath);
+
+	//! Query if there is a journal for a document.
+	static bool Exists(const tstring& strDocPath);
+
+	//! Replay a document's journal onto its DOM.
+	static size_t Replay(const tstring& strDocPath, DomEditor& oEditor, const XML::DocumentPtr& pDOM);
+
+private:
+	////////////////////////////////////////////////////////////////////////////
+	//! The journal file header. It identifies the version of the document the
+	//! edits were made to and is followed by the length-prefixed operations.
+
+	struct Header
+	{
+		char	m_achMagic[8];		//!< The file signature.
+		uint32	m_nFormat;			//!< The journal format version.
+		uint32	m_nCharSize;		//!< The size of the stored characters.
+		uint64	m_nFileSize;		//!< The document size.
+		uint64	m_nLastWrite;		//!< The document last write time.
+	};
+
+	//! The buffer type for encoded operations.
+	typedef std::vector<byte> Buffer;
+
+	//
+	// Members.
+	//
+	DomEditor&			m_oEditor;			//!< The editor making the changes.
+	DWORD				m_dwFlushInterval;	//!< The time between writes in ms.
+	tstring				m_strDocPath;		//!< The document path.
+	bool				m_bOpen;			//!< Are edits being journalled?
+	bool				m_bFailed;			//!< Has journalling been abandoned?
+	HANDLE				m_hFile;			//!< The journal file, once created.
+	HANDLE				m_hThread;			//!< The writer thread.
+	HANDLE				m_hWakeEvent;		//!< Signals the writer thread.
+	HANDLE				m_hEncodedEvent;	//!< Signals that an insertion was encoded.
+	bool				m_bSuspended;		//!< Is a bulk edit being applied?
+	CRITICAL_SECTION	m_oLock;			//!< Guards the members below.
+	Buffer				m_vecPending;		//!< The operations not yet written.
+	Buffer				m_vecInsertOp;		//!< The start of an insertion not yet encoded.
+	NodeRef				m_pInserted;		//!< The sub-tree it inserted, if any.
+	bool				m_bStop;			//!< Should the writer thread finish?
+
+	//
+	// Internal methods.
+	//
+
+	//! Create the journal file and start the writer thread.
+	bool Start();
+
+	//! Queue an encoded operation for the writer thread.
+	void Queue(const Buffer& vecOp);
+
+	//! Queue an insertion for the writer thread to finish encoding.
+	void QueueInsert(const Buffer& vecOp, NodeRef pNode);
+
+	//! Stop the writer thread after it has written everything queued.
+	void Stop();
+
+	//! Abandon journalling after an edit could not be recorded.
+	void Fail(const tchar* pszReason);
+
+	//! Write the queued operations until asked to stop.
+	void WriteQueue();
+
+	//! Create the header that identifies the current version of a document.
+	static bool CreateHeader(const tstring& strDocPath, Header& oHeader);
+
+	//! Replay the encoded operations onto the DOM.
+	static size_t ReplayOps(const byte* pBegin, const byte* pEnd, DomEditor& oEditor, const XML::DocumentPtr& pDOM);
+
+	//! The writer thread function.
+	static unsigned __stdcall ThreadProc(void* pParam);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if edits are being journalled.
+
+inline bool EditJournal::IsOpen() const
+{
+	return m_bOpen;
+}
+
+#endif // APP_EDITJOURNAL_HPP
@@ -0,0 +1,335 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   FastScan.cpp
+//! \brief  The FastScan class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "FastScan.hpp"
+
+#if (defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)) || defined(__SSE2__))
+#define FASTSCAN_SSE2
+#elif defined(_M_IX86)
+#define FASTSCAN_SSE2
+#define FASTSCAN_SSE2_DETECT
+#endif
+
+#ifdef FASTSCAN_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#ifdef FASTSCAN_SSE2
+
+#ifdef FASTSCAN_SSE2_DETECT
+//! Does the processor support SSE2? The x86 build isn't compiled for SSE2, so
+//! the vector code is only used once the processor has been checked.
+static const bool g_bHasSse2 = (::IsProcessorFeaturePresent(PF_XMMI64_INSTRUCTIONS_AVAILABLE) != FALSE);
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the SSE2 code can be used.
+
+inline bool HasSse2()
+{
+#ifdef FASTSCAN_SSE2_DETECT
+	return g_bHasSse2;
+#else
+	return true;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The SSE2 operations for each size of character.
+
+template<size_t Size>
+struct Lanes;
+
+////////////////////////////////////////////////////////////////////////////////
+//! The SSE2 operations for 8-bit characters.
+
+template<>
+struct Lanes<1>
+{
+	//! Fill a register with the character.
+	static __m128i Fill(int nChar)
+	{
+		return _mm_set1_epi8(static_cast<char>(nChar));
+	}
+
+	//! Compare the characters in two registers.
+	static __m128i Equal(__m128i vecLhs, __m128i vecRhs)
+	{
+		return _mm_cmpeq_epi8(vecLhs, vecRhs);
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The SSE2 operations for 16-bit characters.
+
+template<>
+struct Lanes<2>
+{
+	//! Fill a register with the character.
+	static __m128i Fill(int nChar)
+	{
+		return _mm_set1_epi16(static_cast<short>(nChar));
+	}
+
+	//! Compare the characters in two registers.
+	static __m128i Equal(__m128i vecLhs, __m128i vecRhs)
+	{
+		return _mm_cmpeq_epi16(vecLhs, vecRhs);
+	}
+
+	//! Zero extend a register of 8-bit characters and store them.
+	static void Widen(__m128i vecBytes, void* pOutput)
+	{
+		__m128i  vecZero  = _mm_setzero_si128();
+		__m128i* pvecDest = static_cast<__m128i*>(pOutput);
+
+		_mm_storeu_si128(pvecDest+0, _mm_unpacklo_epi8(vecBytes, vecZero));
+		_mm_storeu_si128(pvecDest+1, _mm_unpackhi_epi8(vecBytes, vecZero));
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The SSE2 operations for 32-bit characters.
+
+template<>
+struct Lanes<4>
+{
+	//! Fill a register with the character.
+	static __m128i Fill(int nChar)
+	{
+		return _mm_set1_epi32(nChar);
+	}
+
+	//! Compare the characters in two registers.
+	static __m128i Equal(__m128i vecLhs, __m128i vecRhs)
+	{
+		return _mm_cmpeq_epi32(vecLhs, vecRhs);
+	}
+
+	//! Zero extend a register of 8-bit characters and store them.
+	static void Widen(__m128i vecBytes, void* pOutput)
+	{
+		__m128i  vecZero  = _mm_setzero_si128();
+		__m128i* pvecDest = static_cast<__m128i*>(pOutput);
+		__m128i  vecLow   = _mm_unpacklo_epi8(vecBytes, vecZero);
+		__m128i  vecHigh  = _mm_unpackhi_epi8(vecBytes, vecZero);
+
+		_mm_storeu_si128(pvecDest+0, _mm_unpacklo_epi16(vecLow, vecZero));
+		_mm_storeu_si128(pvecDest+1, _mm_unpackhi_epi16(vecLow, vecZero));
+		_mm_storeu_si128(pvecDest+2, _mm_unpacklo_epi16(vecHigh, vecZero));
+		_mm_storeu_si128(pvecDest+3, _mm_unpackhi_epi16(vecHigh, vecZero));
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the index of the lowest set bit in a non-zero mask.
+
+static uint LowestBit(uint nMask)
+{
+	ASSERT(nMask != 0);
+
+#ifdef _MSC_VER
+	unsigned long nIndex = 0;
+
+	_BitScanForward(&nIndex, nMask);
+
+	return nIndex;
+#else
+	return __builtin_ctz(nMask);
+#endif
+}
+
+#endif // FASTSCAN_SSE2
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the character is in a set of a fixed size.
+
+template<size_t Count, typename CharT>
+inline bool InSet(CharT cChar, const CharT* pszChars)
+{
+	bool bFound = (cChar == pszChars[0]);
+
+	for (size_t i = 1; i != Count; ++i)
+		bFound |= (cChar == pszChars[i]);
+
+	return bFound;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Scan the range one character at a time for the first character that is,
+//! or isn't, in a set of a fixed size. Returns the end of the range if not
+//! found.
+
+template<size_t Count, typename CharT>
+static const CharT* ScanScalar(const CharT* pBegin, const CharT* pEnd, const CharT* pszChars, bool bInSet)
+{
+	for (const CharT* pCurrent = pBegin; pCurrent != pEnd; ++pCurrent)
+	{
+		if (InSet<Count>(*pCurrent, pszChars) == bInSet)
+			return pCurrent;
+	}
+
+	return pEnd;
+}
+
+#ifdef FASTSCAN_SSE2
+
+////////////////////////////////////////////////////////////////////////////////
+//! Scan the range 16 bytes at a time for the first character that is, or
+//! isn't, in a set of a fixed size. Returns the start of the unscanned tail if
+//! not found.
+
+template<size_t Count, typename CharT>
+static const CharT* ScanVector(const CharT* pBegin, const CharT* pEnd, const CharT* pszChars, bool bInSet)
+{
+	typedef Lanes<sizeof(CharT)> Ops;
+
+	const size_t nStep = sizeof(__m128i) / sizeof(CharT);
+	const uint   nFlip = (bInSet) ? 0 : 0xFFFF;
+	__m128i      avecChars[Count];
+
+	for (size_t i = 0; i != Count; ++i)
+		avecChars[i] = Ops::Fill(pszChars[i]);
+
+	const CharT* pCurrent = pBegin;
+
+	for (; static_cast<size_t>(pEnd - pCurrent) >= nStep; pCurrent += nStep)
+	{
+		__m128i vecBlock = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pCurrent));
+		__m128i vecFound = Ops::Equal(vecBlock, avecChars[0]);
+
+		for (size_t i = 1; i != Count; ++i)
+			vecFound = _mm_or_si128(vecFound, Ops::Equal(vecBlock, avecChars[i]));
+
+		uint nMask = static_cast<uint>(_mm_movemask_epi8(vecFound)) ^ nFlip;
+
+		if (nMask != 0)
+			return pCurrent + (LowestBit(nMask) / sizeof(CharT));
+	}
+
+	return pCurrent;
+}
+
+#endif // FASTSCAN_SSE2
+
+////////////////////////////////////////////////////////////////////////////////
+//! Scan the range for the first character that is, or isn't, in a set of a
+//! fixed size. Returns the end of the range if not found.
+
+template<size_t Count, typename CharT>
+static const CharT* Scan(const CharT* pBegin, const CharT* pEnd, const CharT* pszChars, bool bInSet)
+{
+#ifdef FASTSCAN_SSE2
+	if (HasSse2())
+		pBegin = ScanVector<Count>(pBegin, pEnd, pszChars, bInSet);
+#endif
+
+	return ScanScalar<Count>(pBegin, pEnd, pszChars, bInSet);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Scan the range for the first character that is, or isn't, in the set. The
+//! set size is made a compile time constant so that the comparisons are
+//! unrolled.
+
+template<typename CharT>
+static const CharT* Scan(const CharT* pBegin, const CharT* pEnd, const CharT* pszChars, size_t nChars, bool bInSet)
+{
+	switch (nChars)
+	{
+		case 1:	return Scan<1>(pBegin, pEnd, pszChars, bInSet);
+		case 2:	return Scan<2>(pBegin, pEnd, pszChars, bInSet);
+		case 3:	return Scan<3>(pBegin, pEnd, pszChars, bInSet);
+		case 4:	return Scan<4>(pBegin, pEnd, pszChars, bInSet);
+		case 5:	return Scan<5>(pBegin, pEnd, pszChars, bInSet);
+		case 6:	return Scan<6>(pBegin, pEnd, pszChars, bInSet);
+		case 7:	return Scan<7>(pBegin, pEnd, pszChars, bInSet);
+		case 8:	return Scan<8>(pBegin, pEnd, pszChars, bInSet);
+	}
+
+	ASSERT_FALSE();
+	return pEnd;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Scan a long range for the first character that is, or isn't, in the set.
+//! Returns the end of the range if not found.
+
+const char* FastScan::ScanLong(const char* pBegin, const char* pEnd, const char* pszChars, size_t nChars, bool bInSet)
+{
+	return Scan(pBegin, pEnd, pszChars, nChars, bInSet);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Scan a long range for the first character that is, or isn't, in the set.
+//! Returns the end of the range if not found.
+
+const wchar_t* FastScan::ScanLong(const wchar_t* pBegin, const wchar_t* pEnd, const wchar_t* pszChars, size_t nChars, bool bInSet)
+{
+	return Scan(pBegin, pEnd, pszChars, nChars, bInSet);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the first byte that isn't 7-bit ASCII. Returns the end of the range if
+//! the range is all ASCII.
+
+const char* FastScan::SkipAscii(const char* pBegin, const char* pEnd)
+{
+	const char* pCurrent = pBegin;
+
+#ifdef FASTSCAN_SSE2
+	const size_t nStep = sizeof(__m128i);
+
+	if (HasSse2())
+	{
+		for (; static_cast<size_t>(pEnd - pCurrent) >= nStep; pCurrent += nStep)
+		{
+			__m128i vecBlock = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pCurrent));
+			uint    nMask    = static_cast<uint>(_mm_movemask_epi8(vecBlock));
+
+			if (nMask != 0)
+				return pCurrent + LowestBit(nMask);
+		}
+	}
+#endif
+
+	for (; pCurrent != pEnd; ++pCurrent)
+	{
+		if ((*pCurrent & 0x80) != 0)
+			return pCurrent;
+	}
+
+	return pEnd;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Widen a range of 7-bit ASCII characters. The output must have room for the
+//! same number of characters.
+
+void FastScan::WidenAscii(const char* pBegin, const char* pEnd, wchar_t* pOutput)
+{
+	const char* pCurrent = pBegin;
+
+#ifdef FASTSCAN_SSE2
+	const size_t nStep = sizeof(__m128i);
+
+	if (HasSse2())
+	{
+		for (; static_cast<size_t>(pEnd - pCurrent) >= nStep; pCurrent += nStep, pOutput += nStep)
+		{
+			__m128i vecBlock = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pCurrent));
+
+			Lanes<sizeof(wchar_t)>::Widen(vecBlock, pOutput);
+		}
+	}
+#endif
+
+	for (; pCurrent != pEnd; ++pCurrent, ++pOutput)
+		*pOutput = static_cast<wchar_t>(*pCurrent);
+}
@@ -0,0 +1,138 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   FastScan.hpp
+//! \brief  The FastScan class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_FASTSCAN_HPP
+#define APP_FASTSCAN_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//! Character scanning functions used to find the next structural character in
+//! markup, along with the ASCII checks used when decoding text. Where the
+//! processor supports SSE2 the text is processed 16 bytes at a time, otherwise
+//! it falls back to one character at a time. The x86 build checks for SSE2 at
+//! runtime rather than requiring it.
+
+class FastScan
+{
+public:
+	//! The maximum number of characters in a set.
+	static const size_t MAX_SET_SIZE = 8;
+
+	//
+	// Class methods.
+	//
+
+	//! Find the first occurrence of a character.
+	template<typename CharT>
+	static const CharT* Find(const CharT* pBegin, const CharT* pEnd, CharT cChar);
+
+	//! Find the first character that isn't XML whitespace.
+	template<typename CharT>
+	static const CharT* SkipSpace(const CharT* pBegin, const CharT* pEnd);
+
+	//! Find the first byte that isn't 7-bit ASCII.
+	static const char* SkipAscii(const char* pBegin, const char* pEnd);
+
+	//! Widen a range of 7-bit ASCII characters.
+	static void WidenAscii(const char* pBegin, const char* pEnd, wchar_t* pOutput);
+
+private:
+	//! The number of characters checked inline before vectorising.
+	static const size_t SCALAR_PREFIX = 16;
+
+	//! Disallow instantiation.
+	FastScan();
+
+	//
+	// Internal methods.
+	//
+
+	//! Get the end of the short prefix of the range that is checked inline.
+	template<typename CharT>
+	static const CharT* PrefixEnd(const CharT* pBegin, const CharT* pEnd);
+
+	//! Query if the character is in the set.
+	template<typename CharT>
+	static bool InSet(CharT cChar, const CharT* pszChars, size_t nChars);
+
+	//! Scan a long range for the first character that is, or isn't, in the set.
+	static const char* ScanLong(const char* pBegin, const char* pEnd, const char* pszChars, size_t nChars, bool bInSet);
+
+	//! Scan a long range for the first character that is, or isn't, in the set.
+	static const wchar_t* ScanLong(const wchar_t* pBegin, const wchar_t* pEnd, const wchar_t* pszChars, size_t nChars, bool bInSet);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the end of the short prefix of the range that is checked inline. Most
+//! runs in markup are short and are found quicker without a call or setting
+//! up the vector registers.
+
+template<typename CharT>
+inline const CharT* FastScan::PrefixEnd(const CharT* pBegin, const CharT* pEnd)
+{
+	return (static_cast<size_t>(pEnd - pBegin) > SCALAR_PREFIX) ? pBegin + SCALAR_PREFIX : pEnd;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the character is in the set.
+
+template<typename CharT>
+inline bool FastScan::InSet(CharT cChar, const CharT* pszChars, size_t nChars)
+{
+	for (size_t i = 0; i != nChars; ++i)
+	{
+		if (cChar == pszChars[i])
+			return true;
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the first occurrence of a character. Returns the end of the range if
+//! not found.
+
+template<typename CharT>
+inline const CharT* FastScan::Find(const CharT* pBegin, const CharT* pEnd, CharT cChar)
+{
+	const CharT* pCurrent   = pBegin;
+	const CharT* pPrefixEnd = PrefixEnd(pBegin, pEnd);
+
+	for (; pCurrent != pPrefixEnd; ++pCurrent)
+	{
+		if (*pCurrent == cChar)
+			return pCurrent;
+	}
+
+	return (pCurrent != pEnd) ? ScanLong(pCurrent, pEnd, &cChar, 1, true) : pEnd;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the first character that isn't XML whitespace. Returns the end of the
+//! range if there is only whitespace.
+
+template<typename CharT>
+inline const CharT* FastScan::SkipSpace(const CharT* pBegin, const CharT* pEnd)
+{
+	static const CharT s_achSpaces[] = { ' ', '\t', '\r', '\n' };
+
+	const size_t nChars     = sizeof(s_achSpaces) / sizeof(CharT);
+	const CharT* pCurrent   = pBegin;
+	const CharT* pPrefixEnd = PrefixEnd(pBegin, pEnd);
+
+	for (; pCurrent != pPrefixEnd; ++pCurrent)
+	{
+		if (!InSet(*pCurrent, s_achSpaces, nChars))
+			return pCurrent;
+	}
+
+	return (pCurrent != pEnd) ? ScanLong(pCurrent, pEnd, s_achSpaces, nChars, false) : pEnd;
+}
+
+#endif // APP_FASTSCAN_HPP
@@ -0,0 +1,49 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   FileWatcher.cpp
+//! \brief  The FileWatcher class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "FileWatcher.hpp"
+#include <sys/types.h>
+#include <sys/stat.h>
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+FileWatcher::FileWatcher(const tstring& strPath, uint64 nSize)
+	: m_strPath(strPath)
+	, m_nSize(nSize)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Check the file for a change in size. Only the size is compared as the file
+//! is expected to be appended to; the size is remembered for the next poll.
+
+FileWatcher::Change FileWatcher::Poll()
+{
+#ifdef _WIN32
+	struct _stati64 oInfo;
+
+	if (_tstati64(m_strPath.c_str(), &oInfo) != 0)
+		return MISSING;
+#else
+	struct stat oInfo;
+
+	if (stat(m_strPath.c_str(), &oInfo) != 0)
+		return MISSING;
+#endif
+
+	uint64 nSize = oInfo.st_size;
+	Change eChange = UNCHANGED;
+
+	if (nSize > m_nSize)
+		eChange = GREW;
+	else if (nSize < m_nSize)
+		eChange = SHRANK;
+
+	m_nSize = nSize;
+
+	return eChange;
+}
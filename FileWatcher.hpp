@@ -0,0 +1,63 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   FileWatcher.hpp
+//! \brief  The FileWatcher class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_FILEWATCHER_HPP
+#define APP_FILEWATCHER_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//! Detects changes to the size of a file by polling it. The file is never held
+//! open between polls so that the process writing to it is not disturbed.
+
+class FileWatcher
+{
+public:
+	//! The kind of change detected.
+	enum Change
+	{
+		UNCHANGED	= 0,	//!< The file is the same size.
+		GREW		= 1,	//!< The file has been appended to.
+		SHRANK		= 2,	//!< The file has been truncated or replaced.
+		MISSING		= 3,	//!< The file no longer exists.
+	};
+
+	//! Constructor.
+	FileWatcher(const tstring& strPath, uint64 nSize);
+
+	//
+	// Properties.
+	//
+
+	//! Get the file size when it was last polled.
+	uint64 Size() const;
+
+	//
+	// Methods.
+	//
+
+	//! Check the file for a change in size.
+	Change Poll();
+
+private:
+	//
+	// Members.
+	//
+	tstring		m_strPath;		//!< The file path.
+	uint64		m_nSize;		//!< The file size when last polled.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the file size when it was last polled.
+
+inline uint64 FileWatcher::Size() const
+{
+	return m_nSize;
+}
+
+#endif // APP_FILEWATCHER_HPP
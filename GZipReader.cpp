@@ -0,0 +1,139 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   GZipReader.cpp
+//! \brief  The GZipReader class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "GZipReader.hpp"
+#include <Core/RuntimeException.hpp>
+#include <WCL/StrCvt.hpp>
+
+////////////////////////////////////////////////////////////////////////////////
+// Constants.
+
+//! The size of the compressed input buffer.
+static const size_t INPUT_BUFFER_SIZE = 64 * 1024;
+
+//! The zlib window bits value that selects gzip header decoding.
+static const int GZIP_WINDOW_BITS = MAX_WBITS + 16;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+GZipReader::GZipReader(const tchar* pszPath)
+	: m_strPath(pszPath)
+	, m_hFile(INVALID_HANDLE_VALUE)
+	, m_vecInput(INPUT_BUFFER_SIZE)
+	, m_bEOF(false)
+	, m_bFinished(false)
+{
+	memset(&m_oStream, 0, sizeof(m_oStream));
+
+	m_hFile = ::CreateFile(m_strPath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+							FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+	if (m_hFile == INVALID_HANDLE_VALUE)
+		throw Core::RuntimeException(Core::fmt(TXT("Failed to open file '%s': %s"), m_strPath.c_str(), CStrCvt::FormatError().c_str()));
+
+	if (::inflateInit2(&m_oStream, GZIP_WINDOW_BITS) != Z_OK)
+	{
+		::CloseHandle(m_hFile);
+		throw Core::RuntimeException(TXT("Failed to initialise the gzip decompressor"));
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+GZipReader::~GZipReader()
+{
+	::inflateEnd(&m_oStream);
+	::CloseHandle(m_hFile);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read the next block of decompressed data. Returns the number of bytes
+//! written to the buffer, which is only 0 when all the data has been read.
+
+size_t GZipReader::Read(void* pBuffer, size_t nSize)
+{
+	ASSERT(nSize != 0);
+
+	m_oStream.next_out  = static_cast<Bytef*>(pBuffer);
+	m_oStream.avail_out = static_cast<uInt>(nSize);
+
+	while ( (m_oStream.avail_out != 0) && (!m_bFinished) )
+	{
+		if (m_oStream.avail_in == 0)
+			FillInput();
+
+		int nResult = ::inflate(&m_oStream, Z_NO_FLUSH);
+
+		if (nResult == Z_STREAM_END)
+		{
+			if (m_oStream.avail_in == 0)
+				FillInput();
+
+			// A gzip file can contain multiple concatenated members.
+			if (m_oStream.avail_in != 0)
+				::inflateReset(&m_oStream);
+			else
+				m_bFinished = true;
+		}
+		else if ( (nResult == Z_BUF_ERROR) && (m_bEOF) && (m_oStream.avail_in == 0) )
+		{
+			throw Core::RuntimeException(Core::fmt(TXT("The compressed file '%s' is truncated"), m_strPath.c_str()));
+		}
+		else if ( (nResult != Z_OK) && (nResult != Z_BUF_ERROR) )
+		{
+			const char* pszError = (m_oStream.msg != nullptr) ? m_oStream.msg : "unknown error";
+
+			throw Core::RuntimeException(Core::fmt(TXT("Failed to decompress '%s': %hs"), m_strPath.c_str(), pszError));
+		}
+	}
+
+	return nSize - m_oStream.avail_out;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Refill the input buffer from the file.
+
+void GZipReader::FillInput()
+{
+	if (m_bEOF)
+		return;
+
+	DWORD dwRead = 0;
+
+	if (!::ReadFile(m_hFile, &m_vecInput.front(), static_cast<DWORD>(m_vecInput.size()), &dwRead, NULL))
+		throw Core::RuntimeException(Core::fmt(TXT("Failed to read file '%s': %s"), m_strPath.c_str(), CStrCvt::FormatError().c_str()));
+
+	m_oStream.next_in  = &m_vecInput.front();
+	m_oStream.avail_in = dwRead;
+
+	if (dwRead == 0)
+		m_bEOF = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if a file is gzip compressed. This checks for the gzip signature
+//! rather than relying on the file extension.
+
+bool GZipReader::IsCompressed(const tchar* pszPath)
+{
+	HANDLE hFile = ::CreateFile(pszPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+								FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (hFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	byte  abySignature[2] = { 0 };
+	DWORD dwRead = 0;
+
+	BOOL bRead = ::ReadFile(hFile, abySignature, sizeof(abySignature), &dwRead, NULL);
+
+	::CloseHandle(hFile);
+
+	return ( (bRead) && (dwRead == sizeof(abySignature))
+		  && (abySignature[0] == 0x1f) && (abySignature[1] == 0x8b) );
+}
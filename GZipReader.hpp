@@ -0,0 +1,58 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   GZipReader.hpp
+//! \brief  The GZipReader class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_GZIPREADER_HPP
+#define APP_GZIPREADER_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <zlib.h>
+
+////////////////////////////////////////////////////////////////////////////////
+//! A reader that decompresses a gzip file a block at a time. Only one block of
+//! compressed input is held in memory at any time.
+
+class GZipReader : private Core::NotCopyable
+{
+public:
+	//! Constructor.
+	GZipReader(const tchar* pszPath);
+
+	//! Destructor.
+	~GZipReader();
+
+	//
+	// Methods.
+	//
+
+	//! Read the next block of decompressed data.
+	size_t Read(void* pBuffer, size_t nSize);
+
+	//! Query if a file is gzip compressed.
+	static bool IsCompressed(const tchar* pszPath);
+
+private:
+	//
+	// Members.
+	//
+	tstring				m_strPath;		//!< The file path.
+	HANDLE				m_hFile;		//!< The compressed file.
+	z_stream			m_oStream;		//!< The zlib stream state.
+	std::vector<byte>	m_vecInput;		//!< The compressed input buffer.
+	bool				m_bEOF;			//!< Reached the end of the file?
+	bool				m_bFinished;	//!< Reached the end of the compressed data?
+
+	//
+	// Internal methods.
+	//
+
+	//! Refill the input buffer from the file.
+	void FillInput();
+};
+
+#endif // APP_GZIPREADER_HPP
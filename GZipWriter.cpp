@@ -0,0 +1,132 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   GZipWriter.cpp
+//! \brief  The GZipWriter class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "GZipWriter.hpp"
+#include <Core/RuntimeException.hpp>
+#include <WCL/StrCvt.hpp>
+
+////////////////////////////////////////////////////////////////////////////////
+// Constants.
+
+//! The size of the compressed output buffer.
+static const size_t OUTPUT_BUFFER_SIZE = 64 * 1024;
+
+//! The zlib window bits value that selects a gzip header.
+static const int GZIP_WINDOW_BITS = MAX_WBITS + 16;
+
+//! The zlib memory level (the library default).
+static const int GZIP_MEM_LEVEL = 8;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+GZipWriter::GZipWriter(const tchar* pszPath)
+	: m_strPath(pszPath)
+	, m_hFile(INVALID_HANDLE_VALUE)
+	, m_vecOutput(OUTPUT_BUFFER_SIZE)
+{
+	memset(&m_oStream, 0, sizeof(m_oStream));
+
+	m_hFile = ::CreateFile(m_strPath.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+							FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+	if (m_hFile == INVALID_HANDLE_VALUE)
+		throw Core::RuntimeException(Core::fmt(TXT("Failed to create file '%s': %s"), m_strPath.c_str(), CStrCvt::FormatError().c_str()));
+
+	if (::deflateInit2(&m_oStream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, GZIP_WINDOW_BITS,
+						GZIP_MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK)
+	{
+		::CloseHandle(m_hFile);
+		throw Core::RuntimeException(TXT("Failed to initialise the gzip compressor"));
+	}
+
+	m_oStream.next_out  = &m_vecOutput.front();
+	m_oStream.avail_out = static_cast<uInt>(m_vecOutput.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+GZipWriter::~GZipWriter()
+{
+	::deflateEnd(&m_oStream);
+
+	if (m_hFile != INVALID_HANDLE_VALUE)
+		::CloseHandle(m_hFile);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Compress and write a block of data.
+
+void GZipWriter::Write(const void* pBuffer, size_t nSize)
+{
+	ASSERT(m_hFile != INVALID_HANDLE_VALUE);
+
+	m_oStream.next_in  = static_cast<Bytef*>(const_cast<void*>(pBuffer));
+	m_oStream.avail_in = static_cast<uInt>(nSize);
+
+	Deflate(Z_NO_FLUSH);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Flush any remaining data and close the file.
+
+void GZipWriter::Close()
+{
+	ASSERT(m_hFile != INVALID_HANDLE_VALUE);
+
+	m_oStream.next_in  = nullptr;
+	m_oStream.avail_in = 0;
+
+	Deflate(Z_FINISH);
+
+	::CloseHandle(m_hFile);
+	m_hFile = INVALID_HANDLE_VALUE;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Run the compressor over the pending input.
+
+void GZipWriter::Deflate(int nFlush)
+{
+	for (;;)
+	{
+		int nResult = ::deflate(&m_oStream, nFlush);
+
+		if ( (nResult != Z_OK) && (nResult != Z_STREAM_END) && (nResult != Z_BUF_ERROR) )
+			throw Core::RuntimeException(Core::fmt(TXT("Failed to compress '%s'"), m_strPath.c_str()));
+
+		if (m_oStream.avail_out == 0)
+		{
+			FlushOutput();
+			continue;
+		}
+
+		if ( (nFlush == Z_FINISH) && (nResult != Z_STREAM_END) )
+			continue;
+
+		if (m_oStream.avail_in == 0)
+			break;
+	}
+
+	if (nFlush == Z_FINISH)
+		FlushOutput();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write the compressed output buffer to the file.
+
+void GZipWriter::FlushOutput()
+{
+	DWORD dwSize    = static_cast<DWORD>(m_vecOutput.size() - m_oStream.avail_out);
+	DWORD dwWritten = 0;
+
+	if ( (dwSize != 0) && (!::WriteFile(m_hFile, &m_vecOutput.front(), dwSize, &dwWritten, NULL)) )
+		throw Core::RuntimeException(Core::fmt(TXT("Failed to write file '%s': %s"), m_strPath.c_str(), CStrCvt::FormatError().c_str()));
+
+	m_oStream.next_out  = &m_vecOutput.front();
+	m_oStream.avail_out = static_cast<uInt>(m_vecOutput.size());
+}
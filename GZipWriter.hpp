@@ -0,0 +1,59 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   GZipWriter.hpp
+//! \brief  The GZipWriter class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_GZIPWRITER_HPP
+#define APP_GZIPWRITER_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <zlib.h>
+
+////////////////////////////////////////////////////////////////////////////////
+//! A writer that compresses data into a gzip file as it is written. Only one
+//! block of compressed output is held in memory at any time.
+
+class GZipWriter : private Core::NotCopyable
+{
+public:
+	//! Constructor.
+	GZipWriter(const tchar* pszPath);
+
+	//! Destructor.
+	~GZipWriter();
+
+	//
+	// Methods.
+	//
+
+	//! Compress and write a block of data.
+	void Write(const void* pBuffer, size_t nSize);
+
+	//! Flush any remaining data and close the file.
+	void Close();
+
+private:
+	//
+	// Members.
+	//
+	tstring				m_strPath;		//!< The file path.
+	HANDLE				m_hFile;		//!< The compressed file.
+	z_stream			m_oStream;		//!< The zlib stream state.
+	std::vector<byte>	m_vecOutput;	//!< The compressed output buffer.
+
+	//
+	// Internal methods.
+	//
+
+	//! Run the compressor over the pending input.
+	void Deflate(int nFlush);
+
+	//! Write the compressed output buffer to the file.
+	void FlushOutput();
+};
+
+#endif // APP_GZIPWRITER_HPP
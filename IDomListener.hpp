@@ -0,0 +1,91 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   IDomListener.hpp
+//! \brief  The IDomListener interface declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_IDOMLISTENER_HPP
+#define APP_IDOMLISTENER_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "NodeRef.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+//! A single change made to the DOM by the DomEditor. The previous values are
+//! included so that the change can be reverted.
+
+struct DomChange
+{
+	//! The kinds of change.
+	enum Type
+	{
+		NODE_INSERTED,		//!< A node was inserted into a container.
+		NODE_REMOVED,		//!< A node was removed from its container.
+		NODE_MOVED,			//!< A node was moved to another position.
+		ATTRIBUTE_CHANGED,	//!< An attribute was set or removed.
+		TEXT_CHANGED,		//!< The text of a node was replaced.
+		TEXT_EDITED,		//!< A range of the text of a node was replaced.
+		CHILDREN_MOVED,		//!< All the children of a node were moved to another.
+	};
+
+	Type		m_eType;		//!< The kind of change.
+	NodeRef		m_pNode;		//!< The node inserted, removed, moved or changed.
+	NodeRef		m_pParent;		//!< The container the node is now in, if any.
+	size_t		m_nIndex;		//!< The position of the node in its container.
+	NodeRef		m_pOldParent;	//!< The container the node was removed from, if any.
+	size_t		m_nOldIndex;	//!< The position of the node in its old container.
+	tstring		m_strName;		//!< The name of the attribute changed.
+	bool		m_bHadValue;	//!< Did the attribute exist before the change?
+	tstring		m_strOldValue;	//!< The previous attribute value or text.
+	size_t		m_nOffset;		//!< The position of the range of text edited.
+	tstring		m_strNewText;	//!< The text that replaced the range.
+
+	//! Constructor.
+	DomChange(Type eType, NodeRef pNode);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+inline DomChange::DomChange(Type eType, NodeRef pNode)
+	: m_eType(eType)
+	, m_pNode(pNode)
+	, m_nIndex(0)
+	, m_nOldIndex(0)
+	, m_bHadValue(false)
+	, m_nOffset(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The interface for an object that wants to be told about changes to the DOM.
+//! A removed node is still alive when the change is published. The changes
+//! that make up a large edit are published between the start and finish of a
+//! batch so that a listener can defer any expensive work until the end. A
+//! listener that reads the nodes on another thread is told before any node is
+//! modified, so that it can wait for the thread to finish with them.
+
+class IDomListener
+{
+public:
+	//! Handle a change to the DOM.
+	virtual void OnDomChanged(const DomChange& oChange) = 0;
+
+	//! Prepare for a change to the DOM.
+	virtual void OnDomChanging() {}
+
+	//! Handle the start of a batch of changes.
+	virtual void OnBatchStarted() {}
+
+	//! Handle the end of a batch of changes.
+	virtual void OnBatchFinished() {}
+
+protected:
+	//! Protected destructor.
+	virtual ~IDomListener() {}
+};
+
+#endif // APP_IDOMLISTENER_HPP
@@ -0,0 +1,307 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   IncrementalReader.cpp
+//! \brief  The IncrementalReader class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "IncrementalReader.hpp"
+#include <XML/ElementNode.hpp>
+#include <XML/Reader.hpp>
+#include <Core/RuntimeException.hpp>
+#include <WCL/StrCvt.hpp>
+#include "FastScan.hpp"
+#include "DocArena.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+// Constants.
+
+//! The size of the blocks scanned when resuming.
+static const size_t RESUME_BLOCK_SIZE = 4 * 1024 * 1024;
+
+//! The largest block read when looking for the end of a single construct.
+static const size_t MAX_READ_SIZE = 256 * 1024 * 1024;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the child nodes of a document or element node.
+
+static XML::NodeContainer* Container(const XML::NodePtr& pNode)
+{
+	if (pNode->type() == XML::DOCUMENT_NODE)
+		return static_cast<XML::Document*>(pNode.get());
+
+	return static_cast<XML::ElementNode*>(pNode.get());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+IncrementalReader::IncrementalReader(const tstring& strPath, DocArena* pArena)
+	: m_strPath(strPath)
+	, m_pArena(pArena)
+	, m_nPosition(0)
+	, m_nFileSize(0)
+	, m_bComplete(false)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+IncrementalReader::~IncrementalReader()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read the next part of the document into the DOM. The part is limited to
+//! roughly the given number of bytes and top-level records (0 means no limit).
+//! If the DOM is empty the part becomes the new DOM, otherwise the part's nodes
+//! are merged into it and the new ones are returned.
+
+void IncrementalReader::ReadNext(XML::DocumentPtr& pDOM, size_t nMaxBytes, size_t nMaxRecords, AddedNodes& vecAdded)
+{
+	ASSERT(nMaxBytes != 0);
+
+	const MarkupScanner::Elements vecPrevOpen = m_oScanner.OpenElements();
+
+	std::vector<byte> vecBuffer;
+	size_t            nScanned = ScanNext(nMaxBytes, nMaxRecords, vecBuffer);
+
+	// Nothing new?
+	if ( (nScanned == 0) && (pDOM.get() != nullptr) )
+		return;
+
+	// Re-open the elements the previous part left open and close the ones
+	// this part leaves open.
+	const MarkupScanner::Elements& vecOpen = m_oScanner.OpenElements();
+	std::string                    strPrefix;
+	std::string                    strSuffix;
+
+	for (MarkupScanner::Elements::const_iterator it = vecPrevOpen.begin(); it != vecPrevOpen.end(); ++it)
+		strPrefix += "<" + *it + ">";
+
+	for (MarkupScanner::Elements::const_reverse_iterator it = vecOpen.rbegin(); it != vecOpen.rend(); ++it)
+		strSuffix += "</" + *it + ">";
+
+	tstring strText;
+	const byte* pPrefix = reinterpret_cast<const byte*>(strPrefix.data());
+	const byte* pSuffix = reinterpret_cast<const byte*>(strSuffix.data());
+
+	m_oDecoder.Decode(pPrefix, pPrefix + strPrefix.size(), strText);
+	m_oDecoder.Decode(vecBuffer.data(), vecBuffer.data() + nScanned, strText);
+	m_oDecoder.Decode(pSuffix, pSuffix + strSuffix.size(), strText);
+	m_oDecoder.Finish(strText);
+
+	const tchar*     pszBegin = strText.data();
+	const tchar*     pszEnd   = pszBegin + strText.size();
+	XML::DocumentPtr pPart;
+
+	{
+		DocArena::Scope oScope(m_pArena);
+
+		pPart = XML::Reader::readDocument(pszBegin, pszEnd, XML::Reader::DISCARD_WHITESPACE);
+	}
+
+	if (pDOM.get() == nullptr)
+		pDOM = pPart;
+	else
+		Merge(pDOM, pPart, vecPrevOpen.size(), vecAdded);
+
+	FindOpenElements(pDOM);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Position the reader after the content already loaded into the DOM. This is
+//! used when a document that was loaded in full is going to be read further as
+//! it is appended to. The file is only scanned, not parsed again.
+
+void IncrementalReader::Resume(const XML::DocumentPtr& pDOM)
+{
+	std::vector<byte> vecBuffer;
+
+	// Detect the encoding from the byte order mark or XML declaration.
+	ReadBytes(0, TextDecoder::MAX_DETECT_SIZE, vecBuffer);
+
+	m_oDecoder.DetectEncoding(vecBuffer.data(), vecBuffer.data() + vecBuffer.size());
+
+	while ( (ScanNext(RESUME_BLOCK_SIZE, 0, vecBuffer) != 0) && (!m_bComplete) )
+		;
+
+	FindOpenElements(pDOM);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read and scan the next block of complete markup. The block is read from the
+//! current position and grown until at least one complete construct is found
+//! or the end of the file is reached. Any whitespace after the root element is
+//! skipped, as the scanner only consumes text that's followed by a tag. Returns
+//! the number of bytes scanned.
+
+size_t IncrementalReader::ScanNext(size_t nMaxBytes, size_t nMaxRecords, std::vector<byte>& vecBuffer)
+{
+	MarkupScanner oScanner;
+	const char*   pBegin = nullptr;
+	const char*   pEnd   = nullptr;
+	const char*   pCut   = nullptr;
+	bool          bEOF   = false;
+
+	for (size_t nReadSize = nMaxBytes; ; nReadSize *= 2)
+	{
+		if (nReadSize > MAX_READ_SIZE)
+		{
+			throw Core::RuntimeException(Core::fmt(TXT("The document contains a single construct larger than %u MB"),
+													static_cast<uint>(MAX_READ_SIZE / (1024*1024))));
+		}
+
+		ReadBytes(m_nPosition, nReadSize, vecBuffer);
+
+		if ( (m_nPosition == 0) && (vecBuffer.size() >= 2) && (vecBuffer[0] == 0xFF) && (vecBuffer[1] == 0xFE) )
+			throw Core::RuntimeException(TXT("Partial loading does not support UTF-16 encoded documents"));
+
+		bEOF     = (vecBuffer.size() < nReadSize);
+		pBegin   = reinterpret_cast<const char*>(vecBuffer.data());
+		pEnd     = pBegin + vecBuffer.size();
+		oScanner = m_oScanner;
+		pCut     = oScanner.Scan(pBegin, pEnd, nMaxRecords);
+
+		if ( (pCut != pBegin) || (bEOF) || (oScanner.AtRootEnd()) || (oScanner.IsRootClosed()) )
+			break;
+	}
+
+	bool bTrailingSpace = ( (oScanner.IsRootClosed()) && (FastScan::SkipSpace(pCut, pEnd) == pEnd) );
+
+	m_oScanner   = oScanner;
+	m_nPosition += (bTrailingSpace) ? (pEnd - pBegin) : (pCut - pBegin);
+	m_bComplete  = ( (bEOF) && ((pCut == pEnd) || (bTrailingSpace) || (m_oScanner.AtRootEnd())) );
+
+	return pCut - pBegin;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read a block of bytes from the file. The file is opened for each read and
+//! shared for writing so that it can still be appended to by another process.
+
+void IncrementalReader::ReadBytes(uint64 nOffset, size_t nMaxBytes, std::vector<byte>& vecBuffer)
+{
+	HANDLE hFile = ::CreateFile(m_strPath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+								NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (hFile == INVALID_HANDLE_VALUE)
+		throw Core::RuntimeException(Core::fmt(TXT("Failed to open file '%s': %s"), m_strPath.c_str(), CStrCvt::FormatError().c_str()));
+
+	LARGE_INTEGER liSize, liOffset;
+	DWORD         dwRead = 0;
+
+	liOffset.QuadPart = nOffset;
+	vecBuffer.resize(nMaxBytes);
+
+	BOOL bOK = ( (::GetFileSizeEx(hFile, &liSize))
+			  && (::SetFilePointerEx(hFile, liOffset, NULL, FILE_BEGIN))
+			  && (::ReadFile(hFile, &vecBuffer.front(), static_cast<DWORD>(nMaxBytes), &dwRead, NULL)) );
+
+	DWORD dwError = ::GetLastError();
+
+	::CloseHandle(hFile);
+
+	if (!bOK)
+		throw Core::RuntimeException(Core::fmt(TXT("Failed to read file '%s': %s"), m_strPath.c_str(), CStrCvt::FormatError(dwError).c_str()));
+
+	m_nFileSize = liSize.QuadPart;
+	vecBuffer.resize(dwRead);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the chain of elements left open in the DOM. As the document is read in
+//! order they are always the last child element at each level.
+
+void IncrementalReader::FindOpenElements(const XML::DocumentPtr& pDOM)
+{
+	size_t       nDepth = m_oScanner.OpenElements().size();
+	XML::NodePtr pNode  = pDOM;
+
+	m_vecOpen.clear();
+
+	for (size_t i = 0; (i != nDepth) && (pNode.get() != nullptr); ++i)
+	{
+		pNode = LastChildElement(pNode);
+
+		if (pNode.get() != nullptr)
+			m_vecOpen.push_back(pNode.get());
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Merge a parsed part into the existing DOM. The first nDepth levels of the
+//! part are the synthetic elements that re-opened the previously truncated
+//! ones, so their content is merged into the existing elements and everything
+//! else is appended. The levels are walked with a loop rather than recursion
+//! as a deeply nested document can leave thousands of elements open.
+
+void IncrementalReader::Merge(const XML::NodePtr& pTarget, const XML::NodePtr& pSource, size_t nDepth, AddedNodes& vecAdded)
+{
+	typedef std::pair<XML::NodePtr, XML::Nodes> Level;
+	typedef std::vector<Level> Levels;
+
+	Levels       vecLevels;
+	XML::NodePtr pTargetNode = pTarget;
+	XML::NodePtr pSourceNode = pSource;
+
+	for (;;)
+	{
+		ASSERT( (pTargetNode->type() == XML::DOCUMENT_NODE) || (pTargetNode->type() == XML::ELEMENT_NODE) );
+
+		XML::NodeContainer* pSourceNodes = Container(pSourceNode);
+
+		// Take a copy as the nodes are re-parented.
+		vecLevels.push_back(Level(pTargetNode, XML::Nodes(pSourceNodes->beginChild(), pSourceNodes->endChild())));
+
+		XML::Nodes& vecSource = vecLevels.back().second;
+
+		if ( (vecLevels.size() > nDepth) || (vecSource.empty()) )
+			break;
+
+		pTargetNode = LastChildElement(pTargetNode);
+		pSourceNode = vecSource.front();
+
+		ASSERT(pTargetNode.get() != nullptr);
+
+		vecSource.erase(vecSource.begin());
+	}
+
+	// Append the rest, innermost first as the recursive merge did.
+	for (Levels::const_reverse_iterator itLevel = vecLevels.rbegin(); itLevel != vecLevels.rend(); ++itLevel)
+	{
+		const XML::NodePtr& pParent      = itLevel->first;
+		XML::NodeContainer* pTargetNodes = Container(pParent);
+
+		for (XML::Nodes::const_iterator it = itLevel->second.begin(); it != itLevel->second.end(); ++it)
+		{
+			pTargetNodes->appendChild(*it);
+			vecAdded.push_back(AddedNode(pParent.get(), *it));
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the last child element of a container node.
+
+XML::NodePtr IncrementalReader::LastChildElement(const XML::NodePtr& pNode)
+{
+	const XML::NodeContainer* pNodes = nullptr;
+
+	if (pNode->type() == XML::DOCUMENT_NODE)
+		pNodes = static_cast<const XML::Document*>(pNode.get());
+	else if (pNode->type() == XML::ELEMENT_NODE)
+		pNodes = static_cast<const XML::ElementNode*>(pNode.get());
+	else
+		return XML::NodePtr();
+
+	for (XML::NodeContainer::const_iterator it = pNodes->endChild(); it != pNodes->beginChild(); )
+	{
+		--it;
+
+		if ((*it)->type() == XML::ELEMENT_NODE)
+			return *it;
+	}
+
+	return XML::NodePtr();
+}
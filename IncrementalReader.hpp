@@ -0,0 +1,148 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   IncrementalReader.hpp
+//! \brief  The IncrementalReader class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_INCREMENTALREADER_HPP
+#define APP_INCREMENTALREADER_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <XML/Document.hpp>
+#include "MarkupScanner.hpp"
+#include "TextDecoder.hpp"
+
+// Forward declarations.
+class DocArena;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Reads a document from a file one part at a time. Each part ends on a markup
+//! boundary; any elements still open at that point are closed synthetically so
+//! that the part can be parsed and the open elements are marked as truncated.
+//! The next part continues from the saved file position and its nodes are
+//! merged into the existing DOM rather than the file being parsed again.
+
+class IncrementalReader : private Core::NotCopyable
+{
+public:
+	//! A node added to the DOM, along with its parent.
+	typedef std::pair<XML::Node*, XML::NodePtr> AddedNode;
+	//! The collection of nodes added by a read.
+	typedef std::vector<AddedNode> AddedNodes;
+	//! The chain of truncated elements.
+	typedef std::vector<XML::Node*> NodeChain;
+
+	//! Constructor.
+	IncrementalReader(const tstring& strPath, DocArena* pArena);
+
+	//! Destructor.
+	~IncrementalReader();
+
+	//
+	// Properties.
+	//
+
+	//! Get the file offset where the next read will start.
+	uint64 Position() const;
+
+	//! Get the size of the file when it was last read.
+	uint64 FileSize() const;
+
+	//! Query if the entire file has been read.
+	bool IsComplete() const;
+
+	//! Get the chain of elements left open by the last read, outermost first.
+	const NodeChain& TruncatedElements() const;
+
+	//
+	// Methods.
+	//
+
+	//! Read the next part of the document into the DOM.
+	void ReadNext(XML::DocumentPtr& pDOM, size_t nMaxBytes, size_t nMaxRecords, AddedNodes& vecAdded);
+
+	//! Position the reader after the content already loaded into the DOM.
+	void Resume(const XML::DocumentPtr& pDOM);
+
+	//! Set whether the root element is held open for appended content.
+	void HoldRootOpen(bool bHold);
+
+private:
+	//
+	// Members.
+	//
+	tstring			m_strPath;		//!< The file path.
+	DocArena*		m_pArena;		//!< The arena to allocate the nodes from, if any.
+	uint64			m_nPosition;	//!< The offset of the next unread markup.
+	uint64			m_nFileSize;	//!< The file size when last read.
+	bool			m_bComplete;	//!< Has the entire file been read?
+	MarkupScanner	m_oScanner;		//!< The markup scanner state.
+	TextDecoder		m_oDecoder;		//!< The text decoder state.
+	NodeChain		m_vecOpen;		//!< The chain of open elements.
+
+	//
+	// Internal methods.
+	//
+
+	//! Read and scan the next block of complete markup.
+	size_t ScanNext(size_t nMaxBytes, size_t nMaxRecords, std::vector<byte>& vecBuffer);
+
+	//! Read a block of bytes from the file.
+	void ReadBytes(uint64 nOffset, size_t nMaxBytes, std::vector<byte>& vecBuffer);
+
+	//! Find the chain of elements left open in the DOM.
+	void FindOpenElements(const XML::DocumentPtr& pDOM);
+
+	//! Merge a parsed part into the existing DOM.
+	static void Merge(const XML::NodePtr& pTarget, const XML::NodePtr& pSource, size_t nDepth, AddedNodes& vecAdded);
+
+	//! Find the last child element of a container node.
+	static XML::NodePtr LastChildElement(const XML::NodePtr& pNode);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the file offset where the next read will start.
+
+inline uint64 IncrementalReader::Position() const
+{
+	return m_nPosition;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the size of the file when it was last read.
+
+inline uint64 IncrementalReader::FileSize() const
+{
+	return m_nFileSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the entire file has been read.
+
+inline bool IncrementalReader::IsComplete() const
+{
+	return m_bComplete;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the chain of elements left open by the last read, outermost first.
+
+inline const IncrementalReader::NodeChain& IncrementalReader::TruncatedElements() const
+{
+	return m_vecOpen;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Set whether the root element is held open for appended content. When held
+//! open the root's end tag is left unread so that any content written before
+//! it later is still read as children of the root.
+
+inline void IncrementalReader::HoldRootOpen(bool bHold)
+{
+	m_oScanner.HoldRootOpen(bHold);
+}
+
+#endif // APP_INCREMENTALREADER_HPP
@@ -0,0 +1,237 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   MarkupScanner.cpp
+//! \brief  The MarkupScanner class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "MarkupScanner.hpp"
+#include "FastScan.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+// Constants.
+
+//! The nesting depth of a top-level record, i.e. a child of the root.
+static const size_t RECORD_DEPTH = 2;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the range starts with the string.
+
+static bool StartsWith(const char* pBegin, const char* pEnd, const char* pszString)
+{
+	size_t nLength = strlen(pszString);
+
+	return ( (static_cast<size_t>(pEnd - pBegin) >= nLength) && (memcmp(pBegin, pszString, nLength) == 0) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the character terminates an element name.
+
+static bool IsNameEnd(char c)
+{
+	return ( (c == ' ') || (c == '\t') || (c == '\r') || (c == '\n') || (c == '/') || (c == '>') );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+MarkupScanner::MarkupScanner()
+	: m_nRecordsClosed(0)
+	, m_bRootSeen(false)
+	, m_bHoldRoot(false)
+	, m_bAtRootEnd(false)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Scan the complete markup constructs in the range. Scanning stops at the
+//! first incomplete construct, or after the given number of top-level records
+//! have been closed (0 means no limit). Returns the end of the last complete
+//! construct, which is where the next scan should resume from.
+
+const char* MarkupScanner::Scan(const char* pBegin, const char* pEnd, size_t nMaxRecords)
+{
+	const char* pCurrent = pBegin;
+
+	m_nRecordsClosed = 0;
+	m_bAtRootEnd     = false;
+
+	while (pCurrent != pEnd)
+	{
+		const char* pNext = nullptr;
+
+		if (*pCurrent == '<')
+		{
+			pNext = ScanTag(pCurrent, pEnd);
+		}
+		else
+		{
+			// Text only ends at the next tag.
+			pNext = FastScan::Find(pCurrent, pEnd, '<');
+
+			if (pNext == pEnd)
+				pNext = nullptr;
+		}
+
+		if (pNext == nullptr)
+			break;
+
+		pCurrent = pNext;
+
+		if ( (nMaxRecords != 0) && (m_nRecordsClosed == nMaxRecords) )
+			break;
+	}
+
+	return pCurrent;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Scan a single tag, returning the end or nullptr if incomplete.
+
+const char* MarkupScanner::ScanTag(const char* pBegin, const char* pEnd)
+{
+	ASSERT(*pBegin == '<');
+
+	const char* pEndTag = nullptr;
+
+	if (StartsWith(pBegin, pEnd, "<!--"))
+	{
+		pEndTag = FindString(pBegin+4, pEnd, "-->");
+	}
+	else if (StartsWith(pBegin, pEnd, "<![CDATA["))
+	{
+		pEndTag = FindString(pBegin+9, pEnd, "]]>");
+	}
+	else if (StartsWith(pBegin, pEnd, "<!"))
+	{
+		pEndTag = FindDocTypeEnd(pBegin+2, pEnd);
+	}
+	else if (StartsWith(pBegin, pEnd, "<?"))
+	{
+		pEndTag = FindString(pBegin+2, pEnd, "?>");
+	}
+	else if (StartsWith(pBegin, pEnd, "</"))
+	{
+		pEndTag = FastScan::Find(pBegin+2, pEnd, '>');
+
+		if (pEndTag == pEnd)
+			return nullptr;
+
+		if ( (m_bHoldRoot) && (m_vecOpen.size() == 1) )
+		{
+			m_bAtRootEnd = true;
+			return nullptr;
+		}
+
+		++pEndTag;
+
+		if (!m_vecOpen.empty())
+		{
+			m_vecOpen.pop_back();
+
+			if (m_vecOpen.size() == (RECORD_DEPTH-1))
+				++m_nRecordsClosed;
+		}
+	}
+	else if ((pEnd - pBegin) > 1)
+	{
+		pEndTag = FindTagEnd(pBegin+1, pEnd);
+
+		if (pEndTag == nullptr)
+			return nullptr;
+
+		const char* pNameBegin = pBegin+1;
+		const char* pNameEnd   = std::find_if(pNameBegin, pEndTag, IsNameEnd);
+		bool        bEmptyTag  = (*(pEndTag-2) == '/');
+
+		if (!bEmptyTag)
+			m_vecOpen.push_back(std::string(pNameBegin, pNameEnd));
+		else if (m_vecOpen.size() == (RECORD_DEPTH-1))
+			++m_nRecordsClosed;
+
+		m_bRootSeen = true;
+	}
+
+	return pEndTag;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the end of a start tag, skipping quoted attribute values. Returns the
+//! position after the closing '>' or nullptr if incomplete.
+
+const char* MarkupScanner::FindTagEnd(const char* pBegin, const char* pEnd)
+{
+	for (const char* pCurrent = pBegin; pCurrent != pEnd; ++pCurrent)
+	{
+		char c = *pCurrent;
+
+		if ( (c == '"') || (c == '\'') )
+		{
+			pCurrent = FastScan::Find(pCurrent+1, pEnd, c);
+
+			if (pCurrent == pEnd)
+				return nullptr;
+		}
+		else if (c == '>')
+		{
+			return pCurrent+1;
+		}
+	}
+
+	return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the end of a DOCTYPE declaration, skipping any internal subset.
+//! Returns the position after the closing '>' or nullptr if incomplete.
+
+const char* MarkupScanner::FindDocTypeEnd(const char* pBegin, const char* pEnd)
+{
+	int nSubsetDepth = 0;
+
+	for (const char* pCurrent = pBegin; pCurrent != pEnd; ++pCurrent)
+	{
+		char c = *pCurrent;
+
+		if ( (c == '"') || (c == '\'') )
+		{
+			pCurrent = FastScan::Find(pCurrent+1, pEnd, c);
+
+			if (pCurrent == pEnd)
+				return nullptr;
+		}
+		else if (c == '[')
+		{
+			++nSubsetDepth;
+		}
+		else if (c == ']')
+		{
+			--nSubsetDepth;
+		}
+		else if ( (c == '>') && (nSubsetDepth <= 0) )
+		{
+			return pCurrent+1;
+		}
+	}
+
+	return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find a terminator string in the range. Returns the position after the
+//! terminator or nullptr if it wasn't found.
+
+const char* MarkupScanner::FindString(const char* pBegin, const char* pEnd, const char* pszString)
+{
+	size_t nLength = strlen(pszString);
+
+	for (const char* pCurrent = pBegin; ; ++pCurrent)
+	{
+		pCurrent = FastScan::Find(pCurrent, pEnd, *pszString);
+
+		if (pCurrent == pEnd)
+			return nullptr;
+
+		if (StartsWith(pCurrent, pEnd, pszString))
+			return pCurrent + nLength;
+	}
+}
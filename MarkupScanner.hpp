@@ -0,0 +1,124 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   MarkupScanner.hpp
+//! \brief  The MarkupScanner class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_MARKUPSCANNER_HPP
+#define APP_MARKUPSCANNER_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//! A lightweight scanner that tracks the element nesting of raw XML markup
+//! without building a DOM. It works on the bytes of an ASCII compatible
+//! encoding (ANSI or UTF-8) and can be resumed across blocks of input, which
+//! allows a document to be split at markup boundaries before being parsed.
+
+class MarkupScanner
+{
+public:
+	//! The stack of open element names.
+	typedef std::vector<std::string> Elements;
+
+	//! Default constructor.
+	MarkupScanner();
+
+	//
+	// Properties.
+	//
+
+	//! Get the names of the currently open elements, outermost first.
+	const Elements& OpenElements() const;
+
+	//! Get the number of top-level records closed by the last scan.
+	size_t RecordsClosed() const;
+
+	//! Query if the root element has been closed.
+	bool IsRootClosed() const;
+
+	//! Query if the last scan stopped at the root element's end tag.
+	bool AtRootEnd() const;
+
+	//! Set whether scanning stops before the root element's end tag.
+	void HoldRootOpen(bool bHold);
+
+	//
+	// Methods.
+	//
+
+	//! Scan the complete markup constructs in the range.
+	const char* Scan(const char* pBegin, const char* pEnd, size_t nMaxRecords = 0);
+
+private:
+	//
+	// Members.
+	//
+	Elements	m_vecOpen;			//!< The open element names.
+	size_t		m_nRecordsClosed;	//!< The records closed by the last scan.
+	bool		m_bRootSeen;		//!< Has the root element been opened?
+	bool		m_bHoldRoot;		//!< Stop before the root element's end tag?
+	bool		m_bAtRootEnd;		//!< Did the last scan stop at the root's end tag?
+
+	//
+	// Internal methods.
+	//
+
+	//! Scan a single tag, returning the end or nullptr if incomplete.
+	const char* ScanTag(const char* pBegin, const char* pEnd);
+
+	//! Find the end of a start tag, skipping quoted attribute values.
+	static const char* FindTagEnd(const char* pBegin, const char* pEnd);
+
+	//! Find the end of a DOCTYPE declaration, skipping any internal subset.
+	static const char* FindDocTypeEnd(const char* pBegin, const char* pEnd);
+
+	//! Find a terminator string in the range.
+	static const char* FindString(const char* pBegin, const char* pEnd, const char* pszString);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the names of the currently open elements, outermost first.
+
+inline const MarkupScanner::Elements& MarkupScanner::OpenElements() const
+{
+	return m_vecOpen;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of top-level records closed by the last scan.
+
+inline size_t MarkupScanner::RecordsClosed() const
+{
+	return m_nRecordsClosed;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the root element has been closed.
+
+inline bool MarkupScanner::IsRootClosed() const
+{
+	return (m_bRootSeen && m_vecOpen.empty());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the last scan stopped at the root element's end tag.
+
+inline bool MarkupScanner::AtRootEnd() const
+{
+	return m_bAtRootEnd;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Set whether scanning stops before the root element's end tag. This allows
+//! more content to be appended to the root when the document is still being
+//! written.
+
+inline void MarkupScanner::HoldRootOpen(bool bHold)
+{
+	m_bHoldRoot = bHold;
+}
+
+#endif // APP_MARKUPSCANNER_HPP
@@ -0,0 +1,194 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   NameIndex.cpp
+//! \brief  The NameIndex class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "NameIndex.hpp"
+#include <XML/ElementNode.hpp>
+#include "NodeCursor.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+NameIndex::NameIndex()
+	: m_bBuilt(false)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Build the index from the DOM. The elements are visited in document order
+//! using a NodeCursor so that deeply nested documents are handled. The index
+//! is held in addition to the DOM, which keeps its own copy of every name, so
+//! the memory it costs is traced.
+
+void NameIndex::Build(const XML::DocumentPtr& pDOM)
+{
+	Clear();
+
+	NodeCursor oCursor(*pDOM);
+	size_t     nElements = 0;
+
+	while (oCursor.Next())
+	{
+		NodeRef pNode = oCursor.Node();
+
+		if (pNode->type() != XML::ELEMENT_NODE)
+			continue;
+
+		AddElement(pNode.As<const XML::ElementNode>());
+		++nElements;
+	}
+
+	size_t nBytes = nElements * sizeof(const XML::Node*);
+
+	for (NameTable::NameId nID = 0; nID != m_oNames.Count(); ++nID)
+		nBytes += (m_oNames.Name(nID).size() + 1) * sizeof(tchar);
+
+	TRACE3(TXT("Indexed %u elements with %u distinct names in about %u bytes\n"), nElements, m_oNames.Count(), nBytes);
+
+	m_bBuilt = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Discard the index.
+
+void NameIndex::Clear()
+{
+	m_oNames.Clear();
+	m_vecElements.clear();
+	m_bBuilt = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the elements that match a simple name test query. The supported forms
+//! are "//name", "//name[@attr]" and "//name[@attr='value']". Returns false if
+//! the query is not one of these, in which case it needs a full XPath
+//! evaluation.
+
+bool NameIndex::Query(const tstring& strQuery, NodesList& lstNodes) const
+{
+	ASSERT(m_bBuilt);
+
+	tstring strName, strAttrib, strValue;
+	bool    bHasValue = false;
+
+	if (!ParseQuery(strQuery, strName, strAttrib, strValue, bHasValue))
+		return false;
+
+	NameTable::NameId nID = m_oNames.Find(strName);
+
+	// No elements with the name?
+	if (nID == NameTable::INVALID_NAME)
+		return true;
+
+	const Elements& vecElements = m_vecElements[nID];
+
+	for (Elements::const_iterator it = vecElements.begin(); it != vecElements.end(); ++it)
+	{
+		const XML::Node* pNode = *it;
+
+		if (!strAttrib.empty())
+		{
+			const XML::ElementNode* pElement = static_cast<const XML::ElementNode*>(pNode);
+			XML::AttributePtr       pAttrib  = pElement->getAttributes().find(strAttrib);
+
+			if (pAttrib.get() == nullptr)
+				continue;
+
+			if ( (bHasValue) && (pAttrib->value() != strValue) )
+				continue;
+		}
+
+		lstNodes.push_back(XML::NodePtr(const_cast<XML::Node*>(pNode), true));
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add an element to the index under its interned name.
+
+void NameIndex::AddElement(const XML::ElementNode* pElement)
+{
+	NameTable::NameId nID = m_oNames.Intern(pElement->name());
+
+	if (nID >= m_vecElements.size())
+		m_vecElements.resize(nID+1);
+
+	m_vecElements[nID].push_back(pElement);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse a simple name test query.
+
+bool NameIndex::ParseQuery(const tstring& strQuery, tstring& strName, tstring& strAttrib, tstring& strValue, bool& bHasValue)
+{
+	if (strQuery.compare(0, 2, TXT("//")) != 0)
+		return false;
+
+	const tchar* pszQuery = strQuery.c_str() + 2;
+
+	if (!ParseName(pszQuery, strName))
+		return false;
+
+	// No predicate?
+	if (*pszQuery == TXT('\0'))
+		return true;
+
+	if ( (pszQuery[0] != TXT('[')) || (pszQuery[1] != TXT('@')) )
+		return false;
+
+	pszQuery += 2;
+
+	if (!ParseName(pszQuery, strAttrib))
+		return false;
+
+	if (*pszQuery == TXT('='))
+	{
+		tchar cQuote = *++pszQuery;
+
+		if ( (cQuote != TXT('\'')) && (cQuote != TXT('"')) )
+			return false;
+
+		const tchar* pszValue = ++pszQuery;
+
+		while ( (*pszQuery != TXT('\0')) && (*pszQuery != cQuote) )
+			++pszQuery;
+
+		if (*pszQuery != cQuote)
+			return false;
+
+		strValue.assign(pszValue, pszQuery);
+		bHasValue = true;
+		++pszQuery;
+	}
+
+	return ( (pszQuery[0] == TXT(']')) && (pszQuery[1] == TXT('\0')) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse a name in a query. Only plain ASCII names are accepted, anything else
+//! is left to the XPath evaluator.
+
+bool NameIndex::ParseName(const tchar*& pszQuery, tstring& strName)
+{
+	const tchar* pszName = pszQuery;
+	tchar        cFirst  = *pszQuery;
+
+	if ( !((cFirst >= TXT('A')) && (cFirst <= TXT('Z'))) && !((cFirst >= TXT('a')) && (cFirst <= TXT('z'))) && (cFirst != TXT('_')) )
+		return false;
+
+	for (tchar c = *pszQuery; ; c = *++pszQuery)
+	{
+		bool bAlpha = ( ((c >= TXT('A')) && (c <= TXT('Z'))) || ((c >= TXT('a')) && (c <= TXT('z'))) );
+		bool bDigit = ( (c >= TXT('0')) && (c <= TXT('9')) );
+
+		if ( (!bAlpha) && (!bDigit) && (c != TXT('_')) && (c != TXT('-')) && (c != TXT('.')) )
+			break;
+	}
+
+	strName.assign(pszName, pszQuery);
+
+	return true;
+}
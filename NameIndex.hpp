@@ -0,0 +1,101 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   NameIndex.hpp
+//! \brief  The NameIndex class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_NAMEINDEX_HPP
+#define APP_NAMEINDEX_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <XML/Document.hpp>
+#include "NameTable.hpp"
+#include <list>
+
+////////////////////////////////////////////////////////////////////////////////
+//! An index of a document's elements by their interned name. It is built in a
+//! single pass over the DOM and allows simple name test queries, such as
+//! "//name" or "//name[@attr='value']", to be answered by looking up a name
+//! handle rather than comparing every element's name during a full XPath walk.
+//! It saves time, not memory, as the DOM's nodes still hold their own names.
+
+class NameIndex
+{
+public:
+	//! The elements with the same name, in document order.
+	typedef std::vector<const XML::Node*> Elements;
+	//! The list of nodes returned by a query.
+	typedef std::list<XML::NodePtr> NodesList;
+
+	//! Default constructor.
+	NameIndex();
+
+	//
+	// Properties.
+	//
+
+	//! Query if the index has been built.
+	bool IsBuilt() const;
+
+	//! Get the table of interned element names.
+	const NameTable& Names() const;
+
+	//
+	// Methods.
+	//
+
+	//! Build the index from the DOM.
+	void Build(const XML::DocumentPtr& pDOM);
+
+	//! Discard the index.
+	void Clear();
+
+	//! Find the elements that match a simple name test query.
+	bool Query(const tstring& strQuery, NodesList& lstNodes) const;
+
+	//
+	// Class methods.
+	//
+
+	//! Parse a simple name test query.
+	static bool ParseQuery(const tstring& strQuery, tstring& strName, tstring& strAttrib, tstring& strValue, bool& bHasValue);
+
+private:
+	//
+	// Members.
+	//
+	bool					m_bBuilt;		//!< Has the index been built?
+	NameTable				m_oNames;		//!< The element names.
+	std::vector<Elements>	m_vecElements;	//!< The elements by name handle.
+
+	//
+	// Internal methods.
+	//
+
+	//! Add an element to the index.
+	void AddElement(const XML::ElementNode* pElement);
+
+	//! Parse a name in a query.
+	static bool ParseName(const tchar*& pszQuery, tstring& strName);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the index has been built.
+
+inline bool NameIndex::IsBuilt() const
+{
+	return m_bBuilt;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the table of interned element names.
+
+inline const NameTable& NameIndex::Names() const
+{
+	return m_oNames;
+}
+
+#endif // APP_NAMEINDEX_HPP
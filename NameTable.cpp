@@ -0,0 +1,54 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   NameTable.cpp
+//! \brief  The NameTable class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "NameTable.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+NameTable::NameTable()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the handle for a name, adding it if not already present.
+
+NameTable::NameId NameTable::Intern(const tstring& strName)
+{
+	NameMap::iterator it = m_mapNames.lower_bound(strName);
+
+	if ( (it != m_mapNames.end()) && (it->first == strName) )
+		return it->second;
+
+	NameId nID = static_cast<NameId>(m_vecNames.size());
+
+	it = m_mapNames.insert(it, NameMap::value_type(strName, nID));
+	m_vecNames.push_back(&it->first);
+
+	return nID;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the handle for a name, if present. Returns INVALID_NAME if not.
+
+NameTable::NameId NameTable::Find(const tstring& strName) const
+{
+	NameMap::const_iterator it = m_mapNames.find(strName);
+
+	if (it == m_mapNames.end())
+		return INVALID_NAME;
+
+	return it->second;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Remove all names.
+
+void NameTable::Clear()
+{
+	m_mapNames.clear();
+	m_vecNames.clear();
+}
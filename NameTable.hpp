@@ -0,0 +1,87 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   NameTable.hpp
+//! \brief  The NameTable class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_NAMETABLE_HPP
+#define APP_NAMETABLE_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <map>
+
+////////////////////////////////////////////////////////////////////////////////
+//! A table of interned element and attribute names. Each distinct name is
+//! stored once and identified by a small integer so that names can be compared
+//! by value instead of by string.
+
+class NameTable
+{
+public:
+	//! The type of a name handle.
+	typedef uint NameId;
+
+	//! The handle returned when a name is not in the table.
+	static const NameId INVALID_NAME = static_cast<NameId>(-1);
+
+	//! Default constructor.
+	NameTable();
+
+	//
+	// Properties.
+	//
+
+	//! Get the number of distinct names.
+	size_t Count() const;
+
+	//! Get the name for a handle.
+	const tstring& Name(NameId nID) const;
+
+	//
+	// Methods.
+	//
+
+	//! Get the handle for a name, adding it if not already present.
+	NameId Intern(const tstring& strName);
+
+	//! Get the handle for a name, if present.
+	NameId Find(const tstring& strName) const;
+
+	//! Remove all names.
+	void Clear();
+
+private:
+	//! The map of name to handle.
+	typedef std::map<tstring, NameId> NameMap;
+	//! The names indexed by handle.
+	typedef std::vector<const tstring*> Names;
+
+	//
+	// Members.
+	//
+	NameMap		m_mapNames;		//!< The map of name to handle.
+	Names		m_vecNames;		//!< The names indexed by handle.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of distinct names.
+
+inline size_t NameTable::Count() const
+{
+	return m_vecNames.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the name for a handle.
+
+inline const tstring& NameTable::Name(NameId nID) const
+{
+	ASSERT(nID < m_vecNames.size());
+
+	return *m_vecNames[nID];
+}
+
+#endif // APP_NAMETABLE_HPP
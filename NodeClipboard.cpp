@@ -0,0 +1,205 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   NodeClipboard.cpp
+//! \brief  The NodeClipboard class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "NodeClipboard.hpp"
+#include <Core/RuntimeException.hpp>
+#include "XmlFragment.hpp"
+
+// Constants.
+static const tchar STREAM_FORMAT_NAME[] = TXT("XMLEdit Node Stream");
+
+// The clipboard format for the XML text.
+#ifdef _UNICODE
+static const UINT TEXT_FORMAT = CF_UNICODETEXT;
+#else
+static const UINT TEXT_FORMAT = CF_TEXT;
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//! Copy a block of memory into a global handle for the clipboard.
+
+static HGLOBAL CopyToGlobal(const void* pvData, size_t nBytes)
+{
+	HGLOBAL hData = ::GlobalAlloc(GMEM_MOVEABLE, nBytes);
+
+	if (hData == NULL)
+		throw Core::RuntimeException(TXT("Failed to allocate memory for the clipboard"));
+
+	memcpy(::GlobalLock(hData), pvData, nBytes);
+	::GlobalUnlock(hData);
+
+	return hData;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+NodeClipboard::NodeClipboard()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+NodeClipboard::~NodeClipboard()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Copy a sub-tree to the clipboard. The text format is offered without any
+//! data, which defers writing the XML until another application pastes it.
+//! Returns false if the node cannot be copied.
+
+bool NodeClipboard::Copy(HWND hOwner, NodeRef pNode)
+{
+	NodeStream::Buffer vecStream;
+
+	if (!NodeStream::Write(pNode, vecStream))
+		return false;
+
+	if (!::OpenClipboard(hOwner))
+		throw Core::RuntimeException(TXT("Failed to open the clipboard"));
+
+	// Emptying the clipboard releases any previous copy.
+	::EmptyClipboard();
+
+	try
+	{
+		::SetClipboardData(StreamFormat(), CopyToGlobal(&vecStream.front(), vecStream.size()));
+		::SetClipboardData(TEXT_FORMAT, NULL);
+	}
+	catch (...)
+	{
+		::CloseClipboard();
+		throw;
+	}
+
+	::CloseClipboard();
+
+	m_vecStream.swap(vecStream);
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Place a format that was offered on the clipboard, when requested. The
+//! clipboard has already been opened by the application requesting it.
+
+void NodeClipboard::RenderFormat(UINT nFormat)
+{
+	if ( (nFormat != TEXT_FORMAT) || (m_vecStream.empty()) )
+		return;
+
+	const byte*  pBegin = &m_vecStream.front();
+	XML::NodePtr pNode  = NodeStream::Read(pBegin, pBegin + m_vecStream.size(), nullptr);
+	tstring      strXml;
+
+	XmlFragment::Write(pNode, strXml);
+
+	::SetClipboardData(TEXT_FORMAT, CopyToGlobal(strXml.c_str(), (strXml.size() + 1) * sizeof(tchar)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Place all the formats that were offered on the clipboard, as the owner is
+//! about to be destroyed. Nothing is rendered if another application has taken
+//! ownership of the clipboard in the meantime.
+
+void NodeClipboard::RenderAllFormats(HWND hOwner)
+{
+	if (!::OpenClipboard(hOwner))
+		return;
+
+	try
+	{
+		if (::GetClipboardOwner() == hOwner)
+			RenderFormat(TEXT_FORMAT);
+	}
+	catch (const Core::Exception& e)
+	{
+		TRACE1(TXT("Failed to render the clipboard: %s\n"), e.twhat());
+	}
+
+	::CloseClipboard();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Discard the copied sub-tree as the clipboard has been emptied.
+
+void NodeClipboard::Release()
+{
+	NodeStream::Buffer().swap(m_vecStream);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the clipboard holds something that can be pasted.
+
+bool NodeClipboard::CanPaste()
+{
+	return (::IsClipboardFormatAvailable(StreamFormat()) || ::IsClipboardFormatAvailable(TEXT_FORMAT));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Paste a sub-tree from the clipboard, allocating it from the arena. The
+//! private format is preferred, otherwise any text is parsed as XML. Returns
+//! nullptr if the clipboard holds neither.
+
+XML::NodePtr NodeClipboard::Paste(HWND hOwner, DocArena* pArena)
+{
+	if (!::OpenClipboard(hOwner))
+		throw Core::RuntimeException(TXT("Failed to open the clipboard"));
+
+	XML::NodePtr pNode;
+
+	try
+	{
+		HANDLE hData = NULL;
+
+		if ((hData = ::GetClipboardData(StreamFormat())) != NULL)
+		{
+			const byte* pBegin = static_cast<const byte*>(::GlobalLock(hData));
+			size_t      nSize  = ::GlobalSize(hData);
+
+			try
+			{
+				pNode = NodeStream::Read(pBegin, pBegin + nSize, pArena);
+			}
+			catch (...)
+			{
+				::GlobalUnlock(hData);
+				throw;
+			}
+
+			::GlobalUnlock(hData);
+		}
+		else if ((hData = ::GetClipboardData(TEXT_FORMAT)) != NULL)
+		{
+			tstring strXml(static_cast<const tchar*>(::GlobalLock(hData)));
+
+			::GlobalUnlock(hData);
+
+			pNode = XmlFragment::Parse(strXml, pArena);
+		}
+	}
+	catch (...)
+	{
+		::CloseClipboard();
+		throw;
+	}
+
+	::CloseClipboard();
+
+	return pNode;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the ID of the private clipboard format, registering it on first use.
+
+UINT NodeClipboard::StreamFormat()
+{
+	static UINT s_nFormat = ::RegisterClipboardFormat(STREAM_FORMAT_NAME);
+
+	return s_nFormat;
+}
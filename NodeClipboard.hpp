@@ -0,0 +1,73 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   NodeClipboard.hpp
+//! \brief  The NodeClipboard class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_NODECLIPBOARD_HPP
+#define APP_NODECLIPBOARD_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "NodeStream.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+//! The copying and pasting of sub-trees via the clipboard. A sub-tree is copied
+//! as a NodeStream in a private format, which is what is pasted when available,
+//! so that copying between documents never writes out and parses XML text. The
+//! XML text is also offered for other applications but only rendered if one of
+//! them asks for it, from a copy of the stream kept until the clipboard is
+//! emptied.
+
+class NodeClipboard : private Core::NotCopyable
+{
+public:
+	//! Default constructor.
+	NodeClipboard();
+
+	//! Destructor.
+	~NodeClipboard();
+
+	//
+	// Methods.
+	//
+
+	//! Copy a sub-tree to the clipboard.
+	bool Copy(HWND hOwner, NodeRef pNode);
+
+	//! Place a format that was offered on the clipboard, when requested.
+	void RenderFormat(UINT nFormat);
+
+	//! Place all the formats that were offered on the clipboard.
+	void RenderAllFormats(HWND hOwner);
+
+	//! Discard the copied sub-tree as the clipboard has been emptied.
+	void Release();
+
+	//
+	// Class methods.
+	//
+
+	//! Query if the clipboard holds something that can be pasted.
+	static bool CanPaste();
+
+	//! Paste a sub-tree from the clipboard.
+	static XML::NodePtr Paste(HWND hOwner, DocArena* pArena);
+
+private:
+	//
+	// Members.
+	//
+	NodeStream::Buffer	m_vecStream;	//!< The sub-tree last copied.
+
+	//
+	// Internal methods.
+	//
+
+	//! Get the ID of the private clipboard format.
+	static UINT StreamFormat();
+};
+
+#endif // APP_NODECLIPBOARD_HPP
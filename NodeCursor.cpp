@@ -0,0 +1,129 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   NodeCursor.cpp
+//! \brief  The NodeCursor class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "NodeCursor.hpp"
+#include <XML/Document.hpp>
+#include <XML/ElementNode.hpp>
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+NodeCursor::NodeCursor(const XML::NodeContainer& oRoot, Order eOrder)
+	: m_eOrder(eOrder)
+	, m_nDepth(0)
+	, m_bDescend(false)
+{
+	Push(&oRoot, NodeRef());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Move to the next node, returning false when there are no more.
+
+bool NodeCursor::Next()
+{
+	if (m_bDescend)
+		Push(Children(m_pNode), m_pNode);
+
+	m_bDescend = false;
+
+	while (!m_vecStack.empty())
+	{
+		Frame& oFrame = m_vecStack.back();
+
+		// Finished with the container?
+		if (oFrame.m_itNext == oFrame.m_itEnd)
+		{
+			NodeRef pOwner = oFrame.m_pOwner;
+
+			m_vecStack.pop_back();
+
+			if ( (m_eOrder == POSTORDER) && (pOwner.get() != nullptr) )
+			{
+				m_pNode  = pOwner;
+				m_nDepth = m_vecStack.size();
+				return true;
+			}
+
+			continue;
+		}
+
+		NodeRef pNode = *oFrame.m_itNext++;
+
+		// Visit the children first?
+		if ( (m_eOrder == POSTORDER) && (Push(Children(pNode), pNode)) )
+			continue;
+
+		m_pNode    = pNode;
+		m_nDepth   = m_vecStack.size();
+		m_bDescend = (m_eOrder == PREORDER);
+		return true;
+	}
+
+	m_pNode  = NodeRef();
+	m_nDepth = 0;
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the children of a node, if it can have any.
+
+const XML::NodeContainer* NodeCursor::Children(NodeRef pNode)
+{
+	XML::NodeType eType = pNode->type();
+
+	if (eType == XML::DOCUMENT_NODE)
+		return pNode.As<XML::Document>();
+	else if (eType == XML::ELEMENT_NODE)
+		return pNode.As<XML::ElementNode>();
+
+	return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Release the nodes below a container, deepest first. Only a node without
+//! children is ever detached, so destroying it never recurses into the rest
+//! of the tree, however deeply nested it is. The last child is always taken,
+//! so each detach is also cheap.
+
+void NodeCursor::ReleaseChildren(XML::NodeContainer& oRoot)
+{
+	std::vector<XML::NodeContainer*> vecStack(1, &oRoot);
+
+	while (!vecStack.empty())
+	{
+		XML::NodeContainer* pContainer = vecStack.back();
+		size_t              nCount     = pContainer->getChildCount();
+
+		if (nCount == 0)
+		{
+			vecStack.pop_back();
+			continue;
+		}
+
+		const XML::NodeContainer* pChildren = Children(pContainer->getChild(nCount-1));
+
+		if ( (pChildren != nullptr) && (pChildren->hasChildren()) )
+			vecStack.push_back(const_cast<XML::NodeContainer*>(pChildren));
+		else
+			pContainer->removeChild(nCount-1);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Push the children of a container, if it has any.
+
+bool NodeCursor::Push(const XML::NodeContainer* pContainer, NodeRef pOwner)
+{
+	if ( (pContainer == nullptr) || (!pContainer->hasChildren()) )
+		return false;
+
+	Frame oFrame = { pContainer->beginChild(), pContainer->endChild(), pOwner };
+
+	m_vecStack.push_back(oFrame);
+
+	return true;
+}
@@ -0,0 +1,122 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   NodeCursor.hpp
+//! \brief  The NodeCursor class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_NODECURSOR_HPP
+#define APP_NODECURSOR_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <XML/NodeContainer.hpp>
+#include "NodeRef.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+//! A cursor that walks the nodes below a container in either preorder or
+//! postorder. The position is held on an explicit stack rather than the call
+//! stack, so any depth of nesting can be walked and the walk can be stopped
+//! after any node and resumed later, e.g. to spread the work over several
+//! messages on the UI thread. The nodes must not be added or removed while a
+//! walk is suspended.
+
+class NodeCursor
+{
+public:
+	//! The order the nodes are visited in.
+	enum Order
+	{
+		PREORDER,	//!< A node is visited before its children.
+		POSTORDER,	//!< A node is visited after its children.
+	};
+
+	//! Constructor.
+	NodeCursor(const XML::NodeContainer& oRoot, Order eOrder = PREORDER);
+
+	//
+	// Properties.
+	//
+
+	//! Get the current node.
+	NodeRef Node() const;
+
+	//! Get the depth of the current node, where the root's children are at 1.
+	size_t Depth() const;
+
+	//
+	// Methods.
+	//
+
+	//! Move to the next node, returning false when there are no more.
+	bool Next();
+
+	//! Don't visit the children of the current node.
+	void SkipChildren();
+
+	//
+	// Class methods.
+	//
+
+	//! Get the children of a node, if it can have any.
+	static const XML::NodeContainer* Children(NodeRef pNode);
+
+	//! Release the nodes below a container, deepest first.
+	static void ReleaseChildren(XML::NodeContainer& oRoot);
+
+private:
+	//! The remaining children of a container being walked.
+	struct Frame
+	{
+		XML::NodeContainer::const_iterator	m_itNext;	//!< The next child.
+		XML::NodeContainer::const_iterator	m_itEnd;	//!< The end of the children.
+		NodeRef								m_pOwner;	//!< The container node, if not the root.
+	};
+
+	//! The stack of containers being walked.
+	typedef std::vector<Frame> Frames;
+
+	//
+	// Members.
+	//
+	Order		m_eOrder;		//!< The order the nodes are visited in.
+	Frames		m_vecStack;		//!< The containers being walked.
+	NodeRef		m_pNode;		//!< The current node.
+	size_t		m_nDepth;		//!< The depth of the current node.
+	bool		m_bDescend;		//!< Visit the current node's children next?
+
+	//
+	// Internal methods.
+	//
+
+	//! Push the children of a container, if it has any.
+	bool Push(const XML::NodeContainer* pContainer, NodeRef pOwner);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the current node.
+
+inline NodeRef NodeCursor::Node() const
+{
+	return m_pNode;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the depth of the current node, where the root's children are at 1.
+
+inline size_t NodeCursor::Depth() const
+{
+	return m_nDepth;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Don't visit the children of the current node. This only has an effect on a
+//! preorder walk as a postorder walk has visited them already.
+
+inline void NodeCursor::SkipChildren()
+{
+	m_bDescend = false;
+}
+
+#endif // APP_NODECURSOR_HPP
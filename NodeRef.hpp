@@ -0,0 +1,140 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   NodeRef.hpp
+//! \brief  The NodeRef class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_NODEREF_HPP
+#define APP_NODEREF_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <XML/Node.hpp>
+
+////////////////////////////////////////////////////////////////////////////////
+//! A borrowed reference to a DOM node. Unlike an XML::NodePtr, creating,
+//! copying and casting one never touches the node's reference count. It does
+//! not keep the node alive, so it is only valid while the node is still part
+//! of a live document, and should be converted with ToPtr() if the node needs
+//! to be held on to beyond that.
+
+class NodeRef
+{
+public:
+	//! Default constructor.
+	NodeRef();
+
+	//! Construction from a raw node pointer.
+	explicit NodeRef(XML::Node* pNode);
+
+	//! Construction by borrowing from a node smart-pointer.
+	NodeRef(const XML::NodePtr& pNode);
+
+	//
+	// Operators.
+	//
+
+	//! Access the node.
+	XML::Node* operator->() const;
+
+	//! Access the node.
+	XML::Node& operator*() const;
+
+	//
+	// Properties.
+	//
+
+	//! Get the node.
+	XML::Node* get() const;
+
+	//! Get the node as a derived node type.
+	template<typename T>
+	T* As() const;
+
+	//
+	// Methods.
+	//
+
+	//! Create an owning smart-pointer to the node.
+	XML::NodePtr ToPtr() const;
+
+private:
+	//
+	// Members.
+	//
+	XML::Node*	m_pNode;	//!< The node, not owned.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+inline NodeRef::NodeRef()
+	: m_pNode(nullptr)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Construction from a raw node pointer.
+
+inline NodeRef::NodeRef(XML::Node* pNode)
+	: m_pNode(pNode)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Construction by borrowing from a node smart-pointer.
+
+inline NodeRef::NodeRef(const XML::NodePtr& pNode)
+	: m_pNode(pNode.get())
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Access the node.
+
+inline XML::Node* NodeRef::operator->() const
+{
+	ASSERT(m_pNode != nullptr);
+
+	return m_pNode;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Access the node.
+
+inline XML::Node& NodeRef::operator*() const
+{
+	ASSERT(m_pNode != nullptr);
+
+	return *m_pNode;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the node.
+
+inline XML::Node* NodeRef::get() const
+{
+	return m_pNode;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the node as a derived node type. The caller is expected to have already
+//! checked the node type.
+
+template<typename T>
+inline T* NodeRef::As() const
+{
+	return static_cast<T*>(m_pNode);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Create an owning smart-pointer to the node.
+
+inline XML::NodePtr NodeRef::ToPtr() const
+{
+	return XML::NodePtr(m_pNode, true);
+}
+
+#endif // APP_NODEREF_HPP
@@ -0,0 +1,387 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   NodeStream.cpp
+//! \brief  The NodeStream class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "NodeStream.hpp"
+#include <XML/ElementNode.hpp>
+#include <XML/TextNode.hpp>
+#include <XML/CommentNode.hpp>
+#include <XML/ProcessingNode.hpp>
+#include <XML/CDataNode.hpp>
+#include <Core/RuntimeException.hpp>
+#include "DocArena.hpp"
+#include "NodeCursor.hpp"
+#include "NameTable.hpp"
+
+// Constants.
+static const char STREAM_MAGIC[4] = { 'X', 'E', 'N', 'S' };
+
+// The stream format version.
+static const uint32 STREAM_FORMAT = 1;
+
+////////////////////////////////////////////////////////////////////////////////
+//! The header at the start of a stream.
+
+struct Header
+{
+	char	m_achMagic[4];		//!< The stream signature.
+	uint32	m_nFormat;			//!< The format version.
+	uint32	m_nCharSize;		//!< The size of a character.
+	uint32	m_nSize;			//!< The size of the whole stream.
+	uint32	m_nNodes;			//!< The number of nodes.
+	uint32	m_nNamesOffset;		//!< The offset of the name table.
+	uint32	m_nNames;			//!< The number of names.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append an unsigned value to a stream.
+
+static void AppendUInt(NodeStream::Buffer& vecStream, uint32 nValue)
+{
+	const byte* pBytes = reinterpret_cast<const byte*>(&nValue);
+
+	vecStream.insert(vecStream.end(), pBytes, pBytes + sizeof(nValue));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append a length-prefixed string to a stream.
+
+static void AppendString(NodeStream::Buffer& vecStream, const tstring& str)
+{
+	const byte* pBytes = reinterpret_cast<const byte*>(str.data());
+
+	AppendUInt(vecStream, static_cast<uint32>(str.size()));
+	vecStream.insert(vecStream.end(), pBytes, pBytes + (str.size() * sizeof(tchar)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append a set of attributes to a stream, interning their names.
+
+static void AppendAttributes(NodeStream::Buffer& vecStream, const XML::Attributes& vAttribs, NameTable& oNames)
+{
+	AppendUInt(vecStream, static_cast<uint32>(vAttribs.count()));
+
+	for (XML::Attributes::const_iterator it = vAttribs.begin(); it != vAttribs.end(); ++it)
+	{
+		AppendUInt(vecStream, oNames.Intern((*it)->name()));
+		AppendString(vecStream, (*it)->value());
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append a node to a stream. Returns false if the node cannot appear inside an
+//! element.
+
+static bool AppendNode(NodeStream::Buffer& vecStream, NodeRef pNode, NameTable& oNames)
+{
+	XML::NodeType eType = pNode->type();
+
+	AppendUInt(vecStream, static_cast<uint32>(eType));
+
+	if (eType == XML::ELEMENT_NODE)
+	{
+		const XML::ElementNode* pElement = pNode.As<XML::ElementNode>();
+
+		AppendUInt(vecStream, oNames.Intern(pElement->name()));
+		AppendAttributes(vecStream, pElement->getAttributes(), oNames);
+		AppendUInt(vecStream, static_cast<uint32>(pElement->getChildCount()));
+	}
+	else if (eType == XML::TEXT_NODE)
+	{
+		AppendString(vecStream, pNode.As<XML::TextNode>()->text());
+	}
+	else if (eType == XML::COMMENT_NODE)
+	{
+		AppendString(vecStream, pNode.As<XML::CommentNode>()->comment());
+	}
+	else if (eType == XML::CDATA_NODE)
+	{
+		AppendString(vecStream, pNode.As<XML::CDataNode>()->text());
+	}
+	else if (eType == XML::PROCESSING_NODE)
+	{
+		const XML::ProcessingNode* pProcInst = pNode.As<XML::ProcessingNode>();
+
+		AppendUInt(vecStream, oNames.Intern(pProcInst->target()));
+		AppendAttributes(vecStream, pProcInst->getAttributes(), oNames);
+	}
+	else
+	{
+		return false;
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! A cursor over the fields of a stream.
+
+class StreamReader
+{
+public:
+	//! Constructor.
+	StreamReader(const byte* pBegin, const byte* pEnd)
+		: m_pNext(pBegin)
+		, m_pEnd(pEnd)
+	{
+	}
+
+	//! Read an unsigned value.
+	uint32 ReadUInt()
+	{
+		uint32 nValue;
+
+		Read(&nValue, sizeof(nValue));
+
+		return nValue;
+	}
+
+	//! Read an unsigned value that must be less than a limit.
+	uint32 ReadIndex(size_t nLimit)
+	{
+		uint32 nValue = ReadUInt();
+
+		if (nValue >= nLimit)
+			throw Core::RuntimeException(TXT("The node stream is corrupt"));
+
+		return nValue;
+	}
+
+	//! Read a length-prefixed string.
+	tstring ReadString()
+	{
+		uint32  nLength = ReadUInt();
+
+		if ((static_cast<size_t>(m_pEnd - m_pNext) / sizeof(tchar)) < nLength)
+			throw Core::RuntimeException(TXT("The node stream is corrupt"));
+
+		tstring str(nLength, TXT('\0'));
+
+		if (nLength != 0)
+			Read(&str[0], nLength * sizeof(tchar));
+
+		return str;
+	}
+
+private:
+	//
+	// Members.
+	//
+	const byte*	m_pNext;	//!< The next field.
+	const byte*	m_pEnd;		//!< The end of the fields.
+
+	//! Read raw bytes.
+	void Read(void* pvBuffer, size_t nBytes)
+	{
+		if (static_cast<size_t>(m_pEnd - m_pNext) < nBytes)
+			throw Core::RuntimeException(TXT("The node stream is corrupt"));
+
+		memcpy(pvBuffer, m_pNext, nBytes);
+		m_pNext += nBytes;
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read a set of attributes from a stream.
+
+static void ReadAttributes(StreamReader& oReader, const std::vector<tstring>& vecNames, XML::Attributes& vAttribs)
+{
+	uint32 nCount = oReader.ReadUInt();
+
+	for (uint32 i = 0; i != nCount; ++i)
+	{
+		const tstring& strName = vecNames[oReader.ReadIndex(vecNames.size())];
+
+		vAttribs.set(strName, oReader.ReadString());
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read a node from a stream, returning the number of children that follow it.
+
+static XML::NodePtr ReadNode(StreamReader& oReader, const std::vector<tstring>& vecNames, uint32& nChildren)
+{
+	uint32 nType = oReader.ReadUInt();
+
+	nChildren = 0;
+
+	if (nType == XML::ELEMENT_NODE)
+	{
+		const tstring&      strName  = vecNames[oReader.ReadIndex(vecNames.size())];
+		XML::ElementNodePtr pElement = XML::ElementNodePtr(new XML::ElementNode(strName));
+
+		ReadAttributes(oReader, vecNames, pElement->getAttributes());
+		nChildren = oReader.ReadUInt();
+
+		return pElement;
+	}
+	else if (nType == XML::TEXT_NODE)
+	{
+		return XML::NodePtr(new XML::TextNode(oReader.ReadString()));
+	}
+	else if (nType == XML::COMMENT_NODE)
+	{
+		return XML::NodePtr(new XML::CommentNode(oReader.ReadString()));
+	}
+	else if (nType == XML::CDATA_NODE)
+	{
+		return XML::NodePtr(new XML::CDataNode(oReader.ReadString()));
+	}
+	else if (nType == XML::PROCESSING_NODE)
+	{
+		const tstring&        strTarget = vecNames[oReader.ReadIndex(vecNames.size())];
+		XML::ProcessingNode*  pProcInst = new XML::ProcessingNode(strTarget);
+		XML::NodePtr          pNode(pProcInst);
+
+		ReadAttributes(oReader, vecNames, pProcInst->getAttributes());
+
+		return pNode;
+	}
+
+	throw Core::RuntimeException(TXT("The node stream is corrupt"));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if a sub-tree can be encoded, i.e. its root is a node that can appear
+//! inside an element. The descendants of an element always can.
+
+bool NodeStream::CanWrite(NodeRef pRoot)
+{
+	XML::NodeType eType = pRoot->type();
+
+	return ( (eType == XML::ELEMENT_NODE) || (eType == XML::TEXT_NODE) || (eType == XML::COMMENT_NODE)
+		  || (eType == XML::CDATA_NODE) || (eType == XML::PROCESSING_NODE) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Encode a sub-tree. The space for the header is reserved first and filled in
+//! once the nodes and names have been written, so nothing is copied twice.
+//! Returns false if the sub-tree is not one that can appear inside an element.
+
+bool NodeStream::Write(NodeRef pRoot, Buffer& vecStream)
+{
+	NameTable oNames;
+	Header    oHeader;
+	size_t    nNodes = 1;
+
+	vecStream.clear();
+	vecStream.resize(sizeof(oHeader));
+
+	if (!AppendNode(vecStream, pRoot, oNames))
+		return false;
+
+	const XML::NodeContainer* pChildren = NodeCursor::Children(pRoot);
+
+	if (pChildren != nullptr)
+	{
+		for (NodeCursor oCursor(*pChildren); oCursor.Next(); ++nNodes)
+		{
+			if (!AppendNode(vecStream, oCursor.Node(), oNames))
+				return false;
+		}
+	}
+
+	size_t nNamesOffset = vecStream.size();
+
+	for (NameTable::NameId nID = 0; nID != oNames.Count(); ++nID)
+		AppendString(vecStream, oNames.Name(nID));
+
+	memcpy(oHeader.m_achMagic, STREAM_MAGIC, sizeof(STREAM_MAGIC));
+	oHeader.m_nFormat      = STREAM_FORMAT;
+	oHeader.m_nCharSize    = sizeof(tchar);
+	oHeader.m_nSize        = static_cast<uint32>(vecStream.size());
+	oHeader.m_nNodes       = static_cast<uint32>(nNodes);
+	oHeader.m_nNamesOffset = static_cast<uint32>(nNamesOffset);
+	oHeader.m_nNames       = static_cast<uint32>(oNames.Count());
+
+	memcpy(&vecStream.front(), &oHeader, sizeof(oHeader));
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Decode a sub-tree, allocating the nodes from the arena. Any bytes after the
+//! end of the stream are ignored, as a clipboard block may be rounded up.
+
+XML::NodePtr NodeStream::Read(const byte* pBegin, const byte* pEnd, DocArena* pArena)
+{
+	Header oHeader;
+
+	if (static_cast<size_t>(pEnd - pBegin) < sizeof(oHeader))
+		throw Core::RuntimeException(TXT("The node stream is corrupt"));
+
+	memcpy(&oHeader, pBegin, sizeof(oHeader));
+
+	if ( (memcmp(oHeader.m_achMagic, STREAM_MAGIC, sizeof(STREAM_MAGIC)) != 0)
+	  || (oHeader.m_nFormat != STREAM_FORMAT) || (oHeader.m_nCharSize != sizeof(tchar)) )
+		throw Core::RuntimeException(TXT("The node stream was written by an incompatible version"));
+
+	if ( (oHeader.m_nSize > static_cast<size_t>(pEnd - pBegin)) || (oHeader.m_nNamesOffset < sizeof(oHeader))
+	  || (oHeader.m_nNamesOffset > oHeader.m_nSize) || (oHeader.m_nNodes == 0) )
+		throw Core::RuntimeException(TXT("The node stream is corrupt"));
+
+	const byte* pNodes = pBegin + sizeof(oHeader);
+	const byte* pNames = pBegin + oHeader.m_nNamesOffset;
+
+	// The children of an element still to be read.
+	struct Frame
+	{
+		XML::NodeContainer*	m_pContainer;	//!< The element.
+		uint32				m_nRemaining;	//!< The number of children left.
+	};
+
+	std::vector<tstring> vecNames;
+	std::vector<Frame>   vecStack;
+	StreamReader         oNameReader(pNames, pBegin + oHeader.m_nSize);
+
+	vecNames.reserve(std::min<size_t>(oHeader.m_nNames, oHeader.m_nSize));
+
+	for (uint32 i = 0; i != oHeader.m_nNames; ++i)
+		vecNames.push_back(oNameReader.ReadString());
+
+	vecStack.reserve(64);
+
+	StreamReader oReader(pNodes, pNames);
+	XML::NodePtr pRoot;
+
+	{
+		DocArena::Scope oScope(pArena);
+
+		for (uint32 i = 0; i != oHeader.m_nNodes; ++i)
+		{
+			uint32       nChildren = 0;
+			XML::NodePtr pNode = ReadNode(oReader, vecNames, nChildren);
+
+			if (i == 0)
+			{
+				pRoot = pNode;
+			}
+			else
+			{
+				if (vecStack.empty())
+					throw Core::RuntimeException(TXT("The node stream is corrupt"));
+
+				Frame& oFrame = vecStack.back();
+
+				oFrame.m_pContainer->appendChild(pNode);
+
+				if (--oFrame.m_nRemaining == 0)
+					vecStack.pop_back();
+			}
+
+			if (nChildren != 0)
+			{
+				Frame oFrame = { NodeRef(pNode).As<XML::ElementNode>(), nChildren };
+
+				vecStack.push_back(oFrame);
+			}
+		}
+	}
+
+	if (!vecStack.empty())
+		throw Core::RuntimeException(TXT("The node stream is corrupt"));
+
+	return pRoot;
+}
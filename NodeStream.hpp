@@ -0,0 +1,48 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   NodeStream.hpp
+//! \brief  The NodeStream class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_NODESTREAM_HPP
+#define APP_NODESTREAM_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "NodeRef.hpp"
+
+// Forward declarations.
+class DocArena;
+
+////////////////////////////////////////////////////////////////////////////////
+//! A compact binary encoding of a sub-tree, used to copy nodes without writing
+//! them out as XML text and parsing it again. The nodes are written in preorder
+//! with each element followed by the number of children it has, so that they
+//! can be read back without any matching of start and end tags. The element,
+//! attribute and processing instruction names are interned in a table at the
+//! end, which is read first. Strings are stored as raw characters and so can
+//! only be read by a build with the same character size.
+
+class NodeStream
+{
+public:
+	//! The type of an encoded sub-tree.
+	typedef std::vector<byte> Buffer;
+
+	//
+	// Class methods.
+	//
+
+	//! Query if a sub-tree can be encoded.
+	static bool CanWrite(NodeRef pRoot);
+
+	//! Encode a sub-tree.
+	static bool Write(NodeRef pRoot, Buffer& vecStream);
+
+	//! Decode a sub-tree.
+	static XML::NodePtr Read(const byte* pBegin, const byte* pEnd, DocArena* pArena);
+};
+
+#endif // APP_NODESTREAM_HPP
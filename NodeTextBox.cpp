@@ -0,0 +1,214 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   NodeTextBox.cpp
+//! \brief  The NodeTextBox class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "NodeTextBox.hpp"
+#include "TheView.hpp"
+
+// Constants.
+static const WPARAM CTRL_Z = 0x1A;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+NodeTextBox::NodeTextBox(TheView& oView)
+	: m_oView(oView)
+	, m_bEditable(false)
+	, m_bReplacing(false)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+NodeTextBox::~NodeTextBox()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Show the text of a node, optionally allowing it to be edited. The default
+//! limit on the length of the text is lifted for very large values.
+
+void NodeTextBox::Show(const tstring& strText, bool bEditable)
+{
+	m_bEditable = false;
+
+	::SendMessage(m_hWnd, EM_SETLIMITTEXT, 0, 0);
+
+	Text(ToControlText(strText));
+	ReadOnly(!bEditable);
+
+	m_bEditable = bEditable;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Replace a range of the node's text after it was changed elsewhere, e.g. by
+//! an undo. The change is not reported back to the view.
+
+void NodeTextBox::ReplaceText(size_t nOffset, size_t nCount, const tstring& strText)
+{
+	size_t nStart = ToControlOffset(nOffset);
+	size_t nEnd   = ToControlOffset(nOffset + nCount);
+
+	m_bReplacing = true;
+
+	Select(nStart, nEnd);
+	ReplaceSel(ToControlText(strText).c_str());
+
+	m_bReplacing = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Window procedure. The messages that can change the text are tracked, other
+//! than those for the control's own undo, as the document's history is used.
+
+LRESULT NodeTextBox::WndProc(HWND hWnd, UINT iMsg, WPARAM wParam, LPARAM lParam)
+{
+	if ( (m_bEditable) && (!m_bReplacing) )
+	{
+		switch (iMsg)
+		{
+			case WM_UNDO:
+			case EM_UNDO:
+			{
+				return FALSE;
+			}
+
+			case WM_CHAR:
+			{
+				if (wParam == CTRL_Z)
+					return 0;
+
+				return TrackEdit(hWnd, iMsg, wParam, lParam);
+			}
+
+			case WM_IME_CHAR:
+			case WM_CUT:
+			case WM_PASTE:
+			case WM_CLEAR:
+			case EM_REPLACESEL:
+			{
+				return TrackEdit(hWnd, iMsg, wParam, lParam);
+			}
+
+			case WM_KEYDOWN:
+			{
+				// Delete, Shift+Delete and Shift+Insert.
+				if ( (wParam == VK_DELETE) || (wParam == VK_INSERT) )
+					return TrackEdit(hWnd, iMsg, wParam, lParam);
+			}
+			break;
+		}
+	}
+
+	return CEditBox::WndProc(hWnd, iMsg, wParam, lParam);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Pass on a message that may change the text and report the change. Every
+//! edit replaces the selection, or text either side of the caret, so the range
+//! replaced starts at the earlier of the old selection and the new caret, and
+//! the text inserted ends at the new caret. Only the inserted text is read
+//! back from the control's buffer.
+
+LRESULT NodeTextBox::TrackEdit(HWND hWnd, UINT iMsg, WPARAM wParam, LPARAM lParam)
+{
+	DWORD  dwOldStart = 0, dwOldEnd = 0;
+	DWORD  dwNewStart = 0, dwNewEnd = 0;
+
+	::SendMessage(hWnd, EM_GETSEL, reinterpret_cast<WPARAM>(&dwOldStart), reinterpret_cast<LPARAM>(&dwOldEnd));
+
+	size_t nOldLength = ::GetWindowTextLength(hWnd);
+	size_t nOldLines  = ::SendMessage(hWnd, EM_GETLINECOUNT, 0, 0);
+
+	LRESULT lResult = CEditBox::WndProc(hWnd, iMsg, wParam, lParam);
+
+	::SendMessage(hWnd, EM_GETSEL, reinterpret_cast<WPARAM>(&dwNewStart), reinterpret_cast<LPARAM>(&dwNewEnd));
+
+	size_t nNewLength = ::GetWindowTextLength(hWnd);
+	size_t nNewLines  = ::SendMessage(hWnd, EM_GETLINECOUNT, 0, 0);
+
+	// Nothing changed?
+	if ( (nNewLength == nOldLength) && (dwNewStart == dwOldStart) && (dwNewEnd == dwOldEnd) )
+		return lResult;
+
+	size_t  nFirst    = std::min<size_t>(dwOldStart, dwNewEnd);
+	size_t  nInserted = dwNewEnd - nFirst;
+	size_t  nRemoved  = nOldLength + nInserted - nNewLength;
+	tstring strText;
+
+	// Copy the inserted text, dropping the CR of each line break.
+	if (nInserted != 0)
+	{
+		HLOCAL       hBuffer   = reinterpret_cast<HLOCAL>(::SendMessage(hWnd, EM_GETHANDLE, 0, 0));
+		const tchar* pszBuffer = static_cast<const tchar*>(::LocalLock(hBuffer));
+		const tchar* pszBegin  = pszBuffer + nFirst;
+		const tchar* pszEnd    = pszBegin + nInserted;
+
+		strText.reserve(nInserted);
+
+		for (const tchar* psz = pszBegin; psz != pszEnd; ++psz)
+		{
+			if ( (*psz == TXT('\r')) && (psz+1 != pszEnd) && (*(psz+1) == TXT('\n')) )
+				continue;
+
+			strText += *psz;
+		}
+
+		::LocalUnlock(hBuffer);
+	}
+
+	size_t nInsertedBreaks = nInserted - strText.length();
+	size_t nRemovedBreaks  = nOldLines + nInsertedBreaks - nNewLines;
+	size_t nOffset         = nFirst - ::SendMessage(hWnd, EM_LINEFROMCHAR, nFirst, 0);
+
+	m_oView.OnValueEdited(nOffset, nRemoved - nRemovedBreaks, strText);
+
+	return lResult;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Convert a position in the node's text to one in the control. Each line
+//! break before it adds a CR, so the line it is on is found by a binary search
+//! of the line start positions.
+
+size_t NodeTextBox::ToControlOffset(size_t nOffset) const
+{
+	size_t nFirst = 0;
+	size_t nLast  = ::SendMessage(m_hWnd, EM_GETLINECOUNT, 0, 0) - 1;
+
+	while (nFirst < nLast)
+	{
+		size_t nLine  = (nFirst + nLast + 1) / 2;
+		size_t nStart = ::SendMessage(m_hWnd, EM_LINEINDEX, nLine, 0) - nLine;
+
+		if (nStart <= nOffset)
+			nFirst = nLine;
+		else
+			nLast = nLine - 1;
+	}
+
+	return nOffset + nFirst;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Convert the line breaks in a node's text to those of the control.
+
+tstring NodeTextBox::ToControlText(const tstring& strText)
+{
+	tstring strControl;
+
+	strControl.reserve(strText.length() + (strText.length() / 32));
+
+	for (tstring::const_iterator it = strText.begin(); it != strText.end(); ++it)
+	{
+		if ( (*it == TXT('\n')) && ((it == strText.begin()) || (*(it-1) != TXT('\r'))) )
+			strControl += TXT('\r');
+
+		strControl += *it;
+	}
+
+	return strControl;
+}
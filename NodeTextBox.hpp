@@ -0,0 +1,90 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   NodeTextBox.hpp
+//! \brief  The NodeTextBox class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef NODETEXTBOX_HPP
+#define NODETEXTBOX_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <WCL/EditBox.hpp>
+
+// Forward declarations.
+class TheView;
+
+////////////////////////////////////////////////////////////////////////////////
+//! The edit box derived control used to display and edit the text of a node.
+//! Rather than reading the whole value back after each keystroke, the messages
+//! that change the text are watched and each change is passed on to the view
+//! as the range of the node's text that was replaced. The control shows line
+//! breaks as CR/LF pairs, whereas the node holds just the LF, so positions are
+//! converted using the control's own line index. Word wrapping must be off.
+
+class NodeTextBox : public CEditBox
+{
+public:
+	//! Constructor.
+	NodeTextBox(TheView& oView);
+
+	//! Destructor.
+	virtual ~NodeTextBox();
+
+	//
+	// Properties.
+	//
+
+	//! Query if the text can be edited.
+	bool IsEditable() const;
+
+	//
+	// Methods.
+	//
+
+	//! Show the text of a node, optionally allowing it to be edited.
+	void Show(const tstring& strText, bool bEditable);
+
+	//! Replace a range of the node's text after it was changed elsewhere.
+	void ReplaceText(size_t nOffset, size_t nCount, const tstring& strText);
+
+private:
+	//
+	// Members.
+	//
+	TheView&	m_oView;		//!< The document view.
+	bool		m_bEditable;	//!< Can the text be edited?
+	bool		m_bReplacing;	//!< Is the text being changed by ReplaceText()?
+
+	//
+	// Message handlers.
+	//
+
+	//! Window procedure.
+	virtual LRESULT WndProc(HWND hWnd, UINT iMsg, WPARAM wParam, LPARAM lParam);
+
+	//
+	// Internal methods.
+	//
+
+	//! Pass on a message that may change the text and report the change.
+	LRESULT TrackEdit(HWND hWnd, UINT iMsg, WPARAM wParam, LPARAM lParam);
+
+	//! Convert a position in the node's text to one in the control.
+	size_t ToControlOffset(size_t nOffset) const;
+
+	//! Convert the line breaks in a node's text to those of the control.
+	static tstring ToControlText(const tstring& strText);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the text can be edited.
+
+inline bool NodeTextBox::IsEditable() const
+{
+	return m_bEditable;
+}
+
+#endif // NODETEXTBOX_HPP
@@ -0,0 +1,399 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   ParallelReader.cpp
+//! \brief  The ParallelReader class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "ParallelReader.hpp"
+#include <XML/ElementNode.hpp>
+#include <XML/Reader.hpp>
+#include <process.h>
+#include "DocArena.hpp"
+#include "FastScan.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+// Constants.
+
+//! The number of chunks per thread, to balance the load.
+static const size_t CHUNKS_PER_THREAD = 4;
+
+//! The smallest chunk worth parsing on a separate thread.
+static const size_t MIN_CHUNK_SIZE = 1024 * 1024;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the character terminates a tag name.
+
+static bool IsNameEnd(tchar c)
+{
+	return ( (c == TXT(' ')) || (c == TXT('\t')) || (c == TXT('\r')) || (c == TXT('\n'))
+		  || (c == TXT('/')) || (c == TXT('>')) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+ParallelReader::ParallelReader(const tstring& strText, size_t nThreads, DocArena* pArena)
+	: m_strText(strText)
+	, m_nThreads(std::min<size_t>(nThreads, MAXIMUM_WAIT_OBJECTS))
+	, m_pArena(pArena)
+	, m_nRootBegin(0)
+	, m_nBodyBegin(0)
+	, m_nBodyEnd(0)
+	, m_nNextChunk(0)
+	, m_nFallbacks(0)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+ParallelReader::~ParallelReader()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse the document. If the text cannot be split into records, or is too
+//! small to be worth it, it is parsed sequentially.
+
+XML::DocumentPtr ParallelReader::Read()
+{
+	if ( (m_nThreads < 2) || (!Split()) )
+		return ParseAll();
+
+	ParseChunks();
+
+	return MergeChunks();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the root element and split its content into chunks. The name of the
+//! first child element is taken as the record name and the chunks are split
+//! at the next start tag with that name after each nominal chunk boundary.
+//! Returns false if the document doesn't have that shape.
+
+bool ParallelReader::Split()
+{
+	const tchar* pBegin   = m_strText.data();
+	const tchar* pEnd     = pBegin + m_strText.size();
+	const tchar* pCurrent = pBegin;
+
+	// Skip the prolog.
+	for (;;)
+	{
+		pCurrent = FastScan::Find(pCurrent, pEnd, TXT('<'));
+
+		if (pCurrent == pEnd)
+			return false;
+
+		tstring::size_type nOffset = pCurrent - pBegin;
+		tstring::size_type nClose  = tstring::npos;
+
+		if (m_strText.compare(nOffset, 4, TXT("<!--")) == 0)
+			nClose = m_strText.find(TXT("-->"), nOffset);
+		else if (m_strText.compare(nOffset, 2, TXT("<?")) == 0)
+			nClose = m_strText.find(TXT("?>"), nOffset);
+		else if (m_strText.compare(nOffset, 2, TXT("<!")) == 0)
+			return false; // DOCTYPE internal subsets aren't worth parsing here.
+		else
+			break;
+
+		if (nClose == tstring::npos)
+			return false;
+
+		pCurrent = pBegin + nClose;
+	}
+
+	// Find the extent of the root element's content.
+	const tchar* pNameEnd = std::find_if(pCurrent+1, pEnd, IsNameEnd);
+	const tchar* pTagEnd  = FastScan::Find(pNameEnd, pEnd, TXT('>'));
+
+	if ( (pTagEnd == pEnd) || (*(pTagEnd-1) == TXT('/')) )
+		return false;
+
+	m_strRootName.assign(pCurrent+1, pNameEnd);
+	m_nRootBegin = pCurrent - pBegin;
+	m_nBodyBegin = (pTagEnd+1) - pBegin;
+	m_nBodyEnd   = m_strText.rfind(TXT("</") + m_strRootName);
+
+	if ( (m_nBodyEnd == tstring::npos) || (m_nBodyEnd < m_nBodyBegin) )
+		return false;
+
+	// Find the record name.
+	tstring::size_type nRecord = m_strText.find(TXT('<'), m_nBodyBegin);
+
+	if ( (nRecord >= m_nBodyEnd) || (IsNameEnd(m_strText[nRecord+1]))
+	  || (m_strText[nRecord+1] == TXT('!')) || (m_strText[nRecord+1] == TXT('?')) )
+		return false;
+
+	const tchar* pRecord    = pBegin + nRecord + 1;
+	tstring      strPattern = TXT("<") + tstring(pRecord, std::find_if(pRecord, pEnd, IsNameEnd));
+
+	// Split at the nominal boundaries.
+	size_t nBodySize  = m_nBodyEnd - m_nBodyBegin;
+	size_t nChunks    = std::min(m_nThreads * CHUNKS_PER_THREAD, nBodySize / MIN_CHUNK_SIZE);
+
+	if (nChunks < 2)
+		return false;
+
+	size_t nChunkSize = nBodySize / nChunks;
+	Chunk  oChunk;
+
+	oChunk.m_nBegin = m_nBodyBegin;
+
+	for (size_t i = 1; i != nChunks; ++i)
+	{
+		size_t nSplit = FindRecordStart(m_nBodyBegin + (i * nChunkSize), strPattern);
+
+		if ( (nSplit >= m_nBodyEnd) || (nSplit <= oChunk.m_nBegin) )
+			continue;
+
+		oChunk.m_nEnd = nSplit;
+		m_vecChunks.push_back(oChunk);
+
+		oChunk.m_nBegin = nSplit;
+	}
+
+	oChunk.m_nEnd = m_nBodyEnd;
+	m_vecChunks.push_back(oChunk);
+
+	return (m_vecChunks.size() > 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the start of the next record at or after the offset. The match is only
+//! speculative as it may be inside a comment, CDATA section or nested element.
+
+size_t ParallelReader::FindRecordStart(size_t nOffset, const tstring& strPattern) const
+{
+	for (;;)
+	{
+		nOffset = m_strText.find(strPattern, nOffset);
+
+		if (nOffset == tstring::npos)
+			return nOffset;
+
+		size_t nNameEnd = nOffset + strPattern.size();
+
+		if ( (nNameEnd < m_strText.size()) && (IsNameEnd(m_strText[nNameEnd])) )
+			return nOffset;
+
+		nOffset = nNameEnd;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse the chunks on the pool of threads. The calling thread also takes part
+//! and if a thread cannot be started the others take up its share.
+
+void ParallelReader::ParseChunks()
+{
+	std::vector<HANDLE> vecThreads;
+
+	m_nNextChunk = 0;
+
+	for (size_t i = 1; i < m_nThreads; ++i)
+	{
+		HANDLE hThread = reinterpret_cast<HANDLE>(_beginthreadex(NULL, 0, ThreadProc, this, 0, NULL));
+
+		if (hThread == NULL)
+			break;
+
+		vecThreads.push_back(hThread);
+	}
+
+	ParseNextChunks();
+
+	if (!vecThreads.empty())
+		::WaitForMultipleObjects(static_cast<DWORD>(vecThreads.size()), &vecThreads.front(), TRUE, INFINITE);
+
+	for (std::vector<HANDLE>::const_iterator it = vecThreads.begin(); it != vecThreads.end(); ++it)
+		::CloseHandle(*it);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse the next unclaimed chunks until there are none left. A chunk that
+//! fails to parse is left empty for MergeChunks() to deal with.
+
+void ParallelReader::ParseNextChunks()
+{
+	for (;;)
+	{
+		size_t nChunk = static_cast<size_t>(::InterlockedIncrement(&m_nNextChunk) - 1);
+
+		if (nChunk >= m_vecChunks.size())
+			break;
+
+		Chunk& oChunk = m_vecChunks[nChunk];
+
+		try
+		{
+			oChunk.m_pDOM = ParseRange(oChunk.m_nBegin, oChunk.m_nEnd);
+		}
+		catch (const Core::Exception& e)
+		{
+			TRACE2(TXT("Chunk %u was not split at a record boundary: %s\n"), nChunk, e.twhat());
+		}
+		catch (const std::exception&)
+		{
+			// Re-parsed sequentially.
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse the whole document sequentially.
+
+XML::DocumentPtr ParallelReader::ParseAll() const
+{
+	const tchar*    pszBegin = m_strText.data();
+	const tchar*    pszEnd   = pszBegin + m_strText.size();
+	DocArena::Scope oScope(m_pArena);
+
+	return XML::Reader::readDocument(pszBegin, pszEnd, XML::Reader::DISCARD_WHITESPACE);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse a range of the records inside a copy of the root element. The first
+//! range also includes the prolog and the last one includes the real root end
+//! tag and anything that follows it.
+
+XML::DocumentPtr ParallelReader::ParseRange(size_t nBegin, size_t nEnd) const
+{
+	tstring strPart;
+
+	if (nBegin == m_nBodyBegin)
+		strPart.assign(m_strText, 0, nBegin);
+	else
+		strPart.assign(m_strText, m_nRootBegin, m_nBodyBegin - m_nRootBegin);
+
+	strPart.append(m_strText, nBegin, nEnd - nBegin);
+
+	if (nEnd == m_nBodyEnd)
+		strPart.append(m_strText, nEnd, tstring::npos);
+	else
+		strPart += TXT("</") + m_strRootName + TXT(">");
+
+	const tchar*    pszBegin = strPart.data();
+	const tchar*    pszEnd   = pszBegin + strPart.size();
+	DocArena::Scope oScope(m_pArena);
+
+	return XML::Reader::readDocument(pszBegin, pszEnd, XML::Reader::DISCARD_WHITESPACE);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Re-parse any invalid chunks and merge the chunks into one document. A chunk
+//! that failed to parse was cut inside a record or other construct. As most
+//! cuts only split a single record it is first joined with the next chunk. If
+//! that fails too, the rest of the text is parsed in one go, so the work stays
+//! linear however far the construct reaches. Only when that fails is the error
+//! a real one, and the whole document is then parsed again so that the error
+//! refers to a position in the document rather than in the chunk.
+
+XML::DocumentPtr ParallelReader::MergeChunks()
+{
+	XML::DocumentPtr pDOM;
+	size_t           nChunks = m_vecChunks.size();
+
+	for (size_t i = 0; i != nChunks; )
+	{
+		XML::DocumentPtr pPart = m_vecChunks[i].m_pDOM;
+		size_t           nLast = i;
+
+		if (pPart.get() == nullptr)
+		{
+			++m_nFallbacks;
+
+			if (i+1 != nChunks)
+			{
+				nLast = i+1;
+
+				try
+				{
+					pPart = ParseRange(m_vecChunks[i].m_nBegin, m_vecChunks[nLast].m_nEnd);
+				}
+				catch (const Core::Exception&)
+				{
+					// The first chunk's range to the end is the whole document.
+					if ( (i == 0) && (nLast == nChunks-1) )
+						throw;
+				}
+			}
+		}
+
+		if ( (pPart.get() == nullptr) && (nLast != nChunks-1) )
+		{
+			nLast = nChunks-1;
+
+			try
+			{
+				pPart = ParseRange(m_vecChunks[i].m_nBegin, m_vecChunks[nLast].m_nEnd);
+			}
+			catch (const Core::Exception&)
+			{
+				// The first chunk's range to the end is the whole document.
+				if (i == 0)
+					throw;
+			}
+		}
+
+		if (pPart.get() == nullptr)
+		{
+			TRACE1(TXT("The text from chunk %u onwards is invalid, re-parsing the whole document\n"), i);
+
+			pDOM.reset();
+
+			return ParseAll();
+		}
+
+		if (pDOM.get() == nullptr)
+			pDOM = pPart;
+		else
+			AppendRecords(pDOM, pPart);
+
+		// Release the chunk's nodes as we go.
+		for (; i <= nLast; ++i)
+			m_vecChunks[i].m_pDOM.reset();
+	}
+
+	TRACE3(TXT("Parsed document as %u chunks on %u threads, %u re-parsed\n"), nChunks, m_nThreads, m_nFallbacks);
+
+	return pDOM;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Move the records of a parsed chunk under the document root. Any nodes that
+//! follow the chunk's root element are appended to the document.
+
+void ParallelReader::AppendRecords(const XML::DocumentPtr& pTarget, const XML::DocumentPtr& pSource)
+{
+	XML::ElementNodePtr pTargetRoot = pTarget->getRootElement();
+	XML::ElementNodePtr pSourceRoot = pSource->getRootElement();
+
+	// Take copies as the nodes are re-parented.
+	XML::Nodes vecRecords(pSourceRoot->beginChild(), pSourceRoot->endChild());
+	XML::Nodes vecNodes(pSource->beginChild(), pSource->endChild());
+	bool       bAfterRoot = false;
+
+	for (XML::Nodes::const_iterator it = vecRecords.begin(); it != vecRecords.end(); ++it)
+		pTargetRoot->appendChild(*it);
+
+	for (XML::Nodes::const_iterator it = vecNodes.begin(); it != vecNodes.end(); ++it)
+	{
+		if (bAfterRoot)
+			pTarget->appendChild(*it);
+		else if (it->get() == pSourceRoot.get())
+			bAfterRoot = true;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The worker thread function.
+
+unsigned __stdcall ParallelReader::ThreadProc(void* pParam)
+{
+	ParallelReader* pReader = static_cast<ParallelReader*>(pParam);
+
+	pReader->ParseNextChunks();
+
+	return 0;
+}
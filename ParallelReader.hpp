@@ -0,0 +1,130 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   ParallelReader.hpp
+//! \brief  The ParallelReader class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_PARALLELREADER_HPP
+#define APP_PARALLELREADER_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <XML/Document.hpp>
+
+// Forward declarations.
+class DocArena;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parses a document made up of a root element with many top-level records on
+//! multiple threads. The text is split speculatively into chunks at what look
+//! like record start tags and each chunk is parsed inside a copy of the root
+//! element. A chunk that fails to parse means its end was not really a record
+//! boundary, so it is re-parsed together with the next chunk, or failing that
+//! with the rest of the text. The records are then moved under the root of the
+//! first chunk in document order.
+
+class ParallelReader : private Core::NotCopyable
+{
+public:
+	//! Constructor.
+	ParallelReader(const tstring& strText, size_t nThreads, DocArena* pArena);
+
+	//! Destructor.
+	~ParallelReader();
+
+	//
+	// Properties.
+	//
+
+	//! Get the number of chunks the text was split into.
+	size_t ChunkCount() const;
+
+	//! Get the number of chunks that had to be re-parsed sequentially.
+	size_t FallbackCount() const;
+
+	//
+	// Methods.
+	//
+
+	//! Parse the document.
+	XML::DocumentPtr Read();
+
+private:
+	////////////////////////////////////////////////////////////////////////////
+	//! A part of the text parsed as a single unit.
+
+	struct Chunk
+	{
+		size_t				m_nBegin;	//!< The start of the records.
+		size_t				m_nEnd;		//!< The end of the records.
+		XML::DocumentPtr	m_pDOM;		//!< The parsed chunk, if valid.
+	};
+
+	//! The collection of chunks.
+	typedef std::vector<Chunk> Chunks;
+
+	//
+	// Members.
+	//
+	const tstring&	m_strText;		//!< The document text.
+	size_t			m_nThreads;		//!< The number of threads to use.
+	DocArena*		m_pArena;		//!< The arena to allocate from, if any.
+	size_t			m_nRootBegin;	//!< The start of the root start tag.
+	size_t			m_nBodyBegin;	//!< The end of the root start tag.
+	size_t			m_nBodyEnd;		//!< The start of the root end tag.
+	tstring			m_strRootName;	//!< The root element name.
+	Chunks			m_vecChunks;	//!< The chunks being parsed.
+	volatile long	m_nNextChunk;	//!< The next chunk for a thread to parse.
+	size_t			m_nFallbacks;	//!< The number of chunks re-parsed.
+
+	//
+	// Internal methods.
+	//
+
+	//! Find the root element and split its content into chunks.
+	bool Split();
+
+	//! Find the start of the next record at or after the offset.
+	size_t FindRecordStart(size_t nOffset, const tstring& strRecord) const;
+
+	//! Parse the chunks on the pool of threads.
+	void ParseChunks();
+
+	//! Parse the next unclaimed chunks until there are none left.
+	void ParseNextChunks();
+
+	//! Parse the whole document sequentially.
+	XML::DocumentPtr ParseAll() const;
+
+	//! Parse a range of the records inside a copy of the root element.
+	XML::DocumentPtr ParseRange(size_t nBegin, size_t nEnd) const;
+
+	//! Re-parse any invalid chunks and merge the chunks into one document.
+	XML::DocumentPtr MergeChunks();
+
+	//! Move the records of a parsed chunk under the document root.
+	static void AppendRecords(const XML::DocumentPtr& pTarget, const XML::DocumentPtr& pSource);
+
+	//! The worker thread function.
+	static unsigned __stdcall ThreadProc(void* pParam);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of chunks the text was split into.
+
+inline size_t ParallelReader::ChunkCount() const
+{
+	return m_vecChunks.size();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of chunks that had to be re-parsed sequentially.
+
+inline size_t ParallelReader::FallbackCount() const
+{
+	return m_nFallbacks;
+}
+
+#endif // APP_PARALLELREADER_HPP
@@ -0,0 +1,216 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   PreParser.cpp
+//! \brief  The PreParser class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "PreParser.hpp"
+#include <XML/Reader.hpp>
+#include <process.h>
+#include "DocArena.hpp"
+#include "TheDoc.hpp"
+#include "NodeCursor.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+//! Convert a file time to a single value.
+
+static uint64 ToUInt64(const FILETIME& ftTime)
+{
+	return (static_cast<uint64>(ftTime.dwHighDateTime) << 32) | ftTime.dwLowDateTime;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+PreParser::PreParser(const tstring& strPath, uint64 nBudget)
+	: m_strPath(strPath)
+	, m_nFileSize(0)
+	, m_nLastWrite(0)
+	, m_hThread(NULL)
+	, m_nState(RUNNING)
+	, m_pArena(new DocArena)
+{
+	m_pArena->SetLimit(static_cast<size_t>(std::min<uint64>(nBudget, static_cast<size_t>(-1))));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+PreParser::~PreParser()
+{
+	if (m_hThread != NULL)
+		::CloseHandle(m_hThread);
+
+	// The arena goes first so that the nodes are only counted as they are freed.
+	delete m_pArena;
+
+	if (m_pDOM.get() != nullptr)
+		NodeCursor::ReleaseChildren(*m_pDOM);
+
+	m_pDOM.reset();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Start parsing a document in the background. The parse is abandoned if it
+//! needs more than the budget. This returns nullptr if the document or the
+//! thread is not available.
+
+PreParser* PreParser::Start(const tstring& strPath, uint64 nBudget)
+{
+	PreParser* pParser = new PreParser(strPath, nBudget);
+
+	if (GetFileVersion(strPath, pParser->m_nFileSize, pParser->m_nLastWrite))
+	{
+		pParser->m_hThread = reinterpret_cast<HANDLE>(_beginthreadex(NULL, 0, ThreadProc, pParser, 0, NULL));
+
+		if (pParser->m_hThread != NULL)
+			return pParser;
+	}
+
+	delete pParser;
+
+	return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Wait for the parse to finish and take the DOM and its arena. This fails if
+//! the document could not be parsed or has changed since it was read. The
+//! parser must still be released afterwards.
+
+bool PreParser::Wait(XML::DocumentPtr& pDOM, DocArena*& pArena)
+{
+	ASSERT(m_nState != RELEASED);
+
+	DWORD dwStart = ::GetTickCount();
+
+	::WaitForSingleObject(m_hThread, INFINITE);
+
+	TRACE1(TXT("Waited %u ms for the pre-parsed document\n"), ::GetTickCount() - dwStart);
+
+	uint64 nFileSize  = 0;
+	uint64 nLastWrite = 0;
+
+	if ( (m_pDOM.get() == nullptr) || (!GetFileVersion(m_strPath, nFileSize, nLastWrite))
+	  || (nFileSize != m_nFileSize) || (nLastWrite != m_nLastWrite) )
+		return false;
+
+	pDOM   = m_pDOM;
+	pArena = m_pArena;
+
+	m_pDOM.reset();
+	m_pArena = nullptr;
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Cancel the parse and wait for the thread to finish. The parser fails its
+//! next allocation, so this only waits for the file to finish being read, or
+//! the partial DOM to be freed. The parser must still be released afterwards.
+
+void PreParser::Stop()
+{
+	ASSERT(m_nState != RELEASED);
+
+	DWORD dwStart = ::GetTickCount();
+
+	if (m_pArena != nullptr)
+		m_pArena->Cancel();
+
+	::WaitForSingleObject(m_hThread, INFINITE);
+
+	TRACE1(TXT("Waited %u ms for the pre-parse to stop\n"), ::GetTickCount() - dwStart);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Release the parser and any result it holds. If the thread is still running
+//! the parse is cancelled and the parser is left for the thread to delete when
+//! it finishes.
+
+void PreParser::Release()
+{
+	// Cancel first, as the thread may delete the parser as soon as it's released.
+	if (m_pArena != nullptr)
+		m_pArena->Cancel();
+
+	if (::InterlockedCompareExchange(&m_nState, RELEASED, RUNNING) == RUNNING)
+		return;
+
+	delete this;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read and parse the document. A failure is not reported as the document will
+//! be parsed again if it is opened. A cancelled parse fails with bad_alloc as
+//! soon as the parser next allocates a node.
+
+void PreParser::Parse()
+{
+	DWORD dwStart = ::GetTickCount();
+
+	try
+	{
+		tstring strContents;
+
+		TheDoc::ReadTextFile(m_strPath.c_str(), strContents);
+
+		if (m_pArena->IsCancelled())
+		{
+			TRACE(TXT("Cancelled the pre-parse after reading the document\n"));
+			return;
+		}
+
+		const tchar*    pszBegin = strContents.data();
+		const tchar*    pszEnd   = pszBegin + strContents.size();
+		DocArena::Scope oScope(m_pArena);
+
+		m_pDOM = XML::Reader::readDocument(pszBegin, pszEnd, XML::Reader::DISCARD_WHITESPACE);
+	}
+	catch (const Core::Exception& e)
+	{
+		TRACE1(TXT("Failed to pre-parse the document: %s\n"), e.twhat());
+	}
+	catch (const std::exception&)
+	{
+		if (m_pArena->IsCancelled())
+			TRACE(TXT("Cancelled the pre-parse, or it exceeded its memory budget\n"));
+		else
+			TRACE(TXT("Failed to pre-parse the document: out of memory\n"));
+	}
+
+	TRACE1(TXT("Pre-parsed document in %u ms\n"), ::GetTickCount() - dwStart);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the size and last write time of a document.
+
+bool PreParser::GetFileVersion(const tstring& strPath, uint64& nFileSize, uint64& nLastWrite)
+{
+	WIN32_FILE_ATTRIBUTE_DATA oInfo;
+
+	if (!::GetFileAttributesEx(strPath.c_str(), GetFileExInfoStandard, &oInfo))
+		return false;
+
+	nFileSize  = (static_cast<uint64>(oInfo.nFileSizeHigh) << 32) | oInfo.nFileSizeLow;
+	nLastWrite = ToUInt64(oInfo.ftLastWriteTime);
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The background thread function. The thread runs in background mode so that
+//! both its CPU and I/O take second place to the UI and anything the user does.
+
+unsigned __stdcall PreParser::ThreadProc(void* pParam)
+{
+	PreParser* pParser = static_cast<PreParser*>(pParam);
+
+	::SetThreadPriority(::GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+
+	pParser->Parse();
+
+	if (::InterlockedCompareExchange(&pParser->m_nState, FINISHED, RUNNING) == RELEASED)
+		delete pParser;
+
+	return 0;
+}
@@ -0,0 +1,107 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   PreParser.hpp
+//! \brief  The PreParser class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_PREPARSER_HPP
+#define APP_PREPARSER_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <XML/Document.hpp>
+
+// Forward declarations.
+class DocArena;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parses a document on a low priority background thread in the expectation
+//! that it will be opened soon. The owner either waits for the result and
+//! takes the DOM, or releases the object. The DOM is always built on its own
+//! arena, which limits the memory the parse may use and is how a parse that
+//! is no longer wanted is cancelled: the parser fails its next allocation and
+//! unwinds, whatever stage it has reached. A released parser that is still
+//! running deletes itself when it finishes so that the owner never blocks on
+//! work that is no longer wanted.
+
+class PreParser : private Core::NotCopyable
+{
+public:
+	//
+	// Class methods.
+	//
+
+	//! Start parsing a document in the background.
+	static PreParser* Start(const tstring& strPath, uint64 nBudget);
+
+	//
+	// Properties.
+	//
+
+	//! Get the path of the document being parsed.
+	const tstring& Path() const;
+
+	//
+	// Methods.
+	//
+
+	//! Wait for the parse to finish and take the DOM and its arena.
+	bool Wait(XML::DocumentPtr& pDOM, DocArena*& pArena);
+
+	//! Cancel the parse and wait for the thread to finish.
+	void Stop();
+
+	//! Release the parser and any result it holds.
+	void Release();
+
+private:
+	//! The states of the background thread.
+	enum State
+	{
+		RUNNING,	//!< The document is being parsed.
+		FINISHED,	//!< The thread has finished.
+		RELEASED,	//!< The owner has released the parser.
+	};
+
+	//
+	// Members.
+	//
+	tstring				m_strPath;		//!< The document path.
+	uint64				m_nFileSize;	//!< The document size when started.
+	uint64				m_nLastWrite;	//!< The document last write time when started.
+	HANDLE				m_hThread;		//!< The background thread.
+	volatile long		m_nState;		//!< The State of the background thread.
+	DocArena*			m_pArena;		//!< The arena holding the DOM.
+	XML::DocumentPtr	m_pDOM;			//!< The parsed DOM, if successful.
+
+	//! Constructor.
+	PreParser(const tstring& strPath, uint64 nBudget);
+
+	//! Destructor.
+	~PreParser();
+
+	//
+	// Internal methods.
+	//
+
+	//! Read and parse the document.
+	void Parse();
+
+	//! Get the size and last write time of a document.
+	static bool GetFileVersion(const tstring& strPath, uint64& nFileSize, uint64& nLastWrite);
+
+	//! The background thread function.
+	static unsigned __stdcall ThreadProc(void* pParam);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the path of the document being parsed.
+
+inline const tstring& PreParser::Path() const
+{
+	return m_strPath;
+}
+
+#endif // APP_PREPARSER_HPP
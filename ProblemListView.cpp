@@ -0,0 +1,116 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   ProblemListView.cpp
+//! \brief  The ProblemListView class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "ProblemListView.hpp"
+#include "TheView.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+ProblemListView::ProblemListView(TheView& oView)
+	: m_oView(oView)
+	, m_vecProblems()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+ProblemListView::~ProblemListView()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Replace the problems shown, taking the contents of the collection. The
+//! scroll position is kept so that the list doesn't jump while editing.
+
+void ProblemListView::SetProblems(ValidationState::Problems& vecProblems)
+{
+	m_vecProblems.swap(vecProblems);
+
+	ListView_SetItemCountEx(m_hWnd, m_vecProblems.size(), LVSICF_NOSCROLL);
+	Invalidate();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Remove all the problems.
+
+void ProblemListView::Clear()
+{
+	ValidationState::Problems vecEmpty;
+
+	SetProblems(vecEmpty);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Handle child message reflected back from the parent.
+
+void ProblemListView::OnReflectedCtrlMsg(NMHDR& oMsgHdr)
+{
+	ASSERT(oMsgHdr.hwndFrom == m_hWnd);
+
+	if (oMsgHdr.code == LVN_GETDISPINFO)
+		OnGetDispInfo(reinterpret_cast<NMLVDISPINFO&>(oMsgHdr));
+	else if ( (oMsgHdr.code == NM_DBLCLK) || (oMsgHdr.code == NM_RETURN) )
+		OnActivate();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Supply the text for an item.
+
+void ProblemListView::OnGetDispInfo(NMLVDISPINFO& oInfo)
+{
+	LVITEM& oItem = oInfo.item;
+
+	if ( ((oItem.mask & LVIF_TEXT) == 0) || (oItem.iItem < 0)
+	  || (static_cast<size_t>(oItem.iItem) >= m_vecProblems.size()) )
+		return;
+
+	const ValidationProblem& oProblem = m_vecProblems[oItem.iItem];
+
+	if (oItem.iSubItem == TYPE_COLUMN)
+		lstrcpyn(oItem.pszText, TypeName(oProblem.m_eType), oItem.cchTextMax);
+	else if (oItem.iSubItem == MESSAGE_COLUMN)
+		lstrcpyn(oItem.pszText, oProblem.m_strMessage.c_str(), oItem.cchTextMax);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Handle an item being activated.
+
+void ProblemListView::OnActivate()
+{
+	if (!IsSelection())
+		return;
+
+	size_t nItem = Selection();
+
+	if (nItem < m_vecProblems.size())
+		m_oView.OnProblemActivated(m_vecProblems[nItem].m_pNode);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the display name of a kind of problem.
+
+const tchar* ProblemListView::TypeName(ValidationProblem::Type eType)
+{
+	if (eType == ValidationProblem::DUPLICATE_ID)
+		return TXT("Duplicate ID");
+	else if (eType == ValidationProblem::DANGLING_IDREF)
+		return TXT("Dangling IDREF");
+	else if (eType == ValidationProblem::UNDECLARED_PREFIX)
+		return TXT("Undeclared prefix");
+	else if (eType == ValidationProblem::EMPTY_NAMESPACE)
+		return TXT("Empty namespace");
+	else if (eType == ValidationProblem::UNDECLARED_ELEMENT)
+		return TXT("Undeclared element");
+	else if (eType == ValidationProblem::INVALID_CONTENT)
+		return TXT("Invalid content");
+	else if (eType == ValidationProblem::WRONG_ROOT)
+		return TXT("Wrong root");
+
+	ASSERT_FALSE();
+	return TXT("");
+}
@@ -0,0 +1,80 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   ProblemListView.hpp
+//! \brief  The ProblemListView class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef PROBLEMLISTVIEW_HPP
+#define PROBLEMLISTVIEW_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <WCL/ListView.hpp>
+#include "ValidationState.hpp"
+
+// Forward declarations.
+class TheView;
+
+////////////////////////////////////////////////////////////////////////////////
+//! The list view derived control used to display the problems found by
+//! validating the document. The control is virtual, so the text of an item is
+//! only requested when it is drawn, as there may be many problems. Activating
+//! an item selects the node with the problem.
+
+class ProblemListView : public CListView
+{
+public:
+	//! Constructor.
+	ProblemListView(TheView& oView);
+
+	//! Destructor.
+	virtual ~ProblemListView();
+
+	//! The columns.
+	enum Column
+	{
+		TYPE_COLUMN		= 0,	//!< The kind of problem column.
+		MESSAGE_COLUMN	= 1,	//!< The description column.
+	};
+
+	//
+	// Methods.
+	//
+
+	//! Replace the problems shown, taking the contents of the collection.
+	void SetProblems(ValidationState::Problems& vecProblems);
+
+	//! Remove all the problems.
+	void Clear();
+
+private:
+	//
+	// Members.
+	//
+	TheView&					m_oView;		//!< The document view.
+	ValidationState::Problems	m_vecProblems;	//!< The problems shown.
+
+	//
+	// Message handlers.
+	//
+
+	//! Handle child message reflected back from the parent.
+	virtual void OnReflectedCtrlMsg(NMHDR& oMsgHdr);
+
+	//! Supply the text for an item.
+	void OnGetDispInfo(NMLVDISPINFO& oInfo);
+
+	//! Handle an item being activated.
+	void OnActivate();
+
+	//
+	// Internal methods.
+	//
+
+	//! Get the display name of a kind of problem.
+	static const tchar* TypeName(ValidationProblem::Type eType);
+};
+
+#endif // PROBLEMLISTVIEW_HPP
@@ -22,16 +22,34 @@
 #define ID_FILE_MRU_7                   112
 #define ID_FILE_MRU_8                   113
 #define ID_FILE_MRU_9                   114
+#define ID_FILE_OPEN_PREVIEW            115
+#define ID_FILE_LOAD_MORE               116
+#define ID_FILE_OPEN_COMPACT            117
+#define ID_FILE_COMPARE                 118
 #define ID_FILE_EXIT                    120
 #define IDD_NODE_PATH                   132
 #define IDD_FIND                        133
+#define IDD_BULK_EDIT                   134
+#define IDD_STRUCTURE                   135
+#define IDD_SUBTREES                    136
+#define IDD_COMPARE                     137
 #define ID_EDIT_POPUP                   200
 #define ID_EDIT_FIND                    201
 #define ID_EDIT_FIND_NEXT               202
+#define ID_EDIT_UNDO                    203
+#define ID_EDIT_REDO                    204
+#define ID_EDIT_BULK_EDIT               205
+#define ID_EDIT_COPY                    206
+#define ID_EDIT_PASTE                   207
 #define ID_VIEW_POPUP                   300
 #define ID_VIEW_HORZ                    301
 #define ID_VIEW_VERT                    302
 #define ID_VIEW_NODE_PATH               303
+#define ID_VIEW_FOLLOW                  304
+#define ID_VIEW_AUTO_SCROLL             305
+#define ID_VIEW_PROBLEMS                306
+#define ID_VIEW_STRUCTURE               307
+#define ID_VIEW_SUBTREES                308
 #define ID_HELP_POPUP                   900
 #define ID_HELP_CONTENTS                901
 #define ID_HELP_ABOUT                   902
@@ -41,6 +59,15 @@
 #define IDC_COPYRIGHT                   1086
 #define IDC_PATH                        1087
 #define IDC_EDIT1                       1088
+#define IDC_BULK_OPERATION              1089
+#define IDC_BULK_NAME                   1090
+#define IDC_BULK_VALUE                  1091
+#define IDC_STRUCTURE                   1092
+#define IDC_SUBTREES                    1093
+#define IDC_LEFT_TREE                   1094
+#define IDC_RIGHT_TREE                  1095
+#define IDC_SUMMARY                     1096
+#define IDC_NEXT_DIFF                   1097
 #define IDD_MAIN                        5000
 #define IDD_ABOUT                       5001
 #define IDC_STATIC                      -1
@@ -50,9 +77,9 @@
 #ifdef APSTUDIO_INVOKED
 #ifndef APSTUDIO_READONLY_SYMBOLS
 #define _APS_NO_MFC                     1
-#define _APS_NEXT_RESOURCE_VALUE        134
+#define _APS_NEXT_RESOURCE_VALUE        138
 #define _APS_NEXT_COMMAND_VALUE         173
-#define _APS_NEXT_CONTROL_VALUE         1089
+#define _APS_NEXT_CONTROL_VALUE         1098
 #define _APS_NEXT_SYMED_VALUE           104
 #endif
 #endif
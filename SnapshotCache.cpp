@@ -0,0 +1,341 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   SnapshotCache.cpp
+//! \brief  The SnapshotCache class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "SnapshotCache.hpp"
+#include "CompactDoc.hpp"
+#include <WCL/File.hpp>
+#include <WCL/StrCvt.hpp>
+#include <Core/RuntimeException.hpp>
+
+////////////////////////////////////////////////////////////////////////////////
+// Constants.
+
+//! The snapshot file signature.
+static const char SNAPSHOT_MAGIC[8] = { 'X', 'E', 'S', 'N', 'A', 'P', '\r', '\n' };
+
+//! The snapshot format version.
+static const uint32 SNAPSHOT_FORMAT = 1;
+
+//! The snapshot file extension.
+static const tchar SNAPSHOT_EXT[] = TXT(".xsnap");
+
+//! The extension of a snapshot that is still being written.
+static const tchar PARTIAL_EXT[] = TXT(".tmp");
+
+//! The size of each sample of the content that is hashed.
+static const size_t SAMPLE_SIZE = 64 * 1024;
+
+//! The number of samples of the content that are hashed.
+static const size_t SAMPLE_COUNT = 16;
+
+//! The FNV-1a 64-bit offset basis.
+static const uint64 FNV_OFFSET_BASIS = 14695981039346656037ULL;
+
+//! The FNV-1a 64-bit prime.
+static const uint64 FNV_PRIME = 1099511628211ULL;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add a block of bytes to an FNV-1a hash.
+
+static uint64 HashBytes(uint64 nHash, const void* pvData, size_t nBytes)
+{
+	const byte* pData = static_cast<const byte*>(pvData);
+
+	for (size_t i = 0; i != nBytes; ++i)
+		nHash = (nHash ^ pData[i]) * FNV_PRIME;
+
+	return nHash;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Convert a file time to a single value.
+
+static uint64 ToUInt64(const FILETIME& ftTime)
+{
+	return (static_cast<uint64>(ftTime.dwHighDateTime) << 32) | ftTime.dwLowDateTime;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! A snapshot file found in the cache directory.
+
+struct SnapshotFile
+{
+	tstring	m_strPath;		//!< The snapshot path.
+	uint64	m_nSize;		//!< The snapshot size.
+	uint64	m_nLastUsed;	//!< The time the snapshot was last used.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Compare snapshots by when they were last used, oldest first.
+
+static bool OlderThan(const SnapshotFile& oLhs, const SnapshotFile& oRhs)
+{
+	return (oLhs.m_nLastUsed < oRhs.m_nLastUsed);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+SnapshotCache::SnapshotCache(const tstring& strDirectory, uint64 nMaxSize)
+	: m_strDirectory(strDirectory)
+	, m_nMaxSize(nMaxSize)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+SnapshotCache::~SnapshotCache()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Load the snapshot of a document, if there is one that matches the current
+//! version of the document. Returns false if the document must be parsed.
+
+bool SnapshotCache::Load(const tstring& strPath, CompactDoc& oDoc)
+{
+	tstring strSnapshot = SnapshotPath(strPath);
+	Header  oExpected;
+
+	if ( (::GetFileAttributes(strSnapshot.c_str()) == INVALID_FILE_ATTRIBUTES)
+	  || (!CreateHeader(strPath, oExpected)) )
+		return false;
+
+	try
+	{
+		CFile   oFile;
+		Header  oHeader;
+		uint32  nLength = 0;
+		tstring strSource;
+
+		oFile.Open(strSnapshot.c_str(), CFile::ReadOnly);
+		oFile.Read(&oHeader, sizeof(oHeader));
+		oFile.Read(&nLength, sizeof(nLength));
+
+		if ( (memcmp(&oHeader, &oExpected, sizeof(oHeader)) != 0) || (nLength != strPath.size()) )
+			return false;
+
+		strSource.resize(nLength);
+
+		if (nLength != 0)
+			oFile.Read(&strSource[0], nLength * sizeof(tchar));
+
+		if (strSource != strPath)
+			return false;
+
+		oDoc.Read(oFile);
+		oFile.Close();
+	}
+	catch (const Core::Exception& e)
+	{
+		TRACE2(TXT("Failed to read snapshot '%s': %s\n"), strSnapshot.c_str(), e.twhat());
+		return false;
+	}
+	catch (const std::exception& e)
+	{
+		TRACE2(TXT("Failed to read snapshot '%s': %hs\n"), strSnapshot.c_str(), e.what());
+		return false;
+	}
+
+	Touch(strSnapshot);
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Store a snapshot of a document. The snapshot is written under a temporary
+//! name first so that a partly written one is never mistaken for a current
+//! one, and the cache is then trimmed back to its size limit.
+
+void SnapshotCache::Store(const tstring& strPath, const CompactDoc& oDoc)
+{
+	Header oHeader;
+
+	if (!CreateHeader(strPath, oHeader))
+		return;
+
+	::CreateDirectory(m_strDirectory.c_str(), NULL);
+
+	tstring strSnapshot = SnapshotPath(strPath);
+	tstring strPartial  = strSnapshot + PARTIAL_EXT;
+
+	try
+	{
+		CFile  oFile;
+		uint32 nLength = static_cast<uint32>(strPath.size());
+
+		oFile.Create(strPartial.c_str());
+		oFile.Write(&oHeader, sizeof(oHeader));
+		oFile.Write(&nLength, sizeof(nLength));
+		oFile.Write(strPath.data(), nLength * sizeof(tchar));
+
+		oDoc.Write(oFile);
+		oFile.Close();
+	}
+	catch (const Core::Exception& e)
+	{
+		TRACE2(TXT("Failed to write snapshot '%s': %s\n"), strPartial.c_str(), e.twhat());
+		::DeleteFile(strPartial.c_str());
+		return;
+	}
+
+	if (!::MoveFileEx(strPartial.c_str(), strSnapshot.c_str(), MOVEFILE_REPLACE_EXISTING))
+	{
+		TRACE2(TXT("Failed to replace snapshot '%s': %s\n"), strSnapshot.c_str(), CStrCvt::FormatError().c_str());
+		::DeleteFile(strPartial.c_str());
+		return;
+	}
+
+	Evict();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the path of the snapshot for a document. The file name is a hash of the
+//! document path, with the path itself stored in the snapshot to be certain.
+
+tstring SnapshotCache::SnapshotPath(const tstring& strPath) const
+{
+	uint64 nHash = HashBytes(FNV_OFFSET_BASIS, strPath.data(), strPath.size() * sizeof(tchar));
+
+	return m_strDirectory + TXT("\\") + Core::fmt(TXT("%08X%08X"), static_cast<uint32>(nHash >> 32),
+													static_cast<uint32>(nHash)) + SNAPSHOT_EXT;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Remove the least recently used snapshots until the total size is under the
+//! limit. Snapshots in use by another instance just fail to be deleted.
+
+void SnapshotCache::Evict()
+{
+	tstring                   strPattern = m_strDirectory + TXT("\\*") + SNAPSHOT_EXT;
+	WIN32_FIND_DATA           oFindData;
+	std::vector<SnapshotFile> vecFiles;
+	uint64                    nTotalSize = 0;
+
+	HANDLE hFind = ::FindFirstFile(strPattern.c_str(), &oFindData);
+
+	if (hFind == INVALID_HANDLE_VALUE)
+		return;
+
+	do
+	{
+		SnapshotFile oFile;
+
+		oFile.m_strPath   = m_strDirectory + TXT("\\") + oFindData.cFileName;
+		oFile.m_nSize     = (static_cast<uint64>(oFindData.nFileSizeHigh) << 32) | oFindData.nFileSizeLow;
+		oFile.m_nLastUsed = ToUInt64(oFindData.ftLastWriteTime);
+
+		vecFiles.push_back(oFile);
+		nTotalSize += oFile.m_nSize;
+	}
+	while (::FindNextFile(hFind, &oFindData));
+
+	::FindClose(hFind);
+
+	std::sort(vecFiles.begin(), vecFiles.end(), OlderThan);
+
+	for (std::vector<SnapshotFile>::const_iterator it = vecFiles.begin(); (it != vecFiles.end()) && (nTotalSize > m_nMaxSize); ++it)
+	{
+		if (::DeleteFile(it->m_strPath.c_str()))
+		{
+			TRACE1(TXT("Evicted snapshot '%s'\n"), it->m_strPath.c_str());
+			nTotalSize -= it->m_nSize;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Create the header that identifies the current version of a document.
+//! Returns false if the document's details could not be read.
+
+bool SnapshotCache::CreateHeader(const tstring& strPath, Header& oHeader)
+{
+	WIN32_FILE_ATTRIBUTE_DATA oInfo;
+
+	if (!::GetFileAttributesEx(strPath.c_str(), GetFileExInfoStandard, &oInfo))
+		return false;
+
+	memset(&oHeader, 0, sizeof(oHeader));
+	memcpy(oHeader.m_achMagic, SNAPSHOT_MAGIC, sizeof(oHeader.m_achMagic));
+
+	oHeader.m_nFormat    = SNAPSHOT_FORMAT;
+	oHeader.m_nCharSize  = sizeof(CompactDoc::Char);
+	oHeader.m_nFileSize  = (static_cast<uint64>(oInfo.nFileSizeHigh) << 32) | oInfo.nFileSizeLow;
+	oHeader.m_nLastWrite = ToUInt64(oInfo.ftLastWriteTime);
+
+	try
+	{
+		oHeader.m_nContentHash = HashContent(strPath, oHeader.m_nFileSize);
+	}
+	catch (const Core::Exception& e)
+	{
+		TRACE2(TXT("Failed to hash '%s': %s\n"), strPath.c_str(), e.twhat());
+		return false;
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Hash samples of the content of a document. Hashing all of a large document
+//! would cost as much as parsing it, so only evenly spaced samples, including
+//! the start and end, are hashed to catch edits that kept the size and time.
+
+uint64 SnapshotCache::HashContent(const tstring& strPath, uint64 nFileSize)
+{
+	HANDLE hFile = ::CreateFile(strPath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+								NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (hFile == INVALID_HANDLE_VALUE)
+		throw Core::RuntimeException(Core::fmt(TXT("Failed to open file '%s': %s"), strPath.c_str(), CStrCvt::FormatError().c_str()));
+
+	std::vector<byte> vecSample(SAMPLE_SIZE);
+	uint64            nHash = FNV_OFFSET_BASIS;
+	uint64            nLast = (nFileSize > SAMPLE_SIZE) ? nFileSize - SAMPLE_SIZE : 0;
+	BOOL              bOK   = TRUE;
+
+	for (size_t i = 0; (i != SAMPLE_COUNT) && (bOK); ++i)
+	{
+		LARGE_INTEGER liOffset;
+		DWORD         dwRead = 0;
+
+		liOffset.QuadPart = (nLast / (SAMPLE_COUNT-1)) * i;
+
+		bOK = ( (::SetFilePointerEx(hFile, liOffset, NULL, FILE_BEGIN))
+			 && (::ReadFile(hFile, &vecSample.front(), static_cast<DWORD>(vecSample.size()), &dwRead, NULL)) );
+
+		nHash = HashBytes(nHash, &vecSample.front(), dwRead);
+	}
+
+	DWORD dwError = ::GetLastError();
+
+	::CloseHandle(hFile);
+
+	if (!bOK)
+		throw Core::RuntimeException(Core::fmt(TXT("Failed to read file '%s': %s"), strPath.c_str(), CStrCvt::FormatError(dwError).c_str()));
+
+	return nHash;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Mark a snapshot as the most recently used. The last write time is used as
+//! the last access time is not reliably maintained by the file system.
+
+void SnapshotCache::Touch(const tstring& strSnapshot)
+{
+	HANDLE hFile = ::CreateFile(strSnapshot.c_str(), FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE,
+								NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (hFile == INVALID_HANDLE_VALUE)
+		return;
+
+	FILETIME ftNow;
+
+	::GetSystemTimeAsFileTime(&ftNow);
+	::SetFileTime(hFile, NULL, NULL, &ftNow);
+	::CloseHandle(hFile);
+}
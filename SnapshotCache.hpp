@@ -0,0 +1,85 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   SnapshotCache.hpp
+//! \brief  The SnapshotCache class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_SNAPSHOTCACHE_HPP
+#define APP_SNAPSHOTCACHE_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+// Forward declarations.
+class CompactDoc;
+
+////////////////////////////////////////////////////////////////////////////////
+//! A directory of binary snapshots of parsed compact documents, so that a
+//! document that has not changed since it was last opened can be read back
+//! without being parsed again. Each snapshot is keyed by the document's path,
+//! size, last write time and a hash of samples of its content. The total size
+//! of the cache is kept under a limit by removing the least recently used
+//! snapshots. Failures are not fatal as the document can always be parsed.
+
+class SnapshotCache : private Core::NotCopyable
+{
+public:
+	//! Constructor.
+	SnapshotCache(const tstring& strDirectory, uint64 nMaxSize);
+
+	//! Destructor.
+	~SnapshotCache();
+
+	//
+	// Methods.
+	//
+
+	//! Load the snapshot of a document, if there is a current one.
+	bool Load(const tstring& strPath, CompactDoc& oDoc);
+
+	//! Store a snapshot of a document.
+	void Store(const tstring& strPath, const CompactDoc& oDoc);
+
+private:
+	////////////////////////////////////////////////////////////////////////////
+	//! The fixed part of a snapshot file header. It is followed by the path of
+	//! the document and then the document itself.
+
+	struct Header
+	{
+		char	m_achMagic[8];		//!< The file signature.
+		uint32	m_nFormat;			//!< The snapshot format version.
+		uint32	m_nCharSize;		//!< The size of the stored characters.
+		uint64	m_nFileSize;		//!< The document size.
+		uint64	m_nLastWrite;		//!< The document last write time.
+		uint64	m_nContentHash;		//!< The hash of the content samples.
+	};
+
+	//
+	// Members.
+	//
+	tstring	m_strDirectory;		//!< The cache directory.
+	uint64	m_nMaxSize;			//!< The maximum total size of the snapshots.
+
+	//
+	// Internal methods.
+	//
+
+	//! Get the path of the snapshot for a document.
+	tstring SnapshotPath(const tstring& strPath) const;
+
+	//! Remove the least recently used snapshots until under the size limit.
+	void Evict();
+
+	//! Create the header that identifies the current version of a document.
+	static bool CreateHeader(const tstring& strPath, Header& oHeader);
+
+	//! Hash samples of the content of a document.
+	static uint64 HashContent(const tstring& strPath, uint64 nFileSize);
+
+	//! Mark a snapshot as the most recently used.
+	static void Touch(const tstring& strSnapshot);
+};
+
+#endif // APP_SNAPSHOTCACHE_HPP
@@ -0,0 +1,943 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   StructuralDiff.cpp
+//! \brief  The StructuralDiff class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "StructuralDiff.hpp"
+#include <XML/ElementNode.hpp>
+#include <XML/TextNode.hpp>
+#include <XML/CDataNode.hpp>
+#include <XML/CommentNode.hpp>
+#include <XML/ProcessingNode.hpp>
+#include <XML/DocTypeNode.hpp>
+#include <algorithm>
+#include <map>
+#include <set>
+#include "NodeCursor.hpp"
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <thread>
+#endif
+
+//! The FNV-1a 64-bit offset basis.
+static const uint64 FNV_OFFSET_BASIS = 14695981039346656037ULL;
+
+//! The FNV-1a 64-bit prime.
+static const uint64 FNV_PRIME = 1099511628211ULL;
+
+//! The golden ratio constant used to spread the values being combined.
+static const uint64 GOLDEN_RATIO = 0x9E3779B97F4A7C15ULL;
+
+//! The largest table to align children by their longest common subsequence.
+static const size_t LCS_MAX_CELLS = 4 * 1024 * 1024;
+
+//! How far ahead to look for a child to pair an unmatched one with.
+static const size_t PAIR_LOOKAHEAD = 100;
+
+//! The marker for a child without a match.
+static const size_t NO_MATCH = static_cast<size_t>(-1);
+
+////////////////////////////////////////////////////////////////////////////////
+//! Scramble the bits of a hash so that similar inputs give unrelated values.
+
+static uint64 Mix(uint64 nHash)
+{
+	nHash ^= nHash >> 30;
+	nHash *= 0xBF58476D1CE4E5B9ULL;
+	nHash ^= nHash >> 27;
+	nHash *= 0x94D049BB133111EBULL;
+	nHash ^= nHash >> 31;
+
+	return nHash;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add a value to a hash, where the order the values are added in matters.
+
+static uint64 Combine(uint64 nHash, uint64 nValue)
+{
+	return Mix(nHash ^ (nValue + GOLDEN_RATIO + (nHash << 6) + (nHash >> 2)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Compute the FNV-1a hash of a string.
+
+static uint64 HashString(const tstring& str)
+{
+	uint64 nHash = FNV_OFFSET_BASIS;
+
+	for (tstring::const_iterator it = str.begin(); it != str.end(); ++it)
+		nHash = (nHash ^ static_cast<utchar>(*it)) * FNV_PRIME;
+
+	return Mix(nHash);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Compute the hash of a set of attributes. The attribute hashes are summed so
+//! that the order they were written in doesn't matter.
+
+static uint64 HashAttributes(const XML::Attributes& oAttribs)
+{
+	uint64 nHash = 0;
+
+	for (XML::Attributes::const_iterator it = oAttribs.begin(); it != oAttribs.end(); ++it)
+	{
+		const XML::AttributePtr& pAttrib = *it;
+
+		nHash += Combine(HashString(pAttrib->name()), HashString(pAttrib->value()));
+	}
+
+	return nHash;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if two sets of attributes are equal, in any order.
+
+static bool AttributesEqual(const XML::Attributes& oLeft, const XML::Attributes& oRight)
+{
+	if (oLeft.count() != oRight.count())
+		return false;
+
+	for (XML::Attributes::const_iterator it = oLeft.begin(); it != oLeft.end(); ++it)
+	{
+		XML::AttributePtr pOther = oRight.find((*it)->name());
+
+		if ( (pOther.get() == nullptr) || (pOther->value() != (*it)->value()) )
+			return false;
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the children of a node, if it can have any.
+
+static const XML::NodeContainer* Children(const XML::Node* pNode)
+{
+	return NodeCursor::Children(NodeRef(const_cast<XML::Node*>(pNode)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+StructuralDiff::StructuralDiff(size_t nThreads, const Names& vecKeyAttribs, size_t nMaxItems)
+	: m_nThreads(std::max<size_t>(nThreads, 1))
+	, m_vecKeyAttribs(vecKeyAttribs)
+	, m_nMaxItems(nMaxItems)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+StructuralDiff::~StructuralDiff()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Compare two documents. The differences are produced in preorder, with each
+//! pair of nodes that differ followed by their aligned children, which are
+//! walked with an explicit stack so that any depth of nesting can be compared.
+//! Identical sub-trees are never descended into and adjacent ones are merged
+//! into a single entry. Returns false if the entries were cut short.
+
+bool StructuralDiff::Compare(const XML::Document& oLeft, const XML::Document& oRight, Items& vecItems)
+{
+	vecItems.clear();
+
+	FingerprintDocument(oLeft, m_vecLeft);
+	FingerprintDocument(oRight, m_vecRight);
+
+	bool bComplete = true;
+
+	if (m_vecLeft.front().m_nHash != m_vecRight.front().m_nHash)
+	{
+		Side     oLeftDoc  = { &oLeft, 0 };
+		Side     oRightDoc = { &oRight, 0 };
+		DiffItem oRoot     = { DiffItem::CHILDREN_CHANGED, 0, &oLeft, &oRight, 1 };
+
+		vecItems.push_back(oRoot);
+
+		std::vector<Frame> vecStack(1);
+		size_t             nRunLeft  = 0;
+		size_t             nRunRight = 0;
+
+		vecStack.back().m_nNext  = 0;
+		vecStack.back().m_nDepth = 1;
+		AlignChildren(oLeftDoc, oRightDoc, vecStack.back().m_vecPairs);
+
+		while (!vecStack.empty())
+		{
+			Frame& oFrame = vecStack.back();
+
+			// Finished with the children?
+			if (oFrame.m_nNext == oFrame.m_vecPairs.size())
+			{
+				vecStack.pop_back();
+				continue;
+			}
+
+			if (vecItems.size() >= m_nMaxItems)
+			{
+				bComplete = false;
+				break;
+			}
+
+			const Pairing oPair  = oFrame.m_vecPairs[oFrame.m_nNext++];
+			const size_t  nDepth = oFrame.m_nDepth;
+			const Side&   oL     = oPair.m_oLeft;
+			const Side&   oR     = oPair.m_oRight;
+
+			if (oL.m_pNode == nullptr)
+			{
+				DiffItem oItem = { DiffItem::ADDED, nDepth, nullptr, oR.m_pNode, m_vecRight[oR.m_nIndex].m_nSize+1 };
+
+				vecItems.push_back(oItem);
+			}
+			else if (oR.m_pNode == nullptr)
+			{
+				DiffItem oItem = { DiffItem::REMOVED, nDepth, oL.m_pNode, nullptr, m_vecLeft[oL.m_nIndex].m_nSize+1 };
+
+				vecItems.push_back(oItem);
+			}
+			else if ( (oPair.m_nRun != 0) || (m_vecLeft[oL.m_nIndex].m_nHash == m_vecRight[oR.m_nIndex].m_nHash) )
+			{
+				size_t    nRun  = std::max<size_t>(oPair.m_nRun, 1);
+				DiffItem& oLast = vecItems.back();
+
+				// Extend the previous sibling's run, if it continues on both sides?
+				if ( (oLast.m_eType == DiffItem::IDENTICAL) && (oLast.m_nDepth == nDepth)
+				  && (oL.m_nIndex == nRunLeft) && (oR.m_nIndex == nRunRight) )
+				{
+					oLast.m_nCount += nRun;
+				}
+				else
+				{
+					DiffItem oItem = { DiffItem::IDENTICAL, nDepth, oL.m_pNode, oR.m_pNode, nRun };
+
+					vecItems.push_back(oItem);
+				}
+
+				nRunLeft  = oL.m_nIndex;
+				nRunRight = oR.m_nIndex;
+
+				for (size_t i = 0; i != nRun; ++i)
+				{
+					nRunLeft  += m_vecLeft[nRunLeft].m_nSize+1;
+					nRunRight += m_vecRight[nRunRight].m_nSize+1;
+				}
+			}
+			else
+			{
+				DiffItem::Type eType = NodesEqual(oL.m_pNode, oR.m_pNode) ? DiffItem::CHILDREN_CHANGED : DiffItem::CHANGED;
+				DiffItem       oItem = { eType, nDepth, oL.m_pNode, oR.m_pNode, 1 };
+
+				vecItems.push_back(oItem);
+
+				if ( (Children(oL.m_pNode) != nullptr) && (!ChildrenEqual(oL, oR)) )
+				{
+					vecStack.push_back(Frame());
+
+					vecStack.back().m_nNext  = 0;
+					vecStack.back().m_nDepth = nDepth+1;
+					AlignChildren(oL, oR, vecStack.back().m_vecPairs);
+				}
+			}
+		}
+	}
+
+	Fingerprints().swap(m_vecLeft);
+	Fingerprints().swap(m_vecRight);
+
+	return bComplete;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Compute the fingerprints of a document. The chain of single elements from
+//! the root is walked on the calling thread down to the first container with
+//! more than one child element, whose children are the records that are split
+//! across the threads. As the fingerprints only hold the relative size of each
+//! sub-tree, those of the records can simply be appended in order, and then the
+//! containers on the chain are completed on the way back up.
+
+void StructuralDiff::FingerprintDocument(const XML::Document& oDoc, Fingerprints& vecPrints)
+{
+	Nodes vecSpine(1, &oDoc);
+
+	// Descend to the first container without exactly one child element.
+	for (;;)
+	{
+		const XML::NodeContainer* pContainer = Children(vecSpine.back());
+		const XML::Node*          pOnly      = nullptr;
+		size_t                    nElements  = 0;
+
+		for (XML::NodeContainer::const_iterator it = pContainer->beginChild(); it != pContainer->endChild(); ++it)
+		{
+			if ((*it)->type() == XML::ELEMENT_NODE)
+			{
+				pOnly = it->get();
+				++nElements;
+			}
+		}
+
+		if (nElements != 1)
+			break;
+
+		vecSpine.push_back(pOnly);
+	}
+
+	const XML::NodeContainer* pRecords = Children(vecSpine.back());
+
+	for (XML::NodeContainer::const_iterator it = pRecords->beginChild(); it != pRecords->endChild(); ++it)
+		m_vecRecords.push_back(it->get());
+
+	RunWorkers(m_vecRecords.size());
+
+	size_t nTotal = vecSpine.size();
+
+	for (Workers::const_iterator it = m_vecWorkers.begin(); it != m_vecWorkers.end(); ++it)
+		nTotal += it->m_vecPrints.size();
+
+	vecPrints.clear();
+	vecPrints.reserve(nTotal);
+
+	std::vector<size_t> vecOpen;
+
+	// Add the chain and the children before the next link, then the records.
+	for (size_t i = 0; i != vecSpine.size(); ++i)
+	{
+		vecOpen.push_back(vecPrints.size());
+		AppendNode(vecSpine[i], vecPrints);
+
+		if (i+1 == vecSpine.size())
+		{
+			for (Workers::const_iterator it = m_vecWorkers.begin(); it != m_vecWorkers.end(); ++it)
+				vecPrints.insert(vecPrints.end(), it->m_vecPrints.begin(), it->m_vecPrints.end());
+
+			break;
+		}
+
+		const XML::NodeContainer* pContainer = Children(vecSpine[i]);
+
+		for (XML::NodeContainer::const_iterator it = pContainer->beginChild(); it->get() != vecSpine[i+1]; ++it)
+			AppendSubtree(it->get(), vecPrints);
+	}
+
+	// Add the children after each link and complete the chain, deepest first.
+	for (size_t i = vecSpine.size(); i-- != 0; )
+	{
+		if (i+1 != vecSpine.size())
+		{
+			const XML::NodeContainer*           pContainer = Children(vecSpine[i]);
+			XML::NodeContainer::const_iterator  it         = pContainer->beginChild();
+
+			while (it->get() != vecSpine[i+1])
+				++it;
+
+			for (++it; it != pContainer->endChild(); ++it)
+				AppendSubtree(it->get(), vecPrints);
+		}
+
+		CloseContainer(vecPrints, vecOpen[i]);
+	}
+
+	m_vecRecords.clear();
+	m_vecWorkers.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Split the records across the workers and run them. Each worker gets a
+//! contiguous range of the records and the calling thread takes the first.
+
+void StructuralDiff::RunWorkers(size_t nRecords)
+{
+	size_t nWorkers = std::max<size_t>(std::min(m_nThreads, nRecords), 1);
+
+	m_vecWorkers.resize(nWorkers);
+
+	for (size_t i = 0; i != nWorkers; ++i)
+	{
+		Worker& oWorker = m_vecWorkers[i];
+
+		oWorker.m_pDiff  = this;
+		oWorker.m_nBegin = (nRecords * i) / nWorkers;
+		oWorker.m_nEnd   = (nRecords * (i+1)) / nWorkers;
+		oWorker.m_bDone  = false;
+	}
+
+#ifdef _WIN32
+	std::vector<HANDLE> vecThreads;
+
+	for (size_t i = 1; i != nWorkers; ++i)
+	{
+		HANDLE hThread = reinterpret_cast<HANDLE>(_beginthreadex(NULL, 0, ThreadProc, &m_vecWorkers[i], 0, NULL));
+
+		if (hThread == NULL)
+			break;
+
+		vecThreads.push_back(hThread);
+	}
+
+	ThreadProc(&m_vecWorkers.front());
+
+	for (std::vector<HANDLE>::const_iterator it = vecThreads.begin(); it != vecThreads.end(); ++it)
+	{
+		::WaitForSingleObject(*it, INFINITE);
+		::CloseHandle(*it);
+	}
+#else
+	std::vector<std::thread> vecThreads;
+
+	try
+	{
+		for (size_t i = 1; i != nWorkers; ++i)
+			vecThreads.push_back(std::thread(ThreadProc, &m_vecWorkers[i]));
+	}
+	catch (const std::exception&)
+	{
+		// Run on the calling thread.
+	}
+
+	ThreadProc(&m_vecWorkers.front());
+
+	for (std::vector<std::thread>::iterator it = vecThreads.begin(); it != vecThreads.end(); ++it)
+		it->join();
+#endif
+
+	for (Workers::iterator it = m_vecWorkers.begin(); it != m_vecWorkers.end(); ++it)
+	{
+		if (!it->m_bDone)
+			FingerprintRecords(*it);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Compute the fingerprints of a worker's share of the records.
+
+void StructuralDiff::FingerprintRecords(Worker& oWorker)
+{
+	oWorker.m_vecPrints.clear();
+
+	for (size_t i = oWorker.m_nBegin; i != oWorker.m_nEnd; ++i)
+		AppendSubtree(m_vecRecords[i], oWorker.m_vecPrints);
+
+	oWorker.m_bDone = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Align the children of two nodes that differ. The runs of identical children
+//! at either end are skipped first, as when comparing two versions of the same
+//! document that is usually nearly all of them.
+
+void StructuralDiff::AlignChildren(const Side& oLeft, const Side& oRight, Pairings& vecPairs) const
+{
+	Sides vecLeft;
+	Sides vecRight;
+
+	GetChildren(oLeft, m_vecLeft, vecLeft);
+	GetChildren(oRight, m_vecRight, vecRight);
+
+	size_t nLeft   = vecLeft.size();
+	size_t nRight  = vecRight.size();
+	size_t nPrefix = 0;
+	size_t nSuffix = 0;
+
+	while ( (nPrefix != nLeft) && (nPrefix != nRight)
+		 && (m_vecLeft[vecLeft[nPrefix].m_nIndex].m_nHash == m_vecRight[vecRight[nPrefix].m_nIndex].m_nHash) )
+	{
+		++nPrefix;
+	}
+
+	while ( (nSuffix != nLeft-nPrefix) && (nSuffix != nRight-nPrefix)
+		 && (m_vecLeft[vecLeft[nLeft-nSuffix-1].m_nIndex].m_nHash == m_vecRight[vecRight[nRight-nSuffix-1].m_nIndex].m_nHash) )
+	{
+		++nSuffix;
+	}
+
+	if (nPrefix != 0)
+		vecPairs.push_back(MakePair(vecLeft.front(), vecRight.front(), nPrefix));
+
+	Sides vecLeftRest(vecLeft.begin()+nPrefix, vecLeft.end()-nSuffix);
+	Sides vecRightRest(vecRight.begin()+nPrefix, vecRight.end()-nSuffix);
+
+	if (!AlignByKey(vecLeftRest, vecRightRest, vecPairs))
+		AlignBySequence(vecLeftRest, vecRightRest, vecPairs);
+
+	if (nSuffix != 0)
+		vecPairs.push_back(MakePair(vecLeft[nLeft-nSuffix], vecRight[nRight-nSuffix], nSuffix));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Align the children by a key attribute. This is only possible if they are all
+//! elements and each one has a key that is unique on its side. The children are
+//! listed in the order of the right document, with each unmatched left child
+//! placed before the next matched one that followed it.
+
+bool StructuralDiff::AlignByKey(const Sides& vecLeft, const Sides& vecRight, Pairings& vecPairs) const
+{
+	if ( (m_vecKeyAttribs.empty()) || (vecLeft.empty()) || (vecRight.empty()) )
+		return false;
+
+	typedef std::map<tstring, size_t> KeyIndex;
+
+	KeyIndex mapRight;
+	tstring  strKey;
+
+	for (size_t j = 0; j != vecRight.size(); ++j)
+	{
+		if ( (!GetKey(vecRight[j].m_pNode, strKey)) || (!mapRight.insert(std::make_pair(strKey, j)).second) )
+			return false;
+	}
+
+	std::set<tstring>   setLeft;
+	std::vector<size_t> vecMatches(vecRight.size(), NO_MATCH);
+	std::vector<bool>   vecMatched(vecLeft.size(), false);
+
+	for (size_t i = 0; i != vecLeft.size(); ++i)
+	{
+		if ( (!GetKey(vecLeft[i].m_pNode, strKey)) || (!setLeft.insert(strKey).second) )
+			return false;
+
+		KeyIndex::const_iterator it = mapRight.find(strKey);
+
+		if (it != mapRight.end())
+		{
+			vecMatches[it->second] = i;
+			vecMatched[i] = true;
+		}
+	}
+
+	Side   oNone = { nullptr, 0 };
+	size_t nNext = 0;
+
+	for (size_t j = 0; j != vecRight.size(); ++j)
+	{
+		size_t i = vecMatches[j];
+
+		if (i == NO_MATCH)
+		{
+			vecPairs.push_back(MakePair(oNone, vecRight[j], 0));
+			continue;
+		}
+
+		for (; nNext < i; ++nNext)
+		{
+			if (!vecMatched[nNext])
+				vecPairs.push_back(MakePair(vecLeft[nNext], oNone, 0));
+		}
+
+		nNext = std::max(nNext, i+1);
+
+		vecPairs.push_back(MakePair(vecLeft[i], vecRight[j], 0));
+	}
+
+	for (; nNext < vecLeft.size(); ++nNext)
+	{
+		if (!vecMatched[nNext])
+			vecPairs.push_back(MakePair(vecLeft[nNext], oNone, 0));
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Align the children by the longest common subsequence of their fingerprints.
+//! If there are too many to build the table for, identical children are matched
+//! greedily in order instead. The children left between the matches are then
+//! paired up where possible.
+
+void StructuralDiff::AlignBySequence(const Sides& vecLeft, const Sides& vecRight, Pairings& vecPairs) const
+{
+	typedef std::pair<size_t, size_t> Match;
+
+	size_t             nLeft  = vecLeft.size();
+	size_t             nRight = vecRight.size();
+	std::vector<Match> vecMatches;
+
+	if ( (nLeft == 0) || (nRight == 0) )
+	{
+		// Nothing to match.
+	}
+	else if ((nLeft+1) <= (LCS_MAX_CELLS / (nRight+1)))
+	{
+		size_t              nWidth = nRight+1;
+		std::vector<uint32> vecLengths((nLeft+1) * nWidth, 0);
+
+		// Build the table of the longest subsequence from each pair onwards.
+		for (size_t i = nLeft; i-- != 0; )
+		{
+			uint64 nHash = m_vecLeft[vecLeft[i].m_nIndex].m_nHash;
+
+			for (size_t j = nRight; j-- != 0; )
+			{
+				if (nHash == m_vecRight[vecRight[j].m_nIndex].m_nHash)
+					vecLengths[i*nWidth + j] = vecLengths[(i+1)*nWidth + (j+1)] + 1;
+				else
+					vecLengths[i*nWidth + j] = std::max(vecLengths[(i+1)*nWidth + j], vecLengths[i*nWidth + (j+1)]);
+			}
+		}
+
+		for (size_t i = 0, j = 0; (i != nLeft) && (j != nRight); )
+		{
+			if (m_vecLeft[vecLeft[i].m_nIndex].m_nHash == m_vecRight[vecRight[j].m_nIndex].m_nHash)
+				vecMatches.push_back(Match(i++, j++));
+			else if (vecLengths[(i+1)*nWidth + j] >= vecLengths[i*nWidth + (j+1)])
+				++i;
+			else
+				++j;
+		}
+	}
+	else
+	{
+		typedef std::pair<uint64, size_t> HashIndex;
+
+		std::vector<HashIndex> vecRightIndex;
+
+		vecRightIndex.reserve(nRight);
+
+		for (size_t j = 0; j != nRight; ++j)
+			vecRightIndex.push_back(HashIndex(m_vecRight[vecRight[j].m_nIndex].m_nHash, j));
+
+		std::sort(vecRightIndex.begin(), vecRightIndex.end());
+
+		size_t nNext = 0;
+
+		// Match each left child with the next identical right one.
+		for (size_t i = 0; (i != nLeft) && (nNext != nRight); ++i)
+		{
+			uint64 nHash = m_vecLeft[vecLeft[i].m_nIndex].m_nHash;
+
+			std::vector<HashIndex>::const_iterator it = std::lower_bound(vecRightIndex.begin(), vecRightIndex.end(), HashIndex(nHash, nNext));
+
+			if ( (it != vecRightIndex.end()) && (it->first == nHash) )
+			{
+				vecMatches.push_back(Match(i, it->second));
+				nNext = it->second + 1;
+			}
+		}
+	}
+
+	size_t nNextLeft  = 0;
+	size_t nNextRight = 0;
+
+	for (std::vector<Match>::const_iterator it = vecMatches.begin(); it != vecMatches.end(); ++it)
+	{
+		PairUnmatched(vecLeft, nNextLeft, it->first, vecRight, nNextRight, it->second, vecPairs);
+
+		vecPairs.push_back(MakePair(vecLeft[it->first], vecRight[it->second], 0));
+
+		nNextLeft  = it->first+1;
+		nNextRight = it->second+1;
+	}
+
+	PairUnmatched(vecLeft, nNextLeft, nLeft, vecRight, nNextRight, nRight, vecPairs);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Pair up the unmatched children of the same kind and name, in order, so that
+//! a changed child is compared rather than shown as removed and added. Only a
+//! limited number of children ahead are searched for a partner.
+
+void StructuralDiff::PairUnmatched(const Sides& vecLeft, size_t nLeftBegin, size_t nLeftEnd,
+									const Sides& vecRight, size_t nRightBegin, size_t nRightEnd, Pairings& vecPairs)
+{
+	Side   oNone = { nullptr, 0 };
+	size_t j     = nRightBegin;
+
+	for (size_t i = nLeftBegin; i != nLeftEnd; ++i)
+	{
+		size_t nLast = std::min(nRightEnd, j + PAIR_LOOKAHEAD);
+		size_t k     = j;
+
+		while ( (k != nLast) && (!CanPair(vecLeft[i].m_pNode, vecRight[k].m_pNode)) )
+			++k;
+
+		if (k == nLast)
+		{
+			vecPairs.push_back(MakePair(vecLeft[i], oNone, 0));
+			continue;
+		}
+
+		for (; j != k; ++j)
+			vecPairs.push_back(MakePair(oNone, vecRight[j], 0));
+
+		vecPairs.push_back(MakePair(vecLeft[i], vecRight[k], 0));
+		j = k+1;
+	}
+
+	for (; j != nRightEnd; ++j)
+		vecPairs.push_back(MakePair(oNone, vecRight[j], 0));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the key of an element, which is its name and the value of the first of
+//! the key attributes it has.
+
+bool StructuralDiff::GetKey(const XML::Node* pNode, tstring& strKey) const
+{
+	if (pNode->type() != XML::ELEMENT_NODE)
+		return false;
+
+	const XML::ElementNode* pElement = static_cast<const XML::ElementNode*>(pNode);
+
+	for (Names::const_iterator it = m_vecKeyAttribs.begin(); it != m_vecKeyAttribs.end(); ++it)
+	{
+		XML::AttributePtr pAttrib = pElement->getAttributes().find(*it);
+
+		if (pAttrib.get() != nullptr)
+		{
+			strKey = pElement->name() + TXT(' ') + *it + TXT('=') + pAttrib->value();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the children of a node and the indices of their fingerprints.
+
+void StructuralDiff::GetChildren(const Side& oParent, const Fingerprints& vecPrints, Sides& vecChildren)
+{
+	const XML::NodeContainer* pContainer = Children(oParent.m_pNode);
+
+	if (pContainer == nullptr)
+		return;
+
+	vecChildren.reserve(pContainer->getChildCount());
+
+	size_t nIndex = oParent.m_nIndex+1;
+
+	for (XML::NodeContainer::const_iterator it = pContainer->beginChild(); it != pContainer->endChild(); ++it)
+	{
+		Side oChild = { it->get(), nIndex };
+
+		vecChildren.push_back(oChild);
+
+		nIndex += vecPrints[nIndex].m_nSize+1;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the children of two nodes are identical.
+
+bool StructuralDiff::ChildrenEqual(const Side& oLeft, const Side& oRight) const
+{
+	if (Children(oLeft.m_pNode)->getChildCount() != Children(oRight.m_pNode)->getChildCount())
+		return false;
+
+	size_t nEnd   = oLeft.m_nIndex + m_vecLeft[oLeft.m_nIndex].m_nSize + 1;
+	size_t nLeft  = oLeft.m_nIndex+1;
+	size_t nRight = oRight.m_nIndex+1;
+
+	for (; nLeft != nEnd; nLeft += m_vecLeft[nLeft].m_nSize+1, nRight += m_vecRight[nRight].m_nSize+1)
+	{
+		if (m_vecLeft[nLeft].m_nHash != m_vecRight[nRight].m_nHash)
+			return false;
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add a node's sub-tree to the fingerprints. The containers still open are
+//! held by depth and are completed once the walk moves back above them.
+
+void StructuralDiff::AppendSubtree(const XML::Node* pNode, Fingerprints& vecPrints)
+{
+	size_t nRoot = vecPrints.size();
+
+	AppendNode(pNode, vecPrints);
+
+	const XML::NodeContainer* pChildren = Children(pNode);
+
+	if (pChildren == nullptr)
+		return;
+
+	std::vector<size_t> vecOpen(1, nRoot);
+
+	for (NodeCursor oCursor(*pChildren); oCursor.Next(); )
+	{
+		NodeRef pChild = oCursor.Node();
+
+		while (vecOpen.size() > oCursor.Depth())
+		{
+			CloseContainer(vecPrints, vecOpen.back());
+			vecOpen.pop_back();
+		}
+
+		if (NodeCursor::Children(pChild) != nullptr)
+			vecOpen.push_back(vecPrints.size());
+
+		AppendNode(pChild.get(), vecPrints);
+	}
+
+	while (!vecOpen.empty())
+	{
+		CloseContainer(vecPrints, vecOpen.back());
+		vecOpen.pop_back();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add a node to the fingerprints, with the hash of only its own content.
+
+void StructuralDiff::AppendNode(const XML::Node* pNode, Fingerprints& vecPrints)
+{
+	Fingerprint oPrint = { HashNode(pNode), 0 };
+
+	vecPrints.push_back(oPrint);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Complete the fingerprint of a container from those of its children, which
+//! are all of the entries that follow it.
+
+void StructuralDiff::CloseContainer(Fingerprints& vecPrints, size_t nIndex)
+{
+	size_t nEnd  = vecPrints.size();
+	uint64 nHash = vecPrints[nIndex].m_nHash;
+
+	for (size_t i = nIndex+1; i != nEnd; i += vecPrints[i].m_nSize+1)
+		nHash = Combine(nHash, vecPrints[i].m_nHash);
+
+	vecPrints[nIndex].m_nHash = nHash;
+	vecPrints[nIndex].m_nSize = nEnd - nIndex - 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Compute the hash of a node's own content, excluding its children.
+
+uint64 StructuralDiff::HashNode(const XML::Node* pNode)
+{
+	XML::NodeType eType = pNode->type();
+	uint64        nHash = Mix(static_cast<uint64>(eType) + 1);
+
+	if (eType == XML::ELEMENT_NODE)
+	{
+		const XML::ElementNode* pElement = static_cast<const XML::ElementNode*>(pNode);
+
+		nHash = Combine(nHash, HashString(pElement->name()));
+		nHash = Combine(nHash, HashAttributes(pElement->getAttributes()));
+	}
+	else if (eType == XML::TEXT_NODE)
+	{
+		nHash = Combine(nHash, HashString(static_cast<const XML::TextNode*>(pNode)->text()));
+	}
+	else if (eType == XML::CDATA_NODE)
+	{
+		nHash = Combine(nHash, HashString(static_cast<const XML::CDataNode*>(pNode)->text()));
+	}
+	else if (eType == XML::COMMENT_NODE)
+	{
+		nHash = Combine(nHash, HashString(static_cast<const XML::CommentNode*>(pNode)->comment()));
+	}
+	else if (eType == XML::PROCESSING_NODE)
+	{
+		const XML::ProcessingNode* pPI = static_cast<const XML::ProcessingNode*>(pNode);
+
+		nHash = Combine(nHash, HashString(pPI->target()));
+		nHash = Combine(nHash, HashAttributes(pPI->getAttributes()));
+	}
+	else if (eType == XML::DOCTYPE_NODE)
+	{
+		nHash = Combine(nHash, HashString(static_cast<const XML::DocTypeNode*>(pNode)->declaration()));
+	}
+
+	return nHash;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the own content of two nodes of the same kind is equal.
+
+bool StructuralDiff::NodesEqual(const XML::Node* pLeft, const XML::Node* pRight)
+{
+	XML::NodeType eType = pLeft->type();
+
+	ASSERT(eType == pRight->type());
+
+	if (eType == XML::ELEMENT_NODE)
+	{
+		const XML::ElementNode* pLeftElement  = static_cast<const XML::ElementNode*>(pLeft);
+		const XML::ElementNode* pRightElement = static_cast<const XML::ElementNode*>(pRight);
+
+		return ( (pLeftElement->name() == pRightElement->name())
+			  && (AttributesEqual(pLeftElement->getAttributes(), pRightElement->getAttributes())) );
+	}
+	else if (eType == XML::TEXT_NODE)
+	{
+		return (static_cast<const XML::TextNode*>(pLeft)->text() == static_cast<const XML::TextNode*>(pRight)->text());
+	}
+	else if (eType == XML::CDATA_NODE)
+	{
+		return (static_cast<const XML::CDataNode*>(pLeft)->text() == static_cast<const XML::CDataNode*>(pRight)->text());
+	}
+	else if (eType == XML::COMMENT_NODE)
+	{
+		return (static_cast<const XML::CommentNode*>(pLeft)->comment() == static_cast<const XML::CommentNode*>(pRight)->comment());
+	}
+	else if (eType == XML::PROCESSING_NODE)
+	{
+		const XML::ProcessingNode* pLeftPI  = static_cast<const XML::ProcessingNode*>(pLeft);
+		const XML::ProcessingNode* pRightPI = static_cast<const XML::ProcessingNode*>(pRight);
+
+		return ( (pLeftPI->target() == pRightPI->target())
+			  && (AttributesEqual(pLeftPI->getAttributes(), pRightPI->getAttributes())) );
+	}
+	else if (eType == XML::DOCTYPE_NODE)
+	{
+		return (static_cast<const XML::DocTypeNode*>(pLeft)->declaration() == static_cast<const XML::DocTypeNode*>(pRight)->declaration());
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if two nodes can be paired up, i.e. they are the same kind of node
+//! and, for elements and processing instructions, have the same name.
+
+bool StructuralDiff::CanPair(const XML::Node* pLeft, const XML::Node* pRight)
+{
+	XML::NodeType eType = pLeft->type();
+
+	if (eType != pRight->type())
+		return false;
+
+	if (eType == XML::ELEMENT_NODE)
+		return (static_cast<const XML::ElementNode*>(pLeft)->name() == static_cast<const XML::ElementNode*>(pRight)->name());
+	else if (eType == XML::PROCESSING_NODE)
+		return (static_cast<const XML::ProcessingNode*>(pLeft)->target() == static_cast<const XML::ProcessingNode*>(pRight)->target());
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Create a pairing of two nodes.
+
+StructuralDiff::Pairing StructuralDiff::MakePair(const Side& oLeft, const Side& oRight, size_t nRun)
+{
+	Pairing oPair = { oLeft, oRight, nRun };
+
+	return oPair;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The worker thread function.
+
+unsigned __stdcall StructuralDiff::ThreadProc(void* pParam)
+{
+	Worker* pWorker = static_cast<Worker*>(pParam);
+
+	try
+	{
+		pWorker->m_pDiff->FingerprintRecords(*pWorker);
+	}
+	catch (const std::exception&)
+	{
+		// Redone on the calling thread.
+	}
+
+	return 0;
+}
@@ -0,0 +1,210 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   StructuralDiff.hpp
+//! \brief  The StructuralDiff class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_STRUCTURALDIFF_HPP
+#define APP_STRUCTURALDIFF_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <XML/Document.hpp>
+
+////////////////////////////////////////////////////////////////////////////////
+//! A single entry in the differences between two documents. The entries are
+//! held in preorder with their depth, so that they form a tree of the nodes on
+//! the paths to the differences.
+
+struct DiffItem
+{
+	//! The kinds of entry.
+	enum Type
+	{
+		IDENTICAL,			//!< A run of identical sibling sub-trees.
+		CHANGED,			//!< The node's value or attributes differ.
+		CHILDREN_CHANGED,	//!< Only the node's descendants differ.
+		ADDED,				//!< The sub-tree is only in the right document.
+		REMOVED,			//!< The sub-tree is only in the left document.
+	};
+
+	Type				m_eType;	//!< The kind of entry.
+	size_t				m_nDepth;	//!< The depth, where the documents are at 0.
+	const XML::Node*	m_pLeft;	//!< The node in the left document, if any.
+	const XML::Node*	m_pRight;	//!< The node in the right document, if any.
+	size_t				m_nCount;	//!< The siblings in a run or nodes in a sub-tree.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Compares the structure of two documents. Every sub-tree is first given a
+//! fingerprint, a hash of its own content and the fingerprints of its children,
+//! so that two identical sub-trees can be skipped by comparing a single value.
+//! The fingerprints are computed on multiple threads by splitting the records
+//! in the same way as the StructureAnalyser. Where two sub-trees differ their
+//! children are aligned by first skipping the identical ones at either end and
+//! then matching the rest by a key attribute, if they all have a unique one,
+//! or else by the longest common subsequence of their fingerprints. Unmatched
+//! children of the same kind and name are then paired up and compared in turn.
+
+class StructuralDiff : private Core::NotCopyable
+{
+public:
+	//! The differences between two documents.
+	typedef std::vector<DiffItem> Items;
+	//! A list of attribute names.
+	typedef std::vector<tstring> Names;
+
+	//! Constructor.
+	StructuralDiff(size_t nThreads, const Names& vecKeyAttribs, size_t nMaxItems);
+
+	//! Destructor.
+	~StructuralDiff();
+
+	//
+	// Methods.
+	//
+
+	//! Compare two documents, returning false if there were too many differences.
+	bool Compare(const XML::Document& oLeft, const XML::Document& oRight, Items& vecItems);
+
+private:
+	////////////////////////////////////////////////////////////////////////////
+	//! The fingerprint of a node's sub-tree.
+
+	struct Fingerprint
+	{
+		uint64	m_nHash;	//!< The hash of the sub-tree.
+		size_t	m_nSize;	//!< The number of nodes below it.
+	};
+
+	//! The fingerprints of a document in preorder. The children of the node at
+	//! an index start at the next one and are each followed by their own nodes.
+	typedef std::vector<Fingerprint> Fingerprints;
+	//! A collection of nodes.
+	typedef std::vector<const XML::Node*> Nodes;
+
+	////////////////////////////////////////////////////////////////////////////
+	//! A thread's share of the records and their fingerprints.
+
+	struct Worker
+	{
+		StructuralDiff*	m_pDiff;	//!< The diff.
+		size_t			m_nBegin;	//!< The first record.
+		size_t			m_nEnd;		//!< The end of the records.
+		Fingerprints	m_vecPrints;	//!< The fingerprints of the records.
+		bool			m_bDone;	//!< Have the records been fingerprinted?
+	};
+
+	//! The collection of workers.
+	typedef std::vector<Worker> Workers;
+
+	////////////////////////////////////////////////////////////////////////////
+	//! A node and the index of its fingerprint.
+
+	struct Side
+	{
+		const XML::Node*	m_pNode;	//!< The node, if any.
+		size_t				m_nIndex;	//!< The index of its fingerprint.
+	};
+
+	//! The children of a node.
+	typedef std::vector<Side> Sides;
+
+	////////////////////////////////////////////////////////////////////////////
+	//! A pair of aligned nodes, where either may be missing, or the first of a
+	//! run of identical siblings.
+
+	struct Pairing
+	{
+		Side	m_oLeft;	//!< The left node.
+		Side	m_oRight;	//!< The right node.
+		size_t	m_nRun;		//!< The length of a run of identical siblings.
+	};
+
+	//! A collection of aligned nodes.
+	typedef std::vector<Pairing> Pairings;
+
+	////////////////////////////////////////////////////////////////////////////
+	//! The aligned children of a pair still to be turned into entries.
+
+	struct Frame
+	{
+		Pairings	m_vecPairs;	//!< The aligned children.
+		size_t		m_nNext;	//!< The next child.
+		size_t		m_nDepth;	//!< The depth of the children.
+	};
+
+	//
+	// Members.
+	//
+	size_t			m_nThreads;		//!< The number of threads to use.
+	Names			m_vecKeyAttribs;	//!< The attributes that identify elements.
+	size_t			m_nMaxItems;	//!< The most entries to produce.
+	Nodes			m_vecRecords;	//!< The records being fingerprinted.
+	Workers			m_vecWorkers;	//!< The threads' shares of the records.
+	Fingerprints	m_vecLeft;		//!< The fingerprints of the left document.
+	Fingerprints	m_vecRight;		//!< The fingerprints of the right document.
+
+	//
+	// Internal methods.
+	//
+
+	//! Compute the fingerprints of a document.
+	void FingerprintDocument(const XML::Document& oDoc, Fingerprints& vecPrints);
+
+	//! Split the records across the workers and run them.
+	void RunWorkers(size_t nRecords);
+
+	//! Compute the fingerprints of a worker's share of the records.
+	void FingerprintRecords(Worker& oWorker);
+
+	//! Align the children of two nodes that differ.
+	void AlignChildren(const Side& oLeft, const Side& oRight, Pairings& vecPairs) const;
+
+	//! Align the children by a unique key attribute, if they all have one.
+	bool AlignByKey(const Sides& vecLeft, const Sides& vecRight, Pairings& vecPairs) const;
+
+	//! Align the children by the longest common subsequence of fingerprints.
+	void AlignBySequence(const Sides& vecLeft, const Sides& vecRight, Pairings& vecPairs) const;
+
+	//! Pair up the unmatched children of the same kind and name.
+	static void PairUnmatched(const Sides& vecLeft, size_t nLeftBegin, size_t nLeftEnd,
+								const Sides& vecRight, size_t nRightBegin, size_t nRightEnd, Pairings& vecPairs);
+
+	//! Get the key of an element, if it has a key attribute.
+	bool GetKey(const XML::Node* pNode, tstring& strKey) const;
+
+	//! Get the children of a node and the indices of their fingerprints.
+	static void GetChildren(const Side& oParent, const Fingerprints& vecPrints, Sides& vecChildren);
+
+	//! Query if the children of two nodes are identical.
+	bool ChildrenEqual(const Side& oLeft, const Side& oRight) const;
+
+	//! Add a node's sub-tree to the fingerprints.
+	static void AppendSubtree(const XML::Node* pNode, Fingerprints& vecPrints);
+
+	//! Add a node to the fingerprints, with the hash of only its own content.
+	static void AppendNode(const XML::Node* pNode, Fingerprints& vecPrints);
+
+	//! Complete the fingerprint of a container from those of its children.
+	static void CloseContainer(Fingerprints& vecPrints, size_t nIndex);
+
+	//! Compute the hash of a node's own content.
+	static uint64 HashNode(const XML::Node* pNode);
+
+	//! Query if the own content of two nodes of the same kind is equal.
+	static bool NodesEqual(const XML::Node* pLeft, const XML::Node* pRight);
+
+	//! Query if two nodes can be paired up.
+	static bool CanPair(const XML::Node* pLeft, const XML::Node* pRight);
+
+	//! Create a pairing of two nodes.
+	static Pairing MakePair(const Side& oLeft, const Side& oRight, size_t nRun);
+
+	//! The worker thread function.
+	static unsigned __stdcall ThreadProc(void* pParam);
+};
+
+#endif // APP_STRUCTURALDIFF_HPP
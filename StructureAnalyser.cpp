@@ -0,0 +1,761 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   StructureAnalyser.cpp
+//! \brief  The StructureAnalyser class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "StructureAnalyser.hpp"
+#include <XML/TextNode.hpp>
+#include <XML/CDataNode.hpp>
+#include <algorithm>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <thread>
+#endif
+
+// The characters that are whitespace in a document.
+static const tchar WHITESPACE[] = TXT(" \t\r\n");
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if a character is a decimal digit.
+
+static bool IsDigit(tchar cChar)
+{
+	return ( (cChar >= TXT('0')) && (cChar <= TXT('9')) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Skip a run of digits, returning how many there were.
+
+static size_t SkipDigits(const tchar*& pszPos, const tchar* pszEnd)
+{
+	const tchar* pszBegin = pszPos;
+
+	while ( (pszPos != pszEnd) && (IsDigit(*pszPos)) )
+		++pszPos;
+
+	return (pszPos - pszBegin);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Match an exact number of digits followed by a separator, if one is given.
+
+static bool MatchDigits(const tchar*& pszPos, const tchar* pszEnd, size_t nDigits, tchar cSeparator)
+{
+	if (SkipDigits(pszPos, pszEnd) != nDigits)
+		return false;
+
+	if (cSeparator == TXT('\0'))
+		return true;
+
+	if ( (pszPos == pszEnd) || (*pszPos != cSeparator) )
+		return false;
+
+	++pszPos;
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if a range of characters is a whole word.
+
+static bool MatchWord(const tchar* pszBegin, const tchar* pszEnd, const tchar* pszWord)
+{
+	size_t nLength = tstrlen(pszWord);
+
+	return ( (static_cast<size_t>(pszEnd - pszBegin) == nLength) && (std::equal(pszBegin, pszEnd, pszWord)) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Match a number, returning the kind of number or 0 if it isn't one.
+
+static uint MatchNumber(const tchar* pszPos, const tchar* pszEnd)
+{
+	uint nType = StructureAnalyser::INTEGER_VALUE;
+
+	if ( (*pszPos == TXT('-')) || (*pszPos == TXT('+')) )
+		++pszPos;
+
+	size_t nDigits = SkipDigits(pszPos, pszEnd);
+
+	if ( (pszPos != pszEnd) && (*pszPos == TXT('.')) )
+	{
+		++pszPos;
+		nDigits += SkipDigits(pszPos, pszEnd);
+		nType = StructureAnalyser::DECIMAL_VALUE;
+	}
+
+	if (nDigits == 0)
+		return 0;
+
+	if ( (pszPos != pszEnd) && ((*pszPos == TXT('e')) || (*pszPos == TXT('E'))) )
+	{
+		++pszPos;
+
+		if ( (pszPos != pszEnd) && ((*pszPos == TXT('-')) || (*pszPos == TXT('+'))) )
+			++pszPos;
+
+		if (SkipDigits(pszPos, pszEnd) == 0)
+			return 0;
+
+		nType = StructureAnalyser::DECIMAL_VALUE;
+	}
+
+	return (pszPos == pszEnd) ? nType : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Match an ISO 8601 date, optionally followed by a time and time zone,
+//! returning the kind of date or 0 if it isn't one.
+
+static uint MatchDate(const tchar* pszPos, const tchar* pszEnd)
+{
+	if ( (!MatchDigits(pszPos, pszEnd, 4, TXT('-'))) || (!MatchDigits(pszPos, pszEnd, 2, TXT('-')))
+	  || (!MatchDigits(pszPos, pszEnd, 2, TXT('\0'))) )
+		return 0;
+
+	if (pszPos == pszEnd)
+		return StructureAnalyser::DATE_VALUE;
+
+	if ( (*pszPos++ != TXT('T')) || (!MatchDigits(pszPos, pszEnd, 2, TXT(':')))
+	  || (!MatchDigits(pszPos, pszEnd, 2, TXT('\0'))) )
+		return 0;
+
+	if ( (pszPos != pszEnd) && (*pszPos == TXT(':')) )
+	{
+		++pszPos;
+
+		if (!MatchDigits(pszPos, pszEnd, 2, TXT('\0')))
+			return 0;
+
+		if ( (pszPos != pszEnd) && (*pszPos == TXT('.')) )
+		{
+			++pszPos;
+
+			if (SkipDigits(pszPos, pszEnd) == 0)
+				return 0;
+		}
+	}
+
+	if ( (pszPos != pszEnd) && (*pszPos == TXT('Z')) )
+	{
+		++pszPos;
+	}
+	else if ( (pszPos != pszEnd) && ((*pszPos == TXT('+')) || (*pszPos == TXT('-'))) )
+	{
+		++pszPos;
+
+		if ( (!MatchDigits(pszPos, pszEnd, 2, TXT(':'))) || (!MatchDigits(pszPos, pszEnd, 2, TXT('\0'))) )
+			return 0;
+	}
+
+	return (pszPos == pszEnd) ? StructureAnalyser::DATETIME_VALUE : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+StructureAnalyser::StructureAnalyser(size_t nThreads)
+	: m_nThreads(std::max<size_t>(nThreads, 1))
+	, m_pCompact(nullptr)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+StructureAnalyser::~StructureAnalyser()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Summarise the structure of a document. The elements above the records, i.e.
+//! the chain of single elements from the root, are tallied on the calling
+//! thread and the records below them are split across the threads.
+
+void StructureAnalyser::Analyse(const XML::Document& oDoc, Summary& vecSummary)
+{
+	PathTree vecSpine(1, NewTally(0, TXT("")));
+	Names    vecPrefix;
+	size_t   nPath = 0;
+	Elements vecChildren;
+
+	for (XML::NodeContainer::const_iterator it = oDoc.beginChild(); it != oDoc.endChild(); ++it)
+	{
+		if ((*it)->type() == XML::ELEMENT_NODE)
+			vecChildren.push_back(static_cast<const XML::ElementNode*>(it->get()));
+	}
+
+	// Descend to the first element with more than one child element.
+	while (vecChildren.size() == 1)
+	{
+		const XML::ElementNode* pElement = vecChildren.front();
+
+		nPath = ChildPath(vecSpine, nPath, pElement->name());
+		vecPrefix.push_back(pElement->name());
+
+		vecChildren.clear();
+		TallyElement(vecSpine, nPath, *pElement, &vecChildren);
+	}
+
+	m_pCompact = nullptr;
+	m_vecRecords.swap(vecChildren);
+
+	RunWorkers(m_vecRecords.size());
+
+	Tallies mapTallies;
+
+	MergeTree(vecSpine, Names(), mapTallies);
+
+	for (Workers::const_iterator it = m_vecWorkers.begin(); it != m_vecWorkers.end(); ++it)
+		MergeTree(it->m_vecPaths, vecPrefix, mapTallies);
+
+	MakeSummary(mapTallies, vecSummary);
+
+	m_vecRecords.clear();
+	m_vecWorkers.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Summarise the structure of a compact document. The document is split in the
+//! same way as a DOM.
+
+void StructureAnalyser::Analyse(const CompactDoc& oDoc, Summary& vecSummary)
+{
+	PathTree                vecSpine(1, NewTally(0, TXT("")));
+	Names                   vecPrefix;
+	size_t                  nPath = 0;
+	CompactDoc::NodeIndices vecChildren;
+
+	for (CompactDoc::NodeIndex nNode = oDoc.FirstChild(CompactDoc::DOCUMENT); nNode != CompactDoc::NO_NODE;
+			nNode = oDoc.NextSibling(nNode))
+	{
+		if (oDoc.Type(nNode) == XML::ELEMENT_NODE)
+			vecChildren.push_back(nNode);
+	}
+
+	// Descend to the first element with more than one child element.
+	while (vecChildren.size() == 1)
+	{
+		CompactDoc::NodeIndex nElement = vecChildren.front();
+
+		nPath = ChildPath(vecSpine, nPath, oDoc.Name(nElement));
+		vecPrefix.push_back(oDoc.Name(nElement));
+
+		vecChildren.clear();
+		TallyElement(vecSpine, nPath, oDoc, nElement, &vecChildren);
+	}
+
+	m_pCompact = &oDoc;
+	m_vecIndices.swap(vecChildren);
+
+	RunWorkers(m_vecIndices.size());
+
+	Tallies mapTallies;
+
+	MergeTree(vecSpine, Names(), mapTallies);
+
+	for (Workers::const_iterator it = m_vecWorkers.begin(); it != m_vecWorkers.end(); ++it)
+		MergeTree(it->m_vecPaths, vecPrefix, mapTallies);
+
+	MakeSummary(mapTallies, vecSummary);
+
+	m_pCompact = nullptr;
+	m_vecIndices.clear();
+	m_vecWorkers.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Infer the kind of a single value. Leading and trailing whitespace is
+//! ignored and an empty value has no kind.
+
+uint StructureAnalyser::InferType(const tstring& strValue)
+{
+	size_t nFirst = strValue.find_first_not_of(WHITESPACE);
+
+	if (nFirst == tstring::npos)
+		return 0;
+
+	size_t       nLast    = strValue.find_last_not_of(WHITESPACE);
+	const tchar* pszBegin = strValue.data() + nFirst;
+	const tchar* pszEnd   = strValue.data() + nLast + 1;
+
+	if ( (MatchWord(pszBegin, pszEnd, TXT("true"))) || (MatchWord(pszBegin, pszEnd, TXT("false"))) )
+		return BOOLEAN_VALUE;
+
+	uint nType = MatchNumber(pszBegin, pszEnd);
+
+	if (nType == 0)
+		nType = MatchDate(pszBegin, pszEnd);
+
+	if (nType == 0)
+		nType = STRING_VALUE;
+
+	return nType;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the name of the type that covers the kinds of value seen. Integers are
+//! covered by decimals, but other mixtures can only be strings.
+
+const tchar* StructureAnalyser::TypeName(uint nTypes)
+{
+	if (nTypes == 0)
+		return TXT("empty");
+	else if (nTypes == BOOLEAN_VALUE)
+		return TXT("boolean");
+	else if (nTypes == INTEGER_VALUE)
+		return TXT("integer");
+	else if ((nTypes & ~(INTEGER_VALUE | DECIMAL_VALUE)) == 0)
+		return TXT("decimal");
+	else if (nTypes == DATE_VALUE)
+		return TXT("date");
+	else if (nTypes == DATETIME_VALUE)
+		return TXT("dateTime");
+
+	return TXT("string");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Format the summary as tab separated text, one path per line. The attributes
+//! are listed with the percentage of the elements that have them.
+
+tstring StructureAnalyser::Format(const Summary& vecSummary)
+{
+	tstring strText = TXT("Path\tCount\tMin Children\tMax Children\tAvg Children\tValue Type\tAttributes\n");
+
+	for (Summary::const_iterator it = vecSummary.begin(); it != vecSummary.end(); ++it)
+	{
+		tstring strAttribs;
+
+		for (PathSummary::Attribs::const_iterator itAttrib = it->m_vecAttribs.begin();
+				itAttrib != it->m_vecAttribs.end(); ++itAttrib)
+		{
+			if (!strAttribs.empty())
+				strAttribs += TXT(", ");
+
+			double dRate = (100.0 * itAttrib->m_nCount) / it->m_nCount;
+
+			strAttribs += Core::fmt(TXT("%s (%.1f%%, %s)"), itAttrib->m_strName.c_str(), dRate,
+									TypeName(itAttrib->m_nTypes));
+		}
+
+		strText += Core::fmt(TXT("%s\t%u\t%u\t%u\t%.2f\t%s\t%s\n"), it->m_strPath.c_str(), it->m_nCount,
+								it->m_nMinChildren, it->m_nMaxChildren, it->AvgChildren(),
+								TypeName(it->m_nValueTypes), strAttribs.c_str());
+	}
+
+	return strText;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Split the records across the workers and run them. Each worker gets a
+//! contiguous range of the records. The calling thread also takes part and
+//! afterwards runs the share of any thread that could not be started or
+//! failed.
+
+void StructureAnalyser::RunWorkers(size_t nRecords)
+{
+	size_t nWorkers = std::max<size_t>(std::min(m_nThreads, nRecords), 1);
+
+	m_vecWorkers.resize(nWorkers);
+
+	for (size_t i = 0; i != nWorkers; ++i)
+	{
+		Worker& oWorker = m_vecWorkers[i];
+
+		oWorker.m_pAnalyser = this;
+		oWorker.m_nBegin    = (nRecords * i) / nWorkers;
+		oWorker.m_nEnd      = (nRecords * (i+1)) / nWorkers;
+		oWorker.m_bDone     = false;
+	}
+
+#ifdef _WIN32
+	std::vector<HANDLE> vecThreads;
+
+	for (size_t i = 1; i != nWorkers; ++i)
+	{
+		HANDLE hThread = reinterpret_cast<HANDLE>(_beginthreadex(NULL, 0, ThreadProc, &m_vecWorkers[i], 0, NULL));
+
+		if (hThread == NULL)
+			break;
+
+		vecThreads.push_back(hThread);
+	}
+
+	ThreadProc(&m_vecWorkers.front());
+
+	for (std::vector<HANDLE>::const_iterator it = vecThreads.begin(); it != vecThreads.end(); ++it)
+	{
+		::WaitForSingleObject(*it, INFINITE);
+		::CloseHandle(*it);
+	}
+#else
+	std::vector<std::thread> vecThreads;
+
+	try
+	{
+		for (size_t i = 1; i != nWorkers; ++i)
+			vecThreads.push_back(std::thread(ThreadProc, &m_vecWorkers[i]));
+	}
+	catch (const std::exception&)
+	{
+		// Run on the calling thread.
+	}
+
+	ThreadProc(&m_vecWorkers.front());
+
+	for (std::vector<std::thread>::iterator it = vecThreads.begin(); it != vecThreads.end(); ++it)
+		it->join();
+#endif
+
+	for (Workers::iterator it = m_vecWorkers.begin(); it != m_vecWorkers.end(); ++it)
+	{
+		if (!it->m_bDone)
+			TallyRecords(*it);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Tally a worker's share of the records. Each record is walked with a stack
+//! of the elements still to visit and the path of their parent.
+
+void StructureAnalyser::TallyRecords(Worker& oWorker)
+{
+	PathTree& vecPaths = oWorker.m_vecPaths;
+
+	vecPaths.assign(1, NewTally(0, TXT("")));
+
+	if (m_pCompact != nullptr)
+	{
+		typedef std::pair<CompactDoc::NodeIndex, size_t> Pending;
+
+		std::vector<Pending>    vecPending;
+		CompactDoc::NodeIndices vecChildren;
+
+		for (size_t i = oWorker.m_nBegin; i != oWorker.m_nEnd; ++i)
+		{
+			vecPending.push_back(Pending(m_vecIndices[i], 0));
+
+			while (!vecPending.empty())
+			{
+				Pending oNext = vecPending.back();
+				size_t  nPath = ChildPath(vecPaths, oNext.second, m_pCompact->Name(oNext.first));
+
+				vecPending.pop_back();
+				vecChildren.clear();
+
+				TallyElement(vecPaths, nPath, *m_pCompact, oNext.first, &vecChildren);
+
+				for (CompactDoc::NodeIndices::const_reverse_iterator it = vecChildren.rbegin(); it != vecChildren.rend(); ++it)
+					vecPending.push_back(Pending(*it, nPath));
+			}
+		}
+	}
+	else
+	{
+		typedef std::pair<const XML::ElementNode*, size_t> Pending;
+
+		std::vector<Pending> vecPending;
+		Elements             vecChildren;
+
+		for (size_t i = oWorker.m_nBegin; i != oWorker.m_nEnd; ++i)
+		{
+			vecPending.push_back(Pending(m_vecRecords[i], 0));
+
+			while (!vecPending.empty())
+			{
+				Pending oNext = vecPending.back();
+				size_t  nPath = ChildPath(vecPaths, oNext.second, oNext.first->name());
+
+				vecPending.pop_back();
+				vecChildren.clear();
+
+				TallyElement(vecPaths, nPath, *oNext.first, &vecChildren);
+
+				for (Elements::const_reverse_iterator it = vecChildren.rbegin(); it != vecChildren.rend(); ++it)
+					vecPending.push_back(Pending(*it, nPath));
+			}
+		}
+	}
+
+	oWorker.m_bDone = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Tally a DOM element, optionally collecting its child elements. Only the
+//! text of an element without child elements is treated as its value. The
+//! nodes are only read through raw pointers, as the reference counts are not
+//! safe to change on more than one thread.
+
+void StructureAnalyser::TallyElement(PathTree& vecPaths, size_t nPath, const XML::ElementNode& oElement, Elements* pChildren)
+{
+	PathTally& oTally    = vecPaths[nPath];
+	size_t     nChildren = 0;
+	bool       bHasValue = false;
+	tstring    strValue;
+
+	for (XML::NodeContainer::const_iterator it = oElement.beginChild(); it != oElement.endChild(); ++it)
+	{
+		const XML::Node* pNode = it->get();
+
+		if (pNode->type() == XML::ELEMENT_NODE)
+		{
+			++nChildren;
+
+			if (pChildren != nullptr)
+				pChildren->push_back(static_cast<const XML::ElementNode*>(pNode));
+		}
+		else if (pNode->type() == XML::TEXT_NODE)
+		{
+			strValue += static_cast<const XML::TextNode*>(pNode)->text();
+			bHasValue = true;
+		}
+		else if (pNode->type() == XML::CDATA_NODE)
+		{
+			strValue += static_cast<const XML::CDataNode*>(pNode)->text();
+			bHasValue = true;
+		}
+	}
+
+	TallyCounts(oTally, nChildren, bHasValue, strValue);
+
+	const XML::Attributes& oAttribs = oElement.getAttributes();
+
+	for (XML::Attributes::const_iterator it = oAttribs.begin(); it != oAttribs.end(); ++it)
+		TallyAttribute(oTally, (*it)->name(), (*it)->value());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Tally a compact document element, optionally collecting its child elements.
+
+void StructureAnalyser::TallyElement(PathTree& vecPaths, size_t nPath, const CompactDoc& oDoc,
+										CompactDoc::NodeIndex nElement, CompactDoc::NodeIndices* pChildren)
+{
+	PathTally& oTally    = vecPaths[nPath];
+	size_t     nChildren = 0;
+	bool       bHasValue = false;
+	tstring    strValue;
+
+	for (CompactDoc::NodeIndex nNode = oDoc.FirstChild(nElement); nNode != CompactDoc::NO_NODE;
+			nNode = oDoc.NextSibling(nNode))
+	{
+		XML::NodeType eType = oDoc.Type(nNode);
+
+		if (eType == XML::ELEMENT_NODE)
+		{
+			++nChildren;
+
+			if (pChildren != nullptr)
+				pChildren->push_back(nNode);
+		}
+		else if ( (eType == XML::TEXT_NODE) || (eType == XML::CDATA_NODE) )
+		{
+			strValue += oDoc.Value(nNode);
+			bHasValue = true;
+		}
+	}
+
+	TallyCounts(oTally, nChildren, bHasValue, strValue);
+
+	CompactDoc::Attributes vecAttribs;
+
+	oDoc.GetAttributes(nElement, vecAttribs);
+
+	for (CompactDoc::Attributes::const_iterator it = vecAttribs.begin(); it != vecAttribs.end(); ++it)
+		TallyAttribute(oTally, it->first, it->second);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Tally the child element count and value of an element at a path. Text in
+//! mixed content is not a value, nor is text that is only whitespace.
+
+void StructureAnalyser::TallyCounts(PathTally& oTally, size_t nChildren, bool bHasValue, const tstring& strValue)
+{
+	if ( (oTally.m_nCount == 0) || (nChildren < oTally.m_nMinChildren) )
+		oTally.m_nMinChildren = nChildren;
+
+	if ( (oTally.m_nCount == 0) || (nChildren > oTally.m_nMaxChildren) )
+		oTally.m_nMaxChildren = nChildren;
+
+	++oTally.m_nCount;
+	oTally.m_nTotalChildren += nChildren;
+
+	if ( (bHasValue) && (nChildren == 0) )
+	{
+		uint nType = InferType(strValue);
+
+		if (nType != 0)
+		{
+			++oTally.m_nValues;
+			oTally.m_nValueTypes |= nType;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Tally an attribute at a path.
+
+void StructureAnalyser::TallyAttribute(PathTally& oTally, const tstring& strName, const tstring& strValue)
+{
+	AttribTally& oAttrib = oTally.m_mapAttribs[strName];
+
+	++oAttrib.m_nCount;
+	oAttrib.m_nTypes |= InferType(strValue);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find or add the child path with an element name.
+
+size_t StructureAnalyser::ChildPath(PathTree& vecPaths, size_t nParent, const tstring& strName)
+{
+	PathIndex::const_iterator it = vecPaths[nParent].m_mapChildren.find(strName);
+
+	if (it != vecPaths[nParent].m_mapChildren.end())
+		return it->second;
+
+	size_t nPath = vecPaths.size();
+
+	vecPaths.push_back(NewTally(nParent, strName));
+	vecPaths[nParent].m_mapChildren.insert(std::make_pair(strName, nPath));
+
+	return nPath;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the names of a path from the root. The first path in a tree is where it
+//! starts and so is covered by the prefix.
+
+void StructureAnalyser::GetNames(const PathTree& vecPaths, size_t nPath, const Names& vecPrefix, Names& vecNames)
+{
+	vecNames.clear();
+
+	for (; nPath != 0; nPath = vecPaths[nPath].m_nParent)
+		vecNames.push_back(vecPaths[nPath].m_strName);
+
+	vecNames.insert(vecNames.end(), vecPrefix.rbegin(), vecPrefix.rend());
+	std::reverse(vecNames.begin(), vecNames.end());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Merge a tree of paths into the merged tallies.
+
+void StructureAnalyser::MergeTree(const PathTree& vecPaths, const Names& vecPrefix, Tallies& mapTallies)
+{
+	Names vecNames;
+
+	for (size_t nPath = 1; nPath != vecPaths.size(); ++nPath)
+	{
+		const PathTally& oSource = vecPaths[nPath];
+
+		GetNames(vecPaths, nPath, vecPrefix, vecNames);
+
+		Tallies::iterator it = mapTallies.find(vecNames);
+
+		if (it == mapTallies.end())
+		{
+			mapTallies.insert(std::make_pair(vecNames, oSource));
+			continue;
+		}
+
+		PathTally& oTarget = it->second;
+
+		oTarget.m_nMinChildren    = std::min(oTarget.m_nMinChildren, oSource.m_nMinChildren);
+		oTarget.m_nMaxChildren    = std::max(oTarget.m_nMaxChildren, oSource.m_nMaxChildren);
+		oTarget.m_nCount         += oSource.m_nCount;
+		oTarget.m_nTotalChildren += oSource.m_nTotalChildren;
+		oTarget.m_nValues        += oSource.m_nValues;
+		oTarget.m_nValueTypes    |= oSource.m_nValueTypes;
+
+		for (AttribTallies::const_iterator itAttrib = oSource.m_mapAttribs.begin();
+				itAttrib != oSource.m_mapAttribs.end(); ++itAttrib)
+		{
+			AttribTally& oAttrib = oTarget.m_mapAttribs[itAttrib->first];
+
+			oAttrib.m_nCount += itAttrib->second.m_nCount;
+			oAttrib.m_nTypes |= itAttrib->second.m_nTypes;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Create the summary from the merged tallies. The paths are ordered by their
+//! names, so a path is followed by those below it.
+
+void StructureAnalyser::MakeSummary(const Tallies& mapTallies, Summary& vecSummary)
+{
+	vecSummary.clear();
+	vecSummary.reserve(mapTallies.size());
+
+	for (Tallies::const_iterator it = mapTallies.begin(); it != mapTallies.end(); ++it)
+	{
+		const PathTally& oTally = it->second;
+		PathSummary      oSummary;
+
+		for (Names::const_iterator itName = it->first.begin(); itName != it->first.end(); ++itName)
+			oSummary.m_strPath += TXT("/") + *itName;
+
+		oSummary.m_nDepth         = it->first.size();
+		oSummary.m_nCount         = oTally.m_nCount;
+		oSummary.m_nMinChildren   = oTally.m_nMinChildren;
+		oSummary.m_nMaxChildren   = oTally.m_nMaxChildren;
+		oSummary.m_nTotalChildren = oTally.m_nTotalChildren;
+		oSummary.m_nValues        = oTally.m_nValues;
+		oSummary.m_nValueTypes    = oTally.m_nValueTypes;
+
+		for (AttribTallies::const_iterator itAttrib = oTally.m_mapAttribs.begin();
+				itAttrib != oTally.m_mapAttribs.end(); ++itAttrib)
+		{
+			PathSummary::Attrib oAttrib;
+
+			oAttrib.m_strName = itAttrib->first;
+			oAttrib.m_nCount  = itAttrib->second.m_nCount;
+			oAttrib.m_nTypes  = itAttrib->second.m_nTypes;
+
+			oSummary.m_vecAttribs.push_back(oAttrib);
+		}
+
+		vecSummary.push_back(oSummary);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Create an empty path tally.
+
+StructureAnalyser::PathTally StructureAnalyser::NewTally(size_t nParent, const tstring& strName)
+{
+	PathTally oTally;
+
+	oTally.m_nParent        = nParent;
+	oTally.m_strName        = strName;
+	oTally.m_nCount         = 0;
+	oTally.m_nMinChildren   = 0;
+	oTally.m_nMaxChildren   = 0;
+	oTally.m_nTotalChildren = 0;
+	oTally.m_nValues        = 0;
+	oTally.m_nValueTypes    = 0;
+
+	return oTally;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The worker thread function. A share that fails is left to be run again on
+//! the calling thread, where the exception can be reported.
+
+unsigned __stdcall StructureAnalyser::ThreadProc(void* pParam)
+{
+	Worker* pWorker = static_cast<Worker*>(pParam);
+
+	try
+	{
+		pWorker->m_pAnalyser->TallyRecords(*pWorker);
+	}
+	catch (const std::exception&)
+	{
+		pWorker->m_vecPaths.clear();
+
+		TRACE(TXT("A structure analysis worker failed and will be run again\n"));
+	}
+
+	return 0;
+}
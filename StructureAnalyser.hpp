@@ -0,0 +1,224 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   StructureAnalyser.hpp
+//! \brief  The StructureAnalyser class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_STRUCTUREANALYSER_HPP
+#define APP_STRUCTUREANALYSER_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <XML/Document.hpp>
+#include <XML/ElementNode.hpp>
+#include "CompactDoc.hpp"
+#include <map>
+
+////////////////////////////////////////////////////////////////////////////////
+//! The summary of the elements found at a distinct path.
+
+struct PathSummary
+{
+	////////////////////////////////////////////////////////////////////////////
+	//! The summary of an attribute of the elements.
+
+	struct Attrib
+	{
+		tstring		m_strName;		//!< The attribute name.
+		size_t		m_nCount;		//!< The number of elements that have it.
+		uint		m_nTypes;		//!< The kinds of value seen.
+	};
+
+	//! The attributes, ordered by name.
+	typedef std::vector<Attrib> Attribs;
+
+	tstring		m_strPath;			//!< The path, e.g. /feed/record/id.
+	size_t		m_nDepth;			//!< The number of elements in the path.
+	size_t		m_nCount;			//!< The number of elements.
+	size_t		m_nMinChildren;		//!< The fewest child elements.
+	size_t		m_nMaxChildren;		//!< The most child elements.
+	uint64		m_nTotalChildren;	//!< The total of the child elements.
+	size_t		m_nValues;			//!< The number of elements with a text value.
+	uint		m_nValueTypes;		//!< The kinds of text value seen.
+	Attribs		m_vecAttribs;		//!< The attributes.
+
+	//! Get the average number of child elements.
+	double AvgChildren() const;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Summarises the structure of a document by the distinct paths of its elements.
+//! The work is split across threads at the first element with more than one
+//! child element, which is usually the list of records in a large feed. Each
+//! thread tallies a contiguous range of the records into its own tree of paths
+//! and the trees are merged at the end. The tallies are only added, min'd,
+//! max'd and or'd together and the summary is ordered by the path's names, so
+//! the result is the same however the work is split. The analyser only reads
+//! the nodes and does no UI work, so it can also be driven from a test harness.
+
+class StructureAnalyser : private Core::NotCopyable
+{
+public:
+	//! The kinds of value, combined as a mask of those seen.
+	enum ValueType
+	{
+		BOOLEAN_VALUE	= 0x01,		//!< true or false.
+		INTEGER_VALUE	= 0x02,		//!< A whole number.
+		DECIMAL_VALUE	= 0x04,		//!< A number with a fraction or exponent.
+		DATE_VALUE		= 0x08,		//!< An ISO 8601 date.
+		DATETIME_VALUE	= 0x10,		//!< An ISO 8601 date and time.
+		STRING_VALUE	= 0x20,		//!< Anything else.
+	};
+
+	//! The summary of a document, one entry per distinct path.
+	typedef std::vector<PathSummary> Summary;
+
+	//! Constructor.
+	StructureAnalyser(size_t nThreads);
+
+	//! Destructor.
+	~StructureAnalyser();
+
+	//
+	// Methods.
+	//
+
+	//! Summarise the structure of a document.
+	void Analyse(const XML::Document& oDoc, Summary& vecSummary);
+
+	//! Summarise the structure of a compact document.
+	void Analyse(const CompactDoc& oDoc, Summary& vecSummary);
+
+	//
+	// Class methods.
+	//
+
+	//! Infer the kind of a single value.
+	static uint InferType(const tstring& strValue);
+
+	//! Get the name of the type that covers the kinds of value seen.
+	static const tchar* TypeName(uint nTypes);
+
+	//! Format the summary as tab separated text, one path per line.
+	static tstring Format(const Summary& vecSummary);
+
+private:
+	////////////////////////////////////////////////////////////////////////////
+	//! The tally of an attribute at a path.
+
+	struct AttribTally
+	{
+		size_t		m_nCount;		//!< The number of elements that have it.
+		uint		m_nTypes;		//!< The kinds of value seen.
+	};
+
+	//! The attribute tallies by name.
+	typedef std::map<tstring, AttribTally> AttribTallies;
+	//! The child paths by element name.
+	typedef std::map<tstring, size_t> PathIndex;
+
+	////////////////////////////////////////////////////////////////////////////
+	//! The tally of the elements at a path.
+
+	struct PathTally
+	{
+		size_t			m_nParent;			//!< The parent path.
+		tstring			m_strName;			//!< The element name.
+		PathIndex		m_mapChildren;		//!< The child paths.
+		size_t			m_nCount;			//!< The number of elements.
+		size_t			m_nMinChildren;		//!< The fewest child elements.
+		size_t			m_nMaxChildren;		//!< The most child elements.
+		uint64			m_nTotalChildren;	//!< The total of the child elements.
+		size_t			m_nValues;			//!< The number with a text value.
+		uint			m_nValueTypes;		//!< The kinds of text value seen.
+		AttribTallies	m_mapAttribs;		//!< The attributes.
+	};
+
+	//! A tree of paths held by index, where the first is the starting path.
+	typedef std::vector<PathTally> PathTree;
+	//! A path as the element names from the root.
+	typedef std::vector<tstring> Names;
+	//! The merged tallies by path.
+	typedef std::map<Names, PathTally> Tallies;
+	//! The elements that the records are split across threads at.
+	typedef std::vector<const XML::ElementNode*> Elements;
+
+	////////////////////////////////////////////////////////////////////////////
+	//! A thread's share of the records and the tree it tallies them into.
+
+	struct Worker
+	{
+		StructureAnalyser*	m_pAnalyser;	//!< The analyser.
+		size_t				m_nBegin;		//!< The first record.
+		size_t				m_nEnd;			//!< The end of the records.
+		PathTree			m_vecPaths;		//!< The tallies.
+		bool				m_bDone;		//!< Have the records been tallied?
+	};
+
+	//! The collection of workers.
+	typedef std::vector<Worker> Workers;
+
+	//
+	// Members.
+	//
+	size_t					m_nThreads;		//!< The number of threads to use.
+	Elements				m_vecRecords;	//!< The records of a DOM.
+	const CompactDoc*		m_pCompact;		//!< The compact document, if any.
+	CompactDoc::NodeIndices	m_vecIndices;	//!< The records of a compact document.
+	Workers					m_vecWorkers;	//!< The threads' shares of the records.
+
+	//
+	// Internal methods.
+	//
+
+	//! Split the records across the workers and run them.
+	void RunWorkers(size_t nRecords);
+
+	//! Tally a worker's share of the records.
+	void TallyRecords(Worker& oWorker);
+
+	//! Tally a DOM element, optionally collecting its child elements.
+	static void TallyElement(PathTree& vecPaths, size_t nPath, const XML::ElementNode& oElement, Elements* pChildren);
+
+	//! Tally a compact document element, optionally collecting its child elements.
+	static void TallyElement(PathTree& vecPaths, size_t nPath, const CompactDoc& oDoc, CompactDoc::NodeIndex nElement, CompactDoc::NodeIndices* pChildren);
+
+	//! Tally the child element count, value and attributes at a path.
+	static void TallyCounts(PathTally& oTally, size_t nChildren, bool bHasValue, const tstring& strValue);
+
+	//! Tally an attribute at a path.
+	static void TallyAttribute(PathTally& oTally, const tstring& strName, const tstring& strValue);
+
+	//! Find or add the child path with an element name.
+	static size_t ChildPath(PathTree& vecPaths, size_t nParent, const tstring& strName);
+
+	//! Get the names of a path from the root.
+	static void GetNames(const PathTree& vecPaths, size_t nPath, const Names& vecPrefix, Names& vecNames);
+
+	//! Merge a tree of paths into the merged tallies.
+	static void MergeTree(const PathTree& vecPaths, const Names& vecPrefix, Tallies& mapTallies);
+
+	//! Create the summary from the merged tallies.
+	static void MakeSummary(const Tallies& mapTallies, Summary& vecSummary);
+
+	//! Create an empty path tally.
+	static PathTally NewTally(size_t nParent, const tstring& strName);
+
+	//! The worker thread function.
+	static unsigned __stdcall ThreadProc(void* pParam);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the average number of child elements.
+
+inline double PathSummary::AvgChildren() const
+{
+	if (m_nCount == 0)
+		return 0.0;
+
+	return static_cast<double>(m_nTotalChildren) / static_cast<double>(m_nCount);
+}
+
+#endif // APP_STRUCTUREANALYSER_HPP
@@ -0,0 +1,71 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   StructureDlg.cpp
+//! \brief  The StructureDlg class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "StructureDlg.hpp"
+#include "Resource.h"
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+StructureDlg::StructureDlg()
+	: CDialog(IDD_STRUCTURE)
+{
+	DEFINE_CTRL_TABLE
+		CTRL(IDC_STRUCTURE,	&m_lvPaths)
+	END_CTRL_TABLE
+
+	DEFINE_CTRLMSG_TABLE
+	END_CTRLMSG_TABLE
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Dialog initialisation handler.
+
+void StructureDlg::OnInitDialog()
+{
+	// Initialise controls.
+	m_lvPaths.InsertColumn(PATH_COLUMN,       TXT("Path"),                     200, LVCFMT_LEFT);
+	m_lvPaths.InsertColumn(COUNT_COLUMN,      TXT("Count"),                     75, LVCFMT_RIGHT);
+	m_lvPaths.InsertColumn(CHILDREN_COLUMN,   TXT("Children (Min/Avg/Max)"),   130, LVCFMT_LEFT);
+	m_lvPaths.InsertColumn(TYPE_COLUMN,       TXT("Value Type"),                75, LVCFMT_LEFT);
+	m_lvPaths.InsertColumn(ATTRIBUTES_COLUMN, TXT("Attributes"),               300, LVCFMT_LEFT);
+	m_lvPaths.FullRowSelect(true);
+
+	// Load the summary, showing the attributes with how often they occur.
+	for (StructureAnalyser::Summary::const_iterator it = m_vecSummary.begin(); it != m_vecSummary.end(); ++it)
+	{
+		tstring strAttribs;
+
+		for (PathSummary::Attribs::const_iterator itAttrib = it->m_vecAttribs.begin();
+				itAttrib != it->m_vecAttribs.end(); ++itAttrib)
+		{
+			if (!strAttribs.empty())
+				strAttribs += TXT(", ");
+
+			double dRate = (100.0 * itAttrib->m_nCount) / it->m_nCount;
+
+			strAttribs += Core::fmt(TXT("%s %.0f%% %s"), itAttrib->m_strName.c_str(), dRate,
+									StructureAnalyser::TypeName(itAttrib->m_nTypes));
+		}
+
+		size_t n = m_lvPaths.ItemCount();
+
+		m_lvPaths.InsertItem(n,                    it->m_strPath);
+		m_lvPaths.ItemText  (n, COUNT_COLUMN,      Core::fmt(TXT("%u"), it->m_nCount));
+		m_lvPaths.ItemText  (n, CHILDREN_COLUMN,   Core::fmt(TXT("%u / %.1f / %u"), it->m_nMinChildren,
+																it->AvgChildren(), it->m_nMaxChildren));
+		m_lvPaths.ItemText  (n, TYPE_COLUMN,       StructureAnalyser::TypeName(it->m_nValueTypes));
+		m_lvPaths.ItemText  (n, ATTRIBUTES_COLUMN, strAttribs);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! OK button handler.
+
+bool StructureDlg::OnOk()
+{
+	return true;
+}
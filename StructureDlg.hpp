@@ -0,0 +1,58 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   StructureDlg.hpp
+//! \brief  The StructureDlg class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef STRUCTUREDLG_HPP
+#define STRUCTUREDLG_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <WCL/CommonUI.hpp>
+#include "StructureAnalyser.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+//! The dialog used to display the summary of the document's structure.
+
+class StructureDlg : public CDialog
+{
+public:
+	//! Default constructor.
+	StructureDlg();
+	
+	//
+	// Members.
+	//
+	StructureAnalyser::Summary	m_vecSummary;	//!< The summary of the structure.
+
+private:
+	//! The summary columns.
+	enum Column
+	{
+		PATH_COLUMN			= 0,	//!< The element path column.
+		COUNT_COLUMN		= 1,	//!< The element count column.
+		CHILDREN_COLUMN		= 2,	//!< The min/avg/max child elements column.
+		TYPE_COLUMN			= 3,	//!< The value type column.
+		ATTRIBUTES_COLUMN	= 4,	//!< The attributes column.
+	};
+
+	//
+	// Controls.
+	//
+	CListView	m_lvPaths;		//!< The paths view.
+
+	//
+	// Message handlers.
+	//
+
+	//! Dialog initialisation handler.
+	virtual void OnInitDialog();
+
+	//! OK button handler.
+	virtual bool OnOk();
+};
+
+#endif // STRUCTUREDLG_HPP
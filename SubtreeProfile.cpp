@@ -0,0 +1,624 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   SubtreeProfile.cpp
+//! \brief  The SubtreeProfile class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "SubtreeProfile.hpp"
+#include <XML/ElementNode.hpp>
+#include <XML/TextNode.hpp>
+#include <XML/CDataNode.hpp>
+#include <XML/CommentNode.hpp>
+#include <XML/ProcessingNode.hpp>
+#include <XML/DocTypeNode.hpp>
+#include <algorithm>
+#include "DomEditor.hpp"
+#include "NodeCursor.hpp"
+
+// The size of the markup around the values.
+static const uint64 ATTRIB_MARKUP  = 4;		// ' name="value"'
+static const uint64 CDATA_MARKUP   = 12;	// "<![CDATA[" and "]]>"
+static const uint64 COMMENT_MARKUP = 7;		// "<!--" and "-->"
+static const uint64 PI_MARKUP      = 4;		// "<?" and "?>"
+static const uint64 DOCTYPE_MARKUP = 11;	// "<!DOCTYPE " and ">"
+static const uint64 TAGS_MARKUP    = 5;		// "<", ">", "</" and ">"
+static const uint64 EMPTY_MARKUP   = 3;		// "<" and "/>"
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of bytes a character takes when written as UTF-8, counting
+//! a surrogate pair on its high half.
+
+static uint64 Utf8Length(tchar cChar)
+{
+	uint nChar = static_cast<utchar>(cChar);
+
+	if (nChar < 0x80)
+		return 1;
+	else if (nChar < 0x800)
+		return 2;
+	else if ( (nChar >= 0xD800) && (nChar <= 0xDBFF) )
+		return 4;
+	else if ( (nChar >= 0xDC00) && (nChar <= 0xDFFF) )
+		return 0;
+
+	return 3;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of bytes a string takes when written as UTF-8, optionally
+//! including the character references the writer escapes markup with.
+
+static uint64 Utf8Length(const tstring& strText, bool bEscape, bool bInAttrib)
+{
+	uint64 nBytes = 0;
+
+	for (tstring::const_iterator it = strText.begin(); it != strText.end(); ++it)
+	{
+		tchar cChar = *it;
+
+		if (bEscape && (cChar == TXT('&')))
+			nBytes += 5;	// "&amp;"
+		else if (bEscape && ((cChar == TXT('<')) || (cChar == TXT('>'))))
+			nBytes += 4;	// "&lt;" or "&gt;"
+		else if (bEscape && bInAttrib && (cChar == TXT('"')))
+			nBytes += 6;	// "&quot;"
+		else
+			nBytes += Utf8Length(cChar);
+	}
+
+	return nBytes;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the size of a set of attributes.
+
+static uint64 AttributesLength(const XML::Attributes& oAttribs)
+{
+	uint64 nBytes = 0;
+
+	for (XML::Attributes::const_iterator it = oAttribs.begin(); it != oAttribs.end(); ++it)
+	{
+		const XML::AttributePtr& pAttrib = *it;
+
+		nBytes += ATTRIB_MARKUP + Utf8Length(pAttrib->name(), false, false)
+				+ Utf8Length(pAttrib->value(), true, true);
+	}
+
+	return nBytes;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the size of an element's tags when it has or hasn't any children.
+
+static uint64 TagsLength(const XML::ElementNode& oElement, bool bHasChildren)
+{
+	uint64 nName = Utf8Length(oElement.name(), false, false);
+
+	if (bHasChildren)
+		return TAGS_MARKUP + (2 * nName);
+
+	return EMPTY_MARKUP + nName;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add one size to another.
+
+static void Add(SubtreeSize& oTotal, const SubtreeSize& oSize)
+{
+	oTotal.m_nDescendants += oSize.m_nDescendants;
+	oTotal.m_nBytes       += oSize.m_nBytes;
+	oTotal.m_nTextBytes   += oSize.m_nTextBytes;
+	oTotal.m_nAttribBytes += oSize.m_nAttribBytes;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Subtract one size from another.
+
+static void Subtract(SubtreeSize& oTotal, const SubtreeSize& oSize)
+{
+	oTotal.m_nDescendants -= oSize.m_nDescendants;
+	oTotal.m_nBytes       -= oSize.m_nBytes;
+	oTotal.m_nTextBytes   -= oSize.m_nTextBytes;
+	oTotal.m_nAttribBytes -= oSize.m_nAttribBytes;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Create an empty size.
+
+static SubtreeSize NoSize()
+{
+	SubtreeSize oSize = { 0, 0, 0, 0 };
+
+	return oSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The predicate for ordering sub-trees by a measure, largest first, and then
+//! by address so that the order is stable.
+
+struct IsLarger
+{
+	SubtreeProfile::Metric	m_eMetric;	//!< The measure to compare.
+
+	//! Compare two sub-trees.
+	bool operator()(const SubtreeProfile::Entry& oLhs, const SubtreeProfile::Entry& oRhs) const
+	{
+		uint64 nLhs = SubtreeProfile::Value(oLhs.second, m_eMetric);
+		uint64 nRhs = SubtreeProfile::Value(oRhs.second, m_eMetric);
+
+		if (nLhs != nRhs)
+			return (nLhs > nRhs);
+
+		return (oLhs.first < oRhs.first);
+	}
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+SubtreeProfile::SubtreeProfile(DomEditor& oEditor)
+	: m_oEditor(oEditor)
+	, m_bBuilt(false)
+	, m_bInBatch(false)
+	, m_mapSizes()
+{
+	m_oEditor.AddListener(this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+SubtreeProfile::~SubtreeProfile()
+{
+	m_oEditor.RemoveListener(this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Build the profile from the DOM. The nodes are visited in postorder so that
+//! the children of a container have all been measured by the time it is,
+//! with the running totals of each level held on a stack indexed by depth.
+
+void SubtreeProfile::Build(const XML::DocumentPtr& pDOM)
+{
+	Clear();
+
+	std::vector<SubtreeSize> vecTotals(2, NoSize());
+
+	for (NodeCursor oCursor(*pDOM, NodeCursor::POSTORDER); oCursor.Next(); )
+	{
+		NodeRef pNode  = oCursor.Node();
+		size_t  nDepth = oCursor.Depth();
+
+		if (vecTotals.size() < nDepth+2)
+			vecTotals.resize(nDepth+2, NoSize());
+
+		SubtreeSize oSize = MeasureNode(pNode);
+
+		// Include the children measured at the level below.
+		if (pNode->type() == XML::ELEMENT_NODE)
+		{
+			Add(oSize, vecTotals[nDepth+1]);
+			vecTotals[nDepth+1] = NoSize();
+
+			m_mapSizes[pNode.get()] = oSize;
+		}
+
+		++oSize.m_nDescendants;
+		Add(vecTotals[nDepth], oSize);
+	}
+
+	// The document's children are at depth 1.
+	m_mapSizes[pDOM.get()] = vecTotals[1];
+
+	m_bBuilt = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Discard the profile.
+
+void SubtreeProfile::Clear()
+{
+	m_mapSizes.clear();
+
+	m_bBuilt = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the size of an element's or the document's sub-tree.
+
+bool SubtreeProfile::GetSize(NodeRef pNode, SubtreeSize& oSize) const
+{
+	Sizes::const_iterator it = m_mapSizes.find(pNode.get());
+
+	if (it == m_mapSizes.end())
+		return false;
+
+	oSize = it->second;
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the largest element sub-trees by a measure, largest first. Only the
+//! requested number are sorted.
+
+void SubtreeProfile::GetLargest(Metric eMetric, size_t nCount, Entries& vecEntries) const
+{
+	vecEntries.clear();
+	vecEntries.reserve(m_mapSizes.size());
+
+	for (Sizes::const_iterator it = m_mapSizes.begin(); it != m_mapSizes.end(); ++it)
+	{
+		if (it->first->type() == XML::ELEMENT_NODE)
+			vecEntries.push_back(*it);
+	}
+
+	IsLarger oIsLarger = { eMetric };
+
+	nCount = std::min(nCount, vecEntries.size());
+
+	std::partial_sort(vecEntries.begin(), vecEntries.begin()+nCount, vecEntries.end(), oIsLarger);
+	vecEntries.resize(nCount);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Handle a change to the DOM. The difference the change made to the size of
+//! the changed sub-tree is applied to each of its ancestors. The changes made
+//! during a batch are ignored as the profile is discarded at the end of it.
+
+void SubtreeProfile::OnDomChanged(const DomChange& oChange)
+{
+	if (!m_bBuilt || m_bInBatch)
+		return;
+
+	if (oChange.m_eType == DomChange::NODE_INSERTED)
+	{
+		SubtreeSize oSize = AddSubtree(oChange.m_pNode);
+
+		AddToAncestors(oChange.m_pParent, oSize);
+		UpdateEmptyTags(oChange.m_pParent, true);
+	}
+	else if (oChange.m_eType == DomChange::NODE_REMOVED)
+	{
+		SubtreeSize oSize = RemoveSubtree(oChange.m_pNode);
+
+		SubtractFromAncestors(oChange.m_pOldParent, oSize);
+		UpdateEmptyTags(oChange.m_pOldParent, false);
+	}
+	else if (oChange.m_eType == DomChange::NODE_MOVED)
+	{
+		bool bSameParent = (oChange.m_pParent.get() == oChange.m_pOldParent.get());
+
+		SubtreeSize oSize = RemoveSubtree(oChange.m_pNode);
+
+		SubtractFromAncestors(oChange.m_pOldParent, oSize);
+
+		if (!bSameParent)
+			UpdateEmptyTags(oChange.m_pOldParent, false);
+
+		oSize = AddSubtree(oChange.m_pNode);
+
+		AddToAncestors(oChange.m_pParent, oSize);
+
+		if (!bSameParent)
+			UpdateEmptyTags(oChange.m_pParent, true);
+	}
+	else if (oChange.m_eType == DomChange::CHILDREN_MOVED)
+	{
+		const XML::NodeContainer* pChildren = NodeCursor::Children(oChange.m_pParent);
+		SubtreeSize               oSize     = NoSize();
+
+		// The sub-trees themselves are unchanged.
+		for (XML::NodeContainer::const_iterator it = pChildren->beginChild(); it != pChildren->endChild(); ++it)
+			Add(oSize, CachedSize(*it));
+
+		SubtractFromAncestors(oChange.m_pOldParent, oSize);
+		UpdateEmptyTags(oChange.m_pOldParent, false);
+		AddToAncestors(oChange.m_pParent, oSize);
+		UpdateEmptyTags(oChange.m_pParent, true, pChildren->getChildCount());
+	}
+	else if (oChange.m_eType == DomChange::ATTRIBUTE_CHANGED)
+	{
+		OnAttributeChanged(oChange);
+	}
+	else if ( (oChange.m_eType == DomChange::TEXT_CHANGED)
+		   || (oChange.m_eType == DomChange::TEXT_EDITED) )
+	{
+		OnTextChanged(oChange);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Handle the start of a batch of changes.
+
+void SubtreeProfile::OnBatchStarted()
+{
+	m_bInBatch = true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Handle the end of a batch of changes. A batch may touch much of the
+//! document, so the profile is built again from scratch when next used.
+
+void SubtreeProfile::OnBatchFinished()
+{
+	m_bInBatch = false;
+
+	Clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the value of a measure.
+
+uint64 SubtreeProfile::Value(const SubtreeSize& oSize, Metric eMetric)
+{
+	if (eMetric == DESCENDANTS)
+		return oSize.m_nDescendants;
+	else if (eMetric == BYTES)
+		return oSize.m_nBytes;
+	else if (eMetric == TEXT_BYTES)
+		return oSize.m_nTextBytes;
+	else if (eMetric == ATTRIB_BYTES)
+		return oSize.m_nAttribBytes;
+
+	ASSERT_FALSE();
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Measure a sub-tree and cache the sizes of the containers in it. The size
+//! returned includes the node itself in the count of descendants, as that is
+//! what it adds to its ancestors.
+
+SubtreeSize SubtreeProfile::AddSubtree(NodeRef pNode)
+{
+	SubtreeSize oTotal = MeasureNode(pNode);
+
+	const XML::NodeContainer* pChildren = NodeCursor::Children(pNode);
+
+	if (pChildren != nullptr)
+	{
+		for (XML::NodeContainer::const_iterator it = pChildren->beginChild(); it != pChildren->endChild(); ++it)
+			Add(oTotal, AddSubtree(*it));
+
+		m_mapSizes[pNode.get()] = oTotal;
+	}
+
+	++oTotal.m_nDescendants;
+
+	return oTotal;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Remove the cached sizes of the containers in a sub-tree, returning what it
+//! added to its ancestors.
+
+SubtreeSize SubtreeProfile::RemoveSubtree(NodeRef pNode)
+{
+	SubtreeSize oTotal = NoSize();
+
+	if (NodeCursor::Children(pNode) != nullptr)
+	{
+		Sizes::iterator itSize = m_mapSizes.find(pNode.get());
+
+		if (itSize != m_mapSizes.end())
+			oTotal = itSize->second;
+
+		for (NodeCursor oCursor(*NodeCursor::Children(pNode)); oCursor.Next(); )
+			m_mapSizes.erase(oCursor.Node().get());
+
+		m_mapSizes.erase(pNode.get());
+	}
+	else
+	{
+		oTotal = MeasureNode(pNode);
+	}
+
+	++oTotal.m_nDescendants;
+
+	return oTotal;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the cached size of a sub-tree, as it was added to its ancestors.
+
+SubtreeSize SubtreeProfile::CachedSize(NodeRef pNode) const
+{
+	SubtreeSize oTotal = NoSize();
+
+	if (NodeCursor::Children(pNode) != nullptr)
+	{
+		Sizes::const_iterator itSize = m_mapSizes.find(pNode.get());
+
+		if (itSize != m_mapSizes.end())
+			oTotal = itSize->second;
+	}
+	else
+	{
+		oTotal = MeasureNode(pNode);
+	}
+
+	++oTotal.m_nDescendants;
+
+	return oTotal;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Measure a node on its own, excluding its children.
+
+SubtreeSize SubtreeProfile::MeasureNode(NodeRef pNode) const
+{
+	SubtreeSize   oSize = NoSize();
+	XML::NodeType eType = pNode->type();
+
+	if (eType == XML::ELEMENT_NODE)
+	{
+		const XML::ElementNode* pElement = pNode.As<XML::ElementNode>();
+
+		oSize.m_nAttribBytes = AttributesLength(pElement->getAttributes());
+		oSize.m_nBytes       = TagsLength(*pElement, pElement->hasChildren()) + oSize.m_nAttribBytes;
+	}
+	else if ( (eType == XML::TEXT_NODE) || (eType == XML::CDATA_NODE) )
+	{
+		oSize = MeasureText(pNode, m_oEditor.Text(pNode));
+	}
+	else if (eType == XML::COMMENT_NODE)
+	{
+		oSize.m_nBytes = COMMENT_MARKUP + Utf8Length(pNode.As<XML::CommentNode>()->comment(), false, false);
+	}
+	else if (eType == XML::PROCESSING_NODE)
+	{
+		const XML::ProcessingNode* pPI = pNode.As<XML::ProcessingNode>();
+
+		oSize.m_nAttribBytes = AttributesLength(pPI->getAttributes());
+		oSize.m_nBytes       = PI_MARKUP + Utf8Length(pPI->target(), false, false) + oSize.m_nAttribBytes;
+	}
+	else if (eType == XML::DOCTYPE_NODE)
+	{
+		oSize.m_nBytes = DOCTYPE_MARKUP + Utf8Length(pNode.As<XML::DocTypeNode>()->declaration(), false, false);
+	}
+
+	return oSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Measure the text of a text or CDATA node.
+
+SubtreeSize SubtreeProfile::MeasureText(NodeRef pNode, const tstring& strText) const
+{
+	SubtreeSize oSize = NoSize();
+
+	if (pNode->type() == XML::CDATA_NODE)
+	{
+		oSize.m_nTextBytes = Utf8Length(strText, false, false);
+		oSize.m_nBytes     = CDATA_MARKUP + oSize.m_nTextBytes;
+	}
+	else
+	{
+		oSize.m_nTextBytes = Utf8Length(strText, true, false);
+		oSize.m_nBytes     = oSize.m_nTextBytes;
+	}
+
+	return oSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add a size to a container and its ancestors.
+
+void SubtreeProfile::AddToAncestors(NodeRef pContainer, const SubtreeSize& oSize)
+{
+	for (XML::Node* pAncestor = pContainer.get(); pAncestor != nullptr; )
+	{
+		Sizes::iterator it = m_mapSizes.find(pAncestor);
+
+		if (it != m_mapSizes.end())
+			Add(it->second, oSize);
+
+		pAncestor = (pAncestor->hasParent()) ? pAncestor->parent().get() : nullptr;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Subtract a size from a container and its ancestors.
+
+void SubtreeProfile::SubtractFromAncestors(NodeRef pContainer, const SubtreeSize& oSize)
+{
+	for (XML::Node* pAncestor = pContainer.get(); pAncestor != nullptr; )
+	{
+		Sizes::iterator it = m_mapSizes.find(pAncestor);
+
+		if (it != m_mapSizes.end())
+			Subtract(it->second, oSize);
+
+		pAncestor = (pAncestor->hasParent()) ? pAncestor->parent().get() : nullptr;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Adjust a container's own tags after children were added to or removed from
+//! it, as an element without children is written as a single empty tag.
+
+void SubtreeProfile::UpdateEmptyTags(NodeRef pContainer, bool bAdded, size_t nChildren)
+{
+	if (pContainer->type() != XML::ELEMENT_NODE)
+		return;
+
+	const XML::ElementNode* pElement = pContainer.As<XML::ElementNode>();
+	size_t                  nCount   = pElement->getChildCount();
+
+	// Not its first or last children?
+	if (nCount != ((bAdded) ? nChildren : 0u))
+		return;
+
+	SubtreeSize oOld = NoSize();
+	SubtreeSize oNew = NoSize();
+
+	oOld.m_nBytes = TagsLength(*pElement, !bAdded);
+	oNew.m_nBytes = TagsLength(*pElement, bAdded);
+
+	SubtractFromAncestors(pContainer, oOld);
+	AddToAncestors(pContainer, oNew);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Handle the value of an attribute being set or removed.
+
+void SubtreeProfile::OnAttributeChanged(const DomChange& oChange)
+{
+	NodeRef pNode = oChange.m_pNode;
+
+	if (pNode->type() != XML::ELEMENT_NODE)
+		return;
+
+	const XML::Attributes& oAttribs = pNode.As<XML::ElementNode>()->getAttributes();
+	XML::AttributePtr      pAttrib  = oAttribs.find(oChange.m_strName);
+
+	uint64 nName = ATTRIB_MARKUP + Utf8Length(oChange.m_strName, false, false);
+
+	SubtreeSize oOld = NoSize();
+	SubtreeSize oNew = NoSize();
+
+	if (oChange.m_bHadValue)
+		oOld.m_nAttribBytes = nName + Utf8Length(oChange.m_strOldValue, true, true);
+
+	if (pAttrib.get() != nullptr)
+		oNew.m_nAttribBytes = nName + Utf8Length(pAttrib->value(), true, true);
+
+	oOld.m_nBytes = oOld.m_nAttribBytes;
+	oNew.m_nBytes = oNew.m_nAttribBytes;
+
+	SubtractFromAncestors(pNode, oOld);
+	AddToAncestors(pNode, oNew);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Handle the text of a node being replaced or edited. The change holds the
+//! text of an edited range, so only that range needs to be measured.
+
+void SubtreeProfile::OnTextChanged(const DomChange& oChange)
+{
+	NodeRef pNode = oChange.m_pNode;
+
+	if (!pNode->hasParent())
+		return;
+
+	SubtreeSize oOld = MeasureText(pNode, oChange.m_strOldValue);
+	SubtreeSize oNew;
+
+	if (oChange.m_eType == DomChange::TEXT_EDITED)
+		oNew = MeasureText(pNode, oChange.m_strNewText);
+	else
+		oNew = MeasureText(pNode, m_oEditor.Text(pNode));
+
+	// Only the values differ, not the markup around them.
+	if (pNode->type() == XML::CDATA_NODE)
+	{
+		oOld.m_nBytes = oOld.m_nTextBytes;
+		oNew.m_nBytes = oNew.m_nTextBytes;
+	}
+
+	NodeRef pParent(pNode->parent().get());
+
+	SubtractFromAncestors(pParent, oOld);
+	AddToAncestors(pParent, oNew);
+}
@@ -0,0 +1,158 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   SubtreeProfile.hpp
+//! \brief  The SubtreeProfile class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_SUBTREEPROFILE_HPP
+#define APP_SUBTREEPROFILE_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <XML/Document.hpp>
+#include "IDomListener.hpp"
+#include <map>
+
+// Forward declarations.
+class DomEditor;
+
+////////////////////////////////////////////////////////////////////////////////
+//! The aggregate size of a node and its descendants. The bytes are those of the
+//! node's markup written as UTF-8, without any indentation.
+
+struct SubtreeSize
+{
+	uint64	m_nDescendants;		//!< The number of nodes below it.
+	uint64	m_nBytes;			//!< The size of the markup.
+	uint64	m_nTextBytes;		//!< The size of the text and CDATA values.
+	uint64	m_nAttribBytes;		//!< The size of the attributes.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! A profile of the size of every element's sub-tree, like a disk usage report
+//! for a document. The sizes are computed for all the elements in a single
+//! bottom-up pass and cached. After an edit only the sizes of the ancestors of
+//! the changed node are adjusted, by the difference the edit made, except for
+//! a batch of edits, after which the profile is discarded and built again when
+//! next used.
+
+class SubtreeProfile : public IDomListener, private Core::NotCopyable
+{
+public:
+	//! The measures that sub-trees can be ranked by.
+	enum Metric
+	{
+		DESCENDANTS,	//!< The number of nodes below it.
+		BYTES,			//!< The size of the markup.
+		TEXT_BYTES,		//!< The size of the text values.
+		ATTRIB_BYTES,	//!< The size of the attributes.
+	};
+
+	//! An element and the size of its sub-tree.
+	typedef std::pair<const XML::Node*, SubtreeSize> Entry;
+	//! A collection of elements and their sizes.
+	typedef std::vector<Entry> Entries;
+
+	//! Constructor.
+	SubtreeProfile(DomEditor& oEditor);
+
+	//! Destructor.
+	virtual ~SubtreeProfile();
+
+	//
+	// Properties.
+	//
+
+	//! Query if the profile has been built.
+	bool IsBuilt() const;
+
+	//
+	// Methods.
+	//
+
+	//! Build the profile from the DOM.
+	void Build(const XML::DocumentPtr& pDOM);
+
+	//! Discard the profile.
+	void Clear();
+
+	//! Get the size of an element's or the document's sub-tree.
+	bool GetSize(NodeRef pNode, SubtreeSize& oSize) const;
+
+	//! Get the largest sub-trees by a measure, largest first.
+	void GetLargest(Metric eMetric, size_t nCount, Entries& vecEntries) const;
+
+	//! Handle a change to the DOM.
+	virtual void OnDomChanged(const DomChange& oChange);
+
+	//! Handle the start of a batch of changes.
+	virtual void OnBatchStarted();
+
+	//! Handle the end of a batch of changes.
+	virtual void OnBatchFinished();
+
+	//
+	// Class methods.
+	//
+
+	//! Get the value of a measure.
+	static uint64 Value(const SubtreeSize& oSize, Metric eMetric);
+
+private:
+	//! The map of container to the size of its sub-tree.
+	typedef std::map<const XML::Node*, SubtreeSize> Sizes;
+
+	//
+	// Members.
+	//
+	DomEditor&	m_oEditor;		//!< The editor making the changes.
+	bool		m_bBuilt;		//!< Has the profile been built?
+	bool		m_bInBatch;		//!< Is a batch of changes being made?
+	Sizes		m_mapSizes;		//!< The sizes of the containers.
+
+	//
+	// Internal methods.
+	//
+
+	//! Measure a sub-tree and cache the sizes of the containers in it.
+	SubtreeSize AddSubtree(NodeRef pNode);
+
+	//! Remove the cached sizes of the containers in a sub-tree.
+	SubtreeSize RemoveSubtree(NodeRef pNode);
+
+	//! Get the cached size of a sub-tree.
+	SubtreeSize CachedSize(NodeRef pNode) const;
+
+	//! Measure a node on its own, excluding its children.
+	SubtreeSize MeasureNode(NodeRef pNode) const;
+
+	//! Measure the text of a text or CDATA node.
+	SubtreeSize MeasureText(NodeRef pNode, const tstring& strText) const;
+
+	//! Add a size to a container and its ancestors.
+	void AddToAncestors(NodeRef pContainer, const SubtreeSize& oSize);
+
+	//! Subtract a size from a container and its ancestors.
+	void SubtractFromAncestors(NodeRef pContainer, const SubtreeSize& oSize);
+
+	//! Adjust a container's own tags after children were added to or removed from it.
+	void UpdateEmptyTags(NodeRef pContainer, bool bAdded, size_t nChildren = 1);
+
+	//! Handle the value of an attribute being set or removed.
+	void OnAttributeChanged(const DomChange& oChange);
+
+	//! Handle the text of a node being replaced or edited.
+	void OnTextChanged(const DomChange& oChange);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the profile has been built.
+
+inline bool SubtreeProfile::IsBuilt() const
+{
+	return m_bBuilt;
+}
+
+#endif // APP_SUBTREEPROFILE_HPP
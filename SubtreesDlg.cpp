@@ -0,0 +1,131 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   SubtreesDlg.cpp
+//! \brief  The SubtreesDlg class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "SubtreesDlg.hpp"
+#include "Resource.h"
+#include <XML/ElementNode.hpp>
+
+// Constants.
+static const size_t MAX_SUBTREES = 100;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+SubtreesDlg::SubtreesDlg(const SubtreeProfile& oProfile)
+	: CDialog(IDD_SUBTREES)
+	, m_pSelection()
+	, m_oProfile(oProfile)
+{
+	DEFINE_CTRL_TABLE
+		CTRL(IDC_SUBTREES,	&m_lvSubtrees)
+	END_CTRL_TABLE
+
+	DEFINE_CTRLMSG_TABLE
+		NFY_CTRLMSG(IDC_SUBTREES, LVN_COLUMNCLICK, &SubtreesDlg::OnColumnClicked)
+		NFY_CTRLMSG(IDC_SUBTREES, NM_DBLCLK,       &SubtreesDlg::OnSubtreeDblClicked)
+	END_CTRLMSG_TABLE
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Dialog initialisation handler.
+
+void SubtreesDlg::OnInitDialog()
+{
+	// Initialise controls.
+	m_lvSubtrees.InsertColumn(PATH_COLUMN,       TXT("Path"),       250, LVCFMT_LEFT);
+	m_lvSubtrees.InsertColumn(NODES_COLUMN,      TXT("Nodes"),       75, LVCFMT_RIGHT);
+	m_lvSubtrees.InsertColumn(BYTES_COLUMN,      TXT("Bytes"),       90, LVCFMT_RIGHT);
+	m_lvSubtrees.InsertColumn(TEXT_COLUMN,       TXT("Text"),        90, LVCFMT_RIGHT);
+	m_lvSubtrees.InsertColumn(ATTRIBUTES_COLUMN, TXT("Attributes"),  90, LVCFMT_RIGHT);
+	m_lvSubtrees.FullRowSelect(true);
+
+	LoadSubtrees(SubtreeProfile::BYTES);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! OK button handler.
+
+bool SubtreesDlg::OnOk()
+{
+	if (m_lvSubtrees.IsSelection())
+	{
+		XML::Node* pNode = const_cast<XML::Node*>(m_vecEntries[m_lvSubtrees.Selection()].first);
+
+		m_pSelection = NodeRef(pNode).ToPtr();
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Column header clicked handler.
+
+LRESULT SubtreesDlg::OnColumnClicked(NMHDR& oMsgHdr)
+{
+	const NMLISTVIEW& oInfo = reinterpret_cast<const NMLISTVIEW&>(oMsgHdr);
+
+	if (oInfo.iSubItem == NODES_COLUMN)
+		LoadSubtrees(SubtreeProfile::DESCENDANTS);
+	else if (oInfo.iSubItem == BYTES_COLUMN)
+		LoadSubtrees(SubtreeProfile::BYTES);
+	else if (oInfo.iSubItem == TEXT_COLUMN)
+		LoadSubtrees(SubtreeProfile::TEXT_BYTES);
+	else if (oInfo.iSubItem == ATTRIBUTES_COLUMN)
+		LoadSubtrees(SubtreeProfile::ATTRIB_BYTES);
+
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Sub-tree double-clicked handler.
+
+LRESULT SubtreesDlg::OnSubtreeDblClicked(NMHDR& /*oMsgHdr*/)
+{
+	if (m_lvSubtrees.IsSelection())
+		EndDialog(IDOK);
+
+	return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Load the largest sub-trees by a measure.
+
+void SubtreesDlg::LoadSubtrees(SubtreeProfile::Metric eMetric)
+{
+	m_oProfile.GetLargest(eMetric, MAX_SUBTREES, m_vecEntries);
+
+	m_lvSubtrees.DeleteAllItems();
+
+	for (SubtreeProfile::Entries::const_iterator it = m_vecEntries.begin(); it != m_vecEntries.end(); ++it)
+	{
+		const SubtreeSize& oSize = it->second;
+
+		size_t n = m_lvSubtrees.ItemCount();
+
+		m_lvSubtrees.InsertItem(n,                    ElementPath(it->first));
+		m_lvSubtrees.ItemText  (n, NODES_COLUMN,      Core::fmt(TXT("%I64u"), oSize.m_nDescendants));
+		m_lvSubtrees.ItemText  (n, BYTES_COLUMN,      Core::fmt(TXT("%I64u"), oSize.m_nBytes));
+		m_lvSubtrees.ItemText  (n, TEXT_COLUMN,       Core::fmt(TXT("%I64u"), oSize.m_nTextBytes));
+		m_lvSubtrees.ItemText  (n, ATTRIBUTES_COLUMN, Core::fmt(TXT("%I64u"), oSize.m_nAttribBytes));
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the path of names from the root to an element.
+
+tstring SubtreesDlg::ElementPath(const XML::Node* pNode)
+{
+	tstring strPath;
+
+	while ( (pNode != nullptr) && (pNode->type() == XML::ELEMENT_NODE) )
+	{
+		strPath = TXT("/") + static_cast<const XML::ElementNode*>(pNode)->name() + strPath;
+
+		pNode = (pNode->hasParent()) ? pNode->parent().get() : nullptr;
+	}
+
+	return strPath;
+}
@@ -0,0 +1,81 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   SubtreesDlg.hpp
+//! \brief  The SubtreesDlg class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef SUBTREESDLG_HPP
+#define SUBTREESDLG_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <WCL/CommonUI.hpp>
+#include "SubtreeProfile.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+//! The dialog used to display the largest element sub-trees. Clicking a column
+//! ranks them by that measure instead and choosing one selects it in the tree.
+
+class SubtreesDlg : public CDialog
+{
+public:
+	//! Constructor.
+	SubtreesDlg(const SubtreeProfile& oProfile);
+	
+	//
+	// Members.
+	//
+	XML::NodePtr	m_pSelection;	//!< The element chosen, if any.
+
+private:
+	//! The sub-tree columns.
+	enum Column
+	{
+		PATH_COLUMN			= 0,	//!< The element path column.
+		NODES_COLUMN		= 1,	//!< The descendant count column.
+		BYTES_COLUMN		= 2,	//!< The markup size column.
+		TEXT_COLUMN			= 3,	//!< The text size column.
+		ATTRIBUTES_COLUMN	= 4,	//!< The attributes size column.
+	};
+
+	//
+	// Members.
+	//
+	const SubtreeProfile&	m_oProfile;		//!< The sub-tree sizes.
+	SubtreeProfile::Entries	m_vecEntries;	//!< The sub-trees shown.
+
+	//
+	// Controls.
+	//
+	CListView	m_lvSubtrees;		//!< The sub-trees view.
+
+	//
+	// Message handlers.
+	//
+
+	//! Dialog initialisation handler.
+	virtual void OnInitDialog();
+
+	//! OK button handler.
+	virtual bool OnOk();
+
+	//! Column header clicked handler.
+	LRESULT OnColumnClicked(NMHDR& oMsgHdr);
+
+	//! Sub-tree double-clicked handler.
+	LRESULT OnSubtreeDblClicked(NMHDR& oMsgHdr);
+
+	//
+	// Internal methods.
+	//
+
+	//! Load the largest sub-trees by a measure.
+	void LoadSubtrees(SubtreeProfile::Metric eMetric);
+
+	//! Get the path of names from the root to an element.
+	static tstring ElementPath(const XML::Node* pNode);
+};
+
+#endif // SUBTREESDLG_HPP
@@ -0,0 +1,25 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   Common.hpp
+//! \brief  Wrapper include file for the most common header files.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef TEST_COMMON_HPP
+#define TEST_COMMON_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// System headers.
+
+#include <Core/Common.hpp>		// Core library common headers.
+#include <WCL/Common.hpp>		// Windows C++ library common headers.
+
+////////////////////////////////////////////////////////////////////////////////
+// Test framework headers.
+
+#include <Core/UnitTest.hpp>
+
+#endif // TEST_COMMON_HPP
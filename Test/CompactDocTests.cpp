@@ -0,0 +1,145 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   CompactDocTests.cpp
+//! \brief  The unit tests for the CompactDoc class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "CompactDoc.hpp"
+#include <Core/RuntimeException.hpp>
+
+// The tests are built with the text stored as UTF-8, the form that has to be
+// converted as it is read.
+#ifndef APP_UTF8_STORAGE
+#error The CompactDoc tests expect APP_UTF8_STORAGE to be defined
+#endif
+
+//! The decoded value of the first item's text.
+static const tchar TEXT_VALUE[] = TXT("na\x00EFve & \x00FC") TXT("ber \xD83D\xDE00");
+
+//! A document with text outside ASCII in names, values and attributes.
+static const tchar NON_ASCII_DOC[] = TXT("<?xml version=\"1.0\"?>\n")
+									 TXT("<caf\x00E9 city=\"K\x00F8") TXT("benhavn\">\n")
+									 TXT("<item id=\"\x65E5\x672C\">na\x00EFve &amp; \x00FC") TXT("ber \xD83D\xDE00</item>\n")
+									 TXT("<item id=\"plain\"><![CDATA[\x00E0 <b>]]></item>\n")
+									 TXT("<!-- \x00E6\x00F8\x00E5 -->\n")
+									 TXT("</caf\x00E9>\n");
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse a document from a copy of its text.
+
+static void ParseText(CompactDoc& oDoc, const tchar* pszText)
+{
+	tstring strText = pszText;
+
+	oDoc.Parse(strText, true);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the first child of a node with a given type.
+
+static CompactDoc::NodeIndex FindChild(const CompactDoc& oDoc, CompactDoc::NodeIndex nParent, XML::NodeType eType)
+{
+	CompactDoc::NodeIndex nNode = oDoc.FirstChild(nParent);
+
+	while ( (nNode != CompactDoc::NO_NODE) && (oDoc.Type(nNode) != eType) )
+		nNode = oDoc.NextSibling(nNode);
+
+	return nNode;
+}
+
+TEST_SET(CompactDoc)
+{
+
+TEST_CASE(TXT("Names outside ASCII are converted back when handed out"))
+{
+	CompactDoc oDoc;
+
+	ParseText(oDoc, NON_ASCII_DOC);
+
+	CompactDoc::NodeIndex nRoot = FindChild(oDoc, CompactDoc::DOCUMENT, XML::ELEMENT_NODE);
+
+	TEST_TRUE(nRoot != CompactDoc::NO_NODE);
+	TEST_TRUE(oDoc.Name(nRoot) == TXT("caf\x00E9"));
+	TEST_TRUE(oDoc.Name(FindChild(oDoc, nRoot, XML::ELEMENT_NODE)) == TXT("item"));
+}
+TEST_CASE_END
+
+TEST_CASE(TXT("Attribute values outside ASCII are converted back when handed out"))
+{
+	CompactDoc             oDoc;
+	CompactDoc::Attributes vecAttribs;
+
+	ParseText(oDoc, NON_ASCII_DOC);
+
+	CompactDoc::NodeIndex nRoot = FindChild(oDoc, CompactDoc::DOCUMENT, XML::ELEMENT_NODE);
+
+	oDoc.GetAttributes(nRoot, vecAttribs);
+
+	TEST_TRUE(vecAttribs.size() == 1);
+	TEST_TRUE(vecAttribs[0].first == TXT("city"));
+	TEST_TRUE(vecAttribs[0].second == TXT("K\x00F8") TXT("benhavn"));
+}
+TEST_CASE_END
+
+TEST_CASE(TXT("Text outside the BMP survives conversion and decoding"))
+{
+	CompactDoc oDoc;
+
+	ParseText(oDoc, NON_ASCII_DOC);
+
+	CompactDoc::NodeIndex nRoot = FindChild(oDoc, CompactDoc::DOCUMENT, XML::ELEMENT_NODE);
+	CompactDoc::NodeIndex nItem = FindChild(oDoc, nRoot, XML::ELEMENT_NODE);
+	CompactDoc::NodeIndex nText = FindChild(oDoc, nItem, XML::TEXT_NODE);
+
+	TEST_TRUE(oDoc.NeedsDecoding(nText));
+	TEST_TRUE(oDoc.Value(nText) == TEXT_VALUE);
+}
+TEST_CASE_END
+
+TEST_CASE(TXT("CDATA and comments outside ASCII are converted back when handed out"))
+{
+	CompactDoc oDoc;
+
+	ParseText(oDoc, NON_ASCII_DOC);
+
+	CompactDoc::NodeIndex nRoot  = FindChild(oDoc, CompactDoc::DOCUMENT, XML::ELEMENT_NODE);
+	CompactDoc::NodeIndex nItem  = oDoc.NextSibling(FindChild(oDoc, nRoot, XML::ELEMENT_NODE));
+	CompactDoc::NodeIndex nCData = FindChild(oDoc, nItem, XML::CDATA_NODE);
+
+	TEST_TRUE(oDoc.Value(nCData) == TXT("\x00E0 <b>"));
+	TEST_TRUE(oDoc.Value(FindChild(oDoc, nRoot, XML::COMMENT_NODE)) == TXT(" \x00E6\x00F8\x00E5 "));
+}
+TEST_CASE_END
+
+TEST_CASE(TXT("A query compares attribute values outside ASCII"))
+{
+	CompactDoc              oDoc;
+	CompactDoc::NodeIndices vecNodes;
+
+	ParseText(oDoc, NON_ASCII_DOC);
+
+	TEST_TRUE(oDoc.Query(TXT("//item[@id='\x65E5\x672C']"), vecNodes));
+	TEST_TRUE(vecNodes.size() == 1);
+	TEST_TRUE(oDoc.Value(FindChild(oDoc, vecNodes[0], XML::TEXT_NODE)) == TEXT_VALUE);
+}
+TEST_CASE_END
+
+TEST_CASE(TXT("An error is reported at the line of the stored text it was found on"))
+{
+	CompactDoc oDoc;
+
+	TEST_THROWS(ParseText(oDoc, TXT("<caf\x00E9>\n<\x00E9l\x00E8ve>\n</caf\x00E9>\n")));
+
+	try
+	{
+		ParseText(oDoc, TXT("<caf\x00E9>\n<\x00E9l\x00E8ve>\n</caf\x00E9>\n"));
+	}
+	catch (const Core::RuntimeException& e)
+	{
+		TEST_TRUE(tstring(e.twhat()).find(TXT("line 3")) != tstring::npos);
+	}
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
@@ -0,0 +1,223 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   DocArenaTests.cpp
+//! \brief  The unit tests for the DocArena class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "DocArena.hpp"
+#include <XML/Document.hpp>
+#include <XML/ElementNode.hpp>
+#include <XML/TextNode.hpp>
+
+////////////////////////////////////////////////////////////////////////////////
+//! Build a document with a root and the given number of child elements, each
+//! with an attribute and some text.
+
+static XML::DocumentPtr BuildDocument(size_t nElements)
+{
+	XML::DocumentPtr    pDocument(new XML::Document);
+	XML::ElementNodePtr pRoot(new XML::ElementNode(TXT("root")));
+
+	pDocument->appendChild(pRoot);
+
+	for (size_t i = 0; i != nElements; ++i)
+	{
+		XML::ElementNodePtr pElement(new XML::ElementNode(TXT("record")));
+
+		pElement->getAttributes().set(TXT("id"), Core::fmt(TXT("%u"), static_cast<uint>(i)));
+		pElement->appendChild(XML::NodePtr(new XML::TextNode(TXT("Some text for the record"))));
+
+		pRoot->appendChild(pElement);
+	}
+
+	return pDocument;
+}
+
+TEST_SET(DocArena)
+{
+
+TEST_CASE(TXT("Only blocks allocated inside a scope come from the arena"))
+{
+	DocArena oArena;
+	tstring* pOutside = new tstring(TXT("outside"));
+
+	TEST_TRUE(oArena.Blocks() == 0);
+
+	int* pInside = nullptr;
+
+	{
+		DocArena::Scope oScope(&oArena);
+
+		pInside = new int(42);
+	}
+
+	TEST_TRUE(oArena.Blocks() == 1);
+
+	delete pInside;
+	delete pOutside;
+
+	TEST_TRUE(oArena.Blocks() == 0);
+}
+TEST_CASE_END
+
+TEST_CASE(TXT("A block too large for the arena comes from the CRT heap"))
+{
+	DocArena oArena;
+	byte*    pLarge = nullptr;
+	byte*    pSmall = nullptr;
+
+	{
+		DocArena::Scope oScope(&oArena);
+
+		pLarge = new byte[4096];
+		pSmall = new byte[16];
+	}
+
+	TEST_TRUE(oArena.Blocks() == 1);
+
+	delete[] pLarge;
+	delete[] pSmall;
+
+	TEST_TRUE(oArena.Blocks() == 0);
+}
+TEST_CASE_END
+
+TEST_CASE(TXT("A freed block is reused for the next block of the same size"))
+{
+	DocArena oArena;
+
+	DocArena::Scope oScope(&oArena);
+
+	int* pFirst = new int(1);
+
+	delete pFirst;
+
+	int* pSecond = new int(2);
+
+	TEST_TRUE(pSecond == pFirst);
+
+	delete pSecond;
+}
+TEST_CASE_END
+
+TEST_CASE(TXT("A null arena restores the CRT heap within an outer scope"))
+{
+	DocArena oArena;
+	int*     pBlock = nullptr;
+
+	{
+		DocArena::Scope oOuter(&oArena);
+
+		{
+			DocArena::Scope oInner(nullptr);
+
+			pBlock = new int(42);
+		}
+
+		TEST_TRUE(oArena.Blocks() == 0);
+	}
+
+	delete pBlock;
+}
+TEST_CASE_END
+
+TEST_CASE(TXT("A cancelled arena fails every allocation in its scope"))
+{
+	DocArena oArena;
+
+	oArena.Cancel();
+
+	TEST_TRUE(oArena.IsCancelled());
+
+	{
+		DocArena::Scope oScope(&oArena);
+
+		TEST_THROWS(new int(42));
+		TEST_THROWS(new byte[4096]);
+	}
+
+	int* pBlock = new int(42);
+
+	TEST_TRUE(oArena.Blocks() == 0);
+
+	delete pBlock;
+}
+TEST_CASE_END
+
+TEST_CASE(TXT("An arena is cancelled once its limit has been reached"))
+{
+	const size_t BLOCK_SIZE = 64 * 1024;
+	const size_t LIMIT      = 1024 * 1024;
+
+	DocArena            oArena;
+	std::vector<byte*>  vecBlocks;
+	bool                bFailed = false;
+
+	oArena.SetLimit(LIMIT);
+	vecBlocks.reserve(LIMIT / BLOCK_SIZE + 1);
+
+	{
+		DocArena::Scope oScope(&oArena);
+
+		try
+		{
+			for (size_t i = 0; i != (LIMIT / BLOCK_SIZE) + 1; ++i)
+				vecBlocks.push_back(new byte[BLOCK_SIZE]);
+		}
+		catch (const std::bad_alloc&)
+		{
+			bFailed = true;
+		}
+	}
+
+	TEST_TRUE(bFailed);
+	TEST_TRUE(vecBlocks.size() == LIMIT / BLOCK_SIZE);
+	TEST_TRUE(oArena.IsCancelled());
+
+	for (std::vector<byte*>::const_iterator it = vecBlocks.begin(); it != vecBlocks.end(); ++it)
+		delete[] *it;
+}
+TEST_CASE_END
+
+TEST_CASE(TXT("A block allocated inside a scope is still valid after the arena has been destroyed"))
+{
+	DocArena* pArena = new DocArena;
+	tstring*  pValue = nullptr;
+
+	{
+		DocArena::Scope oScope(pArena);
+
+		pValue = new tstring(TXT("a value that outlives the document"));
+	}
+
+	delete pArena;
+
+	TEST_TRUE(*pValue == TXT("a value that outlives the document"));
+
+	delete pValue;
+}
+TEST_CASE_END
+
+TEST_CASE(TXT("A document can be released after its arena has been destroyed"))
+{
+	DocArena*        pArena = new DocArena;
+	XML::DocumentPtr pDocument;
+
+	{
+		DocArena::Scope oScope(pArena);
+
+		pDocument = BuildDocument(1000);
+	}
+
+	TEST_TRUE(pArena->Blocks() != 0);
+
+	delete pArena;
+
+	TEST_TRUE(pDocument->getChild(0)->type() == XML::ELEMENT_NODE);
+
+	pDocument.reset();
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
@@ -0,0 +1,240 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   NodeCursorTests.cpp
+//! \brief  The unit tests for the NodeCursor class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "NodeCursor.hpp"
+#include <XML/Document.hpp>
+#include <XML/ElementNode.hpp>
+#include <XML/TextNode.hpp>
+
+//! The depth of the generated deeply nested document.
+static const size_t DEEP_DOCUMENT_DEPTH = 1000000;
+
+//! The elements of a deeply nested document, outermost first.
+typedef std::vector<XML::ElementNode*> Chain;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Build a document that is a single chain of nested elements, with a text
+//! node inside the innermost one.
+
+static XML::DocumentPtr BuildChain(size_t nDepth, Chain& vecChain)
+{
+	XML::DocumentPtr    pDocument(new XML::Document);
+	XML::NodeContainer* pParent = pDocument.get();
+
+	vecChain.reserve(nDepth);
+
+	for (size_t i = 0; i != nDepth; ++i)
+	{
+		XML::ElementNode* pElement = new XML::ElementNode(TXT("e"));
+
+		pParent->appendChild(XML::NodePtr(pElement));
+		vecChain.push_back(pElement);
+
+		pParent = pElement;
+	}
+
+	pParent->appendChild(XML::NodePtr(new XML::TextNode(TXT("leaf"))));
+
+	return pDocument;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Build a small document of the elements <a><b>t</b><c/></a> followed by the
+//! text x.
+
+static XML::DocumentPtr BuildTree()
+{
+	XML::DocumentPtr    pDocument(new XML::Document);
+	XML::ElementNodePtr pA(new XML::ElementNode(TXT("a")));
+	XML::ElementNodePtr pB(new XML::ElementNode(TXT("b")));
+	XML::ElementNodePtr pC(new XML::ElementNode(TXT("c")));
+
+	pB->appendChild(XML::NodePtr(new XML::TextNode(TXT("t"))));
+	pA->appendChild(pB);
+	pA->appendChild(pC);
+	pDocument->appendChild(pA);
+	pDocument->appendChild(XML::NodePtr(new XML::TextNode(TXT("x"))));
+
+	return pDocument;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Describe the walk of a document as the node names, or text, and depths.
+
+static tstring Walk(const XML::NodeContainer& oRoot, NodeCursor::Order eOrder, const tchar* pszSkip = TXT(""))
+{
+	tstring strWalk;
+
+	for (NodeCursor oCursor(oRoot, eOrder); oCursor.Next(); )
+	{
+		NodeRef pNode = oCursor.Node();
+		tstring strName;
+
+		if (pNode->type() == XML::ELEMENT_NODE)
+			strName = pNode.As<XML::ElementNode>()->name();
+		else
+			strName = pNode.As<XML::TextNode>()->text();
+
+		strWalk += Core::fmt(TXT("%s%u "), strName.c_str(), static_cast<uint>(oCursor.Depth()));
+
+		if (strName == pszSkip)
+			oCursor.SkipChildren();
+	}
+
+	return strWalk;
+}
+
+TEST_SET(NodeCursor)
+{
+
+TEST_CASE(TXT("A preorder walk visits each node before its children"))
+{
+	XML::DocumentPtr pDocument = BuildTree();
+
+	TEST_TRUE(Walk(*pDocument, NodeCursor::PREORDER) == TXT("a1 b2 t3 c2 x1 "));
+}
+TEST_CASE_END
+
+TEST_CASE(TXT("A postorder walk visits each node after its children"))
+{
+	XML::DocumentPtr pDocument = BuildTree();
+
+	TEST_TRUE(Walk(*pDocument, NodeCursor::POSTORDER) == TXT("t3 b2 c2 a1 x1 "));
+}
+TEST_CASE_END
+
+TEST_CASE(TXT("The children of a node can be skipped on a preorder walk"))
+{
+	XML::DocumentPtr pDocument = BuildTree();
+
+	TEST_TRUE(Walk(*pDocument, NodeCursor::PREORDER, TXT("b")) == TXT("a1 b2 c2 x1 "));
+	TEST_TRUE(Walk(*pDocument, NodeCursor::PREORDER, TXT("a")) == TXT("a1 x1 "));
+}
+TEST_CASE_END
+
+TEST_CASE(TXT("Walking an empty container visits nothing"))
+{
+	XML::DocumentPtr pDocument(new XML::Document);
+	NodeCursor       oCursor(*pDocument);
+
+	TEST_FALSE(oCursor.Next());
+	TEST_TRUE(oCursor.Node().get() == nullptr);
+	TEST_TRUE(oCursor.Depth() == 0);
+}
+TEST_CASE_END
+
+TEST_CASE(TXT("A preorder walk of a document nested a million deep visits every node in order"))
+{
+	Chain            vecChain;
+	XML::DocumentPtr pDocument = BuildChain(DEEP_DOCUMENT_DEPTH, vecChain);
+	NodeCursor       oCursor(*pDocument);
+	bool             bInOrder = true;
+
+	for (size_t i = 0; i != DEEP_DOCUMENT_DEPTH; ++i)
+	{
+		if ( (!oCursor.Next()) || (oCursor.Node().get() != vecChain[i]) || (oCursor.Depth() != i+1) )
+		{
+			bInOrder = false;
+			break;
+		}
+	}
+
+	TEST_TRUE(bInOrder);
+	TEST_TRUE(oCursor.Next());
+	TEST_TRUE(oCursor.Node()->type() == XML::TEXT_NODE);
+	TEST_TRUE(oCursor.Depth() == DEEP_DOCUMENT_DEPTH+1);
+	TEST_FALSE(oCursor.Next());
+
+	NodeCursor::ReleaseChildren(*pDocument);
+}
+TEST_CASE_END
+
+TEST_CASE(TXT("A postorder walk of a document nested a million deep visits every node in order"))
+{
+	Chain            vecChain;
+	XML::DocumentPtr pDocument = BuildChain(DEEP_DOCUMENT_DEPTH, vecChain);
+	NodeCursor       oCursor(*pDocument, NodeCursor::POSTORDER);
+
+	TEST_TRUE(oCursor.Next());
+	TEST_TRUE(oCursor.Node()->type() == XML::TEXT_NODE);
+	TEST_TRUE(oCursor.Depth() == DEEP_DOCUMENT_DEPTH+1);
+
+	bool bInOrder = true;
+
+	for (size_t i = DEEP_DOCUMENT_DEPTH; i != 0; --i)
+	{
+		if ( (!oCursor.Next()) || (oCursor.Node().get() != vecChain[i-1]) || (oCursor.Depth() != i) )
+		{
+			bInOrder = false;
+			break;
+		}
+	}
+
+	TEST_TRUE(bInOrder);
+	TEST_FALSE(oCursor.Next());
+
+	NodeCursor::ReleaseChildren(*pDocument);
+}
+TEST_CASE_END
+
+TEST_CASE(TXT("A walk of a document nested a million deep can be suspended and resumed"))
+{
+	Chain            vecChain;
+	XML::DocumentPtr pDocument = BuildChain(DEEP_DOCUMENT_DEPTH, vecChain);
+	NodeCursor       oCursor(*pDocument);
+	size_t           nVisited = 0;
+
+	// Walk in slices, as the UI thread does.
+	for (bool bMore = true; bMore; )
+	{
+		for (size_t i = 0; (i != 1000) && (bMore); ++i)
+		{
+			bMore = oCursor.Next();
+
+			if (bMore)
+				++nVisited;
+		}
+	}
+
+	TEST_TRUE(nVisited == DEEP_DOCUMENT_DEPTH+1);
+
+	NodeCursor::ReleaseChildren(*pDocument);
+}
+TEST_CASE_END
+
+TEST_CASE(TXT("Releasing the children of a document detaches every node"))
+{
+	XML::DocumentPtr  pDocument = BuildTree();
+	XML::NodePtr      pA        = pDocument->getChild(0);
+	XML::ElementNode* pElement  = NodeRef(pA).As<XML::ElementNode>();
+	XML::NodePtr      pB        = pElement->getChild(0);
+
+	NodeCursor::ReleaseChildren(*pDocument);
+
+	TEST_FALSE(pDocument->hasChildren());
+	TEST_FALSE(pA->hasParent());
+	TEST_FALSE(pElement->hasChildren());
+	TEST_FALSE(pB->hasParent());
+}
+TEST_CASE_END
+
+TEST_CASE(TXT("A document nested a million deep can be released without recursing"))
+{
+	Chain            vecChain;
+	XML::DocumentPtr pDocument = BuildChain(DEEP_DOCUMENT_DEPTH, vecChain);
+
+	NodeCursor::ReleaseChildren(*pDocument);
+
+	TEST_FALSE(pDocument->hasChildren());
+
+	pDocument.reset();
+
+	TEST_TRUE(pDocument.get() == nullptr);
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
@@ -0,0 +1,323 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   NodeStreamTests.cpp
+//! \brief  The unit tests for the NodeStream class.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "NodeStream.hpp"
+#include <XML/Document.hpp>
+#include <XML/ElementNode.hpp>
+#include <XML/TextNode.hpp>
+#include <XML/CommentNode.hpp>
+#include <XML/CDataNode.hpp>
+#include <XML/ProcessingNode.hpp>
+
+//! The number of random bit flips applied to a stream.
+static const size_t BIT_FLIPS = 20000;
+
+//! The state of the pseudo-random sequence, fixed so that failures repeat.
+static uint32 s_nSeed = 42;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the next number in the pseudo-random sequence.
+
+static uint32 Random(uint32 nRange)
+{
+	s_nSeed = (s_nSeed * 1103515245) + 12345;
+
+	return (s_nSeed >> 8) % nRange;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Encode a sub-tree, failing the test if it can't be.
+
+static NodeStream::Buffer Encode(NodeRef pRoot)
+{
+	NodeStream::Buffer vecStream;
+
+	TEST_TRUE(NodeStream::Write(pRoot, vecStream));
+
+	return vecStream;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Decode a whole stream.
+
+static XML::NodePtr Decode(const NodeStream::Buffer& vecStream)
+{
+	return NodeStream::Read(&vecStream.front(), &vecStream.front() + vecStream.size(), nullptr);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if decoding the first bytes of a stream is rejected.
+
+static bool IsRejected(const NodeStream::Buffer& vecStream, size_t nLength)
+{
+	try
+	{
+		NodeStream::Read(&vecStream.front(), &vecStream.front() + nLength, nullptr);
+	}
+	catch (const Core::Exception& /*e*/)
+	{
+		return true;
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if a sub-tree survives a round trip, i.e. the decoded copy encodes to
+//! the same bytes as the original.
+
+static bool RoundTrips(NodeRef pRoot)
+{
+	NodeStream::Buffer vecStream = Encode(pRoot);
+	XML::NodePtr       pCopy     = Decode(vecStream);
+
+	return ( (pCopy.get() != pRoot.get()) && (Encode(pCopy) == vecStream) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Generate some text that contains markup and non-ASCII characters.
+
+static tstring RandomText(size_t nMaxLength)
+{
+	static const tchar szChars[] = TXT("ab<>&\"\n xyz\x00e9");
+
+	tstring strText;
+
+	for (size_t nLength = Random(static_cast<uint32>(nMaxLength)); nLength != 0; --nLength)
+		strText += szChars[Random(static_cast<uint32>((sizeof(szChars)/sizeof(tchar))-1))];
+
+	return strText;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Build a tree of the given number of nodes of every type.
+
+static XML::ElementNodePtr BuildTree(size_t nNodes)
+{
+	XML::ElementNodePtr              pRoot(new XML::ElementNode(TXT("root")));
+	std::vector<XML::NodeContainer*> vecElements(1, pRoot.get());
+
+	for (size_t i = 1; i != nNodes; ++i)
+	{
+		XML::NodeContainer* pParent = vecElements[Random(static_cast<uint32>(vecElements.size()))];
+		XML::NodePtr        pNode;
+
+		switch (Random(5))
+		{
+			case 0:
+			{
+				XML::ElementNode* pElement = new XML::ElementNode(Core::fmt(TXT("e%u"), Random(50)));
+
+				for (uint32 nAttributes = Random(4); nAttributes != 0; --nAttributes)
+					pElement->getAttributes().set(Core::fmt(TXT("a%u"), Random(10)), RandomText(20));
+
+				pNode = XML::NodePtr(pElement);
+				vecElements.push_back(pElement);
+			}
+			break;
+
+			case 1:
+			{
+				pNode = XML::NodePtr(new XML::TextNode(RandomText(40)));
+			}
+			break;
+
+			case 2:
+			{
+				pNode = XML::NodePtr(new XML::CommentNode(RandomText(10)));
+			}
+			break;
+
+			case 3:
+			{
+				pNode = XML::NodePtr(new XML::CDataNode(RandomText(30)));
+			}
+			break;
+
+			default:
+			{
+				XML::ProcessingNode* pProcInst = new XML::ProcessingNode(TXT("pi"));
+
+				pProcInst->getAttributes().set(TXT("x"), RandomText(5));
+
+				pNode = XML::NodePtr(pProcInst);
+			}
+			break;
+		}
+
+		pParent->appendChild(pNode);
+	}
+
+	return pRoot;
+}
+
+TEST_SET(NodeStream)
+{
+
+TEST_CASE(TXT("An element with attributes and children survives a round trip"))
+{
+	XML::ElementNodePtr pElement(new XML::ElementNode(TXT("a")));
+
+	pElement->getAttributes().set(TXT("x"), TXT("1 & <2>"));
+	pElement->getAttributes().set(TXT("y"), TXT(""));
+	pElement->appendChild(XML::NodePtr(new XML::ElementNode(TXT("b"))));
+	pElement->appendChild(XML::NodePtr(new XML::TextNode(TXT("t"))));
+
+	XML::NodePtr pCopy = Decode(Encode(NodeRef(pElement.get())));
+
+	TEST_TRUE(pCopy->type() == XML::ELEMENT_NODE);
+
+	const XML::ElementNode* pCopied = NodeRef(pCopy).As<XML::ElementNode>();
+
+	TEST_TRUE(pCopied->name() == TXT("a"));
+	TEST_TRUE(pCopied->getAttributes().count() == 2);
+	TEST_TRUE(pCopied->getAttributes().find(TXT("x"))->value() == TXT("1 & <2>"));
+	TEST_TRUE(pCopied->getAttributes().find(TXT("y"))->value() == TXT(""));
+	TEST_TRUE(pCopied->getChildCount() == 2);
+	TEST_TRUE(RoundTrips(NodeRef(pElement.get())));
+}
+TEST_CASE_END
+
+TEST_CASE(TXT("A text node survives a round trip"))
+{
+	XML::NodePtr pText(new XML::TextNode(TXT("some <text> & \x00e9")));
+	XML::NodePtr pCopy = Decode(Encode(pText));
+
+	TEST_TRUE(pCopy->type() == XML::TEXT_NODE);
+	TEST_TRUE(NodeRef(pCopy).As<XML::TextNode>()->text() == TXT("some <text> & \x00e9"));
+}
+TEST_CASE_END
+
+TEST_CASE(TXT("A comment node survives a round trip"))
+{
+	XML::NodePtr pComment(new XML::CommentNode(TXT(" a comment ")));
+	XML::NodePtr pCopy = Decode(Encode(pComment));
+
+	TEST_TRUE(pCopy->type() == XML::COMMENT_NODE);
+	TEST_TRUE(NodeRef(pCopy).As<XML::CommentNode>()->comment() == TXT(" a comment "));
+}
+TEST_CASE_END
+
+TEST_CASE(TXT("A CDATA node survives a round trip"))
+{
+	XML::NodePtr pCData(new XML::CDataNode(TXT("<unparsed> & ]]")));
+	XML::NodePtr pCopy = Decode(Encode(pCData));
+
+	TEST_TRUE(pCopy->type() == XML::CDATA_NODE);
+	TEST_TRUE(NodeRef(pCopy).As<XML::CDataNode>()->text() == TXT("<unparsed> & ]]"));
+}
+TEST_CASE_END
+
+TEST_CASE(TXT("A processing instruction survives a round trip"))
+{
+	XML::ProcessingNode* pProcInst = new XML::ProcessingNode(TXT("xml-stylesheet"));
+	XML::NodePtr         pNode(pProcInst);
+
+	pProcInst->getAttributes().set(TXT("href"), TXT("style.xsl"));
+
+	XML::NodePtr pCopy = Decode(Encode(pNode));
+
+	TEST_TRUE(pCopy->type() == XML::PROCESSING_NODE);
+
+	const XML::ProcessingNode* pCopied = NodeRef(pCopy).As<XML::ProcessingNode>();
+
+	TEST_TRUE(pCopied->target() == TXT("xml-stylesheet"));
+	TEST_TRUE(pCopied->getAttributes().find(TXT("href"))->value() == TXT("style.xsl"));
+}
+TEST_CASE_END
+
+TEST_CASE(TXT("A large tree of every node type survives a round trip"))
+{
+	XML::ElementNodePtr pRoot = BuildTree(10000);
+
+	TEST_TRUE(RoundTrips(NodeRef(pRoot.get())));
+}
+TEST_CASE_END
+
+TEST_CASE(TXT("A document can't be encoded"))
+{
+	XML::DocumentPtr   pDocument(new XML::Document);
+	NodeStream::Buffer vecStream;
+
+	TEST_FALSE(NodeStream::CanWrite(NodeRef(pDocument.get())));
+	TEST_FALSE(NodeStream::Write(NodeRef(pDocument.get()), vecStream));
+}
+TEST_CASE_END
+
+TEST_CASE(TXT("Every node that can appear inside an element can be encoded"))
+{
+	XML::ElementNodePtr pRoot = BuildTree(100);
+
+	TEST_TRUE(NodeStream::CanWrite(NodeRef(pRoot.get())));
+
+	for (XML::NodeContainer::const_iterator it = pRoot->beginChild(); it != pRoot->endChild(); ++it)
+		TEST_TRUE(NodeStream::CanWrite(NodeRef(*it)));
+}
+TEST_CASE_END
+
+TEST_CASE(TXT("Any bytes after the end of a stream are ignored"))
+{
+	XML::ElementNodePtr pRoot     = BuildTree(100);
+	NodeStream::Buffer  vecStream = Encode(NodeRef(pRoot.get()));
+	NodeStream::Buffer  vecPadded = vecStream;
+
+	vecPadded.resize(vecPadded.size() + 13, 0xCC);
+
+	TEST_TRUE(Encode(Decode(vecPadded)) == vecStream);
+}
+TEST_CASE_END
+
+TEST_CASE(TXT("A stream written by an incompatible version is rejected"))
+{
+	XML::NodePtr       pText(new XML::TextNode(TXT("t")));
+	NodeStream::Buffer vecStream = Encode(pText);
+	NodeStream::Buffer vecMagic  = vecStream;
+
+	vecStream[4] ^= 0xFF;	// The format version.
+	vecMagic[0]  ^= 0xFF;
+
+	TEST_THROWS(Decode(vecStream));
+	TEST_THROWS(Decode(vecMagic));
+}
+TEST_CASE_END
+
+TEST_CASE(TXT("A stream truncated at any length is rejected"))
+{
+	XML::ElementNodePtr pRoot     = BuildTree(100);
+	NodeStream::Buffer  vecStream = Encode(NodeRef(pRoot.get()));
+	bool                bRejected = true;
+
+	for (size_t nLength = 0; (nLength != vecStream.size()) && (bRejected); ++nLength)
+		bRejected = IsRejected(vecStream, nLength);
+
+	TEST_TRUE(bRejected);
+}
+TEST_CASE_END
+
+TEST_CASE(TXT("A stream with random bits flipped is rejected or decoded without crashing"))
+{
+	XML::ElementNodePtr pRoot     = BuildTree(100);
+	NodeStream::Buffer  vecStream = Encode(NodeRef(pRoot.get()));
+	size_t              nRejected = 0;
+
+	for (size_t i = 0; i != BIT_FLIPS; ++i)
+	{
+		NodeStream::Buffer vecCorrupt = vecStream;
+
+		for (uint32 nFlips = Random(3) + 1; nFlips != 0; --nFlips)
+			vecCorrupt[Random(static_cast<uint32>(vecCorrupt.size()))] ^= static_cast<byte>(1 << Random(8));
+
+		if (IsRejected(vecCorrupt, vecCorrupt.size()))
+			++nRejected;
+	}
+
+	// Most flips land in the strings, which are still valid.
+	TEST_TRUE(nRejected != 0);
+}
+TEST_CASE_END
+
+}
+TEST_SET_END
@@ -0,0 +1,18 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   Test.cpp
+//! \brief  The unit test runner for the application's non-UI classes.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+//! The entry point for the test runner.
+
+TEST_SUITE(int argc, tchar* argv[])
+{
+	TEST_SUITE_RUN(CompactDoc);
+	TEST_SUITE_RUN(DocArena);
+	TEST_SUITE_RUN(NodeCursor);
+	TEST_SUITE_RUN(NodeStream);
+}
+TEST_SUITE_END
@@ -0,0 +1,418 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   TextDecoder.cpp
+//! \brief  The TextDecoder class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "TextDecoder.hpp"
+#include <Core/RuntimeException.hpp>
+#include "FastScan.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+// Constants.
+
+//! The shortest run of ASCII worth leaving the code page conversion for.
+static const size_t MIN_ASCII_RUN = 16;
+
+//! The largest block handed to the Win32 conversion functions in one call.
+static const size_t MAX_SLICE_SIZE = 16 * 1024 * 1024;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the length of the UTF-8 sequence that starts with the lead byte.
+
+static size_t Utf8SequenceLength(byte cLead)
+{
+	if (cLead < 0xC0)
+		return 1;
+	if (cLead < 0xE0)
+		return 2;
+	if (cLead < 0xF0)
+		return 3;
+	if (cLead < 0xF8)
+		return 4;
+
+	return 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the character is 7-bit ASCII.
+
+static bool IsAscii(char cChar)
+{
+	return ((cChar & 0x80) == 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the start of the next run of ASCII long enough to be worth copying
+//! directly. Returns the end of the range if there isn't one.
+
+static const char* FindAsciiRun(const char* pBegin, const char* pEnd)
+{
+	const char* pCurrent = pBegin;
+
+	while (pCurrent != pEnd)
+	{
+		const char* pRunBegin = std::find_if(pCurrent, pEnd, IsAscii);
+		const char* pRunEnd   = FastScan::SkipAscii(pRunBegin, pEnd);
+
+		if ( (pRunEnd == pEnd) || (static_cast<size_t>(pRunEnd - pRunBegin) >= MIN_ASCII_RUN) )
+			return pRunBegin;
+
+		pCurrent = pRunEnd;
+	}
+
+	return pEnd;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append a run of ASCII characters, which is the same in every encoding.
+
+static void AppendAscii(const char* pBegin, const char* pEnd, tstring& strOutput)
+{
+	if (pBegin == pEnd)
+		return;
+
+#ifdef _UNICODE
+	size_t nOffset = strOutput.size();
+
+	strOutput.resize(nOffset + (pEnd - pBegin));
+	FastScan::WidenAscii(pBegin, pEnd, &strOutput[nOffset]);
+#else
+	strOutput.append(pBegin, pEnd);
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Convert a character to lower case, without a negative char reaching the
+//! C runtime function.
+
+static char ToLower(char cChar)
+{
+	return static_cast<char>(::tolower(static_cast<unsigned char>(cChar)));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+TextDecoder::TextDecoder()
+	: m_eEncoding(UNKNOWN)
+	, m_bByteOrderMark(false)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Construct for text in a known encoding. No detection is done and so any
+//! byte order mark is decoded as part of the text.
+
+TextDecoder::TextDecoder(Encoding eEncoding)
+	: m_eEncoding(eEncoding)
+	, m_bByteOrderMark(false)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Decode the next block of bytes, appending the text to the output.
+
+void TextDecoder::Decode(const byte* pBegin, const byte* pEnd, tstring& strOutput)
+{
+	// Buffer until we have enough bytes to detect the encoding.
+	if (m_eEncoding == UNKNOWN)
+	{
+		m_vecPending.insert(m_vecPending.end(), pBegin, pEnd);
+
+		if (m_vecPending.size() < MAX_DETECT_SIZE)
+			return;
+
+		std::vector<byte> vecInput;
+
+		vecInput.swap(m_vecPending);
+
+		const byte* pInputBegin = &vecInput.front();
+		const byte* pInputEnd   = pInputBegin + vecInput.size();
+
+		Decode(DetectEncoding(pInputBegin, pInputEnd), pInputEnd, strOutput);
+		return;
+	}
+
+	while (pBegin != pEnd)
+	{
+		const byte* pSliceEnd = pBegin + std::min<size_t>(pEnd - pBegin, MAX_SLICE_SIZE);
+
+		DecodeSlice(pBegin, pSliceEnd, strOutput);
+
+		pBegin = pSliceEnd;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Signal the end of the input, flushing any undecoded bytes.
+
+void TextDecoder::Finish(tstring& strOutput)
+{
+	// Input too short to fill the detection buffer?
+	if (m_eEncoding == UNKNOWN)
+	{
+		std::vector<byte> vecInput;
+
+		vecInput.swap(m_vecPending);
+
+		if (vecInput.empty())
+		{
+			m_eEncoding = ANSI;
+			return;
+		}
+
+		const byte* pInputBegin = &vecInput.front();
+		const byte* pInputEnd   = pInputBegin + vecInput.size();
+
+		Decode(DetectEncoding(pInputBegin, pInputEnd), pInputEnd, strOutput);
+	}
+
+	if (!m_vecPending.empty())
+		throw Core::RuntimeException(TXT("The text ends with an incomplete character"));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Decode a block no larger than the maximum conversion size.
+
+void TextDecoder::DecodeSlice(const byte* pBegin, const byte* pEnd, tstring& strOutput)
+{
+	// Complete the partial character from the previous block first.
+	if (!m_vecPending.empty())
+	{
+		size_t nPending = m_vecPending.size();
+		size_t nTaken   = std::min<size_t>(pEnd - pBegin, 4);
+
+		m_vecPending.insert(m_vecPending.end(), pBegin, pBegin + nTaken);
+
+		const byte* pPendingBegin = &m_vecPending.front();
+		const byte* pPendingEnd   = pPendingBegin + m_vecPending.size();
+		const byte* pComplete     = FindCompleteEnd(pPendingBegin, pPendingEnd);
+		size_t      nLeftover     = pPendingEnd - pComplete;
+
+		// Still incomplete?
+		if (nLeftover >= (nPending + nTaken))
+			return;
+
+		Convert(pPendingBegin, pComplete, strOutput);
+
+		pBegin += nTaken - nLeftover;
+		m_vecPending.clear();
+	}
+
+	const byte* pComplete = FindCompleteEnd(pBegin, pEnd);
+
+	Convert(pBegin, pComplete, strOutput);
+
+	m_vecPending.assign(pComplete, pEnd);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Detect the encoding and skip any byte order mark. Without a byte order mark
+//! the XML declaration is used, which is also enough to tell UTF-16 apart. The
+//! range should hold up to MAX_DETECT_SIZE bytes when they are available.
+
+const byte* TextDecoder::DetectEncoding(const byte* pBegin, const byte* pEnd)
+{
+	size_t nSize = pEnd - pBegin;
+
+	m_bByteOrderMark = false;
+
+	if ( (nSize >= 3) && (pBegin[0] == 0xEF) && (pBegin[1] == 0xBB) && (pBegin[2] == 0xBF) )
+	{
+		m_eEncoding      = UTF_8;
+		m_bByteOrderMark = true;
+		return pBegin + 3;
+	}
+
+	if ( (nSize >= 2) && (pBegin[0] == 0xFF) && (pBegin[1] == 0xFE) )
+	{
+		m_eEncoding      = UTF_16LE;
+		m_bByteOrderMark = true;
+		return pBegin + 2;
+	}
+
+	if ( (nSize >= 4) && (pBegin[0] == '<') && (pBegin[1] == 0) && (pBegin[2] == '?') && (pBegin[3] == 0) )
+	{
+		m_eEncoding = UTF_16LE;
+		return pBegin;
+	}
+
+	Encoding eDeclared = DeclaredEncoding(pBegin, pEnd);
+
+	m_eEncoding = (eDeclared != UNKNOWN) ? eDeclared : ANSI;
+	return pBegin;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the encoding named by an XML declaration at the start of the text. A
+//! declaration without an encoding means UTF-8 and any other name is treated
+//! as the ANSI code page. Returns UNKNOWN if there is no declaration.
+
+TextDecoder::Encoding TextDecoder::DeclaredEncoding(const byte* pBegin, const byte* pEnd)
+{
+	static const char s_szXmlDecl[]  = "<?xml";
+	static const char s_szDeclEnd[]  = "?>";
+	static const char s_szEncoding[] = "encoding";
+
+	const char* pszBegin = reinterpret_cast<const char*>(pBegin);
+	const char* pszEnd   = reinterpret_cast<const char*>(pEnd);
+	size_t      nPrefix  = strlen(s_szXmlDecl);
+
+	if ( (static_cast<size_t>(pszEnd - pszBegin) <= nPrefix) || (strncmp(pszBegin, s_szXmlDecl, nPrefix) != 0)
+	  || (memchr(" \t\r\n", pszBegin[nPrefix], 4) == nullptr) )
+		return UNKNOWN;
+
+	const char* pDeclEnd  = std::search(pszBegin, pszEnd, s_szDeclEnd, s_szDeclEnd + strlen(s_szDeclEnd));
+	const char* pEncoding = std::search(pszBegin, pDeclEnd, s_szEncoding, s_szEncoding + strlen(s_szEncoding));
+
+	if (pEncoding == pDeclEnd)
+		return UTF_8;
+
+	const char* pEquals = FastScan::SkipSpace(pEncoding + strlen(s_szEncoding), pDeclEnd);
+
+	if ( (pEquals == pDeclEnd) || (*pEquals != '=') )
+		return UNKNOWN;
+
+	const char* pQuote = FastScan::SkipSpace(pEquals + 1, pDeclEnd);
+
+	if ( (pQuote == pDeclEnd) || ((*pQuote != '"') && (*pQuote != '\'')) )
+		return UNKNOWN;
+
+	std::string strName(pQuote + 1, std::find(pQuote + 1, pDeclEnd, *pQuote));
+
+	std::transform(strName.begin(), strName.end(), strName.begin(), ToLower);
+
+	if ( (strName == "utf-8") || (strName == "utf8") )
+		return UTF_8;
+
+	return ANSI;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the end of the last complete character in the range. The range must
+//! start on a character boundary.
+
+const byte* TextDecoder::FindCompleteEnd(const byte* pBegin, const byte* pEnd) const
+{
+	if (m_eEncoding == UTF_16LE)
+		return pBegin + ((pEnd - pBegin) & ~static_cast<size_t>(1));
+
+	if (m_eEncoding == UTF_8)
+	{
+		// Look back for the lead byte of the final sequence.
+		for (const byte* pLead = pEnd; (pLead != pBegin) && ((pEnd - pLead) < 4); )
+		{
+			--pLead;
+
+			if ((*pLead & 0xC0) != 0x80)
+			{
+				size_t nLength = Utf8SequenceLength(*pLead);
+
+				return (static_cast<size_t>(pEnd - pLead) < nLength) ? pLead : pEnd;
+			}
+		}
+	}
+
+	if (m_eEncoding == ANSI)
+	{
+		// A byte that can't be a lead byte always ends a character, so count
+		// the run of possible lead bytes before the end. If it's odd the final
+		// byte is the lead byte of a character split across the blocks.
+		const byte* pLead = pEnd;
+
+		while ( (pLead != pBegin) && (::IsDBCSLeadByteEx(CP_ACP, *(pLead-1))) )
+			--pLead;
+
+		if (((pEnd - pLead) % 2) != 0)
+			return pEnd - 1;
+	}
+
+	return pEnd;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Convert a range of complete characters.
+
+void TextDecoder::Convert(const byte* pBegin, const byte* pEnd, tstring& strOutput) const
+{
+	ASSERT(m_eEncoding != UNKNOWN);
+
+	if (pBegin == pEnd)
+		return;
+
+	if (m_eEncoding == UTF_16LE)
+	{
+		const wchar_t* pszWide = reinterpret_cast<const wchar_t*>(pBegin);
+		int            nChars  = static_cast<int>(pEnd - pBegin) / 2;
+
+#ifdef _UNICODE
+		strOutput.append(pszWide, nChars);
+#else
+		int    nLength = ::WideCharToMultiByte(CP_ACP, 0, pszWide, nChars, NULL, 0, NULL, NULL);
+		size_t nOffset = strOutput.size();
+
+		strOutput.resize(nOffset + nLength);
+		::WideCharToMultiByte(CP_ACP, 0, pszWide, nChars, &strOutput[nOffset], nLength, NULL, NULL);
+#endif
+		return;
+	}
+
+	const char* pszBegin = reinterpret_cast<const char*>(pBegin);
+	const char* pszEnd   = reinterpret_cast<const char*>(pEnd);
+
+	// Copy the ASCII runs directly and only convert what lies between them.
+	while (pszBegin != pszEnd)
+	{
+		const char* pAsciiEnd = FastScan::SkipAscii(pszBegin, pszEnd);
+
+		AppendAscii(pszBegin, pAsciiEnd, strOutput);
+
+		if (pAsciiEnd == pszEnd)
+			break;
+
+		// A code page may use ASCII values for trail bytes, so only UTF-8 can
+		// safely be split at the next ASCII character.
+		const char* pOtherEnd = (m_eEncoding == UTF_8) ? FindAsciiRun(pAsciiEnd, pszEnd) : pszEnd;
+
+		ConvertMultiByte(pAsciiEnd, pOtherEnd, strOutput);
+
+		pszBegin = pOtherEnd;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Convert a range of complete characters using the code page.
+
+void TextDecoder::ConvertMultiByte(const char* pBegin, const char* pEnd, tstring& strOutput) const
+{
+	ASSERT( (m_eEncoding == ANSI) || (m_eEncoding == UTF_8) );
+
+	const char* pszBegin = pBegin;
+	int         nBytes   = static_cast<int>(pEnd - pBegin);
+
+#ifdef _UNICODE
+	UINT   nCodePage = (m_eEncoding == UTF_8) ? CP_UTF8 : CP_ACP;
+	int    nLength   = ::MultiByteToWideChar(nCodePage, 0, pszBegin, nBytes, NULL, 0);
+	size_t nOffset   = strOutput.size();
+
+	strOutput.resize(nOffset + nLength);
+	::MultiByteToWideChar(nCodePage, 0, pszBegin, nBytes, &strOutput[nOffset], nLength);
+#else
+	if (m_eEncoding == ANSI)
+	{
+		strOutput.append(pszBegin, nBytes);
+		return;
+	}
+
+	std::wstring strWide(::MultiByteToWideChar(CP_UTF8, 0, pszBegin, nBytes, NULL, 0), L'\0');
+
+	::MultiByteToWideChar(CP_UTF8, 0, pszBegin, nBytes, &strWide[0], static_cast<int>(strWide.size()));
+
+	int    nLength = ::WideCharToMultiByte(CP_ACP, 0, strWide.data(), static_cast<int>(strWide.size()), NULL, 0, NULL, NULL);
+	size_t nOffset = strOutput.size();
+
+	strOutput.resize(nOffset + nLength);
+	::WideCharToMultiByte(CP_ACP, 0, strWide.data(), static_cast<int>(strWide.size()), &strOutput[nOffset], nLength, NULL, NULL);
+#endif
+}
@@ -0,0 +1,110 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   TextDecoder.hpp
+//! \brief  The TextDecoder class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_TEXTDECODER_HPP
+#define APP_TEXTDECODER_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//! Converts a stream of raw file bytes into application text. The data can be
+//! supplied in arbitrary sized blocks; any partial character at the end of a
+//! block is carried over to the next one. The encoding is detected from the
+//! byte order mark or else the XML declaration, with ANSI being assumed when
+//! there is neither. Runs of 7-bit ASCII are copied or widened directly rather
+//! than going through the code page conversion.
+
+class TextDecoder
+{
+public:
+	//! The supported encodings.
+	enum Encoding
+	{
+		UNKNOWN,		//!< Not yet detected.
+		ANSI,			//!< The ANSI code page.
+		UTF_8,			//!< UTF-8.
+		UTF_16LE,		//!< Little-endian UTF-16.
+	};
+
+	//! The number of leading bytes used to detect the encoding.
+	static const size_t MAX_DETECT_SIZE = 256;
+
+	//! Default constructor.
+	TextDecoder();
+
+	//! Construct for text in a known encoding.
+	explicit TextDecoder(Encoding eEncoding);
+
+	//
+	// Properties.
+	//
+
+	//! Get the detected encoding.
+	Encoding GetEncoding() const;
+
+	//! Query if the encoding was detected from a byte order mark.
+	bool HasByteOrderMark() const;
+
+	//
+	// Methods.
+	//
+
+	//! Decode the next block of bytes, appending the text to the output.
+	void Decode(const byte* pBegin, const byte* pEnd, tstring& strOutput);
+
+	//! Signal the end of the input, flushing any undecoded bytes.
+	void Finish(tstring& strOutput);
+
+	//! Detect the encoding and skip any byte order mark.
+	const byte* DetectEncoding(const byte* pBegin, const byte* pEnd);
+
+private:
+	//
+	// Members.
+	//
+	Encoding			m_eEncoding;		//!< The detected encoding.
+	bool				m_bByteOrderMark;	//!< Was there a byte order mark?
+	std::vector<byte>	m_vecPending;		//!< The bytes of a partial character.
+
+	//
+	// Internal methods.
+	//
+
+	//! Decode a block no larger than the maximum conversion size.
+	void DecodeSlice(const byte* pBegin, const byte* pEnd, tstring& strOutput);
+
+	//! Find the end of the last complete character in the range.
+	const byte* FindCompleteEnd(const byte* pBegin, const byte* pEnd) const;
+
+	//! Convert a range of complete characters.
+	void Convert(const byte* pBegin, const byte* pEnd, tstring& strOutput) const;
+
+	//! Convert a range of complete characters using the code page.
+	void ConvertMultiByte(const char* pBegin, const char* pEnd, tstring& strOutput) const;
+
+	//! Get the encoding named by an XML declaration at the start of the text.
+	static Encoding DeclaredEncoding(const byte* pBegin, const byte* pEnd);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the detected encoding.
+
+inline TextDecoder::Encoding TextDecoder::GetEncoding() const
+{
+	return m_eEncoding;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the encoding was detected from a byte order mark.
+
+inline bool TextDecoder::HasByteOrderMark() const
+{
+	return m_bByteOrderMark;
+}
+
+#endif // APP_TEXTDECODER_HPP
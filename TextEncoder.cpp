@@ -0,0 +1,182 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   TextEncoder.cpp
+//! \brief  The TextEncoder class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "TextEncoder.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+// Constants.
+
+//! The largest block handed to the Win32 conversion functions in one call.
+static const size_t MAX_SLICE_SIZE = 4 * 1024 * 1024;
+
+//! The UTF-8 byte order mark.
+static const byte UTF8_BOM[] = { 0xEF, 0xBB, 0xBF };
+
+//! The little-endian UTF-16 byte order mark.
+static const byte UTF16LE_BOM[] = { 0xFF, 0xFE };
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append a range of bytes to the output.
+
+static void AppendBytes(const void* pBegin, size_t nSize, std::vector<byte>& vecOutput)
+{
+	const byte* pBytes = static_cast<const byte*>(pBegin);
+
+	vecOutput.insert(vecOutput.end(), pBytes, pBytes + nSize);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+TextEncoder::TextEncoder(TextDecoder::Encoding eEncoding, bool bByteOrderMark)
+	: m_eEncoding(eEncoding)
+	, m_bWriteBOM(bByteOrderMark)
+{
+	ASSERT(m_eEncoding != TextDecoder::UNKNOWN);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Encode the next block of text, appending the bytes to the output.
+
+void TextEncoder::Encode(const tchar* pBegin, const tchar* pEnd, std::vector<byte>& vecOutput)
+{
+	WriteByteOrderMark(vecOutput);
+
+	// Complete the partial character from the previous block first.
+	if ( (!m_strPending.empty()) && (pBegin != pEnd) )
+	{
+		m_strPending += *pBegin++;
+
+		Convert(m_strPending.data(), m_strPending.data() + m_strPending.size(), vecOutput);
+		m_strPending.clear();
+	}
+
+	while (pBegin != pEnd)
+	{
+		const tchar* pSliceEnd = pBegin + std::min<size_t>(pEnd - pBegin, MAX_SLICE_SIZE);
+		const tchar* pComplete = FindCompleteEnd(pBegin, pSliceEnd);
+
+		Convert(pBegin, pComplete, vecOutput);
+
+		// Hold back the start of a character split across the blocks.
+		if (pSliceEnd == pEnd)
+		{
+			m_strPending.assign(pComplete, pEnd);
+			break;
+		}
+
+		pBegin = pComplete;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Signal the end of the input, flushing any unencoded characters. A lone half
+//! of a character is converted as it is, which the code page conversion will
+//! replace with its default character.
+
+void TextEncoder::Finish(std::vector<byte>& vecOutput)
+{
+	WriteByteOrderMark(vecOutput);
+
+	Convert(m_strPending.data(), m_strPending.data() + m_strPending.size(), vecOutput);
+	m_strPending.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write the byte order mark for the encoding, if it's still required.
+
+void TextEncoder::WriteByteOrderMark(std::vector<byte>& vecOutput)
+{
+	if (!m_bWriteBOM)
+		return;
+
+	if (m_eEncoding == TextDecoder::UTF_8)
+		AppendBytes(UTF8_BOM, sizeof(UTF8_BOM), vecOutput);
+	else if (m_eEncoding == TextDecoder::UTF_16LE)
+		AppendBytes(UTF16LE_BOM, sizeof(UTF16LE_BOM), vecOutput);
+
+	m_bWriteBOM = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the end of the last complete character in the range. In a UTF-16
+//! build that's before a trailing lead surrogate, and in an ANSI build before
+//! a trailing lead byte.
+
+const tchar* TextEncoder::FindCompleteEnd(const tchar* pBegin, const tchar* pEnd) const
+{
+	if (pBegin == pEnd)
+		return pEnd;
+
+#ifdef _UNICODE
+	tchar cLast = *(pEnd-1);
+
+	if ( (cLast >= 0xD800) && (cLast <= 0xDBFF) )
+		return pEnd - 1;
+#else
+	// Count the run of possible lead bytes before the end, as the decoder does.
+	const tchar* pLead = pEnd;
+
+	while ( (pLead != pBegin) && (::IsDBCSLeadByteEx(CP_ACP, static_cast<byte>(*(pLead-1)))) )
+		--pLead;
+
+	if (((pEnd - pLead) % 2) != 0)
+		return pEnd - 1;
+#endif
+
+	return pEnd;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Convert a range of complete characters.
+
+void TextEncoder::Convert(const tchar* pBegin, const tchar* pEnd, std::vector<byte>& vecOutput) const
+{
+	if (pBegin == pEnd)
+		return;
+
+#ifdef _UNICODE
+	ConvertWide(pBegin, pEnd, vecOutput);
+#else
+	// The text is already in the ANSI code page.
+	if (m_eEncoding == TextDecoder::ANSI)
+	{
+		AppendBytes(pBegin, pEnd - pBegin, vecOutput);
+		return;
+	}
+
+	int          nChars = static_cast<int>(pEnd - pBegin);
+	int          nWide  = ::MultiByteToWideChar(CP_ACP, 0, pBegin, nChars, NULL, 0);
+	std::wstring strWide(nWide, L'\0');
+
+	::MultiByteToWideChar(CP_ACP, 0, pBegin, nChars, &strWide[0], nWide);
+
+	ConvertWide(strWide.data(), strWide.data() + strWide.size(), vecOutput);
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Convert a range of UTF-16 characters.
+
+void TextEncoder::ConvertWide(const wchar_t* pBegin, const wchar_t* pEnd, std::vector<byte>& vecOutput) const
+{
+	if (m_eEncoding == TextDecoder::UTF_16LE)
+	{
+		AppendBytes(pBegin, (pEnd - pBegin) * sizeof(wchar_t), vecOutput);
+		return;
+	}
+
+	UINT   nCodePage = (m_eEncoding == TextDecoder::UTF_8) ? CP_UTF8 : CP_ACP;
+	int    nChars    = static_cast<int>(pEnd - pBegin);
+	int    nBytes    = ::WideCharToMultiByte(nCodePage, 0, pBegin, nChars, NULL, 0, NULL, NULL);
+	size_t nOffset   = vecOutput.size();
+
+	if (nBytes == 0)
+		return;
+
+	vecOutput.resize(nOffset + nBytes);
+	::WideCharToMultiByte(nCodePage, 0, pBegin, nChars, reinterpret_cast<char*>(&vecOutput[nOffset]), nBytes, NULL, NULL);
+}
@@ -0,0 +1,64 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   TextEncoder.hpp
+//! \brief  The TextEncoder class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_TEXTENCODER_HPP
+#define APP_TEXTENCODER_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "TextDecoder.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+//! Converts application text into the raw bytes of a file, the reverse of the
+//! TextDecoder, so that a document can be written back in the encoding it was
+//! read in. The text can be supplied in arbitrary sized blocks; a character
+//! split across blocks is carried over to the next one. The byte order mark,
+//! if required, is written before the first block.
+
+class TextEncoder
+{
+public:
+	//! Constructor.
+	TextEncoder(TextDecoder::Encoding eEncoding, bool bByteOrderMark);
+
+	//
+	// Methods.
+	//
+
+	//! Encode the next block of text, appending the bytes to the output.
+	void Encode(const tchar* pBegin, const tchar* pEnd, std::vector<byte>& vecOutput);
+
+	//! Signal the end of the input, flushing any unencoded characters.
+	void Finish(std::vector<byte>& vecOutput);
+
+private:
+	//
+	// Members.
+	//
+	TextDecoder::Encoding	m_eEncoding;	//!< The encoding to write.
+	bool					m_bWriteBOM;	//!< Is the byte order mark still to be written?
+	tstring					m_strPending;	//!< The start of a partial character.
+
+	//
+	// Internal methods.
+	//
+
+	//! Write the byte order mark for the encoding, if required.
+	void WriteByteOrderMark(std::vector<byte>& vecOutput);
+
+	//! Find the end of the last complete character in the range.
+	const tchar* FindCompleteEnd(const tchar* pBegin, const tchar* pEnd) const;
+
+	//! Convert a range of complete characters.
+	void Convert(const tchar* pBegin, const tchar* pEnd, std::vector<byte>& vecOutput) const;
+
+	//! Convert a range of UTF-16 characters.
+	void ConvertWide(const wchar_t* pBegin, const wchar_t* pEnd, std::vector<byte>& vecOutput) const;
+};
+
+#endif // APP_TEXTENCODER_HPP
@@ -0,0 +1,360 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   TextRope.cpp
+//! \brief  The TextRope class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "TextRope.hpp"
+
+// Constants.
+static const size_t MAX_CHUNK_SIZE = 2048;
+static const uint32 INITIAL_SEED = 0x2545F491;
+
+// The size chunks are created at, leaving room for in-place inserts.
+static const size_t BUILD_CHUNK_SIZE = MAX_CHUNK_SIZE / 2;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+TextRope::TextRope()
+	: m_pRoot(nullptr)
+	, m_nSeed(INITIAL_SEED)
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Construction from a string.
+
+TextRope::TextRope(const tstring& strText)
+	: m_pRoot(nullptr)
+	, m_nSeed(INITIAL_SEED)
+{
+	m_pRoot = Build(strText);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+TextRope::~TextRope()
+{
+	Destroy(m_pRoot);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Replace the text.
+
+void TextRope::Assign(const tstring& strText)
+{
+	Clear();
+
+	m_pRoot = Build(strText);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Insert text at a position. Text that fits in the chunk it falls in is
+//! inserted there, otherwise the tree is split and the new chunks joined in.
+
+void TextRope::Insert(size_t nOffset, const tstring& strText)
+{
+	ASSERT(nOffset <= Length());
+
+	if ( (strText.empty()) || (InsertInPlace(m_pRoot, nOffset, strText)) )
+		return;
+
+	Chunk* pLeft  = nullptr;
+	Chunk* pRight = nullptr;
+
+	Split(m_pRoot, nOffset, pLeft, pRight);
+
+	m_pRoot = Merge(Merge(pLeft, Build(strText)), pRight);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Erase a range of the text. A range inside a single chunk that leaves some
+//! of it behind is erased there, otherwise the range is split out of the tree.
+
+void TextRope::Erase(size_t nOffset, size_t nCount)
+{
+	ASSERT(nOffset + nCount <= Length());
+
+	if ( (nCount == 0) || (EraseInPlace(m_pRoot, nOffset, nCount)) )
+		return;
+
+	Chunk* pLeft   = nullptr;
+	Chunk* pMiddle = nullptr;
+	Chunk* pRight  = nullptr;
+
+	Split(m_pRoot, nOffset, pLeft, pRight);
+	Split(pRight, nCount, pMiddle, pRight);
+	Destroy(pMiddle);
+
+	m_pRoot = Merge(pLeft, pRight);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get a range of the text.
+
+tstring TextRope::Text(size_t nOffset, size_t nCount) const
+{
+	ASSERT(nOffset <= Length());
+
+	nCount = std::min(nCount, Length() - nOffset);
+
+	tstring strText;
+
+	strText.reserve(nCount);
+
+	AppendText(m_pRoot, nOffset, nCount, strText);
+
+	return strText;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Discard the text.
+
+void TextRope::Clear()
+{
+	Destroy(m_pRoot);
+
+	m_pRoot = nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Create a detached chunk for a run of text. The priority is drawn from a
+//! xorshift generator so that the shape of the tree is repeatable.
+
+TextRope::Chunk* TextRope::NewChunk(const tchar* pszText, size_t nLength)
+{
+	m_nSeed ^= (m_nSeed << 13);
+	m_nSeed ^= (m_nSeed >> 17);
+	m_nSeed ^= (m_nSeed << 5);
+
+	Chunk* pChunk = new Chunk;
+
+	pChunk->m_strText.assign(pszText, nLength);
+	pChunk->m_nLength   = nLength;
+	pChunk->m_nPriority = m_nSeed;
+	pChunk->m_pLeft     = nullptr;
+	pChunk->m_pRight    = nullptr;
+
+	return pChunk;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Create the sub-tree for a string.
+
+TextRope::Chunk* TextRope::Build(const tstring& strText)
+{
+	Chunk* pRoot = nullptr;
+
+	for (size_t nOffset = 0; nOffset != strText.length(); )
+	{
+		size_t nLength = std::min(BUILD_CHUNK_SIZE, strText.length() - nOffset);
+
+		pRoot    = Merge(pRoot, NewChunk(strText.data() + nOffset, nLength));
+		nOffset += nLength;
+	}
+
+	return pRoot;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Split a sub-tree into the text before and after a position. A position in
+//! the middle of a chunk splits it in two.
+
+void TextRope::Split(Chunk* pChunk, size_t nOffset, Chunk*& pLeft, Chunk*& pRight)
+{
+	if (pChunk == nullptr)
+	{
+		pLeft = pRight = nullptr;
+		return;
+	}
+
+	size_t nStart = LengthOf(pChunk->m_pLeft);
+	size_t nEnd   = nStart + pChunk->m_strText.length();
+
+	if (nOffset <= nStart)
+	{
+		Split(pChunk->m_pLeft, nOffset, pLeft, pChunk->m_pLeft);
+		Update(pChunk);
+		pRight = pChunk;
+	}
+	else if (nOffset >= nEnd)
+	{
+		Split(pChunk->m_pRight, nOffset - nEnd, pChunk->m_pRight, pRight);
+		Update(pChunk);
+		pLeft = pChunk;
+	}
+	else
+	{
+		size_t nSplit = nOffset - nStart;
+		Chunk* pTail  = NewChunk(pChunk->m_strText.data() + nSplit, pChunk->m_strText.length() - nSplit);
+		Chunk* pAfter = pChunk->m_pRight;
+
+		pChunk->m_strText.erase(nSplit);
+		pChunk->m_pRight = nullptr;
+		Update(pChunk);
+
+		pLeft  = pChunk;
+		pRight = Merge(pTail, pAfter);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Insert text inside the chunk that a position falls in, if it fits. The
+//! lengths of the sub-trees on the way down are updated on the way back.
+
+bool TextRope::InsertInPlace(Chunk* pChunk, size_t nOffset, const tstring& strText)
+{
+	if (pChunk == nullptr)
+		return false;
+
+	size_t nStart = LengthOf(pChunk->m_pLeft);
+	size_t nEnd   = nStart + pChunk->m_strText.length();
+	bool   bDone  = false;
+
+	if (nOffset < nStart)
+	{
+		bDone = InsertInPlace(pChunk->m_pLeft, nOffset, strText);
+	}
+	else if (nOffset > nEnd)
+	{
+		bDone = InsertInPlace(pChunk->m_pRight, nOffset - nEnd, strText);
+	}
+	else if (pChunk->m_strText.length() + strText.length() <= MAX_CHUNK_SIZE)
+	{
+		pChunk->m_strText.insert(nOffset - nStart, strText);
+		bDone = true;
+	}
+
+	if (bDone)
+		pChunk->m_nLength += strText.length();
+
+	return bDone;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Erase text inside the chunk that a range falls in, if it can. A chunk is
+//! never emptied this way, so that the tree holds no empty chunks.
+
+bool TextRope::EraseInPlace(Chunk* pChunk, size_t nOffset, size_t nCount)
+{
+	if (pChunk == nullptr)
+		return false;
+
+	size_t nStart = LengthOf(pChunk->m_pLeft);
+	size_t nEnd   = nStart + pChunk->m_strText.length();
+	bool   bDone  = false;
+
+	if (nOffset < nStart)
+	{
+		if (nOffset + nCount <= nStart)
+			bDone = EraseInPlace(pChunk->m_pLeft, nOffset, nCount);
+	}
+	else if (nOffset >= nEnd)
+	{
+		bDone = EraseInPlace(pChunk->m_pRight, nOffset - nEnd, nCount);
+	}
+	else if ( (nOffset + nCount <= nEnd) && (nCount < pChunk->m_strText.length()) )
+	{
+		pChunk->m_strText.erase(nOffset - nStart, nCount);
+		bDone = true;
+	}
+
+	if (bDone)
+		pChunk->m_nLength -= nCount;
+
+	return bDone;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append a range of a sub-tree's text to a string. Only the chunks that
+//! overlap the range are visited.
+
+void TextRope::AppendText(const Chunk* pChunk, size_t nOffset, size_t nCount, tstring& strText)
+{
+	if ( (pChunk == nullptr) || (nCount == 0) )
+		return;
+
+	size_t nStart = LengthOf(pChunk->m_pLeft);
+	size_t nEnd   = nStart + pChunk->m_strText.length();
+
+	if (nOffset < nStart)
+	{
+		size_t nLeft = std::min(nCount, nStart - nOffset);
+
+		AppendText(pChunk->m_pLeft, nOffset, nLeft, strText);
+
+		nOffset += nLeft;
+		nCount  -= nLeft;
+	}
+
+	if ( (nCount != 0) && (nOffset < nEnd) )
+	{
+		size_t nLength = std::min(nCount, nEnd - nOffset);
+
+		strText.append(pChunk->m_strText, nOffset - nStart, nLength);
+
+		nOffset += nLength;
+		nCount  -= nLength;
+	}
+
+	if (nCount != 0)
+		AppendText(pChunk->m_pRight, nOffset - nEnd, nCount, strText);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Join two sub-trees, the first of which holds the earlier text. The chunk
+//! with the higher priority becomes the root, which keeps the tree balanced.
+
+TextRope::Chunk* TextRope::Merge(Chunk* pLeft, Chunk* pRight)
+{
+	if (pLeft == nullptr)
+		return pRight;
+
+	if (pRight == nullptr)
+		return pLeft;
+
+	if (pLeft->m_nPriority > pRight->m_nPriority)
+	{
+		pLeft->m_pRight = Merge(pLeft->m_pRight, pRight);
+		Update(pLeft);
+
+		return pLeft;
+	}
+
+	pRight->m_pLeft = Merge(pLeft, pRight->m_pLeft);
+	Update(pRight);
+
+	return pRight;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Recalculate the length of a sub-tree from its children.
+
+void TextRope::Update(Chunk* pChunk)
+{
+	pChunk->m_nLength = LengthOf(pChunk->m_pLeft) + pChunk->m_strText.length() + LengthOf(pChunk->m_pRight);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the length of the text in a sub-tree.
+
+size_t TextRope::LengthOf(const Chunk* pChunk)
+{
+	return (pChunk != nullptr) ? pChunk->m_nLength : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destroy a sub-tree.
+
+void TextRope::Destroy(Chunk* pChunk)
+{
+	if (pChunk == nullptr)
+		return;
+
+	Destroy(pChunk->m_pLeft);
+	Destroy(pChunk->m_pRight);
+
+	delete pChunk;
+}
@@ -0,0 +1,133 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   TextRope.hpp
+//! \brief  The TextRope class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_TEXTROPE_HPP
+#define APP_TEXTROPE_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+//! A string held as a balanced tree of small chunks so that text can be
+//! inserted and erased anywhere in a very large value without copying the
+//! rest of it. The chunks are ordered by position and balanced as a treap, so
+//! finding a position takes O(log n) and an edit only copies part of a chunk.
+//! A small edit is made inside the chunk it falls in; a larger one splits the
+//! tree at its ends and joins the pieces back together.
+
+class TextRope : private Core::NotCopyable
+{
+public:
+	//! Default constructor.
+	TextRope();
+
+	//! Construction from a string.
+	TextRope(const tstring& strText);
+
+	//! Destructor.
+	~TextRope();
+
+	//
+	// Properties.
+	//
+
+	//! Get the length of the text.
+	size_t Length() const;
+
+	//
+	// Methods.
+	//
+
+	//! Replace the text.
+	void Assign(const tstring& strText);
+
+	//! Insert text at a position.
+	void Insert(size_t nOffset, const tstring& strText);
+
+	//! Erase a range of the text.
+	void Erase(size_t nOffset, size_t nCount);
+
+	//! Get a range of the text.
+	tstring Text(size_t nOffset, size_t nCount) const;
+
+	//! Get the text as a flat string.
+	tstring Text() const;
+
+	//! Discard the text.
+	void Clear();
+
+private:
+	////////////////////////////////////////////////////////////////////////////
+	//! A node in the tree that holds a run of the text.
+
+	struct Chunk
+	{
+		tstring	m_strText;		//!< The text in this chunk.
+		size_t	m_nLength;		//!< The length of the text in this sub-tree.
+		uint32	m_nPriority;	//!< The heap priority that keeps it balanced.
+		Chunk*	m_pLeft;		//!< The chunks before this one.
+		Chunk*	m_pRight;		//!< The chunks after this one.
+	};
+
+	//
+	// Members.
+	//
+	Chunk*	m_pRoot;		//!< The root of the tree.
+	uint32	m_nSeed;		//!< The state of the priority generator.
+
+	//
+	// Internal methods.
+	//
+
+	//! Create a detached chunk for a run of text.
+	Chunk* NewChunk(const tchar* pszText, size_t nLength);
+
+	//! Create the sub-tree for a string.
+	Chunk* Build(const tstring& strText);
+
+	//! Split a sub-tree into the text before and after a position.
+	void Split(Chunk* pChunk, size_t nOffset, Chunk*& pLeft, Chunk*& pRight);
+
+	//! Insert text inside the chunk that a position falls in, if it fits.
+	static bool InsertInPlace(Chunk* pChunk, size_t nOffset, const tstring& strText);
+
+	//! Erase text inside the chunk that a range falls in, if it can.
+	static bool EraseInPlace(Chunk* pChunk, size_t nOffset, size_t nCount);
+
+	//! Append a range of a sub-tree's text to a string.
+	static void AppendText(const Chunk* pChunk, size_t nOffset, size_t nCount, tstring& strText);
+
+	//! Join two sub-trees, the first of which holds the earlier text.
+	static Chunk* Merge(Chunk* pLeft, Chunk* pRight);
+
+	//! Recalculate the length of a sub-tree from its children.
+	static void Update(Chunk* pChunk);
+
+	//! Get the length of the text in a sub-tree.
+	static size_t LengthOf(const Chunk* pChunk);
+
+	//! Destroy a sub-tree.
+	static void Destroy(Chunk* pChunk);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the length of the text.
+
+inline size_t TextRope::Length() const
+{
+	return LengthOf(m_pRoot);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the text as a flat string.
+
+inline tstring TextRope::Text() const
+{
+	return Text(0, Length());
+}
+
+#endif // APP_TEXTROPE_HPP
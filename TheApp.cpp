@@ -13,6 +13,8 @@
 #include <Core/ConfigurationException.hpp>
 #include <Core/StringUtils.hpp>
 #include <WCL/BusyCursor.hpp>
+#include "PreParser.hpp"
+#include "GZipReader.hpp"
 
 ////////////////////////////////////////////////////////////////////////////////
 // Global variables.
@@ -33,6 +35,20 @@ const tchar* CONFIG_VERSION = TXT("1.0");
 //! The maximum size of the MRU list.
 const int MRU_LIST_SIZE = ID_FILE_MRU_9-ID_FILE_MRU_1+1;
 
+//! The estimated memory used to parse a document, as a multiple of its size.
+const uint64 PARSE_MEMORY_FACTOR = 8;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Convert a size setting in MB to bytes. The product is clamped to the largest
+//! size_t, as it would wrap in a 32-bit build.
+
+static size_t MegabytesToSize(uint nMegabytes)
+{
+	uint64 nBytes = static_cast<uint64>(nMegabytes) * 1024 * 1024;
+
+	return static_cast<size_t>(std::min<uint64>(nBytes, static_cast<size_t>(-1)));
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! Constructor.
 
@@ -44,6 +60,28 @@ TheApp::TheApp()
 	, m_eDefLayout(TheView::VERTICAL)
 	, m_nDefSplitPos(0)
 	, m_vecDefColWidths(2)
+	, m_nPreviewSize(16*1024*1024)
+	, m_nPreviewRecords(0)
+	, m_nFollowInterval(1000)
+	, m_bAutoScroll(true)
+	, m_bUseArena(true)
+	, m_nParseThreads(0)
+	, m_nParallelMinSize(32*1024*1024)
+	, m_bUseSnapshots(true)
+	, m_nSnapshotMaxSize(static_cast<uint64>(8192)*1024*1024)
+	, m_bPreParseMRU(false)
+	, m_nPreParseMaxSize(static_cast<uint64>(256)*1024*1024)
+	, m_nPreParseBudget(static_cast<uint64>(2048)*1024*1024)
+	, m_nUndoMaxSize(256*1024*1024)
+	, m_bUseJournal(true)
+	, m_nJournalInterval(1000)
+	, m_bValidate(true)
+	, m_bShowProblems(true)
+	, m_vecKeyAttribs()
+	, m_nCompareMaxItems(10000)
+	, m_bOpenPreview(false)
+	, m_bOpenCompact(false)
+	, m_pPreParser(nullptr)
 {
 	m_vecDefColWidths[0] = 100;
 	m_vecDefColWidths[1] = 100;
@@ -89,7 +127,14 @@ bool TheApp::OnOpen()
 	// Update UI.
 	m_oAppCmds.InitialiseUI();
 
-	return CSDIApp::OnOpen();
+	if (!CSDIApp::OnOpen())
+		return false;
+
+	// Get ahead on the document most likely to be opened next.
+	if ( (m_bPreParseMRU) && (m_pDoc == nullptr) )
+		StartPreParse();
+
+	return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -97,6 +142,12 @@ bool TheApp::OnOpen()
 
 bool TheApp::OnClose()
 {
+	if (m_pPreParser != nullptr)
+	{
+		m_pPreParser->Release();
+		m_pPreParser = nullptr;
+	}
+
 	try
 	{
 		// Save settings.
@@ -119,6 +170,70 @@ TheDoc* TheApp::Document() const
 	return static_cast<TheDoc*>(m_pDoc);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! Take the document parsed in the background at startup. The parse is only
+//! ever used once, so if the path does not match or the DOM is not wanted the
+//! parse is stopped before the document is loaded, so that the two don't
+//! compete for the CPU and memory.
+
+bool TheApp::TakePreParsed(const tchar* pszPath, bool bWanted, XML::DocumentPtr& pDOM, DocArena*& pArena)
+{
+	if (m_pPreParser == nullptr)
+		return false;
+
+	PreParser* pPreParser = m_pPreParser;
+	bool       bTaken     = false;
+
+	m_pPreParser = nullptr;
+
+	if ( (bWanted) && (tstricmp(pPreParser->Path().c_str(), pszPath) == 0) )
+		bTaken = pPreParser->Wait(pDOM, pArena);
+	else
+		pPreParser->Stop();
+
+	pPreParser->Release();
+
+	return bTaken;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Start parsing the most recent document in the background. The document is
+//! skipped if it is too large, compressed, as its expanded size is unknown, or
+//! is estimated to need more memory than the budget or what is available. The
+//! estimate is only a first check; the parse is abandoned if the memory it
+//! actually allocates exceeds the budget.
+
+void TheApp::StartPreParse()
+{
+	ASSERT(m_pPreParser == nullptr);
+
+	if (m_MRUList.Size() == 0)
+		return;
+
+	tstring                   strPath = m_MRUList.File(0);
+	WIN32_FILE_ATTRIBUTE_DATA oInfo;
+
+	if ( (GZipReader::IsCompressed(strPath.c_str()))
+	  || (!::GetFileAttributesEx(strPath.c_str(), GetFileExInfoStandard, &oInfo)) )
+		return;
+
+	MEMORYSTATUSEX oStatus = { sizeof(oStatus) };
+
+	if (!::GlobalMemoryStatusEx(&oStatus))
+		return;
+
+	uint64 nFileSize = (static_cast<uint64>(oInfo.nFileSizeHigh) << 32) | oInfo.nFileSizeLow;
+	uint64 nEstimate = nFileSize * PARSE_MEMORY_FACTOR;
+
+	if ( (nFileSize > m_nPreParseMaxSize) || (nEstimate > m_nPreParseBudget) || (nEstimate > oStatus.ullAvailPhys / 2) )
+	{
+		TRACE1(TXT("Skipped pre-parsing a %u MB document\n"), static_cast<uint>(nFileSize / (1024*1024)));
+		return;
+	}
+
+	m_pPreParser = PreParser::Start(strPath, m_nPreParseBudget);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! Create a document object.
 
@@ -141,6 +256,7 @@ CView* TheApp::CreateView(CDoc& rDoc) const
 const tchar* TheApp::FileExts() const
 {
 	static tchar szExts[] = {	TXT("XML Files (*.xml)\0*.xml\0")
+								TXT("Compressed XML Files (*.xml.gz)\0*.xml.gz\0")
 								TXT("All Files (*.*)\0*.*\0")
 								TXT("\0\0")							};
 									    
@@ -188,7 +304,62 @@ void TheApp::LoadConfig()
 			m_vecDefColWidths[i] = Core::parse<uint>(widths[i]);
 	}
 
+	// Read the preview settings.
+	m_nPreviewSize    = MegabytesToSize(appConfig.readValue<uint>(TXT("Preview"), TXT("SizeMB"), 16));
+	m_nPreviewRecords = appConfig.readValue<uint>(TXT("Preview"), TXT("Records"), 0);
+
+	// Read the follow settings.
+	m_nFollowInterval = appConfig.readValue<uint>(TXT("Follow"), TXT("Interval"), m_nFollowInterval);
+	m_bAutoScroll     = appConfig.readValue<bool>(TXT("Follow"), TXT("AutoScroll"), m_bAutoScroll);
+
+	// Read the memory settings.
+	m_bUseArena = appConfig.readValue<bool>(TXT("Memory"), TXT("UseArena"), m_bUseArena);
+
+	// Read the parallel parsing settings.
+	m_nParseThreads    = appConfig.readValue<uint>(TXT("Parallel"), TXT("Threads"), m_nParseThreads);
+	m_nParallelMinSize = MegabytesToSize(appConfig.readValue<uint>(TXT("Parallel"), TXT("MinSizeMB"), 32));
+
+	// Read the snapshot cache settings.
+	m_bUseSnapshots    = appConfig.readValue<bool>(TXT("Snapshots"), TXT("Enabled"), m_bUseSnapshots);
+	m_strSnapshotDir   = appConfig.readString(TXT("Snapshots"), TXT("Directory"), m_strSnapshotDir);
+	m_nSnapshotMaxSize = static_cast<uint64>(appConfig.readValue<uint>(TXT("Snapshots"), TXT("MaxSizeMB"), 8192)) * 1024 * 1024;
+
+	// Read the background parsing settings.
+	m_bPreParseMRU     = appConfig.readValue<bool>(TXT("PreParse"), TXT("Enabled"), m_bPreParseMRU);
+	m_nPreParseMaxSize = static_cast<uint64>(appConfig.readValue<uint>(TXT("PreParse"), TXT("MaxSizeMB"), 256)) * 1024 * 1024;
+	m_nPreParseBudget  = static_cast<uint64>(appConfig.readValue<uint>(TXT("PreParse"), TXT("MemoryBudgetMB"), 2048)) * 1024 * 1024;
+
+	// Read the undo settings.
+	m_nUndoMaxSize = MegabytesToSize(appConfig.readValue<uint>(TXT("Undo"), TXT("MaxSizeMB"), 256));
+
+	// Read the edit journal settings.
+	m_bUseJournal      = appConfig.readValue<bool>(TXT("Journal"), TXT("Enabled"), m_bUseJournal);
+	m_nJournalInterval = appConfig.readValue<uint>(TXT("Journal"), TXT("FlushIntervalMS"), m_nJournalInterval);
+
+	// Read the validation settings.
+	m_bValidate     = appConfig.readValue<bool>(TXT("Validation"), TXT("Enabled"), m_bValidate);
+	m_bShowProblems = appConfig.readValue<bool>(TXT("Validation"), TXT("ShowProblems"), m_bShowProblems);
+
+	// Read the compare settings.
+	appConfig.readStringList(TXT("Compare"), TXT("KeyAttributes"), TXT("id,key,name"), m_vecKeyAttribs);
+	m_nCompareMaxItems = appConfig.readValue<uint>(TXT("Compare"), TXT("MaxDifferences"), static_cast<uint>(m_nCompareMaxItems));
+
 	// Validate.
+	if (m_nPreviewSize == 0)
+		m_nPreviewSize = 16*1024*1024;
+
+	if (m_nParallelMinSize == 0)
+		m_nParallelMinSize = 32*1024*1024;
+
+	if (m_nFollowInterval == 0)
+		m_nFollowInterval = 1000;
+
+	if (m_nJournalInterval == 0)
+		m_nJournalInterval = 1000;
+
+	if (m_nCompareMaxItems == 0)
+		m_nCompareMaxItems = 10000;
+
 	if ( (m_eDefLayout != TheView::VERTICAL) && (m_eDefLayout != TheView::HORIZONTAL) )
 		m_eDefLayout = TheView::VERTICAL;
 
@@ -223,4 +394,44 @@ void TheApp::SaveConfig()
 	appConfig.writeValue<uint>(TXT("UI"), TXT("Layout"), m_eDefLayout);
 	appConfig.writeValue<uint>(TXT("UI"), TXT("SplitterPos"), m_nDefSplitPos);
 	appConfig.writeStringList(TXT("UI"), TXT("AttribWidths"), widths);
+
+	// Write the preview settings.
+	appConfig.writeValue<uint>(TXT("Preview"), TXT("SizeMB"), static_cast<uint>(m_nPreviewSize / (1024*1024)));
+	appConfig.writeValue<uint>(TXT("Preview"), TXT("Records"), static_cast<uint>(m_nPreviewRecords));
+
+	// Write the follow settings.
+	appConfig.writeValue<uint>(TXT("Follow"), TXT("Interval"), m_nFollowInterval);
+	appConfig.writeValue<bool>(TXT("Follow"), TXT("AutoScroll"), m_bAutoScroll);
+
+	// Write the memory settings.
+	appConfig.writeValue<bool>(TXT("Memory"), TXT("UseArena"), m_bUseArena);
+
+	// Write the parallel parsing settings.
+	appConfig.writeValue<uint>(TXT("Parallel"), TXT("Threads"), m_nParseThreads);
+	appConfig.writeValue<uint>(TXT("Parallel"), TXT("MinSizeMB"), static_cast<uint>(m_nParallelMinSize / (1024*1024)));
+
+	// Write the snapshot cache settings.
+	appConfig.writeValue<bool>(TXT("Snapshots"), TXT("Enabled"), m_bUseSnapshots);
+	appConfig.writeString(TXT("Snapshots"), TXT("Directory"), m_strSnapshotDir);
+	appConfig.writeValue<uint>(TXT("Snapshots"), TXT("MaxSizeMB"), static_cast<uint>(m_nSnapshotMaxSize / (1024*1024)));
+
+	// Write the background parsing settings.
+	appConfig.writeValue<bool>(TXT("PreParse"), TXT("Enabled"), m_bPreParseMRU);
+	appConfig.writeValue<uint>(TXT("PreParse"), TXT("MaxSizeMB"), static_cast<uint>(m_nPreParseMaxSize / (1024*1024)));
+	appConfig.writeValue<uint>(TXT("PreParse"), TXT("MemoryBudgetMB"), static_cast<uint>(m_nPreParseBudget / (1024*1024)));
+
+	// Write the undo settings.
+	appConfig.writeValue<uint>(TXT("Undo"), TXT("MaxSizeMB"), static_cast<uint>(m_nUndoMaxSize / (1024*1024)));
+
+	// Write the edit journal settings.
+	appConfig.writeValue<bool>(TXT("Journal"), TXT("Enabled"), m_bUseJournal);
+	appConfig.writeValue<uint>(TXT("Journal"), TXT("FlushIntervalMS"), m_nJournalInterval);
+
+	// Write the validation settings.
+	appConfig.writeValue<bool>(TXT("Validation"), TXT("Enabled"), m_bValidate);
+	appConfig.writeValue<bool>(TXT("Validation"), TXT("ShowProblems"), m_bShowProblems);
+
+	// Write the compare settings.
+	appConfig.writeStringList(TXT("Compare"), TXT("KeyAttributes"), m_vecKeyAttribs);
+	appConfig.writeValue<uint>(TXT("Compare"), TXT("MaxDifferences"), static_cast<uint>(m_nCompareMaxItems));
 }
@@ -15,9 +15,14 @@
 #include "AppWnd.hpp"
 #include "AppCmds.hpp"
 #include "TheView.hpp"
+#include "CompactDoc.hpp"
+#include "BulkEdit.hpp"
+#include "NodeClipboard.hpp"
 
 // Forward declarations.
 class TheDoc;
+class PreParser;
+class DocArena;
 
 ////////////////////////////////////////////////////////////////////////////////
 //! The application singleton.
@@ -34,8 +39,19 @@ public:
 	//! Get the current open document.
 	TheDoc* Document() const;
 
+	//! Take the document parsed in the background at startup, if it matches.
+	bool TakePreParsed(const tchar* pszPath, bool bWanted, XML::DocumentPtr& pDOM, DocArena*& pArena);
+
+	//! Get the list of supported file extendsions.
+	virtual const tchar* FileExts() const;
+
+	//! Get the default file extension.
+	virtual const tchar* DefFileExt() const;
+
 	//! The array of ListView column widths.
 	typedef std::vector<size_t> Widths;
+	//! The array of attribute names.
+	typedef std::vector<tstring> Names;
 
 	//
 	// Application objects..
@@ -51,14 +67,48 @@ public:
 	TheView::Layout	m_eDefLayout;		//!< The default main view layout.
 	uint			m_nDefSplitPos;		//!< The default splitter bar position.
 	Widths			m_vecDefColWidths;	//!< The default attributes view column widths.
+	size_t			m_nPreviewSize;		//!< The number of bytes to read per preview part.
+	size_t			m_nPreviewRecords;	//!< The number of records to read per preview part (0 = no limit).
+	uint			m_nFollowInterval;	//!< The follow mode polling interval in ms.
+	bool			m_bAutoScroll;		//!< Scroll to the newest record when following?
+	bool			m_bUseArena;		//!< Allocate each document from its own arena?
+	uint			m_nParseThreads;	//!< The number of threads to parse with (0 = one per CPU).
+	size_t			m_nParallelMinSize;	//!< The smallest document to parse on multiple threads.
+	bool			m_bUseSnapshots;	//!< Cache snapshots of compact documents?
+	tstring			m_strSnapshotDir;	//!< The snapshot cache directory (empty = temp folder).
+	uint64			m_nSnapshotMaxSize;	//!< The maximum total size of the snapshot cache.
+	bool			m_bPreParseMRU;		//!< Parse the most recent document in the background at startup?
+	uint64			m_nPreParseMaxSize;	//!< The largest document to parse in the background.
+	uint64			m_nPreParseBudget;	//!< The memory the background parse may use.
+	size_t			m_nUndoMaxSize;		//!< The memory the undo history may retain.
+	bool			m_bUseJournal;		//!< Journal edits for recovery after a crash?
+	uint			m_nJournalInterval;	//!< The time between journal writes in ms.
+	bool			m_bValidate;		//!< Validate documents in the background?
+	bool			m_bShowProblems;	//!< Show the validation problems?
+	Names			m_vecKeyAttribs;	//!< The attributes that identify elements when comparing.
+	size_t			m_nCompareMaxItems;	//!< The most differences to show when comparing.
+
+	//
+	// Open state.
+	//
+	bool			m_bOpenPreview;		//!< Open the next document as a preview?
+	bool			m_bOpenCompact;		//!< Open the next document in the compact form?
 
 	//
 	// Find state.
 	//
 	typedef std::list<XML::NodePtr> NodesList;
+	typedef std::list<CompactDoc::NodeIndex> IndicesList;
 
 	tstring			m_strLastSearch;	//!< The last find XPath query.
+	BulkEdit		m_oLastBulkEdit;	//!< The last bulk edit.
 	NodesList		m_lstQueryNodes;	//!< The list of nodes found in the last query.
+	IndicesList		m_lstQueryIndices;	//!< The list of compact nodes found in the last query.
+
+	//
+	// Clipboard state.
+	//
+	NodeClipboard	m_oClipboard;		//!< The nodes last copied to the clipboard.
 
 private:
 	//
@@ -77,16 +127,18 @@ private:
 	//! Create a view for the document.
 	virtual CView* CreateView(CDoc& rDoc) const;
 
-	//! Get the list of supported file extendsions.
-	virtual const tchar* FileExts() const;
-
-	//! Get the default file extension.
-	virtual const tchar* DefFileExt() const;
+	//
+	// Members.
+	//
+	PreParser*		m_pPreParser;		//!< The background parse of the most recent document.
 
 	//
 	// Internal methods.
 	//
 
+	//! Start parsing the most recent document in the background.
+	void StartPreParse();
+
 	//! Load the application settings.
 	void LoadConfig();
 
@@ -6,18 +6,102 @@
 #include "Common.hpp"
 #include "TheDoc.hpp"
 #include "TheView.hpp"
+#include "TheApp.hpp"
 #include <WCL/App.hpp>
 #include <WCL/FrameWnd.hpp>
 #include <WCL/File.hpp>
 #include <XML/Reader.hpp>
 #include <XML/Writer.hpp>
+#include <Core/RuntimeException.hpp>
+#include "GZipReader.hpp"
+#include "GZipWriter.hpp"
+#include "TextDecoder.hpp"
+#include "TextEncoder.hpp"
+#include "ParallelReader.hpp"
+#include "SnapshotCache.hpp"
+#include "NodeCursor.hpp"
+
+////////////////////////////////////////////////////////////////////////////////
+// Constants.
+
+//! The size of the blocks used when streaming a file.
+static const size_t STREAM_BLOCK_SIZE = 256 * 1024;
+
+//! The file extension for gzip compressed documents.
+static const tchar COMPRESSED_FILE_EXT[] = TXT(".gz");
+
+//! The name of the default snapshot cache folder.
+static const tchar SNAPSHOT_DIR_NAME[] = TXT("XMLEdit Snapshots");
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of threads to parse or analyse a large document with.
+
+static size_t ParseThreadCount()
+{
+	if (App.m_nParseThreads != 0)
+		return App.m_nParseThreads;
+
+	SYSTEM_INFO oInfo;
+
+	::GetSystemInfo(&oInfo);
+
+	return oInfo.dwNumberOfProcessors;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the directory for the snapshot cache.
+
+static tstring SnapshotDirectory()
+{
+	if (!App.m_strSnapshotDir.empty())
+		return App.m_strSnapshotDir;
+
+	return CPath(CPath::TempDir(), SNAPSHOT_DIR_NAME);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add an XML declaration naming the encoding if the text would otherwise not
+//! be detected as being in it when read back, e.g. a UTF-8 document without a
+//! byte order mark whose declaration wasn't kept in the DOM.
+
+static void AddMissingDeclaration(tstring& strContents, TextDecoder::Encoding eEncoding, bool bByteOrderMark)
+{
+	if ( (bByteOrderMark) || (eEncoding == TextDecoder::ANSI) )
+		return;
+
+	TextEncoder       oEncoder(eEncoding, false);
+	TextDecoder       oDecoder;
+	std::vector<byte> vecHeader;
+	size_t            nChars = std::min(strContents.size(), TextDecoder::MAX_DETECT_SIZE);
+
+	oEncoder.Encode(strContents.data(), strContents.data() + nChars, vecHeader);
+	oEncoder.Finish(vecHeader);
+
+	size_t nBytes = std::min(vecHeader.size(), TextDecoder::MAX_DETECT_SIZE);
+
+	oDecoder.DetectEncoding(vecHeader.data(), vecHeader.data() + nBytes);
+
+	if (oDecoder.GetEncoding() == eEncoding)
+		return;
+
+	const tchar* pszName = (eEncoding == TextDecoder::UTF_16LE) ? TXT("UTF-16") : TXT("UTF-8");
+
+	strContents.insert(0, Core::fmt(TXT("<?xml version=\"1.0\" encoding=\"%s\"?>\n"), pszName));
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 //! Constructor.
 
 TheDoc::TheDoc()
 	: m_pDOM(new XML::Document)
+	, m_oHistory(m_oEditor, App.m_nUndoMaxSize)
+	, m_oJournal(m_oEditor, App.m_nJournalInterval)
+	, m_oValidator(m_oEditor)
+	, m_oProfile(m_oEditor)
+	, m_eEncoding(TextDecoder::ANSI)
+	, m_bByteOrderMark(false)
 {
+	m_oEditor.AddListener(this);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -25,6 +109,7 @@ TheDoc::TheDoc()
 
 TheDoc::~TheDoc()
 {
+	ReleaseDOM();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -40,7 +125,7 @@ TheView* TheDoc::View() const
 
 bool TheDoc::Modified() const
 {
-	return false;
+	return m_oEditor.IsModified();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -48,13 +133,65 @@ bool TheDoc::Modified() const
 
 bool TheDoc::Load()
 {
+	DWORD dwStart = ::GetTickCount();
+
 	try
 	{
-		CString strContents;
+		XML::DocumentPtr pPreParsed;
+		DocArena*        pPreArena = nullptr;
+
+		// Compressed files can only be read from the start.
+		bool bFullLoad = (!App.m_bOpenCompact) && ( (!App.m_bOpenPreview) || (GZipReader::IsCompressed(m_Path)) );
+
+		if (App.TakePreParsed(m_Path, bFullLoad, pPreParsed, pPreArena))
+		{
+			m_pArena.reset(pPreArena);
+			m_pDOM = pPreParsed;
+		}
+		else if ( (App.m_bUseArena) && (!App.m_bOpenCompact) )
+		{
+			m_pArena.reset(new DocArena);
+		}
 
-		CFile::ReadTextFile(m_Path, strContents);
+		if (pPreParsed.get() != nullptr)
+		{
+			TRACE(TXT("Using the pre-parsed document\n"));
+		}
+		else if (App.m_bOpenCompact)
+		{
+			LoadCompact();
+		}
+		else if (!bFullLoad)
+		{
+			LoadPreview();
+		}
+		else
+		{
+			tstring strContents;
 
-		m_pDOM = XML::Reader::readDocument(strContents.begin(), strContents.end(), XML::Reader::DISCARD_WHITESPACE);
+			if (GZipReader::IsCompressed(m_Path))
+				ReadCompressedFile(m_Path, strContents);
+			else
+				ReadTextFile(m_Path, strContents);
+
+			TRACE2(TXT("Read and decoded %u characters in %u ms\n"), strContents.size(), ::GetTickCount() - dwStart);
+
+			if (strContents.size() >= App.m_nParallelMinSize)
+			{
+				m_pDOM = ParallelReader(strContents, ParseThreadCount(), m_pArena.get()).Read();
+			}
+			else
+			{
+				const tchar*    pszBegin = strContents.data();
+				const tchar*    pszEnd   = pszBegin + strContents.size();
+				DocArena::Scope oScope(m_pArena.get());
+
+				m_pDOM = XML::Reader::readDocument(pszBegin, pszEnd, XML::Reader::DISCARD_WHITESPACE);
+			}
+		}
+
+		if (!IsCompact())
+			ReadEncoding();
 	}
 	catch (const Core::Exception& e)
 	{
@@ -63,19 +200,528 @@ bool TheDoc::Load()
 		return false;
 	}
 
+	TRACE3(TXT("Loaded document in %u ms (arena: %s, compact: %s)\n"), ::GetTickCount() - dwStart,
+			(m_pArena.get() != nullptr) ? TXT("on") : TXT("off"), IsCompact() ? TXT("on") : TXT("off"));
+
+	m_oEditor.SetArena(m_pArena.get());
+
+	if ( (App.m_bUseJournal) && (!IsCompact()) && (!IsPartial()) )
+	{
+		m_oJournal.Open(static_cast<const tchar*>(m_Path));
+		RecoverEdits();
+	}
+
+	if ( (App.m_bValidate) && (!IsCompact()) && (!IsPartial()) )
+		m_oValidator.Start(m_pDOM);
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if only part of the document has been loaded.
+
+bool TheDoc::IsPartial() const
+{
+	return ( (m_pReader.get() != nullptr) && (!m_pReader->IsComplete()) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if an element was left open by a partial load.
+
+bool TheDoc::IsTruncated(const XML::Node* pNode) const
+{
+	if (!IsPartial())
+		return false;
+
+	const IncrementalReader::NodeChain& vecOpen = m_pReader->TruncatedElements();
+
+	return (std::find(vecOpen.begin(), vecOpen.end(), pNode) != vecOpen.end());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the chain of elements left open by a partial load.
+
+IncrementalReader::NodeChain TheDoc::TruncatedElements() const
+{
+	if (!IsPartial())
+		return IncrementalReader::NodeChain();
+
+	return m_pReader->TruncatedElements();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of bytes of the file loaded so far.
+
+uint64 TheDoc::LoadedBytes() const
+{
+	return (m_pReader.get() != nullptr) ? m_pReader->Position() : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the size of the file being loaded.
+
+uint64 TheDoc::FileSize() const
+{
+	return (m_pReader.get() != nullptr) ? m_pReader->FileSize() : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the index of elements by name. The index is built on first use and
+//! discarded whenever more of the document is loaded.
+
+const NameIndex& TheDoc::Index()
+{
+	if (!m_oIndex.IsBuilt())
+		m_oIndex.Build(m_pDOM);
+
+	return m_oIndex;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the sizes of the element sub-trees. The profile is built on first use
+//! and kept up to date with the edits, but is discarded whenever more of the
+//! document is loaded. The text edited in place is written back first, as the
+//! nodes are read directly.
+
+const SubtreeProfile& TheDoc::Profile()
+{
+	ASSERT(!IsCompact());
+
+	if (!m_oProfile.IsBuilt())
+	{
+		DWORD dwStart = ::GetTickCount();
+
+		m_oEditor.FlattenText();
+		m_oProfile.Build(m_pDOM);
+
+		TRACE1(TXT("Profiled sub-trees in %u ms\n"), ::GetTickCount() - dwStart);
+	}
+
+	return m_oProfile;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Load the first part of the document.
+
+void TheDoc::LoadPreview()
+{
+	XML::DocumentPtr              pDOM;
+	IncrementalReader::AddedNodes vecAdded;
+
+	m_pReader.reset(new IncrementalReader(static_cast<const tchar*>(m_Path), m_pArena.get()));
+
+	m_pReader->ReadNext(pDOM, App.m_nPreviewSize, App.m_nPreviewRecords, vecAdded);
+
+	m_pDOM = pDOM;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Load the document in the compact read-only form. The text is parsed into
+//! a flat table of nodes that refer back into it, no DOM is built. An
+//! unchanged document is read back from the snapshot cache instead.
+
+void TheDoc::LoadCompact()
+{
+	SnapshotCache oCache(SnapshotDirectory(), App.m_nSnapshotMaxSize);
+	CompactDocPtr pCompact(new CompactDoc);
+
+	if ( (App.m_bUseSnapshots) && (oCache.Load(static_cast<const tchar*>(m_Path), *pCompact)) )
+	{
+		m_pCompact = pCompact;
+		return;
+	}
+
+	tstring strContents;
+
+	if (GZipReader::IsCompressed(m_Path))
+		ReadCompressedFile(m_Path, strContents);
+	else
+		ReadTextFile(m_Path, strContents);
+
+	pCompact->Parse(strContents, true);
+
+	if (App.m_bUseSnapshots)
+		oCache.Store(static_cast<const tchar*>(m_Path), *pCompact);
+
+	m_pCompact = pCompact;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Handle a change to the DOM. The name index and any find results may no
+//! longer match the document, unless only the text of a node changed, as
+//! neither refers to the text nodes.
+
+void TheDoc::OnDomChanged(const DomChange& oChange)
+{
+	if ( (oChange.m_eType == DomChange::TEXT_CHANGED) || (oChange.m_eType == DomChange::TEXT_EDITED) )
+		return;
+
+	m_oIndex.Clear();
+
+	App.m_lstQueryNodes.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Release the DOM and the arena that holds it. Anything else that refers to
+//! the nodes is released first. The nodes are destroyed one by one, deepest
+//! first, so that no depth of nesting can overflow the stack. As the arena is
+//! destroyed first their blocks are only counted, and the arena's chunks go
+//! back to the system once the last node has gone.
+
+void TheDoc::ReleaseDOM()
+{
+	DWORD dwStart = ::GetTickCount();
+
+	App.m_lstQueryNodes.clear();
+
+	App.m_lstQueryIndices.clear();
+
+	m_oIndex.Clear();
+	m_oProfile.Clear();
+	m_oHistory.Clear();
+	m_oJournal.Close(true);
+	m_oValidator.Stop();
+	m_oEditor.DiscardText();
+	m_oEditor.SetArena(nullptr);
+	m_pCompact.reset();
+	m_pWatcher.reset();
+	m_pReader.reset();
+
+	m_pArena.reset();
+
+	if (m_pDOM.get() != nullptr)
+		NodeCursor::ReleaseChildren(*m_pDOM);
+
+	m_pDOM.reset();
+
+	TRACE1(TXT("Released document in %u ms\n"), ::GetTickCount() - dwStart);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Offer to recover the edits journalled before a crash. The edits are replayed
+//! as a single step that can be undone. A journal the user does not want is
+//! deleted.
+
+void TheDoc::RecoverEdits()
+{
+	tstring strPath = static_cast<const tchar*>(m_Path);
+
+	if (!EditJournal::Exists(strPath))
+		return;
+
+	if (CApp::This().m_rMainWnd.QueryMsg(TXT("There are unsaved edits to this document from a previous session.\n\n")
+											TXT("Do you want to recover them?")) != IDYES)
+	{
+		::DeleteFile(EditJournal::JournalPath(strPath).c_str());
+		return;
+	}
+
+	m_oHistory.BeginStep(TXT("Recover Edits"));
+
+	try
+	{
+		EditJournal::Replay(strPath, m_oEditor, m_pDOM);
+	}
+	catch (const Core::Exception& e)
+	{
+		// Notify user.
+		CApp::This().m_rMainWnd.AlertMsg(TXT("Failed to recover the edits:-\n\n%s"), e.twhat());
+	}
+
+	m_oHistory.EndStep();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Load the next part of a partially loaded document. The reader continues
+//! from where the last part ended and the new nodes are merged into the DOM.
+
+bool TheDoc::LoadMore(IncrementalReader::AddedNodes& vecAdded)
+{
+	ASSERT(IsPartial());
+
+	try
+	{
+		m_pReader->ReadNext(m_pDOM, App.m_nPreviewSize, App.m_nPreviewRecords, vecAdded);
+		m_oIndex.Clear();
+		m_oProfile.Clear();
+	}
+	catch (const Core::Exception& e)
+	{
+		// Notify user.
+		CApp::This().m_rMainWnd.AlertMsg(TXT("Failed to load more of the XML document:-\n\n%s"), e.twhat());
+		return false;
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Summarise the structure of the document, using one thread per CPU. The text
+//! edited in place is written back first, as the nodes are read directly.
+
+void TheDoc::AnalyseStructure(StructureAnalyser::Summary& vecSummary)
+{
+	DWORD dwStart = ::GetTickCount();
+
+	StructureAnalyser oAnalyser(ParseThreadCount());
+
+	if (IsCompact())
+	{
+		oAnalyser.Analyse(*m_pCompact, vecSummary);
+	}
+	else
+	{
+		m_oEditor.FlattenText();
+		oAnalyser.Analyse(*m_pDOM, vecSummary);
+	}
+
+	TRACE2(TXT("Analysed structure in %u ms (%u paths)\n"), ::GetTickCount() - dwStart, vecSummary.size());
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Compare the document with another file, which is read and parsed in the same
+//! way as a full load, but without an arena as it's discarded separately. The
+//! text edited in place is written back first, as the nodes are read directly.
+//! Returns false if there were more differences than the configured limit.
+
+bool TheDoc::CompareWith(const tchar* pszPath, XML::DocumentPtr& pOther, StructuralDiff::Items& vecItems)
+{
+	ASSERT(!IsCompact());
+
+	DWORD   dwStart = ::GetTickCount();
+	tstring strContents;
+
+	if (GZipReader::IsCompressed(pszPath))
+		ReadCompressedFile(pszPath, strContents);
+	else
+		ReadTextFile(pszPath, strContents);
+
+	if (strContents.size() >= App.m_nParallelMinSize)
+	{
+		pOther = ParallelReader(strContents, ParseThreadCount(), nullptr).Read();
+	}
+	else
+	{
+		const tchar* pszBegin = strContents.data();
+		const tchar* pszEnd   = pszBegin + strContents.size();
+
+		pOther = XML::Reader::readDocument(pszBegin, pszEnd, XML::Reader::DISCARD_WHITESPACE);
+	}
+
+	TRACE1(TXT("Loaded the document to compare with in %u ms\n"), ::GetTickCount() - dwStart);
+
+	dwStart = ::GetTickCount();
+
+	m_oEditor.FlattenText();
+
+	StructuralDiff oDiff(ParseThreadCount(), App.m_vecKeyAttribs, App.m_nCompareMaxItems);
+
+	bool bComplete = oDiff.Compare(*m_pDOM, *pOther, vecItems);
+
+	TRACE2(TXT("Compared documents in %u ms (%u entries)\n"), ::GetTickCount() - dwStart, vecItems.size());
+
+	return bComplete;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Apply an edit to every node matched by an XPath expression, returning the
+//! number of nodes edited. The edit is a single step in the undo history and
+//! a single operation in the journal. If it fails part way through, the nodes
+//! already edited are reverted before the exception is passed on.
+
+size_t TheDoc::ApplyBulkEdit(const BulkEdit& oEdit)
+{
+	if (!IsEditable())
+		throw Core::RuntimeException(TXT("Only a document that has been loaded in full can be edited"));
+
+	DWORD  dwStart = ::GetTickCount();
+	size_t nNodes  = 0;
+
+	m_oHistory.BeginStep(oEdit.Description());
+	m_oJournal.BeginBulkEdit();
+
+	try
+	{
+		nNodes = oEdit.Apply(m_oEditor, m_pDOM);
+	}
+	catch (...)
+	{
+		m_oHistory.RollbackStep();
+		m_oJournal.EndBulkEdit(oEdit, false);
+		throw;
+	}
+
+	m_oHistory.EndStep();
+	m_oJournal.EndBulkEdit(oEdit, (nNodes != 0));
+
+	DWORD dwElapsed = ::GetTickCount() - dwStart;
+
+	TRACE3(TXT("Bulk edited %u nodes in %u ms (%u nodes/sec)\n"), nNodes, dwElapsed,
+			static_cast<size_t>((static_cast<uint64>(nNodes) * 1000) / std::max<DWORD>(dwElapsed, 1)));
+
+	return nNodes;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Insert a pasted node as the last child of the selected node, if that is an
+//! element, or otherwise after it. The insertion is a single step in the undo
+//! history. Returns false if the node cannot be inserted there.
+
+bool TheDoc::PasteNode(NodeRef pSelection, const XML::NodePtr& pNode)
+{
+	if (!IsEditable())
+		throw Core::RuntimeException(TXT("Only a document that has been loaded in full can be edited"));
+
+	NodeRef pParent;
+	size_t  nIndex = 0;
+
+	if (pSelection->type() == XML::ELEMENT_NODE)
+	{
+		pParent = pSelection;
+		nIndex  = DomEditor::Container(pParent).getChildCount();
+	}
+	else if ( (pSelection->hasParent()) && (pSelection->parent()->type() == XML::ELEMENT_NODE) )
+	{
+		pParent = pSelection->parent();
+		nIndex  = DomEditor::IndexOf(DomEditor::Container(pParent), pSelection) + 1;
+	}
+	else
+	{
+		return false;
+	}
+
+	m_oHistory.BeginStep(TXT("Paste"));
+
+	try
+	{
+		m_oEditor.InsertNode(pParent, nIndex, pNode);
+	}
+	catch (...)
+	{
+		m_oHistory.RollbackStep();
+		throw;
+	}
+
+	m_oHistory.EndStep();
+
 	return true;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-//! Save the document.
+//! Start following the file for appended content. The root element's end tag
+//! is held back so that records written after it later are read as children
+//! of the root. If the document was loaded in full a new reader is positioned
+//! after the content already in the DOM by scanning, not parsing, the file.
+
+bool TheDoc::StartFollowing()
+{
+	ASSERT(!IsFollowing());
+
+	try
+	{
+		if (GZipReader::IsCompressed(m_Path))
+			throw Core::RuntimeException(TXT("Compressed documents cannot be followed"));
+
+		if (IsCompact())
+			throw Core::RuntimeException(TXT("Compact documents cannot be followed"));
+
+		// The document is partial while it's followed, so can't be saved.
+		if (Modified())
+			throw Core::RuntimeException(TXT("The changes must be saved before the document can be followed"));
+
+		if (IsPartial())
+		{
+			m_pReader->HoldRootOpen(true);
+		}
+		else
+		{
+			m_pReader.reset(new IncrementalReader(static_cast<const tchar*>(m_Path), m_pArena.get()));
+			m_pReader->HoldRootOpen(true);
+			m_pReader->Resume(m_pDOM);
+		}
+
+		m_pWatcher.reset(new FileWatcher(static_cast<const tchar*>(m_Path), m_pReader->FileSize()));
+	}
+	catch (const Core::Exception& e)
+	{
+		// Notify user.
+		CApp::This().m_rMainWnd.AlertMsg(TXT("Failed to follow the XML document:-\n\n%s"), e.twhat());
+		return false;
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Stop following the file.
+
+void TheDoc::StopFollowing()
+{
+	ASSERT(IsFollowing());
+
+	m_pReader->HoldRootOpen(false);
+	m_pWatcher.reset();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Load any content appended to the file since the last poll. Only the bytes
+//! after the last complete markup are read and the new nodes are merged into
+//! the DOM.
+
+FileWatcher::Change TheDoc::PollFollowing(IncrementalReader::AddedNodes& vecAdded)
+{
+	ASSERT(IsFollowing());
+
+	FileWatcher::Change eChange = m_pWatcher->Poll();
+
+	if (eChange != FileWatcher::GREW)
+		return eChange;
+
+	// Read until the remaining bytes hold no complete markup.
+	for (;;)
+	{
+		uint64 nPosition = m_pReader->Position();
+
+		m_pReader->ReadNext(m_pDOM, App.m_nPreviewSize, 0, vecAdded);
+
+		if ( (m_pReader->Position() == nPosition) || (m_pReader->Position() >= m_pReader->FileSize()) )
+			break;
+	}
+
+	if (!vecAdded.empty())
+	{
+		m_oIndex.Clear();
+		m_oProfile.Clear();
+		m_oValidator.OnNodesAdded(vecAdded);
+	}
+
+	return eChange;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Save the document. A partial or compact document is refused as writing it
+//! would replace the file with only the part that has been loaded.
 
 bool TheDoc::Save()
 {
+	if (!IsEditable())
+	{
+		CApp::This().m_rMainWnd.AlertMsg(TXT("Only a document that has been loaded in full can be saved"));
+		return false;
+	}
+
+	m_oEditor.FlattenText();
+
 	try
 	{
-		CString contents = XML::Writer::writeDocument(m_pDOM).c_str();
+		tstring strContents = XML::Writer::writeDocument(m_pDOM);
 
-		CFile::WriteTextFile(m_Path, contents, ANSI_TEXT);
+		AddMissingDeclaration(strContents, m_eEncoding, m_bByteOrderMark);
+
+		if (IsCompressedPath())
+			WriteCompressedFile(strContents);
+		else
+			WriteTextFile(strContents);
 	}
 	catch (const Core::Exception& e)
 	{
@@ -84,5 +730,174 @@ bool TheDoc::Save()
 		return false;
 	}
 
+	m_oEditor.SetModified(false);
+	m_oJournal.Reset();
+
 	return true;
 }
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read and decode the contents of an uncompressed file. The file is decoded a
+//! block at a time straight into the parser's input buffer.
+
+void TheDoc::ReadTextFile(const tchar* pszPath, tstring& strContents)
+{
+	CFile             oFile;
+	TextDecoder       oDecoder;
+	std::vector<byte> vecBlock(STREAM_BLOCK_SIZE);
+
+	oFile.Open(pszPath, CFile::ReadOnly);
+
+	for (size_t nRemaining = oFile.Size(); nRemaining != 0; )
+	{
+		size_t nRead = std::min(nRemaining, vecBlock.size());
+
+		oFile.Read(&vecBlock.front(), nRead);
+		oDecoder.Decode(&vecBlock.front(), &vecBlock.front() + nRead, strContents);
+
+		nRemaining -= nRead;
+	}
+
+	oDecoder.Finish(strContents);
+	oFile.Close();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Read and decompress the contents of a gzip compressed file. The file is
+//! inflated and decoded a block at a time straight into the parser's input
+//! buffer so that the uncompressed bytes are never held in memory in full.
+
+void TheDoc::ReadCompressedFile(const tchar* pszPath, tstring& strContents)
+{
+	GZipReader        oReader(pszPath);
+	TextDecoder       oDecoder;
+	std::vector<byte> vecBlock(STREAM_BLOCK_SIZE);
+	size_t            nRead = 0;
+
+	while ((nRead = oReader.Read(&vecBlock.front(), vecBlock.size())) != 0)
+		oDecoder.Decode(&vecBlock.front(), &vecBlock.front() + nRead, strContents);
+
+	oDecoder.Finish(strContents);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Detect the encoding of the file from its first bytes, in the same way as
+//! the text is decoded when read, so that it can be saved in the same one.
+
+void TheDoc::ReadEncoding()
+{
+	std::vector<byte> vecHeader(TextDecoder::MAX_DETECT_SIZE);
+	size_t            nRead = 0;
+
+	if (GZipReader::IsCompressed(m_Path))
+	{
+		GZipReader oReader(m_Path);
+
+		nRead = oReader.Read(&vecHeader.front(), vecHeader.size());
+	}
+	else
+	{
+		CFile oFile;
+
+		oFile.Open(m_Path, CFile::ReadOnly);
+
+		nRead = std::min(oFile.Size(), vecHeader.size());
+
+		if (nRead != 0)
+			oFile.Read(&vecHeader.front(), nRead);
+
+		oFile.Close();
+	}
+
+	TextDecoder oDecoder;
+
+	oDecoder.DetectEncoding(&vecHeader.front(), &vecHeader.front() + nRead);
+
+	m_eEncoding      = oDecoder.GetEncoding();
+	m_bByteOrderMark = oDecoder.HasByteOrderMark();
+
+	TRACE2(TXT("Detected encoding %d (byte order mark: %s)\n"), m_eEncoding, m_bByteOrderMark ? TXT("yes") : TXT("no"));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Encode and write the contents to an uncompressed file. The text is written
+//! a block at a time in the encoding, and with the byte order mark, that the
+//! file was read with.
+
+void TheDoc::WriteTextFile(const tstring& strContents) const
+{
+	CFile             oFile;
+	TextEncoder       oEncoder(m_eEncoding, m_bByteOrderMark);
+	const size_t      nBlockChars = STREAM_BLOCK_SIZE / 4;
+	std::vector<byte> vecBlock;
+
+	oFile.Create(m_Path);
+
+	for (size_t nOffset = 0; nOffset < strContents.size(); nOffset += nBlockChars)
+	{
+		const tchar* pszBlock = strContents.data() + nOffset;
+		size_t       nChars   = std::min(nBlockChars, strContents.size() - nOffset);
+
+		vecBlock.clear();
+		oEncoder.Encode(pszBlock, pszBlock + nChars, vecBlock);
+
+		if (!vecBlock.empty())
+			oFile.Write(&vecBlock.front(), vecBlock.size());
+	}
+
+	vecBlock.clear();
+	oEncoder.Finish(vecBlock);
+
+	if (!vecBlock.empty())
+		oFile.Write(&vecBlock.front(), vecBlock.size());
+
+	oFile.Close();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Compress and write the contents to a gzip compressed file. The text is
+//! encoded and compressed a block at a time, like an uncompressed save it is
+//! written in the encoding that the file was read with.
+
+void TheDoc::WriteCompressedFile(const tstring& strContents) const
+{
+	GZipWriter        oWriter(m_Path);
+	TextEncoder       oEncoder(m_eEncoding, m_bByteOrderMark);
+	const size_t      nBlockChars = STREAM_BLOCK_SIZE / 4;
+	std::vector<byte> vecBlock;
+
+	for (size_t nOffset = 0; nOffset < strContents.size(); nOffset += nBlockChars)
+	{
+		const tchar* pszBlock = strContents.data() + nOffset;
+		size_t       nChars   = std::min(nBlockChars, strContents.size() - nOffset);
+
+		vecBlock.clear();
+		oEncoder.Encode(pszBlock, pszBlock + nChars, vecBlock);
+
+		if (!vecBlock.empty())
+			oWriter.Write(&vecBlock.front(), vecBlock.size());
+	}
+
+	vecBlock.clear();
+	oEncoder.Finish(vecBlock);
+
+	if (!vecBlock.empty())
+		oWriter.Write(&vecBlock.front(), vecBlock.size());
+
+	oWriter.Close();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the document path is for a gzip compressed file.
+
+bool TheDoc::IsCompressedPath() const
+{
+	const tchar* pszPath = m_Path;
+	size_t       nLength = tstrlen(pszPath);
+	size_t       nExtLen = tstrlen(COMPRESSED_FILE_EXT);
+
+	if (nLength < nExtLen)
+		return false;
+
+	return (tstricmp(pszPath + nLength - nExtLen, COMPRESSED_FILE_EXT) == 0);
+}
@@ -13,6 +13,21 @@
 
 #include <WCL/SDIDoc.hpp>
 #include <XML/Document.hpp>
+#include <Core/UniquePtr.hpp>
+#include "IncrementalReader.hpp"
+#include "TextDecoder.hpp"
+#include "FileWatcher.hpp"
+#include "DocArena.hpp"
+#include "NameIndex.hpp"
+#include "CompactDoc.hpp"
+#include "DomEditor.hpp"
+#include "UndoHistory.hpp"
+#include "EditJournal.hpp"
+#include "BulkEdit.hpp"
+#include "Validator.hpp"
+#include "StructureAnalyser.hpp"
+#include "SubtreeProfile.hpp"
+#include "StructuralDiff.hpp"
 
 // Forward declarations.
 class TheView;
@@ -20,7 +35,7 @@ class TheView;
 ////////////////////////////////////////////////////////////////////////////////
 //! The document.
 
-class TheDoc : public CSDIDoc
+class TheDoc : public CSDIDoc, private IDomListener
 {
 public:
 	//! Constructor.
@@ -42,6 +57,48 @@ public:
 	//! Get the underlying XML DOM document.
 	XML::DocumentPtr DOM() const;
 
+	//! Query if only part of the document has been loaded.
+	bool IsPartial() const;
+
+	//! Query if an element was left open by a partial load.
+	bool IsTruncated(const XML::Node* pNode) const;
+
+	//! Get the chain of elements left open by a partial load.
+	IncrementalReader::NodeChain TruncatedElements() const;
+
+	//! Get the number of bytes of the file loaded so far.
+	uint64 LoadedBytes() const;
+
+	//! Get the size of the file being loaded.
+	uint64 FileSize() const;
+
+	//! Query if the file is being followed for appended content.
+	bool IsFollowing() const;
+
+	//! Get the index of elements by name, building it if required.
+	const NameIndex& Index();
+
+	//! Query if the document was loaded in the compact read-only form.
+	bool IsCompact() const;
+
+	//! Get the compact read-only form of the document.
+	const CompactDoc& Compact() const;
+
+	//! Query if the document can be edited.
+	bool IsEditable() const;
+
+	//! Get the editor for the DOM.
+	DomEditor& Editor();
+
+	//! Get the undo history of the edits.
+	UndoHistory& History();
+
+	//! Get the background validator.
+	Validator& Validation();
+
+	//! Get the sizes of the element sub-trees, building them if required.
+	const SubtreeProfile& Profile();
+
 	//
 	// Methods.
 	//
@@ -52,11 +109,97 @@ public:
 	//! Save the document.
 	virtual bool Save();
 
+	//! Load the next part of a partially loaded document.
+	bool LoadMore(IncrementalReader::AddedNodes& vecAdded);
+
+	//! Apply an edit to every node matched by an XPath expression.
+	size_t ApplyBulkEdit(const BulkEdit& oEdit);
+
+	//! Summarise the structure of the document.
+	void AnalyseStructure(StructureAnalyser::Summary& vecSummary);
+
+	//! Compare the document with another file.
+	bool CompareWith(const tchar* pszPath, XML::DocumentPtr& pOther, StructuralDiff::Items& vecItems);
+
+	//! Insert a pasted node relative to the selected one.
+	bool PasteNode(NodeRef pSelection, const XML::NodePtr& pNode);
+
+	//! Start following the file for appended content.
+	bool StartFollowing();
+
+	//! Stop following the file.
+	void StopFollowing();
+
+	//! Load any content appended to the file since the last poll.
+	FileWatcher::Change PollFollowing(IncrementalReader::AddedNodes& vecAdded);
+
+	//
+	// Class methods.
+	//
+
+	//! Read and decode the contents of an uncompressed file.
+	static void ReadTextFile(const tchar* pszPath, tstring& strContents);
+
+	//! Read and decompress the contents of a gzip compressed file.
+	static void ReadCompressedFile(const tchar* pszPath, tstring& strContents);
+
 private:
+	//! The reader smart-pointer type.
+	typedef Core::UniquePtr<IncrementalReader> ReaderPtr;
+	//! The watcher smart-pointer type.
+	typedef Core::UniquePtr<FileWatcher> WatcherPtr;
+	//! The arena smart-pointer type.
+	typedef Core::UniquePtr<DocArena> ArenaPtr;
+	//! The compact document smart-pointer type.
+	typedef Core::UniquePtr<CompactDoc> CompactDocPtr;
+
 	//
 	// Members.
 	//
+	ArenaPtr			m_pArena;	//!< The arena holding the DOM, if enabled.
 	XML::DocumentPtr	m_pDOM;		//!< The XML DOM document.
+	ReaderPtr			m_pReader;	//!< The reader for a partially loaded document.
+	WatcherPtr			m_pWatcher;	//!< The watcher for a followed document.
+	NameIndex			m_oIndex;	//!< The index of elements by name.
+	CompactDocPtr		m_pCompact;	//!< The compact read-only form, if used.
+	DomEditor			m_oEditor;	//!< The editor for the DOM.
+	UndoHistory			m_oHistory;	//!< The undo history of the edits.
+	EditJournal			m_oJournal;	//!< The journal of unsaved edits.
+	Validator			m_oValidator;	//!< The background validator.
+	SubtreeProfile		m_oProfile;	//!< The sizes of the element sub-trees.
+	TextDecoder::Encoding	m_eEncoding;		//!< The encoding the file was read in.
+	bool					m_bByteOrderMark;	//!< Did the file start with a byte order mark?
+
+	//
+	// Internal methods.
+	//
+
+	//! Load the first part of the document.
+	void LoadPreview();
+
+	//! Load the document in the compact read-only form.
+	void LoadCompact();
+
+	//! Release the DOM and the arena that holds it.
+	void ReleaseDOM();
+
+	//! Offer to recover the edits journalled before a crash.
+	void RecoverEdits();
+
+	//! Handle a change to the DOM.
+	virtual void OnDomChanged(const DomChange& oChange);
+
+	//! Detect the encoding of the file from its first bytes.
+	void ReadEncoding();
+
+	//! Encode and write the contents to an uncompressed file.
+	void WriteTextFile(const tstring& strContents) const;
+
+	//! Compress and write the contents to a gzip compressed file.
+	void WriteCompressedFile(const tstring& strContents) const;
+
+	//! Query if the document path is for a gzip compressed file.
+	bool IsCompressedPath() const;
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -67,4 +210,63 @@ inline XML::DocumentPtr TheDoc::DOM() const
 	return m_pDOM;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the file is being followed for appended content.
+
+inline bool TheDoc::IsFollowing() const
+{
+	return (m_pWatcher.get() != nullptr);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the document was loaded in the compact read-only form.
+
+inline bool TheDoc::IsCompact() const
+{
+	return (m_pCompact.get() != nullptr);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the compact read-only form of the document.
+
+inline const CompactDoc& TheDoc::Compact() const
+{
+	ASSERT(IsCompact());
+
+	return *m_pCompact;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the document can be edited. Only a DOM that has been loaded in full
+//! can be, as a partial one has synthetic end tags for the truncated elements.
+
+inline bool TheDoc::IsEditable() const
+{
+	return ( (!IsCompact()) && (!IsPartial()) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the editor for the DOM.
+
+inline DomEditor& TheDoc::Editor()
+{
+	return m_oEditor;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the undo history of the edits.
+
+inline UndoHistory& TheDoc::History()
+{
+	return m_oHistory;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the background validator.
+
+inline Validator& TheDoc::Validation()
+{
+	return m_oValidator;
+}
+
 #endif // APP_THEDOC_HPP
@@ -9,14 +9,19 @@
 #include "Resource.h"
 #include "TheApp.hpp"
 #include <XML/Document.hpp>
-#include <XML/TextNode.hpp>
 #include <XML/ElementNode.hpp>
 #include <XML/CommentNode.hpp>
 #include <XML/ProcessingNode.hpp>
 #include <XML/DocTypeNode.hpp>
-#include <XML/CDataNode.hpp>
 #include <WCL/ScreenDC.hpp>
 
+// Constants.
+static const uint VALIDATE_INTERVAL = 100;
+static const DWORD VALIDATE_SLICE = 20;
+static const int PROBLEMS_HEIGHT_DIVISOR = 4;
+static const size_t PROBLEM_TYPE_WIDTH = 150;
+static const size_t PROBLEM_MESSAGE_WIDTH = 600;
+
 ////////////////////////////////////////////////////////////////////////////////
 //! Constructor.
 
@@ -24,7 +29,10 @@ TheView::TheView(TheDoc& rDoc)
 	: CView(rDoc)
 	, m_wndMainSplit(CSplitWnd::RESIZEABLE)
 	, m_tvNodeTree(*this)
+	, m_ebValue(*this)
+	, m_lvProblems(*this)
 	, m_fntControls(ANSI_FIXED_FONT)
+	, m_bEditingValue(false)
 {
 /*
 	DEFINE_CTRLMSG_TABLE
@@ -63,6 +71,22 @@ void TheView::SetSelection(const XML::NodePtr& pNode)
 	m_tvNodeTree.SetSelection(pNode);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! Get the selected node of a compact document.
+
+CompactDoc::NodeIndex TheView::SelectedIndex() const
+{
+	return m_tvNodeTree.SelectedIndex();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Set the selected node of a compact document.
+
+void TheView::SetSelection(CompactDoc::NodeIndex nNode)
+{
+	m_tvNodeTree.SetSelection(nNode);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! Set the layout of the panes.
 
@@ -88,6 +112,60 @@ void TheView::Activate()
 	m_tvNodeTree.Focus();
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! Add the nodes loaded by a partial read to the view.
+
+void TheView::OnNodesAdded(const IncrementalReader::AddedNodes& vecAdded, const IncrementalReader::NodeChain& vecUpdated)
+{
+	m_tvNodeTree.AddNodes(vecAdded, vecUpdated);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Start following the document's file for appended content.
+
+void TheView::StartFollowing()
+{
+	if (Document().StartFollowing())
+		StartTimer(FOLLOW_TIMER_ID, App.m_nFollowInterval);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Stop following the document's file.
+
+void TheView::StopFollowing()
+{
+	StopTimer(FOLLOW_TIMER_ID);
+	Document().StopFollowing();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Pass a clipboard message on to the value view, if it has the focus, as the
+//! copy and paste commands' accelerators would otherwise take the keystrokes
+//! away from it. Returns false if the view does not have the focus.
+
+bool TheView::ForwardToValue(UINT iMsg)
+{
+	if (::GetFocus() != m_ebValue.Handle())
+		return false;
+
+	m_ebValue.SendMessage(iMsg, 0, 0);
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Show or hide the validation problems. They are only shown below the other
+//! panes when the document is being validated.
+
+void TheView::ShowProblems(bool bShow)
+{
+	bool bVisible = ( (bShow) && (Document().Validation().IsRunning()) );
+
+	m_lvProblems.Show(bVisible ? SW_SHOW : SW_HIDE);
+
+	LayoutPanes();
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! Handle window creation.
 
@@ -112,8 +190,13 @@ void TheView::OnCreate(const CRect& rcClient)
 										| WS_BORDER | LVS_REPORT | LVS_SINGLESEL | LVS_SHOWSELALWAYS | LVS_NOSORTHEADER);
 
 	m_ebValue.Create(m_wndMainSplit, IDC_VALUE, rcEmpty, WS_EX_CLIENTEDGE,
-										WS_CHILD | WS_CLIPSIBLINGS | WS_CLIPCHILDREN | WS_VISIBLE
-										| ES_MULTILINE | ES_AUTOVSCROLL | ES_LEFT);
+										WS_CHILD | WS_CLIPSIBLINGS | WS_CLIPCHILDREN | WS_VISIBLE | WS_VSCROLL | WS_HSCROLL
+										| ES_MULTILINE | ES_AUTOVSCROLL | ES_AUTOHSCROLL | ES_LEFT);
+
+	m_lvProblems.Create(*this, IDC_PROBLEMS, rcEmpty, WS_EX_CLIENTEDGE,
+										WS_CHILD | WS_CLIPSIBLINGS | WS_CLIPCHILDREN
+										| WS_BORDER | LVS_REPORT | LVS_SINGLESEL | LVS_SHOWSELALWAYS | LVS_NOSORTHEADER
+										| LVS_OWNERDATA);
 
 	// Add the child controls to the splitters.
 	m_wndMainSplit.SetPane(CSplitWnd::LEFT_PANE, &m_tvNodeTree);
@@ -134,11 +217,24 @@ void TheView::OnCreate(const CRect& rcClient)
 	m_ebValue.Font(m_fntControls);
 	m_ebValue.ReadOnly(true);
 
+	m_lvProblems.Font(m_fntControls);
+	m_lvProblems.InsertColumn(ProblemListView::TYPE_COLUMN,    TXT("Problem"),     PROBLEM_TYPE_WIDTH,    LVCFMT_LEFT);
+	m_lvProblems.InsertColumn(ProblemListView::MESSAGE_COLUMN, TXT("Description"), PROBLEM_MESSAGE_WIDTH, LVCFMT_LEFT);
+	m_lvProblems.FullRowSelect(true);
+
 	// Update the menu.
 	App.m_oAppWnd.m_oMenu.CheckCmd(ID_VIEW_HORZ, true);
 
-	// Display the current DOM.
+	// Display the current DOM and follow any edits to it.
 	InitialiseView();
+
+	Document().Editor().AddListener(&m_tvNodeTree);
+
+	// Show the problems found by the background validation, if any.
+	ShowProblems(App.m_bShowProblems);
+
+	if (Document().Validation().IsRunning())
+		StartTimer(VALIDATE_TIMER_ID, VALIDATE_INTERVAL);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -150,6 +246,13 @@ void TheView::OnDestroy()
 	App.m_nDefSplitPos = m_wndMainSplit.SizingBarPos();
 	App.m_vecDefColWidths[NAME_COLUMN]  = m_lvAttributes.ColumnWidth(NAME_COLUMN);
 	App.m_vecDefColWidths[VALUE_COLUMN] = m_lvAttributes.ColumnWidth(VALUE_COLUMN);
+
+	if (Document().IsFollowing())
+		StopFollowing();
+
+	StopTimer(VALIDATE_TIMER_ID);
+
+	Document().Editor().RemoveListener(&m_tvNodeTree);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -157,7 +260,7 @@ void TheView::OnDestroy()
 
 void TheView::OnResize(int /*iFlag*/, const CSize& /*rNewSize*/)
 {
-	m_wndMainSplit.Move(ClientRect());
+	LayoutPanes();
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -168,8 +271,22 @@ void TheView::OnNodeSelected(NMTREEVIEW& oMsg)
 	ASSERT(oMsg.hdr.hwndFrom == m_tvNodeTree.Handle());
 	ASSERT(oMsg.hdr.code     == TVN_SELCHANGED);
 
-	XML::NodePtr pNode = m_tvNodeTree.GetItemNode(oMsg.itemNew.hItem);
+	if (Document().IsCompact())
+	{
+		OnCompactNodeSelected(m_tvNodeTree.GetItemIndex(oMsg.itemNew.hItem));
+		return;
+	}
+
+	ShowNode(m_tvNodeTree.GetItemNode(oMsg.itemNew.hItem));
+}
 
+////////////////////////////////////////////////////////////////////////////////
+//! Show the attributes or content of a node in the details pane. The text of a
+//! text or CDATA node can be edited in place, unless it holds a CR that the
+//! value view could not keep apart from its own line breaks.
+
+void TheView::ShowNode(NodeRef pNode)
+{
 	ASSERT(pNode.get() != nullptr);
 
 	XML::NodeType eType = pNode->type();
@@ -177,16 +294,16 @@ void TheView::OnNodeSelected(NMTREEVIEW& oMsg)
 	// Has attributes?
 	if ( (eType == XML::ELEMENT_NODE) || (eType == XML::PROCESSING_NODE) )
 	{
-		XML::Attributes vAttribs;
+		const XML::Attributes* pAttribs = nullptr;
 
-		// Extract the attributes.
+		// Find the attributes.
 		if (eType == XML::ELEMENT_NODE)
 		{
-			vAttribs = Core::static_ptr_cast<XML::ElementNode>(pNode)->getAttributes();
+			pAttribs = &pNode.As<XML::ElementNode>()->getAttributes();
 		}
 		else if (eType == XML::PROCESSING_NODE)
 		{
-			vAttribs = Core::static_ptr_cast<XML::ProcessingNode>(pNode)->getAttributes();
+			pAttribs = &pNode.As<XML::ProcessingNode>()->getAttributes();
 		}
 		else
 		{
@@ -198,7 +315,7 @@ void TheView::OnNodeSelected(NMTREEVIEW& oMsg)
 
 		m_lvAttributes.DeleteAllItems();
 
-		for (XML::Attributes::const_iterator it = vAttribs.begin(); it != vAttribs.end(); ++it)
+		for (XML::Attributes::const_iterator it = pAttribs->begin(); it != pAttribs->end(); ++it)
 		{
 			const XML::AttributePtr& pAttribute = *it;
 
@@ -212,23 +329,21 @@ void TheView::OnNodeSelected(NMTREEVIEW& oMsg)
 		   || (eType == XML::DOCTYPE_NODE) || (eType == XML::CDATA_NODE) )
 	{
 		tstring strText;
+		bool    bEditable = false;
 
 		// Extract text value.
-		if (eType == XML::TEXT_NODE)
+		if ( (eType == XML::TEXT_NODE) || (eType == XML::CDATA_NODE) )
 		{
-			strText = Core::static_ptr_cast<XML::TextNode>(pNode)->text();
+			strText   = Document().Editor().Text(pNode);
+			bEditable = ( (Document().IsEditable()) && (strText.find(TXT('\r')) == tstring::npos) );
 		}
 		else if (eType == XML::COMMENT_NODE)
 		{
-			strText = Core::static_ptr_cast<XML::CommentNode>(pNode)->comment();
+			strText = pNode.As<XML::CommentNode>()->comment();
 		}
 		else if (eType == XML::DOCTYPE_NODE)
 		{
-			strText = Core::static_ptr_cast<XML::DocTypeNode>(pNode)->declaration();
-		}
-		else if (eType == XML::CDATA_NODE)
-		{
-			strText = Core::static_ptr_cast<XML::CDataNode>(pNode)->text();
+			strText = pNode.As<XML::DocTypeNode>()->declaration();
 		}
 		else
 		{
@@ -237,7 +352,7 @@ void TheView::OnNodeSelected(NMTREEVIEW& oMsg)
 
 		// Switch info controls and display text.
 		m_wndMainSplit.SetPane(CSplitWnd::RIGHT_PANE, &m_ebValue);
-		m_ebValue.Text(strText.c_str());
+		m_ebValue.Show(strText, bEditable);
 	}
 	// No proprties.
 	else
@@ -246,6 +361,162 @@ void TheView::OnNodeSelected(NMTREEVIEW& oMsg)
 	}
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! Handle a selection change in the node tree of a compact document. The
+//! attributes and text are only decoded from the source text at this point.
+
+void TheView::OnCompactNodeSelected(CompactDoc::NodeIndex nNode)
+{
+	const CompactDoc& oDoc  = Document().Compact();
+	XML::NodeType     eType = oDoc.Type(nNode);
+
+	// Has attributes?
+	if ( (eType == XML::ELEMENT_NODE) || (eType == XML::PROCESSING_NODE) )
+	{
+		CompactDoc::Attributes vecAttribs;
+
+		oDoc.GetAttributes(nNode, vecAttribs);
+
+		// Switch info controls and display attributes.
+		m_wndMainSplit.SetPane(CSplitWnd::RIGHT_PANE, &m_lvAttributes);
+
+		m_lvAttributes.DeleteAllItems();
+
+		for (CompactDoc::Attributes::const_iterator it = vecAttribs.begin(); it != vecAttribs.end(); ++it)
+		{
+			size_t n = m_lvAttributes.ItemCount();
+			m_lvAttributes.InsertItem(n,    it->first.c_str());
+			m_lvAttributes.ItemText  (n, 1, it->second.c_str());
+		}
+	}
+	// Is content?
+	else if ( (eType == XML::TEXT_NODE) || (eType == XML::COMMENT_NODE)
+		   || (eType == XML::DOCTYPE_NODE) || (eType == XML::CDATA_NODE) )
+	{
+		// Switch info controls and display text.
+		m_wndMainSplit.SetPane(CSplitWnd::RIGHT_PANE, &m_ebValue);
+		m_ebValue.Show(oDoc.Value(nNode), false);
+	}
+	// No proprties.
+	else
+	{
+		m_wndMainSplit.SetPane(CSplitWnd::RIGHT_PANE, nullptr);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Handle an edit to the text in the value view by applying it to the selected
+//! node. If the view has somehow got out of step with the node it is shown
+//! again rather than making the wrong edit.
+
+void TheView::OnValueEdited(size_t nOffset, size_t nCount, const tstring& strText)
+{
+	XML::NodePtr pNode   = Selection();
+	DomEditor&   oEditor = Document().Editor();
+
+	if ( (!Document().IsEditable()) || (nOffset + nCount > oEditor.TextLength(pNode)) )
+	{
+		ASSERT_FALSE();
+
+		ShowNode(pNode);
+		return;
+	}
+
+	m_bEditingValue = true;
+
+	oEditor.EditText(pNode, nOffset, nCount, strText);
+
+	m_bEditingValue = false;
+
+	App.m_oAppCmds.UpdateUI();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Handle an edit to the text of the selected node. An edit made elsewhere,
+//! e.g. by an undo, is applied to just the range of the value view's text that
+//! it replaced.
+
+void TheView::OnTextEdited(const DomChange& oChange)
+{
+	if (m_bEditingValue)
+		return;
+
+	if (m_ebValue.IsEditable())
+		m_ebValue.ReplaceText(oChange.m_nOffset, oChange.m_strOldValue.length(), oChange.m_strNewText);
+	else
+		ShowNode(oChange.m_pNode);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Handle a validation problem being activated by selecting its node. The node
+//! is only used as a key, as it may have been removed since the problems were
+//! published, in which case it will no longer have an item in the tree.
+
+void TheView::OnProblemActivated(const XML::Node* pNode)
+{
+	HTREEITEM hItem = m_tvNodeTree.FindNodeItem(pNode);
+
+	if (hItem == NULL)
+		return;
+
+	m_tvNodeTree.Select(hItem);
+	m_tvNodeTree.EnsureVisible(hItem);
+	m_tvNodeTree.Focus();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Handle the follow mode polling and validation timers. Any records appended
+//! to the file are added to the tree and, if enabled, the last one is scrolled
+//! into view.
+
+void TheView::OnTimer(uint nTimerID)
+{
+	if (nTimerID == VALIDATE_TIMER_ID)
+	{
+		UpdateProblems();
+		return;
+	}
+
+	if ( (nTimerID != FOLLOW_TIMER_ID) || (!Document().IsFollowing()) )
+		return;
+
+	IncrementalReader::NodeChain  vecTruncated = Document().TruncatedElements();
+	IncrementalReader::AddedNodes vecAdded;
+	FileWatcher::Change           eChange = FileWatcher::UNCHANGED;
+
+	try
+	{
+		eChange = Document().PollFollowing(vecAdded);
+	}
+	catch (const Core::Exception& e)
+	{
+		StopFollowing();
+		App.m_oAppCmds.UpdateUI();
+
+		App.m_oAppWnd.AlertMsg(TXT("Failed to read the appended content:-\n\n%s"), e.twhat());
+		return;
+	}
+
+	if ( (eChange == FileWatcher::SHRANK) || (eChange == FileWatcher::MISSING) )
+	{
+		StopFollowing();
+		App.m_oAppCmds.UpdateUI();
+
+		App.NotifyMsg(TXT("The file has been truncated or deleted and is no longer being followed"));
+		return;
+	}
+
+	if (!vecAdded.empty())
+	{
+		OnNodesAdded(vecAdded, vecTruncated);
+
+		if (App.m_bAutoScroll)
+			m_tvNodeTree.EnsureVisible(m_tvNodeTree.GetNodeItem(vecAdded.back().second));
+
+		App.m_oAppCmds.UpdateUI();
+	}
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! Initialise the view from the DOM.
 
@@ -258,3 +529,42 @@ void TheView::InitialiseView()
 	// Set initial focus.
 	Activate();
 }
+
+////////////////////////////////////////////////////////////////////////////////
+//! Lay out the panes to fill the view. The problems, when shown, take a fixed
+//! share of the height below the split window.
+
+void TheView::LayoutPanes()
+{
+	CRect rcClient = ClientRect();
+
+	if (!::IsWindowVisible(m_lvProblems.Handle()))
+	{
+		m_wndMainSplit.Move(rcClient);
+		return;
+	}
+
+	int nSplit = rcClient.bottom - (rcClient.Height() / PROBLEMS_HEIGHT_DIVISOR);
+
+	m_wndMainSplit.Move(CRect(rcClient.left, rcClient.top, rcClient.right, nSplit));
+	m_lvProblems.Move(CRect(rcClient.left, nSplit, rcClient.right, rcClient.bottom));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Advance the validation by copying out the facts about the edited elements
+//! for a short time slice, then show the problems if new ones were published.
+
+void TheView::UpdateProblems()
+{
+	Validator& oValidator = Document().Validation();
+
+	if (!oValidator.IsRunning())
+		return;
+
+	oValidator.Step(VALIDATE_SLICE);
+
+	Validator::Problems vecProblems;
+
+	if (oValidator.TakeProblems(vecProblems))
+		m_lvProblems.SetProblems(vecProblems);
+}
@@ -10,8 +10,10 @@
 #include <WCL/View.hpp>
 #include <WCL/SplitWnd.hpp>
 #include <WCL/ListView.hpp>
-#include <WCL/EditBox.hpp>
 #include "XmlTreeView.hpp"
+#include "NodeTextBox.hpp"
+#include "ProblemListView.hpp"
+#include "IncrementalReader.hpp"
 
 // Forward declarations.
 class TheDoc;
@@ -48,6 +50,12 @@ public:
 	//! Set the selected node.
 	void SetSelection(const XML::NodePtr& pNode);
 
+	//! Get the selected node of a compact document.
+	CompactDoc::NodeIndex SelectedIndex() const;
+
+	//! Set the selected node of a compact document.
+	void SetSelection(CompactDoc::NodeIndex nNode);
+
 	//
 	// Methods.
 	//
@@ -58,6 +66,21 @@ public:
 	//! Activate the view.
 	void Activate();
 
+	//! Add the nodes loaded by a partial read to the view.
+	void OnNodesAdded(const IncrementalReader::AddedNodes& vecAdded, const IncrementalReader::NodeChain& vecUpdated);
+
+	//! Start following the document's file for appended content.
+	void StartFollowing();
+
+	//! Stop following the document's file.
+	void StopFollowing();
+
+	//! Pass a clipboard message on to the value view, if it has the focus.
+	bool ForwardToValue(UINT iMsg);
+
+	//! Show or hide the validation problems.
+	void ShowProblems(bool bShow);
+
 private:
 	//
 	// Members.
@@ -65,8 +88,10 @@ private:
 	CSplitWnd		m_wndMainSplit;		//!< The tree/details split window.
 	XmlTreeView		m_tvNodeTree;		//!< The DOM tree view.
 	CListView		m_lvAttributes;		//!< The node attributes view.
-	CEditBox		m_ebValue;			//!< The node value view.
+	NodeTextBox		m_ebValue;			//!< The node value view.
+	ProblemListView	m_lvProblems;		//!< The validation problems view.
 	CFont			m_fntControls;		//!< The font to use for the controls.
+	bool			m_bEditingValue;	//!< Is the value view's edit being applied?
 
 	//! The ID of the main split window.
 	static const uint IDC_MAIN_SPLIT = 100;
@@ -76,6 +101,12 @@ private:
 	static const uint IDC_ATTRIBUTES = 103;
 	//! The ID of the node value control.
 	static const uint IDC_VALUE = 104;
+	//! The ID of the validation problems view.
+	static const uint IDC_PROBLEMS = 105;
+	//! The ID of the follow mode polling timer.
+	static const uint FOLLOW_TIMER_ID = 1;
+	//! The ID of the validation timer.
+	static const uint VALIDATE_TIMER_ID = 2;
 
 	//! The attributes columns.
 	enum Column
@@ -100,6 +131,21 @@ private:
 	//! Handle a selection change in the node tree.
 	void OnNodeSelected(NMTREEVIEW& oMsg);
 
+	//! Handle the follow mode polling timer.
+	virtual void OnTimer(uint nTimerID);
+
+	//! Handle a selection change in the node tree of a compact document.
+	void OnCompactNodeSelected(CompactDoc::NodeIndex nNode);
+
+	//! Handle an edit to the text in the value view.
+	void OnValueEdited(size_t nOffset, size_t nCount, const tstring& strText);
+
+	//! Handle an edit to the text of the selected node.
+	void OnTextEdited(const DomChange& oChange);
+
+	//! Handle a validation problem being activated.
+	void OnProblemActivated(const XML::Node* pNode);
+
 	//
 	// Internal methods.
 	//
@@ -107,12 +153,25 @@ private:
 	//! Initialise the view from the DOM.
 	void InitialiseView();
 
+	//! Show the attributes or content of a node in the details pane.
+	void ShowNode(NodeRef pNode);
+
+	//! Lay out the panes to fill the view.
+	void LayoutPanes();
+
+	//! Advance the validation and show any new problems.
+	void UpdateProblems();
+
 	//
 	// Friends.
 	//
 
 	//! Allow the DOM tree-view to reflect events back.
 	friend class XmlTreeView;
+	//! Allow the value view to report edits.
+	friend class NodeTextBox;
+	//! Allow the problems view to report activation.
+	friend class ProblemListView;
 };
 
 #endif // APP_THEVIEW_HPP
@@ -0,0 +1,407 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   UndoHistory.cpp
+//! \brief  The UndoHistory class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "UndoHistory.hpp"
+#include "DomEditor.hpp"
+#include "NodeCursor.hpp"
+
+// Constants.
+static const tchar* DEFAULT_STEP_NAME = TXT("Edit");
+static const tchar* TYPING_STEP_NAME = TXT("Typing");
+static const size_t BYTES_PER_NODE = 128;
+
+// The number of changes in a step above which it is reverted as a batch.
+static const size_t BATCH_THRESHOLD = 100;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+UndoHistory::UndoHistory(DomEditor& oEditor, size_t nMaxSize)
+	: m_oEditor(oEditor)
+	, m_nMaxSize(nMaxSize)
+	, m_nSize(0)
+	, m_eMode(RECORDING)
+	, m_nDepth(0)
+	, m_bTyping(false)
+{
+	m_oEditor.AddListener(this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+UndoHistory::~UndoHistory()
+{
+	m_oEditor.RemoveListener(this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the name of the step that would be undone.
+
+const tstring& UndoHistory::UndoName() const
+{
+	ASSERT(CanUndo());
+
+	return m_vecUndo.back().m_strName;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the name of the step that would be redone.
+
+const tstring& UndoHistory::RedoName() const
+{
+	ASSERT(CanRedo());
+
+	return m_vecRedo.back().m_strName;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Set the limit on the memory retained by the history.
+
+void UndoHistory::SetMaxSize(size_t nMaxSize)
+{
+	m_nMaxSize = nMaxSize;
+
+	Evict();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Start grouping the following changes into a single step. The calls can be
+//! nested, in which case the outermost name is used.
+
+void UndoHistory::BeginStep(const tstring& strName)
+{
+	ASSERT(m_eMode == RECORDING);
+
+	if (m_nDepth++ == 0)
+	{
+		PushStep(m_vecUndo, strName);
+		ClearRedo();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Finish grouping changes. A step that made no changes is discarded.
+
+void UndoHistory::EndStep()
+{
+	ASSERT(m_nDepth != 0);
+
+	if (--m_nDepth != 0)
+		return;
+
+	if (m_vecUndo.back().m_vecActions.empty())
+	{
+		m_nSize -= m_vecUndo.back().m_nSize;
+		m_vecUndo.pop_back();
+	}
+
+	Evict();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Finish grouping changes and revert them, e.g. after a failure part way
+//! through a step that should be applied in full or not at all. The step is
+//! not kept for redo.
+
+void UndoHistory::RollbackStep()
+{
+	ASSERT(m_nDepth == 1);
+
+	bool bChanged = !m_vecUndo.back().m_vecActions.empty();
+
+	EndStep();
+
+	if (bChanged)
+	{
+		Undo();
+		ClearRedo();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Revert the last step.
+
+void UndoHistory::Undo()
+{
+	Apply(m_vecUndo, m_vecRedo, UNDOING);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Re-apply the last step undone.
+
+void UndoHistory::Redo()
+{
+	Apply(m_vecRedo, m_vecUndo, REDOING);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Discard the history. The steps hold nodes from the document, so this must
+//! be done before the document's arena is destroyed.
+
+void UndoHistory::Clear()
+{
+	ASSERT(m_nDepth == 0);
+
+	Steps().swap(m_vecUndo);
+	Steps().swap(m_vecRedo);
+
+	m_nSize   = 0;
+	m_bTyping = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Handle a change to the DOM by recording how to revert it. A change made
+//! outside a step becomes a step of its own, unless it is a text edit that
+//! carries on from the typing in the last step.
+
+void UndoHistory::OnDomChanged(const DomChange& oChange)
+{
+	Action oAction;
+
+	oAction.m_eType       = oChange.m_eType;
+	oAction.m_pNode       = oChange.m_pNode.ToPtr();
+	oAction.m_nIndex      = oChange.m_nIndex;
+	oAction.m_nOldIndex   = oChange.m_nOldIndex;
+	oAction.m_strName     = oChange.m_strName;
+	oAction.m_bHadValue   = oChange.m_bHadValue;
+	oAction.m_strOldValue = oChange.m_strOldValue;
+	oAction.m_nOffset     = oChange.m_nOffset;
+	oAction.m_nLength     = oChange.m_strNewText.length();
+
+	if (oChange.m_pParent.get() != nullptr)
+		oAction.m_pParent = oChange.m_pParent.ToPtr();
+
+	if (oChange.m_pOldParent.get() != nullptr)
+		oAction.m_pOldParent = oChange.m_pOldParent.ToPtr();
+
+	bool bSingle = ( (m_eMode == RECORDING) && (m_nDepth == 0) );
+	bool bTyping = ( (bSingle) && (oChange.m_eType == DomChange::TEXT_EDITED) );
+
+	if ( (bSingle) && (!bTyping || !ContinuesTyping(oAction)) )
+	{
+		PushStep(m_vecUndo, bTyping ? TYPING_STEP_NAME : DEFAULT_STEP_NAME);
+		ClearRedo();
+	}
+
+	if (bSingle)
+		m_bTyping = bTyping;
+
+	Steps& vecSteps = (m_eMode == UNDOING) ? m_vecRedo : m_vecUndo;
+	Step&  oStep    = vecSteps.back();
+	size_t nSize    = EstimateSize(oAction);
+
+	oStep.m_vecActions.push_back(oAction);
+	oStep.m_nSize += nSize;
+	m_nSize       += nSize;
+
+	if (bSingle)
+		Evict();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Revert the last step on one stack. The changes made in doing so are
+//! published by the editor and recorded as a step on the other stack. A large
+//! step is published as a batch.
+
+void UndoHistory::Apply(Steps& vecFrom, Steps& vecTo, Mode eMode)
+{
+	ASSERT(m_eMode == RECORDING);
+	ASSERT(m_nDepth == 0);
+	ASSERT(!vecFrom.empty());
+
+	Step oStep;
+
+	std::swap(oStep, vecFrom.back());
+	vecFrom.pop_back();
+	m_nSize -= oStep.m_nSize;
+
+	PushStep(vecTo, oStep.m_strName);
+
+	bool bBatch = (oStep.m_vecActions.size() > BATCH_THRESHOLD);
+
+	if (bBatch)
+		m_oEditor.BeginBatch();
+
+	m_eMode = eMode;
+
+	try
+	{
+		typedef Actions::const_reverse_iterator CIter;
+
+		for (CIter it = oStep.m_vecActions.rbegin(); it != oStep.m_vecActions.rend(); ++it)
+			Revert(*it);
+	}
+	catch (...)
+	{
+		m_eMode = RECORDING;
+
+		if (bBatch)
+			m_oEditor.EndBatch();
+
+		throw;
+	}
+
+	m_eMode = RECORDING;
+
+	if (bBatch)
+		m_oEditor.EndBatch();
+
+	Evict();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Revert a single change.
+
+void UndoHistory::Revert(const Action& oAction)
+{
+	switch (oAction.m_eType)
+	{
+		case DomChange::NODE_INSERTED:
+		{
+			m_oEditor.RemoveNode(oAction.m_pNode);
+		}
+		break;
+
+		case DomChange::NODE_REMOVED:
+		{
+			m_oEditor.InsertNode(oAction.m_pOldParent, oAction.m_nOldIndex, oAction.m_pNode);
+		}
+		break;
+
+		case DomChange::NODE_MOVED:
+		{
+			m_oEditor.MoveNode(oAction.m_pNode, oAction.m_pOldParent, oAction.m_nOldIndex);
+		}
+		break;
+
+		case DomChange::CHILDREN_MOVED:
+		{
+			m_oEditor.MoveChildren(oAction.m_pParent, oAction.m_pOldParent);
+		}
+		break;
+
+		case DomChange::ATTRIBUTE_CHANGED:
+		{
+			if (oAction.m_bHadValue)
+				m_oEditor.SetAttribute(oAction.m_pNode, oAction.m_strName, oAction.m_strOldValue);
+			else
+				m_oEditor.RemoveAttribute(oAction.m_pNode, oAction.m_strName);
+		}
+		break;
+
+		case DomChange::TEXT_CHANGED:
+		{
+			m_oEditor.SetText(oAction.m_pNode, oAction.m_strOldValue);
+		}
+		break;
+
+		case DomChange::TEXT_EDITED:
+		{
+			m_oEditor.EditText(oAction.m_pNode, oAction.m_nOffset, oAction.m_nLength, oAction.m_strOldValue);
+		}
+		break;
+
+		default:
+		{
+			ASSERT_FALSE();
+		}
+		break;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Discard the oldest undo steps until the history is under the memory limit.
+//! The newest step is always kept, as is any step still being recorded.
+
+void UndoHistory::Evict()
+{
+	size_t nKeep = (m_nDepth != 0) ? 1 : 0;
+	size_t nDrop = 0;
+
+	while ( (m_nSize > m_nMaxSize) && ((nDrop + nKeep + 1) < m_vecUndo.size()) )
+		m_nSize -= m_vecUndo[nDrop++].m_nSize;
+
+	if (nDrop != 0)
+	{
+		TRACE1(TXT("UndoHistory: Discarding %u oldest steps\n"), nDrop);
+
+		m_vecUndo.erase(m_vecUndo.begin(), m_vecUndo.begin() + nDrop);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Discard the steps that can be redone, as a new edit has been made.
+
+void UndoHistory::ClearRedo()
+{
+	for (Steps::const_iterator it = m_vecRedo.begin(); it != m_vecRedo.end(); ++it)
+		m_nSize -= it->m_nSize;
+
+	m_vecRedo.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add a new empty step to a stack.
+
+void UndoHistory::PushStep(Steps& vecSteps, const tstring& strName)
+{
+	vecSteps.push_back(Step());
+
+	Step& oStep = vecSteps.back();
+
+	oStep.m_strName = strName;
+	oStep.m_nSize   = sizeof(Step);
+
+	m_nSize  += oStep.m_nSize;
+	m_bTyping = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if a text edit carries on from the typing in the last step, i.e. it
+//! is made to the same node where the last edit left the caret.
+
+bool UndoHistory::ContinuesTyping(const Action& oAction) const
+{
+	if (!m_bTyping)
+		return false;
+
+	const Action& oLast = m_vecUndo.back().m_vecActions.back();
+
+	if (oLast.m_pNode.get() != oAction.m_pNode.get())
+		return false;
+
+	size_t nCaret = oLast.m_nOffset + oLast.m_nLength;
+
+	return ( (oAction.m_nOffset == nCaret) || (oAction.m_nOffset + oAction.m_strOldValue.length() == nCaret) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Estimate the memory retained by an action. A removed sub-tree is only kept
+//! alive by the history, so its nodes are counted.
+
+size_t UndoHistory::EstimateSize(const Action& oAction)
+{
+	size_t nSize = sizeof(Action) + ((oAction.m_strName.size() + oAction.m_strOldValue.size()) * sizeof(tchar));
+
+	if (oAction.m_eType == DomChange::NODE_REMOVED)
+	{
+		size_t                    nNodes    = 1;
+		const XML::NodeContainer* pChildren = NodeCursor::Children(NodeRef(oAction.m_pNode));
+
+		if (pChildren != nullptr)
+		{
+			NodeCursor oCursor(*pChildren);
+
+			while (oCursor.Next())
+				++nNodes;
+		}
+
+		nSize += nNodes * BYTES_PER_NODE;
+	}
+
+	return nSize;
+}
@@ -0,0 +1,189 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   UndoHistory.hpp
+//! \brief  The UndoHistory class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_UNDOHISTORY_HPP
+#define APP_UNDOHISTORY_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "IDomListener.hpp"
+
+// Forward declarations.
+class DomEditor;
+
+////////////////////////////////////////////////////////////////////////////////
+//! The undo and redo history of the edits made through a DomEditor. Rather
+//! than copying the document, each step records how to revert its changes.
+//! A removed sub-tree is kept alive by reference, so it is shared with the
+//! document it came from rather than copied. Undoing a step reverts it through
+//! the editor, which records the step for redo in the same way. The oldest
+//! steps are discarded when the memory they retain goes over the limit. Text
+//! edits that carry on from one another are grouped into a single step.
+
+class UndoHistory : public IDomListener, private Core::NotCopyable
+{
+public:
+	//! Constructor.
+	UndoHistory(DomEditor& oEditor, size_t nMaxSize);
+
+	//! Destructor.
+	virtual ~UndoHistory();
+
+	//
+	// Properties.
+	//
+
+	//! Query if there is a step to undo.
+	bool CanUndo() const;
+
+	//! Query if there is a step to redo.
+	bool CanRedo() const;
+
+	//! Get the name of the step that would be undone.
+	const tstring& UndoName() const;
+
+	//! Get the name of the step that would be redone.
+	const tstring& RedoName() const;
+
+	//! Get the estimated memory retained by the history.
+	size_t Size() const;
+
+	//! Set the limit on the memory retained by the history.
+	void SetMaxSize(size_t nMaxSize);
+
+	//
+	// Methods.
+	//
+
+	//! Start grouping the following changes into a single step.
+	void BeginStep(const tstring& strName);
+
+	//! Finish grouping changes.
+	void EndStep();
+
+	//! Finish grouping changes and revert them, e.g. after a failure.
+	void RollbackStep();
+
+	//! Revert the last step.
+	void Undo();
+
+	//! Re-apply the last step undone.
+	void Redo();
+
+	//! Discard the history.
+	void Clear();
+
+	//! Handle a change to the DOM.
+	virtual void OnDomChanged(const DomChange& oChange);
+
+private:
+	////////////////////////////////////////////////////////////////////////////
+	//! A recorded change. The nodes are held so that they outlive any removal.
+
+	struct Action
+	{
+		DomChange::Type	m_eType;		//!< The kind of change.
+		XML::NodePtr	m_pNode;		//!< The node changed.
+		XML::NodePtr	m_pParent;		//!< The container the node is now in.
+		size_t			m_nIndex;		//!< The position in the container.
+		XML::NodePtr	m_pOldParent;	//!< The container the node was in.
+		size_t			m_nOldIndex;	//!< The position in the old container.
+		tstring			m_strName;		//!< The attribute name.
+		bool			m_bHadValue;	//!< Did the attribute exist?
+		tstring			m_strOldValue;	//!< The previous attribute value or text.
+		size_t			m_nOffset;		//!< The position of the text edited.
+		size_t			m_nLength;		//!< The length of the text inserted.
+	};
+
+	//! The collection of actions.
+	typedef std::vector<Action> Actions;
+
+	////////////////////////////////////////////////////////////////////////////
+	//! A group of changes that is undone and redone as one.
+
+	struct Step
+	{
+		tstring		m_strName;		//!< The name shown to the user.
+		Actions		m_vecActions;	//!< The changes in the order made.
+		size_t		m_nSize;		//!< The estimated memory retained.
+	};
+
+	//! The stack of steps.
+	typedef std::vector<Step> Steps;
+
+	//! What the changes being published are part of.
+	enum Mode
+	{
+		RECORDING,	//!< A new edit.
+		UNDOING,	//!< An undo.
+		REDOING,	//!< A redo.
+	};
+
+	//
+	// Members.
+	//
+	DomEditor&	m_oEditor;		//!< The editor making the changes.
+	size_t		m_nMaxSize;		//!< The limit on the retained memory.
+	size_t		m_nSize;		//!< The estimated retained memory.
+	Steps		m_vecUndo;		//!< The steps that can be undone.
+	Steps		m_vecRedo;		//!< The steps that can be redone.
+	Mode		m_eMode;		//!< What the current changes are part of.
+	size_t		m_nDepth;		//!< The nesting of BeginStep() calls.
+	bool		m_bTyping;		//!< Can the last step take more text edits?
+
+	//
+	// Internal methods.
+	//
+
+	//! Revert the last step on one stack, recording it on the other.
+	void Apply(Steps& vecFrom, Steps& vecTo, Mode eMode);
+
+	//! Revert a single change.
+	void Revert(const Action& oAction);
+
+	//! Discard the oldest steps until under the memory limit.
+	void Evict();
+
+	//! Discard the steps that can be redone.
+	void ClearRedo();
+
+	//! Add a new empty step to a stack.
+	void PushStep(Steps& vecSteps, const tstring& strName);
+
+	//! Query if a text edit carries on from the last step's typing.
+	bool ContinuesTyping(const Action& oAction) const;
+
+	//! Estimate the memory retained by an action.
+	static size_t EstimateSize(const Action& oAction);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if there is a step to undo.
+
+inline bool UndoHistory::CanUndo() const
+{
+	return !m_vecUndo.empty();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if there is a step to redo.
+
+inline bool UndoHistory::CanRedo() const
+{
+	return !m_vecRedo.empty();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the estimated memory retained by the history.
+
+inline size_t UndoHistory::Size() const
+{
+	return m_nSize;
+}
+
+#endif // APP_UNDOHISTORY_HPP
@@ -0,0 +1,378 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   ValidationState.cpp
+//! \brief  The ValidationState class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "ValidationState.hpp"
+#include <algorithm>
+
+// Constants.
+static const tchar XMLNS_ATTRIB[] = TXT("xmlns");
+
+// The prefix of a namespace declaration attribute.
+static const tchar XMLNS_PREFIX[] = TXT("xmlns:");
+
+// The reserved prefix that never needs declaring.
+static const tchar XML_PREFIX[] = TXT("xml");
+
+// The predefined ID attribute.
+static const tchar XML_ID_ATTRIB[] = TXT("xml:id");
+
+// The attribute treated as an ID when the DTD does not declare one.
+static const tchar ID_ATTRIB[] = TXT("id");
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the namespace prefix of a name, if it has one.
+
+static tstring Prefix(const tstring& strName)
+{
+	size_t nColon = strName.find(TXT(':'));
+
+	return (nColon != tstring::npos) ? strName.substr(0, nColon) : TXT("");
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Split a list of references separated by whitespace.
+
+static void SplitRefs(const tstring& strValue, std::vector<tstring>& vecRefs)
+{
+	size_t nStart = 0;
+
+	while ((nStart = strValue.find_first_not_of(TXT(" \t\r\n"), nStart)) != tstring::npos)
+	{
+		size_t nEnd = strValue.find_first_of(TXT(" \t\r\n"), nStart);
+
+		if (nEnd == tstring::npos)
+			nEnd = strValue.length();
+
+		vecRefs.push_back(strValue.substr(nStart, nEnd - nStart));
+		nStart = nEnd;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Remove an element from the list of those that use a value.
+
+static void RemoveKey(std::map< tstring, std::vector<const XML::Node*> >& mapIndex, const tstring& strValue, const XML::Node* pNode)
+{
+	std::map< tstring, std::vector<const XML::Node*> >::iterator itValue = mapIndex.find(strValue);
+
+	if (itValue == mapIndex.end())
+		return;
+
+	std::vector<const XML::Node*>& vecKeys = itValue->second;
+
+	vecKeys.erase(std::find(vecKeys.begin(), vecKeys.end(), pNode));
+
+	if (vecKeys.empty())
+		mapIndex.erase(itValue);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add a problem to a collection.
+
+static void AddProblem(std::vector<ValidationProblem>& vecProblems, const XML::Node* pNode, ValidationProblem::Type eType, const tstring& strMessage)
+{
+	ValidationProblem oProblem;
+
+	oProblem.m_pNode      = pNode;
+	oProblem.m_eType      = eType;
+	oProblem.m_strMessage = strMessage;
+
+	vecProblems.push_back(oProblem);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Default constructor.
+
+ValidationState::ValidationState()
+{
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Discard all the elements and validate against a new DTD.
+
+void ValidationState::Reset(const DtdModel& oDtd)
+{
+	m_oDtd = oDtd;
+	m_mapEntries.clear();
+	m_mapIds.clear();
+	m_setRoots.clear();
+	m_setChanged.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add or replace an element. It is checked by the next call to Check().
+
+void ValidationState::Update(const ElementFacts& oFacts)
+{
+	Entries::iterator itEntry = m_mapEntries.find(oFacts.m_pNode);
+
+	if (itEntry != m_mapEntries.end())
+	{
+		Unindex(itEntry->second);
+	}
+	else
+	{
+		itEntry = m_mapEntries.insert(Entries::value_type(oFacts.m_pNode, Entry())).first;
+	}
+
+	Entry& oEntry = itEntry->second;
+
+	oEntry.m_oFacts = oFacts;
+	oEntry.m_vecProblems.clear();
+
+	Index(oEntry);
+
+	if (oFacts.m_pParent == nullptr)
+		m_setRoots.insert(oFacts.m_pNode);
+
+	m_setChanged.insert(oFacts.m_pNode);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Remove an element. Its descendants are removed separately.
+
+void ValidationState::Remove(const XML::Node* pNode)
+{
+	Entries::iterator itEntry = m_mapEntries.find(pNode);
+
+	if (itEntry == m_mapEntries.end())
+		return;
+
+	Unindex(itEntry->second);
+
+	m_setRoots.erase(pNode);
+	m_setChanged.erase(pNode);
+	m_mapEntries.erase(itEntry);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Check the elements that have changed since the last check. The problems
+//! with IDs depend on the other elements as well and are found as the problems
+//! are collected. The stop flag is polled between the elements; if it is set
+//! the check is abandoned, leaving the elements not yet checked as changed,
+//! and false is returned.
+
+bool ValidationState::Check(const volatile LONG& bStop)
+{
+	while (!m_setChanged.empty())
+	{
+		if (bStop != FALSE)
+			return false;
+
+		KeySet::iterator  it      = m_setChanged.begin();
+		Entries::iterator itEntry = m_mapEntries.find(*it);
+
+		if (itEntry != m_mapEntries.end())
+			CheckElement(itEntry->second);
+
+		m_setChanged.erase(it);
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get all the problems in document order. The elements are walked from the
+//! roots using an explicit stack, so any depth of nesting can be handled. A
+//! child is only visited from the parent it was last updated with, so a list
+//! of children that is out of date cannot visit an element twice.
+
+void ValidationState::GetProblems(Problems& vecProblems) const
+{
+	typedef std::pair<const XML::Node*, const XML::Node*> Visit;
+	typedef std::vector<Visit> Visits;
+
+	vecProblems.clear();
+
+	Visits vecStack;
+
+	for (KeySet::const_reverse_iterator it = m_setRoots.rbegin(); it != m_setRoots.rend(); ++it)
+		vecStack.push_back(Visit(*it, nullptr));
+
+	while (!vecStack.empty())
+	{
+		Visit                   oVisit  = vecStack.back();
+		Entries::const_iterator itEntry = m_mapEntries.find(oVisit.first);
+
+		vecStack.pop_back();
+
+		if ( (itEntry == m_mapEntries.end()) || (itEntry->second.m_oFacts.m_pParent != oVisit.second) )
+			continue;
+
+		const Entry& oEntry = itEntry->second;
+
+		vecProblems.insert(vecProblems.end(), oEntry.m_vecProblems.begin(), oEntry.m_vecProblems.end());
+
+		GetIdProblems(oEntry, vecProblems);
+
+		const ElementFacts::Children& vecChildren = oEntry.m_oFacts.m_vecChildren;
+
+		for (ElementFacts::Children::const_reverse_iterator it = vecChildren.rbegin(); it != vecChildren.rend(); ++it)
+			vecStack.push_back(Visit(*it, oVisit.first));
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Remove an element's IDs from the index.
+
+void ValidationState::Unindex(const Entry& oEntry)
+{
+	const XML::Node* pNode = oEntry.m_oFacts.m_pNode;
+
+	for (Values::const_iterator it = oEntry.m_vecIds.begin(); it != oEntry.m_vecIds.end(); ++it)
+		RemoveKey(m_mapIds, *it, pNode);
+
+	if (oEntry.m_oFacts.m_pParent == nullptr)
+		m_setRoots.erase(pNode);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Find the IDs and references in an element and index the IDs. The attributes
+//! declared by the DTD are used, along with xml:id, and an attribute named
+//! "id" is taken to be an ID unless the DTD declares another one.
+
+void ValidationState::Index(Entry& oEntry)
+{
+	const ElementFacts& oFacts  = oEntry.m_oFacts;
+	bool                bDtdIds = m_oDtd.HasIdAttribute(oFacts.m_strName);
+
+	oEntry.m_vecIds.clear();
+	oEntry.m_vecRefs.clear();
+
+	for (ElementFacts::Attributes::const_iterator it = oFacts.m_vecAttribs.begin(); it != oFacts.m_vecAttribs.end(); ++it)
+	{
+		const tstring&       strName = it->first;
+		DtdModel::AttribType eType   = m_oDtd.AttributeType(oFacts.m_strName, strName);
+
+		if ( (eType == DtdModel::ID_ATTRIB) || (strName == XML_ID_ATTRIB) || ((strName == ID_ATTRIB) && (!bDtdIds)) )
+			oEntry.m_vecIds.push_back(it->second);
+		else if (eType == DtdModel::IDREF_ATTRIB)
+			oEntry.m_vecRefs.push_back(it->second);
+		else if (eType == DtdModel::IDREFS_ATTRIB)
+			SplitRefs(it->second, oEntry.m_vecRefs);
+	}
+
+	for (Values::const_iterator it = oEntry.m_vecIds.begin(); it != oEntry.m_vecIds.end(); ++it)
+		m_mapIds[*it].push_back(oFacts.m_pNode);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Check an element on its own: its namespace prefixes and, if there is a DTD,
+//! its content.
+
+void ValidationState::CheckElement(Entry& oEntry) const
+{
+	const ElementFacts& oFacts      = oEntry.m_oFacts;
+	Problems&           vecProblems = oEntry.m_vecProblems;
+	tstring             strPrefix   = Prefix(oFacts.m_strName);
+
+	vecProblems.clear();
+
+	if ( (!strPrefix.empty()) && (!IsPrefixDeclared(oEntry, strPrefix)) )
+	{
+		AddProblem(vecProblems, oFacts.m_pNode, ValidationProblem::UNDECLARED_PREFIX,
+					Core::fmt(TXT("The prefix '%s' of element '%s' is not declared"), strPrefix.c_str(), oFacts.m_strName.c_str()));
+	}
+
+	for (ElementFacts::Attributes::const_iterator it = oFacts.m_vecAttribs.begin(); it != oFacts.m_vecAttribs.end(); ++it)
+	{
+		const tstring& strName = it->first;
+
+		strPrefix = Prefix(strName);
+
+		if (strPrefix == XMLNS_ATTRIB)
+		{
+			if (it->second.empty())
+			{
+				AddProblem(vecProblems, oFacts.m_pNode, ValidationProblem::EMPTY_NAMESPACE,
+							Core::fmt(TXT("The prefix '%s' is declared with an empty namespace"), strName.c_str() + tstrlen(XMLNS_PREFIX)));
+			}
+		}
+		else if ( (!strPrefix.empty()) && (!IsPrefixDeclared(oEntry, strPrefix)) )
+		{
+			AddProblem(vecProblems, oFacts.m_pNode, ValidationProblem::UNDECLARED_PREFIX,
+						Core::fmt(TXT("The prefix '%s' of attribute '%s' is not declared"), strPrefix.c_str(), strName.c_str()));
+		}
+	}
+
+	if ( (oFacts.m_pParent == nullptr) && (!m_oDtd.RootName().empty()) && (oFacts.m_strName != m_oDtd.RootName()) )
+	{
+		AddProblem(vecProblems, oFacts.m_pNode, ValidationProblem::WRONG_ROOT,
+					Core::fmt(TXT("The root element '%s' does not match the DOCTYPE '%s'"), oFacts.m_strName.c_str(), m_oDtd.RootName().c_str()));
+	}
+
+	if (!m_oDtd.HasElements())
+		return;
+
+	if (!m_oDtd.IsDeclared(oFacts.m_strName))
+	{
+		AddProblem(vecProblems, oFacts.m_pNode, ValidationProblem::UNDECLARED_ELEMENT,
+					Core::fmt(TXT("The element '%s' is not declared"), oFacts.m_strName.c_str()));
+	}
+	else if (!m_oDtd.MatchesContent(oFacts.m_strName, oFacts.m_vecChildNames, oFacts.m_bHasText))
+	{
+		AddProblem(vecProblems, oFacts.m_pNode, ValidationProblem::INVALID_CONTENT,
+					Core::fmt(TXT("The content of '%s' does not match %s"), oFacts.m_strName.c_str(), m_oDtd.ContentModel(oFacts.m_strName).c_str()));
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if a namespace prefix is declared by an element or its ancestors.
+
+bool ValidationState::IsPrefixDeclared(const Entry& oEntry, const tstring& strPrefix) const
+{
+	if ( (strPrefix == XML_PREFIX) || (strPrefix == XMLNS_ATTRIB) )
+		return true;
+
+	tstring      strDecl = XMLNS_PREFIX + strPrefix;
+	const Entry* pEntry  = &oEntry;
+
+	for (;;)
+	{
+		const ElementFacts::Attributes& vecAttribs = pEntry->m_oFacts.m_vecAttribs;
+
+		for (ElementFacts::Attributes::const_iterator it = vecAttribs.begin(); it != vecAttribs.end(); ++it)
+		{
+			if (it->first == strDecl)
+				return true;
+		}
+
+		Entries::const_iterator itParent = m_mapEntries.find(pEntry->m_oFacts.m_pParent);
+
+		if (itParent == m_mapEntries.end())
+			return false;
+
+		pEntry = &itParent->second;
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Add the problems with an element's IDs and references.
+
+void ValidationState::GetIdProblems(const Entry& oEntry, Problems& vecProblems) const
+{
+	const XML::Node* pNode = oEntry.m_oFacts.m_pNode;
+
+	for (Values::const_iterator it = oEntry.m_vecIds.begin(); it != oEntry.m_vecIds.end(); ++it)
+	{
+		ValueIndex::const_iterator itId = m_mapIds.find(*it);
+
+		if ( (itId != m_mapIds.end()) && (itId->second.size() > 1) )
+		{
+			AddProblem(vecProblems, pNode, ValidationProblem::DUPLICATE_ID,
+						Core::fmt(TXT("The ID '%s' is used by %u elements"), it->c_str(), itId->second.size()));
+		}
+	}
+
+	for (Values::const_iterator it = oEntry.m_vecRefs.begin(); it != oEntry.m_vecRefs.end(); ++it)
+	{
+		if (m_mapIds.find(*it) == m_mapIds.end())
+		{
+			AddProblem(vecProblems, pNode, ValidationProblem::DANGLING_IDREF,
+						Core::fmt(TXT("The ID '%s' referred to by '%s' does not exist"), it->c_str(), oEntry.m_oFacts.m_strName.c_str()));
+		}
+	}
+}
@@ -0,0 +1,167 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   ValidationState.hpp
+//! \brief  The ValidationState class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_VALIDATIONSTATE_HPP
+#define APP_VALIDATIONSTATE_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <XML/Node.hpp>
+#include "DtdModel.hpp"
+#include <map>
+#include <set>
+
+////////////////////////////////////////////////////////////////////////////////
+//! A problem found by validating a document.
+
+struct ValidationProblem
+{
+	//! The kinds of problem.
+	enum Type
+	{
+		DUPLICATE_ID,			//!< An ID is used by more than one element.
+		DANGLING_IDREF,			//!< A reference to an ID that is not used.
+		UNDECLARED_PREFIX,		//!< A namespace prefix that is not declared.
+		EMPTY_NAMESPACE,		//!< A namespace prefix declared with no URI.
+		UNDECLARED_ELEMENT,		//!< An element that the DTD does not declare.
+		INVALID_CONTENT,		//!< Content that does not match the DTD.
+		WRONG_ROOT,				//!< A root element that the DOCTYPE does not name.
+	};
+
+	const XML::Node*	m_pNode;		//!< The element, only used as a key.
+	Type				m_eType;		//!< The kind of problem.
+	tstring				m_strMessage;	//!< The description.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! The facts about an element that validation needs, copied out of the DOM so
+//! that it can be validated on another thread. The nodes are only used as keys
+//! and are never dereferenced.
+
+struct ElementFacts
+{
+	//! An attribute name and value.
+	typedef std::pair<tstring, tstring> Attribute;
+	//! The attributes in document order.
+	typedef std::vector<Attribute> Attributes;
+	//! The child elements in document order.
+	typedef std::vector<const XML::Node*> Children;
+
+	const XML::Node*	m_pNode;			//!< The element.
+	const XML::Node*	m_pParent;			//!< The parent element, if any.
+	tstring				m_strName;			//!< The element name.
+	Attributes			m_vecAttribs;		//!< The attributes.
+	Children			m_vecChildren;		//!< The child elements.
+	DtdModel::Names		m_vecChildNames;	//!< The names of the child elements.
+	bool				m_bHasText;			//!< Is there text that is not whitespace?
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! A mirror of a document's elements, built from the facts copied out of it,
+//! and the problems found in them. The elements are updated and removed as
+//! the document is edited and only those that changed are checked again. The
+//! IDs are indexed by value, so a duplicate or a dangling reference is found
+//! without a search.
+
+class ValidationState
+{
+public:
+	//! The collection of problems.
+	typedef std::vector<ValidationProblem> Problems;
+
+	//! Default constructor.
+	ValidationState();
+
+	//
+	// Properties.
+	//
+
+	//! Get the number of elements.
+	size_t ElementCount() const;
+
+	//
+	// Methods.
+	//
+
+	//! Discard all the elements and validate against a new DTD.
+	void Reset(const DtdModel& oDtd);
+
+	//! Add or replace an element.
+	void Update(const ElementFacts& oFacts);
+
+	//! Remove an element.
+	void Remove(const XML::Node* pNode);
+
+	//! Check the elements that have changed since the last check.
+	bool Check(const volatile LONG& bStop);
+
+	//! Get all the problems in document order.
+	void GetProblems(Problems& vecProblems) const;
+
+private:
+	//! A collection of attribute values.
+	typedef std::vector<tstring> Values;
+	//! A collection of elements.
+	typedef std::vector<const XML::Node*> Keys;
+
+	////////////////////////////////////////////////////////////////////////////
+	//! The state of an element.
+
+	struct Entry
+	{
+		ElementFacts	m_oFacts;		//!< The element.
+		Values			m_vecIds;		//!< The IDs it has.
+		Values			m_vecRefs;		//!< The IDs it refers to.
+		Problems		m_vecProblems;	//!< The problems found by the last check.
+	};
+
+	//! The map of element to its state.
+	typedef std::map<const XML::Node*, Entry> Entries;
+	//! The map of ID to the elements that use it.
+	typedef std::map<tstring, Keys> ValueIndex;
+	//! A set of elements.
+	typedef std::set<const XML::Node*> KeySet;
+
+	//
+	// Members.
+	//
+	DtdModel		m_oDtd;			//!< The DTD, if any.
+	Entries			m_mapEntries;	//!< The elements.
+	ValueIndex		m_mapIds;		//!< The elements by ID.
+	KeySet			m_setRoots;		//!< The elements with no parent element.
+	KeySet			m_setChanged;	//!< The elements not checked since they changed.
+
+	//
+	// Internal methods.
+	//
+
+	//! Remove an element's IDs from the index.
+	void Unindex(const Entry& oEntry);
+
+	//! Find the IDs and references in an element and index the IDs.
+	void Index(Entry& oEntry);
+
+	//! Check an element on its own.
+	void CheckElement(Entry& oEntry) const;
+
+	//! Query if a namespace prefix is declared by an element or its ancestors.
+	bool IsPrefixDeclared(const Entry& oEntry, const tstring& strPrefix) const;
+
+	//! Add the problems with an element's IDs and references.
+	void GetIdProblems(const Entry& oEntry, Problems& vecProblems) const;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the number of elements.
+
+inline size_t ValidationState::ElementCount() const
+{
+	return m_mapEntries.size();
+}
+
+#endif // APP_VALIDATIONSTATE_HPP
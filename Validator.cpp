@@ -0,0 +1,626 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   Validator.cpp
+//! \brief  The Validator class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "Validator.hpp"
+#include <XML/ElementNode.hpp>
+#include <XML/DocTypeNode.hpp>
+#include <process.h>
+#include "DomEditor.hpp"
+
+// Constants.
+static const size_t TEXT_CHUNK_SIZE = 4096;
+
+// The characters that are whitespace in a document.
+static const tchar WHITESPACE[] = TXT(" \t\r\n");
+
+// The prefix of a namespace declaration attribute.
+static const tchar XMLNS_ATTRIB[] = TXT("xmlns");
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if an attribute declares a namespace.
+
+static bool IsNamespaceDecl(const tstring& strName)
+{
+	size_t nLength = tstrlen(XMLNS_ATTRIB);
+
+	return ( (strName.compare(0, nLength, XMLNS_ATTRIB) == 0)
+		  && ((strName.length() == nLength) || (strName[nLength] == TXT(':'))) );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Constructor.
+
+Validator::Validator(DomEditor& oEditor)
+	: m_oEditor(oEditor)
+	, m_bInBatch(false)
+	, m_bBatchChanged(false)
+	, m_bIncomplete(false)
+	, m_hThread(NULL)
+	, m_hWakeEvent(NULL)
+	, m_bStop(FALSE)
+	, m_bPublished(false)
+{
+	::InitializeCriticalSection(&m_oLock);
+
+	m_oEditor.AddListener(this);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Destructor.
+
+Validator::~Validator()
+{
+	m_oEditor.RemoveListener(this);
+
+	Stop();
+
+	::DeleteCriticalSection(&m_oLock);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Start validating a document. The whole document is validated first.
+
+void Validator::Start(const XML::DocumentPtr& pDOM)
+{
+	ASSERT(!IsRunning());
+
+	m_pDOM       = pDOM;
+	m_bStop      = FALSE;
+	m_hWakeEvent = ::CreateEvent(NULL, FALSE, FALSE, NULL);
+
+	if (m_hWakeEvent != NULL)
+		m_hThread = reinterpret_cast<HANDLE>(_beginthreadex(NULL, 0, ThreadProc, this, 0, NULL));
+
+	if (m_hThread == NULL)
+	{
+		TRACE(TXT("The validation thread could not be started\n"));
+		Stop();
+		return;
+	}
+
+	Rescan();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Stop validating the document. Any work not yet done is discarded. The
+//! validation thread polls the flag while it works, so the wait is short even
+//! when it is part way through a large job.
+
+void Validator::Stop()
+{
+	if (m_hThread != NULL)
+	{
+		::InterlockedExchange(&m_bStop, TRUE);
+		::SetEvent(m_hWakeEvent);
+		::WaitForSingleObject(m_hThread, INFINITE);
+		::CloseHandle(m_hThread);
+
+		m_hThread = NULL;
+	}
+
+	if (m_hWakeEvent != NULL)
+	{
+		::CloseHandle(m_hWakeEvent);
+		m_hWakeEvent = NULL;
+	}
+
+	m_vecDirty.clear();
+	m_pCursor.reset();
+	m_pCursorRoot.reset();
+	m_lstJob.clear();
+	m_lstQueue.clear();
+	m_vecProblems.clear();
+	m_pDOM.reset();
+
+	m_bIncomplete = false;
+	m_bPublished  = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Validate the whole document again. Any work not yet queued is discarded
+//! and the queued work is dropped when the new job is queued.
+
+void Validator::Rescan()
+{
+	if (!IsRunning())
+		return;
+
+	m_vecDirty.clear();
+	m_pCursor.reset();
+	m_pCursorRoot.reset();
+	m_lstJob.clear();
+
+	Job& oJob = CurrentJob();
+
+	oJob.m_bReset = true;
+	ParseDtd(m_pDOM, oJob.m_oDtd);
+
+	MarkDirty(NodeRef(m_pDOM.get()), true);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Copy out the facts about the dirty elements for a period of time, in ms.
+//! What has been copied is queued at the end of each slice so that the
+//! validation thread can work on it in the meantime.
+
+void Validator::Step(DWORD dwSlice)
+{
+	if ( (!IsRunning()) || (m_bInBatch) )
+		return;
+
+	DWORD dwStart = ::GetTickCount();
+
+	while (::GetTickCount() - dwStart < dwSlice)
+	{
+		// Continue copying a sub-tree?
+		if (m_pCursor.get() != nullptr)
+		{
+			if (m_pCursor->Next())
+			{
+				if (m_pCursor->Node()->type() == XML::ELEMENT_NODE)
+					CopyFacts(m_pCursor->Node());
+			}
+			else
+			{
+				m_pCursor.reset();
+				m_pCursorRoot.reset();
+			}
+
+			continue;
+		}
+
+		if (m_vecDirty.empty())
+			break;
+
+		Dirty oDirty = m_vecDirty.back();
+
+		m_vecDirty.pop_back();
+
+		if (!IsAttached(oDirty.m_pNode))
+			continue;
+
+		if (oDirty.m_pNode->type() == XML::ELEMENT_NODE)
+			CopyFacts(oDirty.m_pNode);
+
+		if (oDirty.m_bSubtree)
+		{
+			m_pCursorRoot = oDirty.m_pNode;
+			m_pCursor.reset(new NodeCursor(DomEditor::Container(m_pCursorRoot)));
+		}
+	}
+
+	bool bComplete = ( (m_pCursor.get() == nullptr) && (m_vecDirty.empty()) );
+
+	if ( (!m_lstJob.empty()) || ((bComplete) && (m_bIncomplete)) )
+	{
+		CurrentJob();
+		QueueJob(bComplete);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Take the problems found since the last call, if any. Returns false if no
+//! problems have been published since then.
+
+bool Validator::TakeProblems(Problems& vecProblems)
+{
+	Problems vecTaken;
+
+	::EnterCriticalSection(&m_oLock);
+
+	bool bPublished = m_bPublished;
+
+	if (bPublished)
+		vecTaken.swap(m_vecProblems);
+
+	m_bPublished = false;
+
+	::LeaveCriticalSection(&m_oLock);
+
+	if (bPublished)
+		vecProblems.swap(vecTaken);
+
+	return bPublished;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Mark the nodes added to the document by a read, and their parents, as
+//! dirty.
+
+void Validator::OnNodesAdded(const IncrementalReader::AddedNodes& vecAdded)
+{
+	if (!IsRunning())
+		return;
+
+	ResetCursor();
+
+	for (IncrementalReader::AddedNodes::const_iterator it = vecAdded.begin(); it != vecAdded.end(); ++it)
+	{
+		MarkDirty(NodeRef(it->first), false);
+		MarkDirty(it->second, true);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Handle a change to the DOM by marking the affected elements as dirty. The
+//! elements in a removed sub-tree are queued for removal straight away, as
+//! the sub-tree may be changed or destroyed later.
+
+void Validator::OnDomChanged(const DomChange& oChange)
+{
+	if (!IsRunning())
+		return;
+
+	if (m_bInBatch)
+	{
+		m_bBatchChanged = true;
+		return;
+	}
+
+	if (oChange.m_eType == DomChange::NODE_INSERTED)
+	{
+		ResetCursor();
+		MarkDirty(oChange.m_pNode, true);
+		MarkDirty(oChange.m_pParent, false);
+	}
+	else if (oChange.m_eType == DomChange::NODE_REMOVED)
+	{
+		ResetCursor();
+
+		if (oChange.m_pNode->type() == XML::ELEMENT_NODE)
+		{
+			// Keep the removals after the updates copied before them.
+			if ( (!m_lstJob.empty()) && (!m_lstJob.back().m_vecUpdated.empty()) )
+				QueueJob(false);
+
+			Keys& vecRemoved = CurrentJob().m_vecRemoved;
+
+			vecRemoved.push_back(oChange.m_pNode.get());
+
+			for (NodeCursor oCursor(DomEditor::Container(oChange.m_pNode)); oCursor.Next(); )
+			{
+				if (oCursor.Node()->type() == XML::ELEMENT_NODE)
+					vecRemoved.push_back(oCursor.Node().get());
+			}
+		}
+
+		MarkDirty(oChange.m_pOldParent, false);
+	}
+	else if (oChange.m_eType == DomChange::NODE_MOVED)
+	{
+		ResetCursor();
+		MarkDirty(oChange.m_pNode, true);
+		MarkDirty(oChange.m_pOldParent, false);
+		MarkDirty(oChange.m_pParent, false);
+	}
+	else if (oChange.m_eType == DomChange::CHILDREN_MOVED)
+	{
+		ResetCursor();
+		MarkDirty(oChange.m_pOldParent, false);
+		MarkDirty(oChange.m_pParent, true);
+	}
+	else if (oChange.m_eType == DomChange::ATTRIBUTE_CHANGED)
+	{
+		// A namespace declaration affects the whole sub-tree.
+		MarkDirty(oChange.m_pNode, IsNamespaceDecl(oChange.m_strName));
+	}
+	else if ( (oChange.m_eType == DomChange::TEXT_CHANGED) || (oChange.m_eType == DomChange::TEXT_EDITED) )
+	{
+		if (oChange.m_pNode->hasParent())
+			MarkDirty(oChange.m_pNode->parent(), false);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Handle the start of a batch of changes.
+
+void Validator::OnBatchStarted()
+{
+	m_bInBatch      = true;
+	m_bBatchChanged = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Handle the end of a batch of changes by validating the whole document
+//! again, if required.
+
+void Validator::OnBatchFinished()
+{
+	m_bInBatch = false;
+
+	if (m_bBatchChanged)
+		Rescan();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Mark a node, and optionally its sub-tree, as dirty. Only elements and the
+//! document itself are of interest. A node that was marked last is not marked
+//! again, as typing into a text node marks its parent for every keystroke.
+
+void Validator::MarkDirty(NodeRef pNode, bool bSubtree)
+{
+	if (pNode.get() == nullptr)
+		return;
+
+	XML::NodeType eType = pNode->type();
+
+	if ( (eType != XML::ELEMENT_NODE) && (eType != XML::DOCUMENT_NODE) )
+		return;
+
+	if ( (!m_vecDirty.empty()) && (m_vecDirty.back().m_pNode.get() == pNode.get())
+	  && ((m_vecDirty.back().m_bSubtree) || (!bSubtree)) )
+		return;
+
+	Dirty oDirty;
+
+	oDirty.m_pNode    = pNode.ToPtr();
+	oDirty.m_bSubtree = bSubtree;
+
+	m_vecDirty.push_back(oDirty);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Abandon copying the current sub-tree, as the DOM structure has changed. It
+//! is marked as dirty again so that it is copied from the start.
+
+void Validator::ResetCursor()
+{
+	if (m_pCursor.get() == nullptr)
+		return;
+
+	MarkDirty(m_pCursorRoot, true);
+
+	m_pCursor.reset();
+	m_pCursorRoot.reset();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the job being filled, creating it if required.
+
+Validator::Job& Validator::CurrentJob()
+{
+	if (m_lstJob.empty())
+	{
+		m_lstJob.push_back(Job());
+
+		m_lstJob.back().m_bReset    = false;
+		m_lstJob.back().m_bComplete = false;
+	}
+
+	return m_lstJob.back();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Queue the job being filled for the validation thread. A job that resets the
+//! mirror makes any jobs still queued redundant, so they are discarded, but
+//! only after the lock has been released.
+
+void Validator::QueueJob(bool bComplete)
+{
+	ASSERT(!m_lstJob.empty());
+
+	Jobs lstDiscarded;
+
+	m_lstJob.back().m_bComplete = bComplete;
+
+	::EnterCriticalSection(&m_oLock);
+
+	if (m_lstJob.back().m_bReset)
+		lstDiscarded.swap(m_lstQueue);
+
+	m_lstQueue.splice(m_lstQueue.end(), m_lstJob);
+
+	::LeaveCriticalSection(&m_oLock);
+
+	::SetEvent(m_hWakeEvent);
+
+	m_bIncomplete = !bComplete;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Copy the facts about an element into the current job.
+
+void Validator::CopyFacts(NodeRef pElement)
+{
+	const XML::ElementNode* pNode = pElement.As<XML::ElementNode>();
+	FactsList&              vecUpdated = CurrentJob().m_vecUpdated;
+
+	vecUpdated.push_back(ElementFacts());
+
+	ElementFacts& oFacts = vecUpdated.back();
+
+	oFacts.m_pNode    = pElement.get();
+	oFacts.m_pParent  = nullptr;
+	oFacts.m_strName  = pNode->name();
+	oFacts.m_bHasText = false;
+
+	if (pElement->hasParent())
+	{
+		NodeRef pParent = pElement->parent();
+
+		if (pParent->type() == XML::ELEMENT_NODE)
+			oFacts.m_pParent = pParent.get();
+	}
+
+	const XML::Attributes& vAttribs = pNode->getAttributes();
+
+	for (XML::Attributes::const_iterator it = vAttribs.begin(); it != vAttribs.end(); ++it)
+		oFacts.m_vecAttribs.push_back(ElementFacts::Attribute((*it)->name(), (*it)->value()));
+
+	const XML::NodeContainer& oChildren = DomEditor::Container(pElement);
+
+	for (XML::NodeContainer::const_iterator it = oChildren.beginChild(); it != oChildren.endChild(); ++it)
+	{
+		NodeRef       pChild = *it;
+		XML::NodeType eType  = pChild->type();
+
+		if (eType == XML::ELEMENT_NODE)
+		{
+			oFacts.m_vecChildren.push_back(pChild.get());
+			oFacts.m_vecChildNames.push_back(pChild.As<XML::ElementNode>()->name());
+		}
+		else if ( ((eType == XML::TEXT_NODE) || (eType == XML::CDATA_NODE)) && (!oFacts.m_bHasText) )
+		{
+			oFacts.m_bHasText = HasText(pChild);
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if a text or CDATA node has text that is not whitespace. The text is
+//! read a chunk at a time, as it may be held in a rope that is being edited.
+
+bool Validator::HasText(NodeRef pNode) const
+{
+	size_t nLength = m_oEditor.TextLength(pNode);
+
+	for (size_t nOffset = 0; nOffset < nLength; nOffset += TEXT_CHUNK_SIZE)
+	{
+		tstring strChunk = m_oEditor.Text(pNode, nOffset, std::min(TEXT_CHUNK_SIZE, nLength - nOffset));
+
+		if (strChunk.find_first_not_of(WHITESPACE) != tstring::npos)
+			return true;
+	}
+
+	return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Apply the queued jobs and publish the problems until asked to stop. The
+//! mirror belongs to this thread alone. The changed elements are checked after
+//! every job, but the problems are only collected and published once the
+//! mirror is consistent with the document again. The stop flag is polled
+//! throughout, as a job for a large document can take some time.
+
+void Validator::ValidateQueue()
+{
+	ValidationState oState;
+	Jobs            lstJobs;
+
+	for (;;)
+	{
+		::WaitForSingleObject(m_hWakeEvent, INFINITE);
+
+		::EnterCriticalSection(&m_oLock);
+		lstJobs.splice(lstJobs.end(), m_lstQueue);
+		::LeaveCriticalSection(&m_oLock);
+
+		if (IsStopping())
+			break;
+
+		if (lstJobs.empty())
+			continue;
+
+		DWORD dwStart   = ::GetTickCount();
+		bool  bComplete = false;
+
+		for (Jobs::const_iterator itJob = lstJobs.begin(); itJob != lstJobs.end(); ++itJob)
+		{
+			if (!ApplyJob(*itJob, oState))
+				return;
+
+			bComplete = itJob->m_bComplete;
+		}
+
+		lstJobs.clear();
+
+		if (!oState.Check(m_bStop))
+			return;
+
+		if (!bComplete)
+			continue;
+
+		Problems vecProblems;
+
+		oState.GetProblems(vecProblems);
+
+		TRACE3(TXT("Validated %u elements, found %u problems in %u ms\n"), oState.ElementCount(), vecProblems.size(), ::GetTickCount() - dwStart);
+
+		::EnterCriticalSection(&m_oLock);
+		m_vecProblems.swap(vecProblems);
+		m_bPublished = true;
+		::LeaveCriticalSection(&m_oLock);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Apply a job to the mirror. The stop flag is polled between the elements and
+//! false is returned if it is set, as the mirror is then of no further use.
+
+bool Validator::ApplyJob(const Job& oJob, ValidationState& oState) const
+{
+	if (oJob.m_bReset)
+		oState.Reset(oJob.m_oDtd);
+
+	for (Keys::const_iterator it = oJob.m_vecRemoved.begin(); it != oJob.m_vecRemoved.end(); ++it)
+	{
+		if (IsStopping())
+			return false;
+
+		oState.Remove(*it);
+	}
+
+	for (FactsList::const_iterator it = oJob.m_vecUpdated.begin(); it != oJob.m_vecUpdated.end(); ++it)
+	{
+		if (IsStopping())
+			return false;
+
+		oState.Update(*it);
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if a node is still part of the document, i.e. it has not been removed
+//! since it was marked as dirty.
+
+bool Validator::IsAttached(NodeRef pNode)
+{
+	const XML::Node* pAncestor = pNode.get();
+
+	while (pAncestor->type() != XML::DOCUMENT_NODE)
+	{
+		if (!pAncestor->hasParent())
+			return false;
+
+		pAncestor = pAncestor->parent().get();
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse the DTD in a document's DOCTYPE, if it has one.
+
+void Validator::ParseDtd(const XML::DocumentPtr& pDOM, DtdModel& oDtd)
+{
+	oDtd.Clear();
+
+	for (XML::NodeContainer::const_iterator it = pDOM->beginChild(); it != pDOM->endChild(); ++it)
+	{
+		if ((*it)->type() == XML::DOCTYPE_NODE)
+		{
+			oDtd.Parse(NodeRef(*it).As<XML::DocTypeNode>()->declaration());
+			break;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! The validation thread function. The thread runs in background mode so that
+//! it takes second place to the UI.
+
+unsigned __stdcall Validator::ThreadProc(void* pParam)
+{
+	Validator* pValidator = static_cast<Validator*>(pParam);
+
+	::SetThreadPriority(::GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+
+	pValidator->ValidateQueue();
+
+	return 0;
+}
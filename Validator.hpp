@@ -0,0 +1,197 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   Validator.hpp
+//! \brief  The Validator class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_VALIDATOR_HPP
+#define APP_VALIDATOR_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include <XML/Document.hpp>
+#include <Core/UniquePtr.hpp>
+#include "IDomListener.hpp"
+#include "IncrementalReader.hpp"
+#include "ValidationState.hpp"
+#include "NodeCursor.hpp"
+#include <list>
+
+// Forward declarations.
+class DomEditor;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Validates a document in the background as it is edited. The elements that
+//! each edit affects are marked as dirty and the facts about them are copied
+//! out of the DOM on the UI thread, a time slice at a time, as the nodes must
+//! not be touched by another thread. The copies are queued for a background
+//! thread which keeps a mirror of the document in a ValidationState, checks
+//! the elements that changed and publishes the problems found. A batch of
+//! edits causes the whole document to be validated again.
+
+class Validator : public IDomListener, private Core::NotCopyable
+{
+public:
+	//! The collection of problems.
+	typedef ValidationState::Problems Problems;
+
+	//! Constructor.
+	Validator(DomEditor& oEditor);
+
+	//! Destructor.
+	virtual ~Validator();
+
+	//
+	// Properties.
+	//
+
+	//! Query if the document is being validated.
+	bool IsRunning() const;
+
+	//
+	// Methods.
+	//
+
+	//! Start validating a document.
+	void Start(const XML::DocumentPtr& pDOM);
+
+	//! Stop validating the document.
+	void Stop();
+
+	//! Validate the whole document again.
+	void Rescan();
+
+	//! Copy out the facts about the dirty elements for a period of time.
+	void Step(DWORD dwSlice);
+
+	//! Take the problems found since the last call, if any.
+	bool TakeProblems(Problems& vecProblems);
+
+	//! Mark the nodes added to the document by a read as dirty.
+	void OnNodesAdded(const IncrementalReader::AddedNodes& vecAdded);
+
+	//! Handle a change to the DOM.
+	virtual void OnDomChanged(const DomChange& oChange);
+
+	//! Handle the start of a batch of changes.
+	virtual void OnBatchStarted();
+
+	//! Handle the end of a batch of changes.
+	virtual void OnBatchFinished();
+
+private:
+	//! A collection of elements.
+	typedef std::vector<const XML::Node*> Keys;
+	//! A collection of element facts.
+	typedef std::vector<ElementFacts> FactsList;
+
+	////////////////////////////////////////////////////////////////////////////
+	//! A node whose facts need copying, optionally along with its sub-tree.
+
+	struct Dirty
+	{
+		XML::NodePtr	m_pNode;		//!< The node.
+		bool			m_bSubtree;		//!< Copy its descendants too?
+	};
+
+	////////////////////////////////////////////////////////////////////////////
+	//! A set of changes for the background thread. The removals happened before
+	//! the updates were copied. Only the problems found after a complete job
+	//! are published, as the mirror is only consistent with the document then.
+
+	struct Job
+	{
+		bool			m_bReset;		//!< Discard the mirror first?
+		DtdModel		m_oDtd;			//!< The DTD, for a reset.
+		Keys			m_vecRemoved;	//!< The elements removed.
+		FactsList		m_vecUpdated;	//!< The elements added or changed.
+		bool			m_bComplete;	//!< Is the mirror consistent afterwards?
+	};
+
+	//! The collection of dirty nodes.
+	typedef std::vector<Dirty> DirtyList;
+	//! The queue of jobs.
+	typedef std::list<Job> Jobs;
+	//! The cursor smart-pointer type.
+	typedef Core::UniquePtr<NodeCursor> CursorPtr;
+
+	//
+	// Members.
+	//
+	DomEditor&			m_oEditor;		//!< The editor making the changes.
+	XML::DocumentPtr	m_pDOM;			//!< The document being validated.
+	bool				m_bInBatch;		//!< Is a batch of changes being made?
+	bool				m_bBatchChanged;	//!< Did the batch change the DOM?
+	DirtyList			m_vecDirty;		//!< The nodes whose facts need copying.
+	XML::NodePtr		m_pCursorRoot;	//!< The node whose sub-tree is being copied.
+	CursorPtr			m_pCursor;		//!< The position in the sub-tree.
+	Jobs				m_lstJob;		//!< The job being filled, if any.
+	bool				m_bIncomplete;	//!< Was the last job queued incomplete?
+	HANDLE				m_hThread;		//!< The validation thread.
+	HANDLE				m_hWakeEvent;	//!< Signals the validation thread.
+	volatile LONG		m_bStop;		//!< Should the validation thread finish?
+	CRITICAL_SECTION	m_oLock;		//!< Guards the members below.
+	Jobs				m_lstQueue;		//!< The jobs not yet applied.
+	Problems			m_vecProblems;	//!< The problems last published.
+	bool				m_bPublished;	//!< Have problems been published since taken?
+
+	//
+	// Internal methods.
+	//
+
+	//! Mark a node, and optionally its sub-tree, as dirty.
+	void MarkDirty(NodeRef pNode, bool bSubtree);
+
+	//! Abandon copying the current sub-tree, as the DOM structure has changed.
+	void ResetCursor();
+
+	//! Get the job being filled, creating it if required.
+	Job& CurrentJob();
+
+	//! Queue the job being filled for the validation thread.
+	void QueueJob(bool bComplete);
+
+	//! Copy the facts about an element into the current job.
+	void CopyFacts(NodeRef pElement);
+
+	//! Query if a node has text that is not whitespace.
+	bool HasText(NodeRef pNode) const;
+
+	//! Apply the queued jobs and publish the problems until asked to stop.
+	void ValidateQueue();
+
+	//! Apply a job to the mirror, unless asked to stop first.
+	bool ApplyJob(const Job& oJob, ValidationState& oState) const;
+
+	//! Query if the validation thread has been asked to stop.
+	bool IsStopping() const;
+
+	//! Query if a node is still part of the document.
+	static bool IsAttached(NodeRef pNode);
+
+	//! Parse the DTD in a document's DOCTYPE, if it has one.
+	static void ParseDtd(const XML::DocumentPtr& pDOM, DtdModel& oDtd);
+
+	//! The validation thread function.
+	static unsigned __stdcall ThreadProc(void* pParam);
+};
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the document is being validated.
+
+inline bool Validator::IsRunning() const
+{
+	return (m_hThread != NULL);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if the validation thread has been asked to stop.
+
+inline bool Validator::IsStopping() const
+{
+	return (m_bStop != FALSE);
+}
+
+#endif // APP_VALIDATOR_HPP
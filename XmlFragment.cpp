@@ -0,0 +1,190 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   XmlFragment.cpp
+//! \brief  The XmlFragment class definition.
+//! \author Chris Oldwood
+
+#include "Common.hpp"
+#include "XmlFragment.hpp"
+#include <XML/Document.hpp>
+#include <XML/ElementNode.hpp>
+#include <XML/TextNode.hpp>
+#include <XML/CommentNode.hpp>
+#include <XML/ProcessingNode.hpp>
+#include <XML/CDataNode.hpp>
+#include <XML/Reader.hpp>
+#include <Core/RuntimeException.hpp>
+#include "DocArena.hpp"
+#include "NodeCursor.hpp"
+
+// Constants.
+static const tchar FRAGMENT_WRAPPER[] = TXT("_");
+
+// The start of an XML declaration.
+static const tchar XML_DECLARATION[] = TXT("<?xml");
+
+// The characters treated as whitespace around a fragment.
+static const tchar WHITESPACE[] = TXT(" \t\r\n");
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append text to a fragment, escaping the markup characters.
+
+static void AppendEscaped(tstring& strXml, const tstring& strText)
+{
+	for (tstring::const_iterator it = strText.begin(); it != strText.end(); ++it)
+	{
+		switch (*it)
+		{
+			case TXT('<'):	strXml += TXT("&lt;");		break;
+			case TXT('>'):	strXml += TXT("&gt;");		break;
+			case TXT('&'):	strXml += TXT("&amp;");		break;
+			case TXT('"'):	strXml += TXT("&quot;");	break;
+			default:		strXml += *it;				break;
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append a set of attributes to a fragment.
+
+static void AppendAttributes(tstring& strXml, const XML::Attributes& vAttribs)
+{
+	for (XML::Attributes::const_iterator it = vAttribs.begin(); it != vAttribs.end(); ++it)
+	{
+		strXml += TXT(' ');
+		strXml += (*it)->name();
+		strXml += TXT("=\"");
+		AppendEscaped(strXml, (*it)->value());
+		strXml += TXT('"');
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Append the start of a node to a fragment. Returns false if the node cannot
+//! appear inside an element.
+
+static bool AppendNode(tstring& strXml, NodeRef pNode)
+{
+	XML::NodeType eType = pNode->type();
+
+	if (eType == XML::ELEMENT_NODE)
+	{
+		const XML::ElementNode* pElement = pNode.As<XML::ElementNode>();
+
+		strXml += TXT("<") + pElement->name();
+		AppendAttributes(strXml, pElement->getAttributes());
+		strXml += (pElement->hasChildren()) ? TXT(">") : TXT("/>");
+	}
+	else if (eType == XML::TEXT_NODE)
+	{
+		AppendEscaped(strXml, pNode.As<XML::TextNode>()->text());
+	}
+	else if (eType == XML::COMMENT_NODE)
+	{
+		strXml += TXT("<!--") + pNode.As<XML::CommentNode>()->comment() + TXT("-->");
+	}
+	else if (eType == XML::CDATA_NODE)
+	{
+		strXml += TXT("<![CDATA[") + pNode.As<XML::CDataNode>()->text() + TXT("]]>");
+	}
+	else if (eType == XML::PROCESSING_NODE)
+	{
+		const XML::ProcessingNode* pProcInst = pNode.As<XML::ProcessingNode>();
+
+		strXml += TXT("<?") + pProcInst->target();
+		AppendAttributes(strXml, pProcInst->getAttributes());
+		strXml += TXT("?>");
+	}
+	else
+	{
+		return false;
+	}
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Write a sub-tree as XML text. Returns false if the sub-tree contains a node
+//! that cannot appear inside an element.
+
+bool XmlFragment::Write(NodeRef pRoot, tstring& strXml)
+{
+	if (!AppendNode(strXml, pRoot))
+		return false;
+
+	const XML::NodeContainer* pChildren = NodeCursor::Children(pRoot);
+
+	if ( (pChildren == nullptr) || (!pChildren->hasChildren()) )
+		return true;
+
+	std::vector<NodeRef> vecOpen(1, pRoot);
+	NodeCursor           oCursor(*pChildren);
+
+	while (oCursor.Next())
+	{
+		// Close the elements that are not ancestors of this node.
+		for (; vecOpen.size() > oCursor.Depth(); vecOpen.pop_back())
+			strXml += TXT("</") + vecOpen.back().As<XML::ElementNode>()->name() + TXT(">");
+
+		if (!AppendNode(strXml, oCursor.Node()))
+			return false;
+
+		const XML::NodeContainer* pContainer = NodeCursor::Children(oCursor.Node());
+
+		if ( (pContainer != nullptr) && (pContainer->hasChildren()) )
+			vecOpen.push_back(oCursor.Node());
+	}
+
+	for (; !vecOpen.empty(); vecOpen.pop_back())
+		strXml += TXT("</") + vecOpen.back().As<XML::ElementNode>()->name() + TXT(">");
+
+	return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Parse XML text containing a single node, such as that copied from another
+//! application, which may start with an XML declaration. The node is parsed in
+//! the arena and detached from the document used to parse it.
+
+XML::NodePtr XmlFragment::Parse(const tstring& strXml, DocArena* pArena)
+{
+	size_t nStart = strXml.find_first_not_of(WHITESPACE);
+
+	if ( (nStart != tstring::npos) && (strXml.compare(nStart, tstrlen(XML_DECLARATION), XML_DECLARATION) == 0) )
+	{
+		size_t nEnd = strXml.find(TXT("?>"), nStart);
+
+		nStart = (nEnd != tstring::npos) ? nEnd + 2 : tstring::npos;
+	}
+
+	if (nStart == tstring::npos)
+		throw Core::RuntimeException(TXT("The text does not contain an XML node"));
+
+	tstring strFragment = TXT("<") + tstring(FRAGMENT_WRAPPER) + TXT(">")
+						+ strXml.substr(nStart)
+						+ TXT("</") + FRAGMENT_WRAPPER + TXT(">");
+
+	const tchar* pszBegin = strFragment.data();
+	const tchar* pszEnd   = pszBegin + strFragment.size();
+
+	XML::DocumentPtr pDoc;
+
+	{
+		DocArena::Scope oScope(pArena);
+
+		pDoc = XML::Reader::readDocument(pszBegin, pszEnd, XML::Reader::DISCARD_WHITESPACE);
+	}
+
+	if ( (pDoc->getChildCount() != 1) || ((*pDoc->beginChild())->type() != XML::ELEMENT_NODE) )
+		throw Core::RuntimeException(TXT("The text is not a single XML node"));
+
+	XML::ElementNode* pWrapper = NodeRef(*pDoc->beginChild()).As<XML::ElementNode>();
+
+	if (pWrapper->getChildCount() != 1)
+		throw Core::RuntimeException(TXT("The text is not a single XML node"));
+
+	XML::NodePtr pNode = *pWrapper->beginChild();
+
+	pWrapper->removeChild(0);
+
+	return pNode;
+}
@@ -0,0 +1,37 @@
+////////////////////////////////////////////////////////////////////////////////
+//! \file   XmlFragment.hpp
+//! \brief  The XmlFragment class declaration.
+//! \author Chris Oldwood
+
+// Check for previous inclusion
+#ifndef APP_XMLFRAGMENT_HPP
+#define APP_XMLFRAGMENT_HPP
+
+#if _MSC_VER > 1000
+#pragma once
+#endif
+
+#include "NodeRef.hpp"
+
+// Forward declarations.
+class DocArena;
+
+////////////////////////////////////////////////////////////////////////////////
+//! The conversion of a sub-tree to and from XML text. Only the types of node
+//! that can appear inside an element are supported.
+
+class XmlFragment
+{
+public:
+	//
+	// Class methods.
+	//
+
+	//! Write a sub-tree as XML text.
+	static bool Write(NodeRef pRoot, tstring& strXml);
+
+	//! Parse XML text containing a single node.
+	static XML::NodePtr Parse(const tstring& strXml, DocArena* pArena);
+};
+
+#endif // APP_XMLFRAGMENT_HPP
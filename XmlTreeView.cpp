@@ -7,18 +7,32 @@
 #include "XmlTreeView.hpp"
 #include "TheView.hpp"
 #include <XML/Document.hpp>
-#include <XML/TextNode.hpp>
 #include <XML/ElementNode.hpp>
 #include <XML/CommentNode.hpp>
 #include <XML/ProcessingNode.hpp>
 #include "TheApp.hpp"
 #include "TheDoc.hpp"
+#include "NodeCursor.hpp"
+#include "DomEditor.hpp"
+
+// Constants.
+static const size_t SUMMARY_TEXT_LENGTH = 1024;
+
+////////////////////////////////////////////////////////////////////////////////
+//! Query if a tree item is expanded.
+
+static bool IsItemExpanded(HWND hWnd, HTREEITEM hItem)
+{
+	return ((TreeView_GetItemState(hWnd, hItem, TVIS_EXPANDED) & TVIS_EXPANDED) != 0);
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 //! Default constructor.
 
 XmlTreeView::XmlTreeView(TheView& oView)
 	: m_oView(oView)
+	, m_bInBatch(false)
+	, m_bBatchChanged(false)
 {
 }
 
@@ -38,8 +52,8 @@ XML::NodePtr XmlTreeView::Selection() const
 
 	XML::NodePtr pNode;
 
-	if (hSelItem != NULL)
-		pNode = GetItemNode(hSelItem);
+	if ( (hSelItem != NULL) && (!m_oView.Document().IsCompact()) )
+		pNode = GetItemNode(hSelItem).ToPtr();
 
 	return pNode;
 }
@@ -54,6 +68,29 @@ void XmlTreeView::SetSelection(const XML::NodePtr& pNode)
 	Select(hItem);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! Get the current selected node of a compact document.
+
+CompactDoc::NodeIndex XmlTreeView::SelectedIndex() const
+{
+	HTREEITEM hSelItem = TreeView::Selection();
+
+	if (hSelItem == NULL)
+		return CompactDoc::NO_NODE;
+
+	return GetItemIndex(hSelItem);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Set the selected node of a compact document.
+
+void XmlTreeView::SetSelection(CompactDoc::NodeIndex nNode)
+{
+	ASSERT(nNode < m_vecIndexItems.size());
+
+	Select(m_vecIndexItems[nNode]);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! Refresh the entire document.
 
@@ -62,24 +99,67 @@ void XmlTreeView::Refresh()
 	// Clear the old DOM.
 	m_mapItemNode.clear();
 	m_mapNodeItem.clear();
+	m_mapItemIndex.clear();
+	m_vecIndexItems.clear();
 	Clear();
 
-	XML::DocumentPtr pDOM    = m_oView.Document().DOM();
-	tstring          strItem = TXT("DOM");
+	tstring strItem = RootItemText();
+
+	if (m_oView.Document().IsCompact())
+	{
+		const CompactDoc& oDoc  = m_oView.Document().Compact();
+		HTREEITEM         hRoot = InsertRootItem(strItem, oDoc.HasChildren(CompactDoc::DOCUMENT), 0);
+
+		AddCompactTree(hRoot, oDoc);
+		return;
+	}
+
+	XML::DocumentPtr pDOM = m_oView.Document().DOM();
 
 	ASSERT(pDOM.get() != nullptr);
 
 	HTREEITEM hRoot = InsertRootItem(strItem, pDOM->hasChildren(), 0);
 
-	AddItemNodeMapping(hRoot, pDOM);
+	AddItemNodeMapping(hRoot, NodeRef(pDOM.get()));
 
 	AddNodeTree(hRoot, *pDOM);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! Add nodes appended to the document by a partial read. The previously
+//! truncated elements are updated as they may now be complete.
+
+void XmlTreeView::AddNodes(const IncrementalReader::AddedNodes& vecAdded, const IncrementalReader::NodeChain& vecUpdated)
+{
+	typedef IncrementalReader::AddedNodes::const_iterator AddedIter;
+	typedef IncrementalReader::NodeChain::const_iterator NodeIter;
+
+	for (AddedIter it = vecAdded.begin(); it != vecAdded.end(); ++it)
+	{
+		NodeRef pNode = it->second;
+
+		HTREEITEM hItem = AddNode(GetNodeItem(NodeRef(it->first)), pNode);
+
+		if (pNode->type() == XML::ELEMENT_NODE)
+			AddNodeTree(hItem, *pNode.As<XML::ElementNode>());
+	}
+
+	for (NodeIter it = vecUpdated.begin(); it != vecUpdated.end(); ++it)
+	{
+		NodeRef pNode(*it);
+
+		UpdateNode(GetNodeItem(pNode), pNode);
+	}
+
+	XML::DocumentPtr pDOM = m_oView.Document().DOM();
+
+	UpdateItem(Root(), RootItemText(), pDOM->hasChildren(), 0);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! Create a mapping between the item and node.
 
-void XmlTreeView::AddItemNodeMapping(HTREEITEM hItem, const XML::NodePtr& pNode)
+void XmlTreeView::AddItemNodeMapping(HTREEITEM hItem, NodeRef pNode)
 {
 	ASSERT(m_mapItemNode.find(hItem)       == m_mapItemNode.end());
 	ASSERT(m_mapNodeItem.find(pNode.get()) == m_mapNodeItem.end());
@@ -89,21 +169,22 @@ void XmlTreeView::AddItemNodeMapping(HTREEITEM hItem, const XML::NodePtr& pNode)
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-//! Get the XML node for the tree item.
+//! Get the XML node for the tree item. The node is borrowed from the document
+//! so that selection changes and lookups do not touch its reference count.
 
-XML::NodePtr XmlTreeView::GetItemNode(HTREEITEM hItem) const
+NodeRef XmlTreeView::GetItemNode(HTREEITEM hItem) const
 {
 	ItemNodeMap::const_iterator it = m_mapItemNode.find(hItem);
 
 	ASSERT(it != m_mapItemNode.end());
 
-	return XML::NodePtr(it->second, true);
+	return NodeRef(it->second);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //! Get the tree item for the XML node.
 
-HTREEITEM XmlTreeView::GetNodeItem(const XML::NodePtr& pNode) const
+HTREEITEM XmlTreeView::GetNodeItem(NodeRef pNode) const
 {
 	NodeItemMap::const_iterator it = m_mapNodeItem.find(pNode.get());
 
@@ -112,6 +193,198 @@ HTREEITEM XmlTreeView::GetNodeItem(const XML::NodePtr& pNode) const
 	return it->second;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! Find the tree item for the XML node, if it has one. The node is only used
+//! as a key, so it may no longer be part of the document.
+
+HTREEITEM XmlTreeView::FindNodeItem(const XML::Node* pNode) const
+{
+	NodeItemMap::const_iterator it = m_mapNodeItem.find(const_cast<XML::Node*>(pNode));
+
+	if (it == m_mapNodeItem.end())
+		return NULL;
+
+	return it->second;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Get the compact document node for the tree item.
+
+CompactDoc::NodeIndex XmlTreeView::GetItemIndex(HTREEITEM hItem) const
+{
+	ItemIndexMap::const_iterator it = m_mapItemIndex.find(hItem);
+
+	ASSERT(it != m_mapItemIndex.end());
+
+	return it->second;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Handle a change to the DOM. Only the items for the nodes involved and their
+//! containers are touched. A moved sub-tree is re-created in its new position
+//! with the same items expanded and the selection restored.
+
+void XmlTreeView::OnDomChanged(const DomChange& oChange)
+{
+	if (m_bInBatch)
+	{
+		m_bBatchChanged = true;
+		return;
+	}
+
+	if (oChange.m_eType == DomChange::NODE_INSERTED)
+	{
+		InsertNodeTree(oChange.m_pParent, oChange.m_nIndex, oChange.m_pNode);
+		UpdateContainer(oChange.m_pParent);
+	}
+	else if (oChange.m_eType == DomChange::NODE_REMOVED)
+	{
+		RemoveNodeTree(oChange.m_pNode);
+		UpdateContainer(oChange.m_pOldParent);
+	}
+	else if (oChange.m_eType == DomChange::NODE_MOVED)
+	{
+		HTREEITEM            hSelItem  = TreeView::Selection();
+		NodeRef              pSelected = (hSelItem != NULL) ? GetItemNode(hSelItem) : NodeRef();
+		std::vector<NodeRef> vecExpanded;
+
+		const XML::NodeContainer* pChildren = NodeCursor::Children(oChange.m_pNode);
+
+		if (IsItemExpanded(m_hWnd, GetNodeItem(oChange.m_pNode)))
+			vecExpanded.push_back(oChange.m_pNode);
+
+		if (pChildren != nullptr)
+		{
+			for (NodeCursor oCursor(*pChildren); oCursor.Next(); )
+			{
+				if (IsItemExpanded(m_hWnd, GetNodeItem(oCursor.Node())))
+					vecExpanded.push_back(oCursor.Node());
+			}
+		}
+
+		RemoveNodeTree(oChange.m_pNode);
+		UpdateContainer(oChange.m_pOldParent);
+		InsertNodeTree(oChange.m_pParent, oChange.m_nIndex, oChange.m_pNode);
+		UpdateContainer(oChange.m_pParent);
+
+		for (std::vector<NodeRef>::const_iterator it = vecExpanded.begin(); it != vecExpanded.end(); ++it)
+			TreeView_Expand(m_hWnd, GetNodeItem(*it), TVE_EXPAND);
+
+		if ( (pSelected.get() != nullptr) && (GetNodeItem(pSelected) != TreeView::Selection()) )
+			Select(GetNodeItem(pSelected));
+	}
+	else if (oChange.m_eType == DomChange::CHILDREN_MOVED)
+	{
+		HTREEITEM            hSelItem  = TreeView::Selection();
+		NodeRef              pSelected = (hSelItem != NULL) ? GetItemNode(hSelItem) : NodeRef();
+		std::vector<NodeRef> vecExpanded;
+
+		const XML::NodeContainer& oChildren = DomEditor::Container(oChange.m_pParent);
+
+		for (NodeCursor oCursor(oChildren); oCursor.Next(); )
+		{
+			if (IsItemExpanded(m_hWnd, GetNodeItem(oCursor.Node())))
+				vecExpanded.push_back(oCursor.Node());
+		}
+
+		for (XML::NodeContainer::const_iterator it = oChildren.beginChild(); it != oChildren.endChild(); ++it)
+			RemoveNodeTree(*it);
+
+		AddNodeTree(GetNodeItem(oChange.m_pParent), oChildren);
+		UpdateContainer(oChange.m_pOldParent);
+		UpdateContainer(oChange.m_pParent);
+
+		for (std::vector<NodeRef>::const_iterator it = vecExpanded.begin(); it != vecExpanded.end(); ++it)
+			TreeView_Expand(m_hWnd, GetNodeItem(*it), TVE_EXPAND);
+
+		if ( (pSelected.get() != nullptr) && (GetNodeItem(pSelected) != TreeView::Selection()) )
+			Select(GetNodeItem(pSelected));
+	}
+	else if ( (oChange.m_eType == DomChange::ATTRIBUTE_CHANGED) || (oChange.m_eType == DomChange::TEXT_CHANGED) )
+	{
+		HTREEITEM hItem = GetNodeItem(oChange.m_pNode);
+
+		UpdateNode(hItem, oChange.m_pNode);
+
+		if (hItem == TreeView::Selection())
+			m_oView.ShowNode(oChange.m_pNode);
+	}
+	else if (oChange.m_eType == DomChange::TEXT_EDITED)
+	{
+		HTREEITEM hItem = GetNodeItem(oChange.m_pNode);
+
+		UpdateNode(hItem, oChange.m_pNode);
+
+		if (hItem == TreeView::Selection())
+			m_oView.OnTextEdited(oChange);
+	}
+	else
+	{
+		ASSERT_FALSE();
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Handle the start of a batch of changes. The changes are ignored until the
+//! end of the batch, so the selected and expanded nodes are held on to now,
+//! before any of them can be removed.
+
+void XmlTreeView::OnBatchStarted()
+{
+	m_bInBatch      = true;
+	m_bBatchChanged = false;
+
+	if (m_oView.Document().IsCompact())
+		return;
+
+	HTREEITEM hSelItem = TreeView::Selection();
+
+	if (hSelItem != NULL)
+		m_pBatchSelected = GetItemNode(hSelItem).ToPtr();
+
+	for (NodeItemMap::const_iterator it = m_mapNodeItem.begin(); it != m_mapNodeItem.end(); ++it)
+	{
+		if (IsItemExpanded(m_hWnd, it->second))
+			m_vecBatchExpanded.push_back(XML::NodePtr(it->first, true));
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Handle the end of a batch of changes by rebuilding the tree, if required.
+//! The expanded items and the selection are restored for the nodes that are
+//! still in the document.
+
+void XmlTreeView::OnBatchFinished()
+{
+	Nodes        vecExpanded;
+	XML::NodePtr pSelected = m_pBatchSelected;
+
+	vecExpanded.swap(m_vecBatchExpanded);
+	m_pBatchSelected.reset();
+	m_bInBatch = false;
+
+	if (!m_bBatchChanged)
+		return;
+
+	DWORD dwStart = ::GetTickCount();
+
+	Refresh();
+
+	for (Nodes::const_iterator it = vecExpanded.begin(); it != vecExpanded.end(); ++it)
+	{
+		NodeItemMap::const_iterator itItem = m_mapNodeItem.find(it->get());
+
+		if (itItem != m_mapNodeItem.end())
+			TreeView_Expand(m_hWnd, itItem->second, TVE_EXPAND);
+	}
+
+	NodeItemMap::const_iterator itSelected = m_mapNodeItem.find(pSelected.get());
+
+	Select((itSelected != m_mapNodeItem.end()) ? itSelected->second : Root());
+
+	TRACE1(TXT("Rebuilt the tree after a batch of edits in %u ms\n"), ::GetTickCount() - dwStart);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! Handle child message reflected back from the parent.
 
@@ -125,34 +398,33 @@ void XmlTreeView::OnReflectedCtrlMsg(NMHDR& oMsgHdr)
 }
 
 ////////////////////////////////////////////////////////////////////////////////
-//! Add the node container to the tree.
+//! Add the node container to the tree. The nodes are added in document order
+//! with a stack of the items at each depth, so any depth of nesting can be
+//! shown.
 
 void XmlTreeView::AddNodeTree(HTREEITEM hParent, const XML::NodeContainer& oContainer)
 {
-	typedef XML::NodeContainer::const_iterator CIter;
+	NodeCursor             oCursor(oContainer);
+	std::vector<HTREEITEM> vecParents(1, hParent);
 
-	// Add all children to the parent node.
-	for (CIter it = oContainer.beginChild(); it != oContainer.endChild(); ++it)
+	// Add all descendants under their parent's item.
+	while (oCursor.Next())
 	{
-		const XML::NodePtr& pNode = *it;
+		vecParents.resize(oCursor.Depth());
 
-		HTREEITEM hItem = AddNode(hParent, pNode);
+		HTREEITEM hItem = AddNode(vecParents.back(), oCursor.Node());
 
-		// If a container node, recursively add it's sub-tree.
-		if (pNode->type() == XML::DOCUMENT_NODE)
-			AddNodeTree(hItem, *Core::static_ptr_cast<XML::Document>(pNode));
-		else if (pNode->type() == XML::ELEMENT_NODE)
-			AddNodeTree(hItem, *Core::static_ptr_cast<XML::ElementNode>(pNode));
+		vecParents.push_back(hItem);
 	}
 }
 
 ////////////////////////////////////////////////////////////////////////////////
 //! Add a node to the tree.
 
-HTREEITEM XmlTreeView::AddNode(HTREEITEM hParent, const XML::NodePtr& pNode)
+HTREEITEM XmlTreeView::AddNode(HTREEITEM hParent, NodeRef pNode, HTREEITEM hAfter)
 {
 	// Add it to the tree view.
-	HTREEITEM hItem = InsertItem(hParent, TVI_LAST, TXT(""));
+	HTREEITEM hItem = InsertItem(hParent, hAfter, TXT(""));
 
 	AddItemNodeMapping(hItem, pNode);
 
@@ -161,10 +433,71 @@ HTREEITEM XmlTreeView::AddNode(HTREEITEM hParent, const XML::NodePtr& pNode)
 	return hItem;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! Add a node and its sub-tree at its position in its container.
+
+HTREEITEM XmlTreeView::InsertNodeTree(NodeRef pParent, size_t nIndex, NodeRef pNode)
+{
+	const XML::NodeContainer& oContainer = DomEditor::Container(pParent);
+	HTREEITEM                 hAfter     = TVI_FIRST;
+
+	if (nIndex != 0)
+		hAfter = GetNodeItem(*(oContainer.beginChild() + (nIndex-1)));
+
+	HTREEITEM hItem = AddNode(GetNodeItem(pParent), pNode, hAfter);
+
+	const XML::NodeContainer* pChildren = NodeCursor::Children(pNode);
+
+	if (pChildren != nullptr)
+		AddNodeTree(hItem, *pChildren);
+
+	return hItem;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Remove the items for a node and its sub-tree. The mappings are removed
+//! first as deleting the selected item changes the selection.
+
+void XmlTreeView::RemoveNodeTree(NodeRef pNode)
+{
+	HTREEITEM hItem = GetNodeItem(pNode);
+
+	m_mapItemNode.erase(hItem);
+	m_mapNodeItem.erase(pNode.get());
+
+	const XML::NodeContainer* pChildren = NodeCursor::Children(pNode);
+
+	if (pChildren != nullptr)
+	{
+		for (NodeCursor oCursor(*pChildren); oCursor.Next(); )
+		{
+			NodeItemMap::iterator it = m_mapNodeItem.find(oCursor.Node().get());
+
+			ASSERT(it != m_mapNodeItem.end());
+
+			m_mapItemNode.erase(it->second);
+			m_mapNodeItem.erase(it);
+		}
+	}
+
+	TreeView_DeleteItem(m_hWnd, hItem);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Update the item for a container after its children have changed.
+
+void XmlTreeView::UpdateContainer(NodeRef pNode)
+{
+	if (pNode->type() == XML::DOCUMENT_NODE)
+		UpdateItem(Root(), RootItemText(), pNode.As<XML::Document>()->hasChildren(), 0);
+	else
+		UpdateNode(GetNodeItem(pNode), pNode);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! Update a node in the tree.
 
-void XmlTreeView::UpdateNode(HTREEITEM hItem, const XML::NodePtr& pNode)
+void XmlTreeView::UpdateNode(HTREEITEM hItem, NodeRef pNode)
 {
 	XML::NodeType eType        = pNode->type();
 	tstring       strItem      = pNode->typeStr();
@@ -174,14 +507,14 @@ void XmlTreeView::UpdateNode(HTREEITEM hItem, const XML::NodePtr& pNode)
 	// Create a summary for the tree item.
 	if (eType == XML::DOCUMENT_NODE)
 	{
-		XML::DocumentPtr pDoc = Core::static_ptr_cast<XML::Document>(pNode);
+		const XML::Document* pDoc = pNode.As<XML::Document>();
 
 		bHasChildren = pDoc->hasChildren();
 		nImage       = 0;
 	}
 	else if (eType == XML::ELEMENT_NODE)
 	{
-		XML::ElementNodePtr pElement = Core::static_ptr_cast<XML::ElementNode>(pNode);
+		XML::ElementNode* pElement = pNode.As<XML::ElementNode>();
 
 		strItem      = pElement->name();
 		strItem     += TXT(' ');
@@ -190,12 +523,14 @@ void XmlTreeView::UpdateNode(HTREEITEM hItem, const XML::NodePtr& pNode)
 		nImage       = 1;
 
 		PostProcessSummary(strItem);
+
+		if (m_oView.Document().IsTruncated(pNode.get()))
+			strItem += TXT(" [truncated]");
 	}
 	else if (eType == XML::TEXT_NODE)
 	{
-		XML::TextNodePtr pText = Core::static_ptr_cast<XML::TextNode>(pNode);
-
-		strItem = pText->text();
+		// Only the start of a large value is needed for the summary.
+		strItem = m_oView.Document().Editor().Text(pNode, 0, SUMMARY_TEXT_LENGTH);
 		nImage  = 6;
 
 		PostProcessSummary(strItem);
@@ -206,7 +541,7 @@ void XmlTreeView::UpdateNode(HTREEITEM hItem, const XML::NodePtr& pNode)
 	}
 	else if (eType == XML::PROCESSING_NODE)
 	{
-		XML::ProcessingNodePtr pProcInst = Core::static_ptr_cast<XML::ProcessingNode>(pNode);
+		XML::ProcessingNode* pProcInst = pNode.As<XML::ProcessingNode>();
 
 		strItem  = pProcInst->target();
 		strItem += TXT(' ');
@@ -234,6 +569,117 @@ void XmlTreeView::UpdateNode(HTREEITEM hItem, const XML::NodePtr& pNode)
 	UpdateItem(hItem, strItem, bHasChildren, nImage);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! Add the nodes of a compact document to the tree. The nodes are stored in
+//! document order so a node's parent has always been added before it.
+
+void XmlTreeView::AddCompactTree(HTREEITEM hRoot, const CompactDoc& oDoc)
+{
+	size_t nCount = oDoc.NodeCount();
+
+	m_vecIndexItems.resize(nCount, NULL);
+
+	m_vecIndexItems[CompactDoc::DOCUMENT] = hRoot;
+	m_mapItemIndex.insert(std::make_pair(hRoot, CompactDoc::DOCUMENT));
+
+	for (CompactDoc::NodeIndex nNode = CompactDoc::DOCUMENT+1; nNode != nCount; ++nNode)
+	{
+		HTREEITEM hParent = m_vecIndexItems[oDoc.Parent(nNode)];
+		HTREEITEM hItem   = InsertItem(hParent, TVI_LAST, TXT(""));
+
+		m_vecIndexItems[nNode] = hItem;
+		m_mapItemIndex.insert(std::make_pair(hItem, nNode));
+
+		UpdateCompactNode(hItem, oDoc, nNode);
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Update a compact document node in the tree.
+
+void XmlTreeView::UpdateCompactNode(HTREEITEM hItem, const CompactDoc& oDoc, CompactDoc::NodeIndex nNode)
+{
+	XML::NodeType          eType        = oDoc.Type(nNode);
+	tstring                strItem;
+	bool                   bHasChildren = false;
+	int                    nImage       = -1;
+	CompactDoc::Attributes vecAttribs;
+
+	// Create a summary for the tree item.
+	if (eType == XML::ELEMENT_NODE)
+	{
+		oDoc.GetAttributes(nNode, vecAttribs);
+
+		strItem      = oDoc.Name(nNode);
+		strItem     += TXT(' ');
+		strItem     += MakeAttribSummary(vecAttribs);
+		bHasChildren = oDoc.HasChildren(nNode);
+		nImage       = 1;
+
+		PostProcessSummary(strItem);
+	}
+	else if (eType == XML::TEXT_NODE)
+	{
+		strItem = oDoc.Value(nNode);
+		nImage  = 6;
+
+		PostProcessSummary(strItem);
+	}
+	else if (eType == XML::COMMENT_NODE)
+	{
+		strItem = TXT("Comment");
+		nImage  = 5;
+	}
+	else if (eType == XML::PROCESSING_NODE)
+	{
+		oDoc.GetAttributes(nNode, vecAttribs);
+
+		strItem  = oDoc.Name(nNode);
+		strItem += TXT(' ');
+		strItem += MakeAttribSummary(vecAttribs);
+		nImage   = 4;
+
+		PostProcessSummary(strItem);
+	}
+	else if (eType == XML::DOCTYPE_NODE)
+	{
+		strItem = TXT("DOCTYPE");
+		nImage  = 7;
+	}
+	else if (eType == XML::CDATA_NODE)
+	{
+		strItem = TXT("CDATA");
+		nImage  = 8;
+	}
+	else
+	{
+		ASSERT_FALSE();
+	}
+
+	// Add it to the tree view.
+	UpdateItem(hItem, strItem, bHasChildren, nImage);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//! Generate the text for the root item. A partially loaded document shows how
+//! much of the file has been read.
+
+tstring XmlTreeView::RootItemText() const
+{
+	const TheDoc& oDoc = m_oView.Document();
+
+	if (oDoc.IsCompact())
+		return TXT("DOM (compact - read-only)");
+
+	if (!oDoc.IsPartial())
+		return TXT("DOM");
+
+	uint64 nFileSize = std::max<uint64>(oDoc.FileSize(), 1);
+	uint   nPercent  = static_cast<uint>((oDoc.LoadedBytes() * 100) / nFileSize);
+
+	return Core::fmt(TXT("DOM (partial - %u%% loaded)"), nPercent);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! Generate a summary of the attributes.
 
@@ -261,6 +707,31 @@ tstring XmlTreeView::MakeAttribSummary(XML::Attributes& vAttribs)
 	return str;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+//! Generate a summary of the decoded attributes.
+
+tstring XmlTreeView::MakeAttribSummary(const CompactDoc::Attributes& vecAttribs)
+{
+	// Type aliases.
+	typedef CompactDoc::Attributes::const_iterator ConstIter;
+
+	tstring str;
+
+	// For all attributes...
+	for (ConstIter it = vecAttribs.begin(); it != vecAttribs.end(); ++it)
+	{
+		if (!str.empty())
+			str += TXT(' ');
+
+		str += it->first;
+		str += TXT("=\"");
+		str += it->second;
+		str += TXT("\"");
+	}
+
+	return str;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 //! Post-process the summary.
 
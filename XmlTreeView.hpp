@@ -14,15 +14,21 @@
 #include <WCL/TreeView.hpp>
 #include <XML/Node.hpp>
 #include <XML/Attributes.hpp>
+#include "IncrementalReader.hpp"
+#include "CompactDoc.hpp"
+#include "NodeRef.hpp"
+#include "IDomListener.hpp"
 #include <map>
 
 // Forward declarations.
 class TheView;
 
 ////////////////////////////////////////////////////////////////////////////////
-//! The tree view derived control used to display the DOM.
+//! The tree view derived control used to display the DOM. Edits to the DOM are
+//! applied to only the affected items, except for a batch of edits, which is
+//! applied by rebuilding the tree once at the end.
 
-class XmlTreeView : public WCL::TreeView
+class XmlTreeView : public WCL::TreeView, public IDomListener
 {
 public:
 	//! Default constructor.
@@ -41,6 +47,12 @@ public:
 	//! Set the selected node.
 	void SetSelection(const XML::NodePtr& pNode);
 
+	//! Get the current selected node of a compact document.
+	CompactDoc::NodeIndex SelectedIndex() const;
+
+	//! Set the selected node of a compact document.
+	void SetSelection(CompactDoc::NodeIndex nNode);
+
 	//
 	// Methods.
 	//
@@ -48,24 +60,54 @@ public:
 	//! Refresh the entire document.
 	void Refresh();
 
+	//! Add nodes appended to the document by a partial read.
+	void AddNodes(const IncrementalReader::AddedNodes& vecAdded, const IncrementalReader::NodeChain& vecUpdated);
+
 	//! Get the XML node for the tree item.
-	XML::NodePtr GetItemNode(HTREEITEM hItem) const; // throw()
+	NodeRef GetItemNode(HTREEITEM hItem) const; // throw()
 
 	//! Get the tree item for the XML node.
-	HTREEITEM GetNodeItem(const XML::NodePtr& pNode) const; // throw()
+	HTREEITEM GetNodeItem(NodeRef pNode) const; // throw()
+
+	//! Find the tree item for the XML node, if it has one.
+	HTREEITEM FindNodeItem(const XML::Node* pNode) const; // throw()
+
+	//! Get the compact document node for the tree item.
+	CompactDoc::NodeIndex GetItemIndex(HTREEITEM hItem) const; // throw()
+
+	//! Handle a change to the DOM.
+	virtual void OnDomChanged(const DomChange& oChange);
+
+	//! Handle the start of a batch of changes.
+	virtual void OnBatchStarted();
+
+	//! Handle the end of a batch of changes.
+	virtual void OnBatchFinished();
 
 private:
 	//! A map of tree item to node ptr.
 	typedef std::map<HTREEITEM, XML::Node*> ItemNodeMap;
 	//! A map of node ptr to tree item.
 	typedef std::map<XML::Node*, HTREEITEM> NodeItemMap;
+	//! A map of tree item to compact node index.
+	typedef std::map<HTREEITEM, CompactDoc::NodeIndex> ItemIndexMap;
+	//! The tree items indexed by compact node index.
+	typedef std::vector<HTREEITEM> IndexItems;
+	//! A collection of nodes.
+	typedef std::vector<XML::NodePtr> Nodes;
 
 	//
 	// Members.
 	//
-	TheView&	m_oView;		//!< The document view.
-	ItemNodeMap	m_mapItemNode;	//!< The map of tree item to XML node.
-	NodeItemMap	m_mapNodeItem;	//!< The map of xml node to tree item.
+	TheView&		m_oView;		//!< The document view.
+	ItemNodeMap		m_mapItemNode;	//!< The map of tree item to XML node.
+	NodeItemMap		m_mapNodeItem;	//!< The map of xml node to tree item.
+	ItemIndexMap	m_mapItemIndex;	//!< The map of tree item to compact node.
+	IndexItems		m_vecIndexItems;	//!< The tree items of the compact nodes.
+	bool			m_bInBatch;		//!< Is a batch of changes being made?
+	bool			m_bBatchChanged;	//!< Did the batch change the DOM?
+	XML::NodePtr	m_pBatchSelected;	//!< The node selected before the batch.
+	Nodes			m_vecBatchExpanded;	//!< The nodes expanded before the batch.
 
 	//
 	// Message handlers.
@@ -79,20 +121,41 @@ private:
 	//
 
 	//! Create a mapping between the item and node.
-	void AddItemNodeMapping(HTREEITEM hItem, const XML::NodePtr& pNode);
+	void AddItemNodeMapping(HTREEITEM hItem, NodeRef pNode);
 
 	//! Add the node container to the tree.
 	void AddNodeTree(HTREEITEM hParent, const XML::NodeContainer& oContainer);
 
 	//! Add a node to the tree.
-	HTREEITEM AddNode(HTREEITEM hParent, const XML::NodePtr& pNode);
+	HTREEITEM AddNode(HTREEITEM hParent, NodeRef pNode, HTREEITEM hAfter = TVI_LAST);
+
+	//! Add a node and its sub-tree at its position in its container.
+	HTREEITEM InsertNodeTree(NodeRef pParent, size_t nIndex, NodeRef pNode);
+
+	//! Remove the items for a node and its sub-tree.
+	void RemoveNodeTree(NodeRef pNode);
+
+	//! Update the item for a container after its children have changed.
+	void UpdateContainer(NodeRef pNode);
 
 	//! Update a node in the tree.
-	void UpdateNode(HTREEITEM hItem, const XML::NodePtr& pNode);
+	void UpdateNode(HTREEITEM hItem, NodeRef pNode);
+
+	//! Add the nodes of a compact document to the tree.
+	void AddCompactTree(HTREEITEM hRoot, const CompactDoc& oDoc);
+
+	//! Update a compact document node in the tree.
+	void UpdateCompactNode(HTREEITEM hItem, const CompactDoc& oDoc, CompactDoc::NodeIndex nNode);
+
+	//! Generate the text for the root item.
+	tstring RootItemText() const;
 
 	//! Generate a summary of the attributes.
 	static tstring MakeAttribSummary(XML::Attributes& vAttribs);
 
+	//! Generate a summary of the decoded attributes.
+	static tstring MakeAttribSummary(const CompactDoc::Attributes& vecAttribs);
+
 	//! Post-process the summary.
 	static void PostProcessSummary(tstring& str);
 };